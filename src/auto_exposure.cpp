@@ -0,0 +1,121 @@
+#include "auto_exposure.h"
+
+#include <math.h>
+#include <algorithm>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float auto_exposure_luminance(float r, float g, float b)
+{
+    return r * 0.2126f + g * 0.7152f + b * 0.0722f;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint32_t auto_exposure_bin(float luminance, const AutoExposureSettings& settings)
+{
+    if (!(luminance >= exp2f(settings.min_log2_luminance)))
+        return 0;
+
+    float t = (log2f(luminance) - settings.min_log2_luminance) / (settings.max_log2_luminance - settings.min_log2_luminance);
+
+    t = std::min(std::max(t, 0.0f), 1.0f);
+
+    return std::min(uint32_t(t * float(AUTO_EXPOSURE_HISTOGRAM_BINS - 1)), uint32_t(AUTO_EXPOSURE_HISTOGRAM_BINS - 2)) + 1;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float auto_exposure_bin_log2_luminance(uint32_t bin, const AutoExposureSettings& settings)
+{
+    float t = (float(bin) - 0.5f) / float(AUTO_EXPOSURE_HISTOGRAM_BINS - 1);
+
+    return settings.min_log2_luminance + t * (settings.max_log2_luminance - settings.min_log2_luminance);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void auto_exposure_histogram(const float* rgb, size_t count, size_t stride, const AutoExposureSettings& settings, uint32_t* histogram)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const float* pixel = rgb + i * stride;
+
+        histogram[auto_exposure_bin(auto_exposure_luminance(pixel[0], pixel[1], pixel[2]), settings)]++;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool auto_exposure_average_log2_luminance(const uint32_t* histogram, const AutoExposureSettings& settings, float& average)
+{
+    // The steps of auto_exposure_cs.glsl: a prefix sum over the bins, the count of each bin clipped to the percentile
+    // range, then a weighted average of the bin centers.
+    uint32_t total = 0;
+
+    for (uint32_t i = 1; i < AUTO_EXPOSURE_HISTOGRAM_BINS; i++)
+        total += histogram[i];
+
+    float    low           = settings.low_percentile * float(total);
+    float    high          = settings.high_percentile * float(total);
+    float    weight        = 0.0f;
+    float    weighted_log2 = 0.0f;
+    uint32_t prefix        = 0;
+
+    for (uint32_t i = 1; i < AUTO_EXPOSURE_HISTOGRAM_BINS; i++)
+    {
+        float before = float(prefix);
+
+        prefix += histogram[i];
+
+        float clipped = std::min(std::max(float(prefix), low), high) - std::min(std::max(before, low), high);
+
+        weight += clipped;
+        weighted_log2 += clipped * auto_exposure_bin_log2_luminance(i, settings);
+    }
+
+    if (weight <= 0.0f)
+        return false;
+
+    average = weighted_log2 / weight;
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float auto_exposure_target(float average_log2_luminance, const AutoExposureSettings& settings)
+{
+    float exposure = settings.key * exp2f(settings.compensation - average_log2_luminance);
+
+    return std::min(std::max(exposure, settings.min_exposure), settings.max_exposure);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float auto_exposure_adapt(float exposure, float target, float delta_time, const AutoExposureSettings& settings)
+{
+    if (delta_time <= 0.0f || exposure <= 0.0f)
+        return exposure <= 0.0f ? target : exposure;
+
+    float speed  = target > exposure ? settings.speed_up : settings.speed_down;
+    float amount = 1.0f - expf(-delta_time * speed);
+
+    return exp2f(log2f(exposure) + (log2f(target) - log2f(exposure)) * amount);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void auto_exposure_update(const uint32_t* histogram, float delta_time, const AutoExposureSettings& settings, AutoExposureState& state)
+{
+    float average;
+
+    if (!auto_exposure_average_log2_luminance(histogram, settings, average))
+        return;
+
+    state.average_log2_luminance = average;
+    state.target_exposure        = auto_exposure_target(average, settings);
+    state.exposure               = auto_exposure_adapt(state.exposure, state.target_exposure, delta_time, settings);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Histogram auto-exposure. tonemap_cs.glsl tone maps the frame with the exposure of the previous one and adds every pixel to a
+// histogram of log2 luminance in the same pass, auto_exposure_cs.glsl then reduces the histogram to the average log luminance of the
+// pixels between two percentiles and moves the exposure towards the one that maps it to the key value. The functions below are the CPU
+// versions of both passes, used by the reference renderer.
+
+// Keep in sync with AUTO_EXPOSURE_HISTOGRAM_BINS in auto_exposure.glsl. Bin 0 holds the pixels darker than the range, which are
+// ignored, bins 1 to AUTO_EXPOSURE_HISTOGRAM_BINS - 1 split the range evenly.
+#define AUTO_EXPOSURE_HISTOGRAM_BINS 64
+
+// Layout of the AutoExposure buffer in auto_exposure.glsl, the histogram follows it.
+struct AutoExposureState
+{
+    float exposure;               // Exposure applied to the frame, includes the compensation.
+    float target_exposure;        // Exposure the adaptation is moving towards.
+    float average_log2_luminance; // Of the last frame that had pixels in range.
+    float padding;
+};
+
+struct AutoExposureSettings
+{
+    float min_log2_luminance = -10.0f;
+    float max_log2_luminance = 6.0f;
+    float low_percentile     = 0.5f;  // Fraction of the darkest pixels left out of the average.
+    float high_percentile    = 0.95f; // Pixels above this fraction are left out too, the sun disk would dominate otherwise.
+    float key                = 0.5f;  // Luminance the average is mapped to before the compensation, 0.6 exposure on the default view.
+    float compensation       = 0.0f;  // In stops.
+    float min_exposure       = 0.01f;
+    float max_exposure       = 64.0f;
+    float speed_up           = 1.0f;  // Adaptation rate when the exposure rises, per second.
+    float speed_down         = 3.0f;  // And when it falls, faster so that a bright frame does not stay blown out.
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Rec. 709 luminance.
+float auto_exposure_luminance(float r, float g, float b);
+
+// Histogram bin of 'luminance'.
+uint32_t auto_exposure_bin(float luminance, const AutoExposureSettings& settings);
+
+// Log2 luminance at the center of bin 'bin', which must not be 0.
+float auto_exposure_bin_log2_luminance(uint32_t bin, const AutoExposureSettings& settings);
+
+// Adds 'count' RGB pixels, 'stride' floats apart, to 'histogram'.
+void auto_exposure_histogram(const float* rgb, size_t count, size_t stride, const AutoExposureSettings& settings, uint32_t* histogram);
+
+// Average log2 luminance of the pixels of 'histogram' between the two percentiles. Pixels that straddle a percentile are weighted by
+// the fraction inside it. Returns false if no pixel is in range.
+bool auto_exposure_average_log2_luminance(const uint32_t* histogram, const AutoExposureSettings& settings, float& average);
+
+// Exposure that maps 'average_log2_luminance' to the key value.
+float auto_exposure_target(float average_log2_luminance, const AutoExposureSettings& settings);
+
+// Moves 'exposure' towards 'target' over 'delta_time' seconds, exponentially in stops so that the speed does not depend on the
+// brightness.
+float auto_exposure_adapt(float exposure, float target, float delta_time, const AutoExposureSettings& settings);
+
+// Runs the reduction of auto_exposure_cs.glsl over 'histogram' and updates 'state'. 'state' is left unchanged if no pixel is in range.
+void auto_exposure_update(const uint32_t* histogram, float delta_time, const AutoExposureSettings& settings, AutoExposureState& state);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,206 @@
+#include "benchmark_script.h"
+
+#include <fstream>
+#include <sstream>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool fail(std::string& error, uint32_t line, const std::string& reason)
+{
+    error = "line " + std::to_string(line) + ": " + reason;
+    return false;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static void copy_values(BenchmarkKeyframe& dst, const BenchmarkKeyframe& src, uint32_t mask)
+{
+    if (mask & BENCHMARK_POSITION)
+        dst.position = src.position;
+    if (mask & BENCHMARK_DIRECTION)
+        dst.direction = src.direction;
+    if (mask & BENCHMARK_SUN_ANGLE)
+        dst.sun_angle = src.sun_angle;
+    if (mask & BENCHMARK_COVERAGE)
+        dst.coverage = src.coverage;
+    if (mask & BENCHMARK_WIND_ANGLE)
+        dst.wind_angle = src.wind_angle;
+    if (mask & BENCHMARK_WIND_SPEED)
+        dst.wind_speed = src.wind_speed;
+
+    dst.mask |= mask;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool parse_benchmark_script(const std::string& text, BenchmarkScript& script, std::string& error)
+{
+    std::istringstream stream(text);
+    std::string        line;
+    uint32_t           line_number = 0;
+
+    script = BenchmarkScript();
+
+    while (std::getline(stream, line))
+    {
+        line_number++;
+
+        size_t comment = line.find('#');
+
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream tokens(line);
+        std::string        command;
+
+        if (!(tokens >> command))
+            continue;
+
+        bool ok = true;
+
+        if (command == "timestep")
+            ok = bool(tokens >> script.timestep) && script.timestep > 0.0f;
+        else if (command == "warmup")
+            ok = bool(tokens >> script.warmup);
+        else if (command == "frames")
+            ok = bool(tokens >> script.frames) && script.frames > 0;
+        else if (command == "keyframe")
+        {
+            BenchmarkKeyframe keyframe;
+
+            if (!(tokens >> keyframe.time))
+                return fail(error, line_number, "expected a time after 'keyframe'");
+
+            if (!script.keyframes.empty() && keyframe.time <= script.keyframes.back().time)
+                return fail(error, line_number, "keyframe times must be increasing");
+
+            script.keyframes.push_back(keyframe);
+        }
+        else
+        {
+            if (script.keyframes.empty())
+                return fail(error, line_number, "'" + command + "' must follow a keyframe");
+
+            BenchmarkKeyframe& keyframe = script.keyframes.back();
+
+            if (command == "position")
+            {
+                ok = bool(tokens >> keyframe.position.x >> keyframe.position.y >> keyframe.position.z);
+                keyframe.mask |= BENCHMARK_POSITION;
+            }
+            else if (command == "direction")
+            {
+                ok = bool(tokens >> keyframe.direction.x >> keyframe.direction.y >> keyframe.direction.z) && glm::length(keyframe.direction) > 0.0f;
+                keyframe.mask |= BENCHMARK_DIRECTION;
+
+                if (ok)
+                    keyframe.direction = glm::normalize(keyframe.direction);
+            }
+            else if (command == "sun_angle")
+            {
+                ok = bool(tokens >> keyframe.sun_angle);
+                keyframe.sun_angle = glm::radians(keyframe.sun_angle);
+                keyframe.mask |= BENCHMARK_SUN_ANGLE;
+            }
+            else if (command == "coverage")
+            {
+                ok = bool(tokens >> keyframe.coverage);
+                keyframe.mask |= BENCHMARK_COVERAGE;
+            }
+            else if (command == "wind_angle")
+            {
+                ok = bool(tokens >> keyframe.wind_angle);
+                keyframe.wind_angle = glm::radians(keyframe.wind_angle);
+                keyframe.mask |= BENCHMARK_WIND_ANGLE;
+            }
+            else if (command == "wind_speed")
+            {
+                ok = bool(tokens >> keyframe.wind_speed);
+                keyframe.mask |= BENCHMARK_WIND_SPEED;
+            }
+            else
+                return fail(error, line_number, "unknown command '" + command + "'");
+        }
+
+        if (!ok)
+            return fail(error, line_number, "invalid value for '" + command + "'");
+
+        std::string extra;
+
+        if (tokens >> extra)
+            return fail(error, line_number, "unexpected '" + extra + "'");
+    }
+
+    if (script.keyframes.empty())
+        return fail(error, line_number, "the script has no keyframes");
+
+    // Fill in omitted values so that every keyframe carries the same set: forward from the previous keyframe, then backward into the
+    // keyframes before the first one that sets a value.
+    for (size_t i = 1; i < script.keyframes.size(); i++)
+        copy_values(script.keyframes[i], script.keyframes[i - 1], script.keyframes[i - 1].mask & ~script.keyframes[i].mask);
+
+    for (size_t i = script.keyframes.size() - 1; i > 0; i--)
+        copy_values(script.keyframes[i - 1], script.keyframes[i], script.keyframes[i].mask & ~script.keyframes[i - 1].mask);
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool load_benchmark_script(const std::string& path, BenchmarkScript& script, std::string& error)
+{
+    std::ifstream file(path);
+
+    if (!file)
+    {
+        error = "failed to open " + path;
+        return false;
+    }
+
+    std::stringstream text;
+    text << file.rdbuf();
+
+    return parse_benchmark_script(text.str(), script, error);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+BenchmarkKeyframe sample_benchmark_script(const BenchmarkScript& script, float time)
+{
+    const std::vector<BenchmarkKeyframe>& keyframes = script.keyframes;
+
+    if (time <= keyframes.front().time)
+        return keyframes.front();
+
+    if (time >= keyframes.back().time)
+        return keyframes.back();
+
+    size_t next = 1;
+
+    while (keyframes[next].time < time)
+        next++;
+
+    const BenchmarkKeyframe& a = keyframes[next - 1];
+    const BenchmarkKeyframe& b = keyframes[next];
+
+    float t = (time - a.time) / (b.time - a.time);
+
+    BenchmarkKeyframe result;
+
+    result.time       = time;
+    result.mask       = a.mask;
+    result.position   = glm::mix(a.position, b.position, t);
+    result.direction  = glm::mix(a.direction, b.direction, t);
+    result.sun_angle  = glm::mix(a.sun_angle, b.sun_angle, t);
+    result.coverage   = glm::mix(a.coverage, b.coverage, t);
+    result.wind_angle = glm::mix(a.wind_angle, b.wind_angle, t);
+    result.wind_speed = glm::mix(a.wind_speed, b.wind_speed, t);
+
+    // Opposite directions cancel out half way, keep the previous one instead of producing a NaN.
+    float length     = glm::length(result.direction);
+    result.direction = length > 1e-6f ? result.direction / length : a.direction;
+
+    return result;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
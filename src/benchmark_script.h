@@ -0,0 +1,63 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Keyframed camera path and cloud parameters driven by --benchmark. Scripts are plain text, one command per line, '#' starts a comment:
+//
+//     timestep 0.016667           # seconds per frame, time is pinned to frame * timestep
+//     warmup 120                  # frames rendered at time 0 before measuring
+//     frames 600                  # measured frames
+//     keyframe 0                  # starts a keyframe at the given time in seconds
+//     position 0 5 0
+//     direction -1 0 0
+//     sun_angle -58               # degrees
+//     coverage 0.7
+//     wind_angle 0                # degrees
+//     wind_speed 50
+//     keyframe 10
+//     position -2000 150 0
+//
+// Keyframes must be in increasing time order. Values are linearly interpolated between keyframes and a keyframe that omits a value
+// keeps it from the keyframe before it. Values that no keyframe sets stay under the control of the application.
+
+#define BENCHMARK_POSITION (1 << 0)
+#define BENCHMARK_DIRECTION (1 << 1)
+#define BENCHMARK_SUN_ANGLE (1 << 2)
+#define BENCHMARK_COVERAGE (1 << 3)
+#define BENCHMARK_WIND_ANGLE (1 << 4)
+#define BENCHMARK_WIND_SPEED (1 << 5)
+
+struct BenchmarkKeyframe
+{
+    float     time       = 0.0f;
+    uint32_t  mask       = 0;
+    glm::vec3 position   = glm::vec3(0.0f);
+    glm::vec3 direction  = glm::vec3(0.0f, 0.0f, -1.0f);
+    float     sun_angle  = 0.0f; // Radians
+    float     coverage   = 0.0f;
+    float     wind_angle = 0.0f; // Radians
+    float     wind_speed = 0.0f;
+};
+
+struct BenchmarkScript
+{
+    float                          timestep = 1.0f / 60.0f;
+    uint32_t                       warmup   = 60;
+    uint32_t                       frames   = 600;
+    std::vector<BenchmarkKeyframe> keyframes;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Parses the text of a script. On failure 'error' receives the line number and the reason.
+bool parse_benchmark_script(const std::string& text, BenchmarkScript& script, std::string& error);
+
+bool load_benchmark_script(const std::string& path, BenchmarkScript& script, std::string& error);
+
+// Interpolated state at 'time', clamped to the first and last keyframe. The mask of the result is the same for every time.
+BenchmarkKeyframe sample_benchmark_script(const BenchmarkScript& script, float time);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
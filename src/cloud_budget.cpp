@@ -0,0 +1,162 @@
+#include "cloud_budget.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <fstream>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static float quantize_down(float value)
+{
+    // The epsilon keeps values that are exact multiples from dropping a step to rounding.
+    return floorf(value / CLOUD_BUDGET_QUANTUM + 0.001f) * CLOUD_BUDGET_QUANTUM;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float cloud_budget_cost(const CloudBudgetLevel& level)
+{
+    return level.scale * level.scale * level.step_fraction;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+CloudBudgetLevel cloud_budget_level(float cost, const CloudBudgetSettings& settings)
+{
+    CloudBudgetLevel level;
+
+    cost = std::min(std::max(cost, 0.0f), 1.0f);
+
+    if (cost >= settings.min_step_fraction)
+    {
+        level.scale         = 1.0f;
+        level.step_fraction = std::max(quantize_down(cost), settings.min_step_fraction);
+    }
+    else
+    {
+        level.scale         = std::max(quantize_down(sqrtf(cost / settings.min_step_fraction)), settings.min_scale);
+        level.step_fraction = settings.min_step_fraction;
+    }
+
+    return level;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void CloudBudgetController::reset(const CloudBudgetSettings& settings)
+{
+    m_settings        = settings;
+    m_level           = { 1.0f, 1.0f };
+    m_full_quality_ms = 0.0f;
+    m_settle          = 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool CloudBudgetController::update(float measured_ms, const CloudBudgetLevel& rendered)
+{
+    if (measured_ms <= 0.0f || cloud_budget_cost(rendered) <= 0.0f)
+        return false;
+
+    float full_quality_ms = measured_ms / cloud_budget_cost(rendered);
+
+    if (m_full_quality_ms > 0.0f)
+        m_full_quality_ms += (full_quality_ms - m_full_quality_ms) * m_settings.smoothing;
+    else
+        m_full_quality_ms = full_quality_ms;
+
+    if (m_settle > 0)
+    {
+        m_settle--;
+        return false;
+    }
+
+    float cost      = cloud_budget_cost(m_level);
+    float predicted = m_full_quality_ms * cost;
+    float target    = m_settings.target_ms;
+
+    if (predicted >= target * (1.0f - m_settings.hysteresis) && predicted <= target * (1.0f + m_settings.hysteresis))
+        return false;
+
+    float            desired = std::min(std::max(target / m_full_quality_ms, cost / CLOUD_BUDGET_MAX_CHANGE), cost * CLOUD_BUDGET_MAX_CHANGE);
+    CloudBudgetLevel level   = cloud_budget_level(desired, m_settings);
+
+    if (level.scale == m_level.scale && level.step_fraction == m_level.step_fraction)
+        return false;
+
+    m_level  = level;
+    m_settle = m_settings.settle_frames;
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void cloud_budget_simulate(const CloudBudgetSettings& settings, const std::vector<float>& trace, uint32_t latency, std::vector<CloudBudgetLevel>& levels, std::vector<float>& times)
+{
+    CloudBudgetController controller;
+    controller.reset(settings);
+
+    levels.resize(trace.size());
+    times.resize(trace.size());
+
+    for (size_t i = 0; i < trace.size(); i++)
+    {
+        // As in the sample, the frame whose queries were just read back is fed before the level of the new frame is picked.
+        if (i >= latency)
+            controller.update(times[i - latency], levels[i - latency]);
+
+        levels[i] = controller.level();
+        times[i]  = trace[i] * cloud_budget_cost(levels[i]);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool cloud_budget_read_trace(const std::string& path, const std::string& pass, std::vector<float>& trace)
+{
+    std::ifstream file(path);
+
+    if (!file.is_open())
+        return false;
+
+    bool        json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    std::string line;
+
+    trace.clear();
+
+    while (std::getline(file, line))
+    {
+        if (json)
+        {
+            // {"frame":N,"passes":[{"name":"...","cpu_ms":X,"gpu_ms":Y or null},...]}
+            size_t name = line.find("\"name\":\"" + pass + "\"");
+
+            if (name == std::string::npos)
+                continue;
+
+            size_t gpu = line.find("\"gpu_ms\":", name);
+
+            if (gpu != std::string::npos && line.compare(gpu + 9, 4, "null") != 0)
+                trace.push_back(float(atof(line.c_str() + gpu + 9)));
+        }
+        else
+        {
+            // frame,pass,cpu_ms,gpu_ms with an empty gpu_ms for dropped samples.
+            size_t first  = line.find(',');
+            size_t second = first == std::string::npos ? first : line.find(',', first + 1);
+            size_t third  = second == std::string::npos ? second : line.find(',', second + 1);
+
+            if (third == std::string::npos || third + 1 >= line.size())
+                continue;
+
+            if (line.compare(first + 1, second - first - 1, pass) == 0)
+                trace.push_back(float(atof(line.c_str() + third + 1)));
+        }
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
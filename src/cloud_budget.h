@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Feedback controller that keeps the GPU time of the cloud pass near a budget by lowering the number of march steps and the resolution
+// the clouds are rendered at. The cost of a level is modelled as scale^2 * step_fraction of the full quality pass: a measured time
+// divided by the cost of the level it was rendered with estimates the full quality time, and the level whose cost fits that estimate
+// into the budget follows. Steps are lowered first, down to min_step_fraction, the resolution after that. Nothing changes while the
+// predicted time stays within +-hysteresis of the budget, and nothing changes again until settle_frames measurements of the new level
+// came in, so the GPU timers resolving a few frames late cannot make it oscillate. Nothing here depends on OpenGL, main.cpp feeds the
+// resolved times of the "Clouds" pass and cloud_budget_simulate() replays recorded ones.
+
+// Scale and step fraction are rounded down to multiples of this, so that noise in the measurements does not resize the target every
+// frame.
+#define CLOUD_BUDGET_QUANTUM 0.0625f
+
+// A single step never changes the cost by more than this factor.
+#define CLOUD_BUDGET_MAX_CHANGE 2.0f
+
+struct CloudBudgetSettings
+{
+    float    target_ms         = 4.0f;
+    float    min_scale         = 0.25f; // per axis, 0.25 matches the 4x4 blocks of the temporal path
+    float    min_step_fraction = 0.5f;
+    float    hysteresis        = 0.1f;
+    float    smoothing         = 0.25f; // weight of a new measurement in the running estimate
+    uint32_t settle_frames     = 4;
+};
+
+struct CloudBudgetLevel
+{
+    float scale;
+    float step_fraction;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float cloud_budget_cost(const CloudBudgetLevel& level);
+
+// Most expensive level that costs no more than 'cost' of the full quality pass, or the cheapest one 'settings' allows. Steps are
+// lowered first.
+CloudBudgetLevel cloud_budget_level(float cost, const CloudBudgetSettings& settings);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+class CloudBudgetController
+{
+public:
+    // Starts over at full quality.
+    void reset(const CloudBudgetSettings& settings);
+
+    // Feeds the measured time of a frame rendered with 'rendered'. Returns true if level() changed.
+    bool update(float measured_ms, const CloudBudgetLevel& rendered);
+
+    inline const CloudBudgetSettings& settings() const { return m_settings; }
+    inline const CloudBudgetLevel&    level() const { return m_level; }
+
+    // Running estimate of the time of the pass at full quality, 0 before the first measurement.
+    inline float full_quality_ms() const { return m_full_quality_ms; }
+
+private:
+    CloudBudgetSettings m_settings;
+    CloudBudgetLevel    m_level           = { 1.0f, 1.0f };
+    float               m_full_quality_ms = 0.0f;
+    uint32_t            m_settle          = 0;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Replays 'trace', times of the pass recorded at full quality, through a controller. Frame i takes trace[i] times the cost of its level
+// and is measured 'latency' frames later, as the profiler reads its queries back. 'levels' and 'times' receive the level and the
+// simulated time of every frame.
+void cloud_budget_simulate(const CloudBudgetSettings& settings, const std::vector<float>& trace, uint32_t latency, std::vector<CloudBudgetLevel>& levels, std::vector<float>& times);
+
+// Reads the GPU times of pass 'pass' out of a log written by --profile-log, CSV or JSON lines. Frames where the time was dropped are
+// skipped.
+bool cloud_budget_read_trace(const std::string& path, const std::string& pass, std::vector<float>& trace);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,139 @@
+#include "cloud_budget.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+// Replays a recorded trace of cloud pass times through CloudBudgetController to tune it offline.
+//
+// Usage:
+//     cloud-budget-simulator <profile log> [--target-ms N] [--pass NAME] [--temporal] [--latency N] [--hysteresis N]
+//                            [--settle-frames N] [--output levels.csv]
+//
+// The log is what the sample writes with --profile-log, CSV or JSON lines, recorded without --cloud-budget so that it holds the full
+// quality time of every frame. --temporal limits the controller to the steps, as in the temporal path. --output writes the simulated
+// level and time of every frame.
+
+// PROFILER_FRAMES_IN_FLIGHT of profiler.h, duplicated here so that the tool does not depend on GL headers.
+#define PROFILER_LATENCY 3
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, const char* argv[])
+{
+    CloudBudgetSettings settings;
+    uint32_t            latency = PROFILER_LATENCY;
+    std::string         pass    = "Clouds";
+    std::string         log_path;
+    std::string         output_path;
+
+    settings.settle_frames = PROFILER_LATENCY + 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--target-ms") && i + 1 < argc)
+            settings.target_ms = float(atof(argv[++i]));
+        else if (!strcmp(argv[i], "--pass") && i + 1 < argc)
+            pass = argv[++i];
+        else if (!strcmp(argv[i], "--temporal"))
+            settings.min_scale = 1.0f;
+        else if (!strcmp(argv[i], "--latency") && i + 1 < argc)
+            latency = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--hysteresis") && i + 1 < argc)
+            settings.hysteresis = float(atof(argv[++i]));
+        else if (!strcmp(argv[i], "--settle-frames") && i + 1 < argc)
+            settings.settle_frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc)
+            output_path = argv[++i];
+        else if (argv[i][0] != '-' && log_path.empty())
+            log_path = argv[i];
+        else
+        {
+            printf("Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (log_path.empty())
+    {
+        printf("Usage: cloud-budget-simulator <profile log> [--target-ms N] [--pass NAME] [--temporal] [--latency N] [--hysteresis N] [--settle-frames N] [--output levels.csv]\n");
+        return 1;
+    }
+
+    std::vector<float> trace;
+
+    if (!cloud_budget_read_trace(log_path, pass, trace))
+    {
+        printf("Failed to read %s\n", log_path.c_str());
+        return 1;
+    }
+
+    if (trace.empty())
+    {
+        printf("%s has no GPU times of pass '%s'\n", log_path.c_str(), pass.c_str());
+        return 1;
+    }
+
+    std::vector<CloudBudgetLevel> levels;
+    std::vector<float>            times;
+
+    cloud_budget_simulate(settings, trace, latency, levels, times);
+
+    uint32_t over_budget = 0;
+    uint32_t changes     = 0;
+    double   error_sum   = 0.0;
+    double   time_sum    = 0.0;
+    double   trace_sum   = 0.0;
+    double   scale_sum   = 0.0;
+    double   steps_sum   = 0.0;
+
+    for (size_t i = 0; i < trace.size(); i++)
+    {
+        if (times[i] > settings.target_ms * (1.0f + settings.hysteresis))
+            over_budget++;
+
+        if (i > 0 && (levels[i].scale != levels[i - 1].scale || levels[i].step_fraction != levels[i - 1].step_fraction))
+            changes++;
+
+        error_sum += fabs(times[i] - settings.target_ms);
+        time_sum += times[i];
+        trace_sum += trace[i];
+        scale_sum += levels[i].scale;
+        steps_sum += levels[i].step_fraction;
+    }
+
+    double n = double(trace.size());
+
+    printf("%zu frames of '%s', target %.2f ms\n\n", trace.size(), pass.c_str(), settings.target_ms);
+    printf("Full quality:       %.3f ms average\n", trace_sum / n);
+    printf("Controlled:         %.3f ms average, %.3f ms mean absolute error\n", time_sum / n, error_sum / n);
+    printf("Over budget:        %u frames (%.1f%%)\n", over_budget, 100.0 * over_budget / n);
+    printf("Level changes:      %u\n", changes);
+    printf("Average resolution: %.1f%%\n", 100.0 * scale_sum / n);
+    printf("Average steps:      %.1f%%\n", 100.0 * steps_sum / n);
+
+    if (!output_path.empty())
+    {
+        FILE* file = fopen(output_path.c_str(), "w");
+
+        if (!file)
+        {
+            printf("Failed to write %s\n", output_path.c_str());
+            return 1;
+        }
+
+        fprintf(file, "frame,full_quality_ms,scale,step_fraction,ms\n");
+
+        for (size_t i = 0; i < trace.size(); i++)
+            fprintf(file, "%zu,%.4f,%.4f,%.4f,%.4f\n", i, trace[i], levels[i].scale, levels[i].step_fraction, times[i]);
+
+        fclose(file);
+    }
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,209 @@
+#include "cloud_layers.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <algorithm>
+#include <numeric>
+
+static const char* kTypeNames[CLOUD_LAYER_TYPE_COUNT] = { "Volumetric", "Cirrus" };
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+const char* cloud_layer_type_name(CloudLayerType type)
+{
+    return type < CLOUD_LAYER_TYPE_COUNT ? kTypeNames[type] : "Unknown";
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool cloud_layers_validate(const CloudLayer* layers, uint32_t count, std::string& error)
+{
+    char message[256];
+
+    if (count > CLOUD_MAX_LAYERS)
+    {
+        snprintf(message, sizeof(message), "%u cloud layers, at most %u are supported", count, CLOUD_MAX_LAYERS);
+        error = message;
+        return false;
+    }
+
+    uint32_t volumetric = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const CloudLayer& layer = layers[i];
+
+        if (layer.type == CLOUD_LAYER_VOLUMETRIC)
+            volumetric++;
+
+        if (layer.min_height < 0.0f || layer.max_height < layer.min_height)
+        {
+            snprintf(message, sizeof(message), "Layer %u has an invalid height range %.0f to %.0f", i, layer.min_height, layer.max_height);
+            error = message;
+            return false;
+        }
+
+        if (layer.type == CLOUD_LAYER_CIRRUS && (layer.max_height != layer.min_height || !(layer.scale > 0.0f)))
+        {
+            snprintf(message, sizeof(message), "Cirrus layer %u must have a single height and a positive scale", i);
+            error = message;
+            return false;
+        }
+
+        // Touching is fine, a cirrus layer may sit right on top of the volumetric shell.
+        for (uint32_t j = 0; j < i; j++)
+        {
+            const CloudLayer& other = layers[j];
+
+            bool overlap = layer.min_height < other.max_height && other.min_height < layer.max_height;
+
+            if (overlap || (layer.min_height == other.min_height && layer.max_height == other.max_height))
+            {
+                snprintf(message, sizeof(message), "%s layer %u overlaps %s layer %u", cloud_layer_type_name(layer.type), i, cloud_layer_type_name(other.type), j);
+                error = message;
+                return false;
+            }
+        }
+
+        if (i > 0 && layer.min_height < layers[i - 1].min_height)
+        {
+            snprintf(message, sizeof(message), "%s layer %u is below %s layer %u, layers are listed from the bottom up", cloud_layer_type_name(layer.type), i, cloud_layer_type_name(layers[i - 1].type), i - 1);
+            error = message;
+            return false;
+        }
+    }
+
+    if (volumetric != 1)
+    {
+        snprintf(message, sizeof(message), "%u volumetric cloud layers, exactly one is supported", volumetric);
+        error = message;
+        return false;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float cloud_layer_distance(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& center, float radius)
+{
+    glm::vec3 l = origin - center;
+    float     b = glm::dot(direction, l);
+    float     c = glm::dot(l, l) - radius * radius;
+    float     d = b * b - c;
+
+    if (d < 0.0f)
+        return -1.0f;
+
+    float s = sqrtf(d);
+
+    // The near crossing when the origin is outside the sphere, the far one from inside.
+    return -b - s > 0.0f ? -b - s : -b + s;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec4 cloud_layer_cirrus_uniform(const CloudLayer& layer)
+{
+    return glm::vec4(layer.min_height, layer.coverage, layer.opacity, layer.scale);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Unit gradient of lattice point (x, y) of octave 'octave', repeating every 'period' points.
+static glm::vec2 cirrus_gradient(uint32_t x, uint32_t y, uint32_t period, uint32_t octave)
+{
+    uint32_t h = (x % period) * 1597334673U ^ (y % period) * 3812015801U ^ (octave + 1) * 2798796415U;
+
+    h ^= h >> 16;
+    h *= 0x7feb352dU;
+    h ^= h >> 15;
+    h *= 0x846ca68bU;
+    h ^= h >> 16;
+
+    float angle = float(h) * (6.28318530718f / 4294967296.0f);
+
+    return glm::vec2(cosf(angle), sinf(angle));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Gradient noise at 'p', in lattice units, in about [-0.7, 0.7].
+static float cirrus_gradient_noise(const glm::vec2& p, uint32_t period, uint32_t octave)
+{
+    glm::vec2 cell = glm::floor(p);
+    glm::vec2 w    = p - cell;
+    glm::vec2 u    = w * w * w * (w * (w * 6.0f - 15.0f) + 10.0f);
+
+    uint32_t x = uint32_t(cell.x);
+    uint32_t y = uint32_t(cell.y);
+
+    float va = glm::dot(cirrus_gradient(x, y, period, octave), w);
+    float vb = glm::dot(cirrus_gradient(x + 1, y, period, octave), w - glm::vec2(1.0f, 0.0f));
+    float vc = glm::dot(cirrus_gradient(x, y + 1, period, octave), w - glm::vec2(0.0f, 1.0f));
+    float vd = glm::dot(cirrus_gradient(x + 1, y + 1, period, octave), w - glm::vec2(1.0f, 1.0f));
+
+    return glm::mix(glm::mix(va, vb, u.x), glm::mix(vc, vd, u.x), u.y);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void cloud_cirrus_texture_generate(uint32_t size, uint32_t frequency, std::vector<std::vector<float>>& mips)
+{
+    const uint32_t kOctaves = 5;
+
+    std::vector<float> texels(size_t(size) * size);
+
+    for (uint32_t y = 0; y < size; y++)
+    {
+        for (uint32_t x = 0; x < size; x++)
+        {
+            glm::vec2 uv        = (glm::vec2(float(x), float(y)) + 0.5f) / float(size);
+            float     value     = 0.0f;
+            float     amplitude = 1.0f;
+
+            for (uint32_t octave = 0; octave < kOctaves; octave++)
+            {
+                uint32_t period = frequency << octave;
+
+                value += (1.0f - fabsf(cirrus_gradient_noise(uv * float(period), period, octave))) * amplitude;
+                amplitude *= 0.5f;
+            }
+
+            texels[size_t(y) * size + x] = value;
+        }
+    }
+
+    // Replace every value by its rank, which leaves the pattern as it is and makes the coverage the fraction of texels kept.
+    std::vector<uint32_t> order(texels.size());
+
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return texels[a] < texels[b] || (texels[a] == texels[b] && a < b); });
+
+    mips.clear();
+    mips.emplace_back(texels.size());
+
+    for (size_t i = 0; i < order.size(); i++)
+        mips[0][order[i]] = (float(i) + 0.5f) / float(order.size());
+
+    for (uint32_t mip_size = size / 2; mip_size > 0; mip_size /= 2)
+    {
+        const std::vector<float>& src = mips.back();
+        std::vector<float>        dst(size_t(mip_size) * mip_size);
+
+        for (uint32_t y = 0; y < mip_size; y++)
+        {
+            for (uint32_t x = 0; x < mip_size; x++)
+            {
+                size_t i = size_t(y) * 2 * mip_size * 2 + x * 2;
+                size_t j = i + mip_size * 2;
+
+                dst[size_t(y) * mip_size + x] = (src[i] + src[i + 1] + src[j] + src[j + 1]) * 0.25f;
+            }
+        }
+
+        mips.push_back(std::move(dst));
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
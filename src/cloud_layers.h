@@ -0,0 +1,60 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Stack of cloud layers. The volumetric layer is the shell between cloud_min_height and cloud_max_height marched by cloud_march.glsl.
+// The light volume, the shadow map, the empty space grid and the tiles are all built for that shell, so a stack holds exactly one of
+// them. The other layers are cirrus: a sphere high above the shell, shaded from one curl noise and one cirrus texture fetch where the ray
+// crosses it, so high cloud costs two texture fetches per pixel instead of a march through kilometres of empty shell. Layers are
+// composited front to back in the order the ray crosses them.
+
+#define CLOUD_MAX_LAYERS 4
+
+// Keep in sync with CLOUD_MAX_CIRRUS_LAYERS in cloud_march.glsl.
+#define CLOUD_MAX_CIRRUS_LAYERS (CLOUD_MAX_LAYERS - 1)
+
+// Size of the cirrus texture and repeats of its coarsest octave across it.
+#define CLOUD_CIRRUS_TEXTURE_SIZE      256
+#define CLOUD_CIRRUS_TEXTURE_FREQUENCY 4
+
+enum CloudLayerType
+{
+    CLOUD_LAYER_VOLUMETRIC,
+    CLOUD_LAYER_CIRRUS,
+    CLOUD_LAYER_TYPE_COUNT
+};
+
+struct CloudLayer
+{
+    CloudLayerType type       = CLOUD_LAYER_CIRRUS;
+    float          min_height = 8000.0f;  // Above the planet surface.
+    float          max_height = 8000.0f;  // Equal to min_height for cirrus.
+    float          coverage   = 0.5f;     // Fraction of the sky covered, cirrus only.
+    float          opacity    = 0.6f;     // Of the densest streaks, cirrus only.
+    float          scale      = 20000.0f; // Width of one repeat of the noise in meters, cirrus only. Streaks are 4 times longer.
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+const char* cloud_layer_type_name(CloudLayerType type);
+
+// Checks that 'layers' holds exactly one volumetric layer, that no layer overlaps another and that they are listed from the bottom up.
+// Returns false with a message otherwise.
+bool cloud_layers_validate(const CloudLayer* layers, uint32_t count, std::string& error);
+
+// Distance along a ray with a normalized 'direction' to the first point where it crosses the sphere of 'radius' around 'center', or a
+// negative value if it does not cross it ahead of 'origin'. cloud_layer_distance() in cloud_march.glsl.
+float cloud_layer_distance(const glm::vec3& origin, const glm::vec3& direction, const glm::vec3& center, float radius);
+
+// u_CirrusLayers entry of a cirrus layer: height, coverage, opacity and scale.
+glm::vec4 cloud_layer_cirrus_uniform(const CloudLayer& layer);
+
+// Generates the tileable single channel texture of the cirrus layers, size^2 with 'size' a power of two, and its box filtered mip
+// chain into 'mips', mip 0 first. Ridged gradient noise, whose thin crests read as the fibres of cirrus, equalized so that the values
+// of mip 0 are spread evenly over [0, 1] and a coverage of c keeps a fraction c of the texels.
+void cloud_cirrus_texture_generate(uint32_t size, uint32_t frequency, std::vector<std::vector<float>>& mips);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
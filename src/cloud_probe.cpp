@@ -0,0 +1,59 @@
+#include "cloud_probe.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void CloudProbeScheduler::reset(uint32_t size, uint32_t tiles_per_axis)
+{
+    m_size           = size;
+    m_tiles_per_axis = std::max(std::min(tiles_per_axis, size), 1u);
+    m_next           = 0;
+    m_cycles         = 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+CloudProbeTile CloudProbeScheduler::next()
+{
+    uint32_t tiles_per_face = m_tiles_per_axis * m_tiles_per_axis;
+    uint32_t tile           = m_next % tiles_per_face;
+    uint32_t tile_x         = tile % m_tiles_per_axis;
+    uint32_t tile_y         = tile / m_tiles_per_axis;
+
+    CloudProbeTile result;
+
+    // Edges spread evenly over the face, so that no tile is empty or past the edge when the size is not a multiple of the tiles.
+    result.face           = m_next / tiles_per_face;
+    result.x              = tile_x * m_size / m_tiles_per_axis;
+    result.y              = tile_y * m_size / m_tiles_per_axis;
+    result.width          = (tile_x + 1) * m_size / m_tiles_per_axis - result.x;
+    result.height         = (tile_y + 1) * m_size / m_tiles_per_axis - result.y;
+    result.first_of_cycle = m_next == 0;
+    result.last_of_face   = tile == tiles_per_face - 1;
+
+    if (++m_next == frames_per_cycle())
+    {
+        m_next = 0;
+        m_cycles++;
+    }
+
+    return result;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::mat4 cloud_probe_face_view_proj(uint32_t face, const glm::vec3& position, float near_plane, float far_plane)
+{
+    // The orientations of the cubemap faces in the GL specification, whose t axis points down the face.
+    static const glm::vec3 FORWARD[CLOUD_PROBE_FACES] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f) };
+    static const glm::vec3 UP[CLOUD_PROBE_FACES]      = { glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f) };
+
+    glm::mat4 view = glm::lookAt(position, position + FORWARD[face], UP[face]);
+    glm::mat4 proj = glm::perspective(glm::radians(90.0f), 1.0f, near_plane, far_plane);
+
+    return proj * view;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
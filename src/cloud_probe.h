@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+// Low resolution cubemap of the sky and clouds around the camera for reflections and ambient lighting. Marching all six faces every
+// frame would cost more than the main view, so the probe is rendered one face, or one tile of a face, per frame in round-robin order
+// and a full update takes CloudProbeScheduler::frames_per_cycle() frames. Each cycle renders from the position the camera had when it
+// started, so the faces of a cycle always line up. clouds_fs.glsl renders the tiles with the view of their face.
+
+#define CLOUD_PROBE_FACES 6
+
+// Default edge of a face in texels.
+#define CLOUD_PROBE_SIZE 64
+
+// Region of a face rendered in one frame.
+struct CloudProbeTile
+{
+    uint32_t face;
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+    bool     first_of_cycle; // The scheduler started a new cycle, latch the probe position.
+    bool     last_of_face;   // The face is complete once this tile is rendered.
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+class CloudProbeScheduler
+{
+public:
+    // Splits every 'size' x 'size' face into 'tiles_per_axis' x 'tiles_per_axis' tiles and starts over from the first tile of face 0.
+    void reset(uint32_t size, uint32_t tiles_per_axis);
+
+    // Tile to render this frame. Faces are visited in order, the tiles of a face row by row.
+    CloudProbeTile next();
+
+    inline uint32_t size() const { return m_size; }
+    inline uint32_t frames_per_cycle() const { return CLOUD_PROBE_FACES * m_tiles_per_axis * m_tiles_per_axis; }
+
+    // True once every face was rendered at least once and the probe can be sampled.
+    inline bool complete() const { return m_cycles > 0; }
+
+private:
+    uint32_t m_size           = CLOUD_PROBE_SIZE;
+    uint32_t m_tiles_per_axis = 1;
+    uint32_t m_next           = 0;
+    uint32_t m_cycles         = 0;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// 90 degree view projection of cubemap face 'face' (+X, -X, +Y, -Y, +Z, -Z) seen from 'position'. Rendering a face with it and sampling
+// the cubemap along a direction read the same texel.
+glm::mat4 cloud_probe_face_view_proj(uint32_t face, const glm::vec3& position, float near_plane, float far_plane);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
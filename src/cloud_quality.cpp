@@ -0,0 +1,83 @@
+#include "cloud_quality.h"
+
+#include <string.h>
+#include <algorithm>
+#include <string>
+
+// Custom keeps the exact light cone and sky by default, the tiers below Ultra trade them for the sun transmittance volume and the
+// sky-view LUT. Low drops the detail noise and half the cone, Ultra marches the light cone and evaluates the sky for every sample and
+// pixel instead of reading them from the precomputed volumes.
+static const CloudQualityPreset kPresets[CLOUD_QUALITY_COUNT] = {
+    { 128, 6, true, false, false }, // Custom
+    { 48, 3, false, true, true },   // Low
+    { 96, 4, true, true, true },    // Medium
+    { 128, 6, true, true, true },   // High
+    { 192, 6, true, false, false }  // Ultra
+};
+
+static const char* kNames[CLOUD_QUALITY_COUNT] = { "Custom", "Low", "Medium", "High", "Ultra" };
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+const char* cloud_quality_name(CloudQualityTier tier)
+{
+    return kNames[tier];
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+const CloudQualityPreset& cloud_quality_preset(CloudQualityTier tier)
+{
+    return kPresets[tier];
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool cloud_quality_parse(const char* name, CloudQualityTier& tier)
+{
+    for (int i = 0; i < CLOUD_QUALITY_COUNT; i++)
+    {
+        if (!strcmp(name, kNames[i]))
+        {
+            tier = CloudQualityTier(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+CloudPermutation cloud_quality_permutation(CloudQualityTier tier, bool light_volume, bool sky_view_lut)
+{
+    const CloudQualityPreset& preset = kPresets[tier];
+    CloudPermutation          permutation;
+
+    permutation.tier          = tier;
+    permutation.max_num_steps = preset.max_num_steps;
+    permutation.cone_samples  = preset.cone_samples;
+    permutation.detail_noise  = preset.detail_noise;
+    permutation.light_volume  = light_volume;
+    permutation.sky_view_lut  = sky_view_lut;
+
+    return permutation;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void cloud_permutation_defines(const CloudPermutation& permutation, ShaderDefines& defines)
+{
+    defines.clear();
+
+    if (permutation.tier == CLOUD_QUALITY_CUSTOM)
+        return;
+
+    defines.push_back({ "CLOUD_MAX_NUM_STEPS", std::to_string(std::max(permutation.max_num_steps, 1)) });
+    defines.push_back({ "CLOUD_CONE_SAMPLES", std::to_string(std::min(std::max(permutation.cone_samples, 1), CLOUD_MAX_CONE_SAMPLES)) });
+    defines.push_back({ "CLOUD_DETAIL_NOISE", permutation.detail_noise ? "1" : "0" });
+    defines.push_back({ "CLOUD_LIGHT_VOLUME", permutation.light_volume ? "1" : "0" });
+    defines.push_back({ "CLOUD_SKY_VIEW_LUT", permutation.sky_view_lut ? "1" : "0" });
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "shader_source.h"
+
+// Quality tiers of the cloud pass. A tier sets the march steps and the cone samples, turns the detail noise on or off and picks the
+// light march and the sky model, then compiles all of them into a variant of the cloud programs as preprocessor defines, see the
+// permutation defines at the top of cloud_density.glsl and cloud_march.glsl. With the settings folded into constants the compiler
+// unrolls the light cone and drops the branches and fetches the variant does not use. CLOUD_QUALITY_CUSTOM compiles no defines and
+// reads every setting from its uniform, which the debug GUI can change freely.
+
+// Size of the cone kernel in cloud_density.glsl, the most cone samples a variant can take.
+#define CLOUD_MAX_CONE_SAMPLES 6
+
+enum CloudQualityTier
+{
+    CLOUD_QUALITY_CUSTOM = 0,
+    CLOUD_QUALITY_LOW,
+    CLOUD_QUALITY_MEDIUM,
+    CLOUD_QUALITY_HIGH,
+    CLOUD_QUALITY_ULTRA,
+    CLOUD_QUALITY_COUNT
+};
+
+// Settings a tier applies. Those of CLOUD_QUALITY_CUSTOM are the defaults of the sample.
+struct CloudQualityPreset
+{
+    int32_t max_num_steps;
+    int32_t cone_samples;
+    bool    detail_noise;
+    bool    light_volume; // Sun transmittance volume, otherwise the light cone is marched for every sample.
+    bool    sky_view_lut; // Sky-view LUT, otherwise the Preetham model is evaluated for every pixel.
+};
+
+// What a variant of the cloud programs is compiled for. The light march and the sky model are those in use, which may differ from
+// the preset when the GUI changed them or their programs are not available.
+struct CloudPermutation
+{
+    CloudQualityTier tier          = CLOUD_QUALITY_CUSTOM;
+    int32_t          max_num_steps = 128;
+    int32_t          cone_samples  = CLOUD_MAX_CONE_SAMPLES;
+    bool             detail_noise  = true;
+    bool             light_volume  = false;
+    bool             sky_view_lut  = false;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+const char*               cloud_quality_name(CloudQualityTier tier);
+const CloudQualityPreset& cloud_quality_preset(CloudQualityTier tier);
+
+// Case sensitive, as returned by cloud_quality_name(). Returns false for an unknown name.
+bool cloud_quality_parse(const char* name, CloudQualityTier& tier);
+
+// Permutation of 'tier' with the light march and sky model in use.
+CloudPermutation cloud_quality_permutation(CloudQualityTier tier, bool light_volume, bool sky_view_lut);
+
+// Defines of the variant, none for CLOUD_QUALITY_CUSTOM. Key them with shader_defines_key().
+void cloud_permutation_defines(const CloudPermutation& permutation, ShaderDefines& defines);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,1209 @@
+#include "cloud_reference.h"
+#include "cpu_noise.h"
+#include "empty_space_grid.h"
+#include "image_io.h"
+#include "light_volume.h"
+#include "sky_view_lut.h"
+#include "slice_scheduler.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+
+#define NUM_CONE_SAMPLES 6
+
+// Detail noise of a density sample, as in cloud_density.glsl.
+#define DENSITY_DETAIL_NONE 0
+#define DENSITY_DETAIL_MEAN 1
+#define DENSITY_DETAIL_FULL 2
+
+#define DETAIL_NOISE_MEAN_FBM 0.7f
+
+// Cirrus layers, as in cloud_march.glsl.
+#define CIRRUS_STRETCH      4.0f
+#define CIRRUS_CURL_SCALE   4.0f
+#define CIRRUS_CURL_AMOUNT  0.05f
+#define CIRRUS_LAYER_OFFSET glm::vec2(0.31f, 0.57f)
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static inline int32_t wrap(int32_t i, int32_t size)
+{
+    i %= size;
+    return i < 0 ? i + size : i;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static inline float smoothstep(float edge0, float edge1, float x)
+{
+    float t = glm::clamp((x - edge0) / (edge1 - edge0), 0.0f, 1.0f);
+
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Cloud type 0 is a thin stratus layer at the bottom of the shell, 1 fills the whole shell.
+static inline float density_height_gradient_for_point(float height_fraction, float cloud_type)
+{
+    float top = glm::mix(0.35f, 1.2f, cloud_type);
+
+    return 1.0f - smoothstep(top - 0.2f, top, height_fraction);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static inline float remap(float original_value, float original_min, float original_max, float new_min, float new_max)
+{
+    return new_min + (((original_value - original_min) / (original_max - original_min)) * (new_max - new_min));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void ReferenceVolume::create(const float* texels, uint32_t size, uint32_t num_channels, NoiseFormat format)
+{
+    std::vector<std::vector<float>> mips;
+    cpu_noise_generate_mips(texels, size, num_channels, mips);
+
+    m_size = size;
+    m_mips.resize(mips.size());
+
+    for (size_t i = 0; i < mips.size(); i++)
+    {
+        m_mips[i].assign(mips[i].size() / num_channels, glm::vec4(0.0f));
+
+        for (size_t j = 0; j < m_mips[i].size(); j++)
+        {
+            for (uint32_t c = 0; c < num_channels; c++)
+                m_mips[i][j][c] = noise_format_quantize(format, mips[i][j * num_channels + c]);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec4 ReferenceVolume::sample_lod(const glm::vec3& uvw, float lod) const
+{
+    // Magnification filter at or below lod 0, otherwise blend the two nearest mips.
+    if (lod <= 0.0f)
+        return sample_trilinear(0, uvw);
+
+    float max_lod = float(m_mips.size() - 1);
+
+    if (lod >= max_lod)
+        return sample_trilinear(uint32_t(max_lod), uvw);
+
+    uint32_t mip = uint32_t(lod);
+    float    t   = lod - float(mip);
+
+    if (t == 0.0f)
+        return sample_trilinear(mip, uvw);
+
+    return glm::mix(sample_trilinear(mip, uvw), sample_trilinear(mip + 1, uvw), t);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec4 ReferenceVolume::sample_trilinear(uint32_t mip, const glm::vec3& uvw) const
+{
+    int32_t   size   = int32_t(std::max(m_size >> mip, 1u));
+    glm::vec3 coord  = uvw * float(size) - 0.5f;
+    glm::vec3 base   = glm::floor(coord);
+    glm::vec3 weight = coord - base;
+
+    const std::vector<glm::vec4>& texels = m_mips[mip];
+
+    int32_t x0 = wrap(int32_t(base.x), size), x1 = wrap(int32_t(base.x) + 1, size);
+    int32_t y0 = wrap(int32_t(base.y), size), y1 = wrap(int32_t(base.y) + 1, size);
+    int32_t z0 = wrap(int32_t(base.z), size), z1 = wrap(int32_t(base.z) + 1, size);
+
+    auto texel = [&](int32_t x, int32_t y, int32_t z) { return texels[(size_t(z) * size + y) * size + x]; };
+
+    glm::vec4 c00 = glm::mix(texel(x0, y0, z0), texel(x1, y0, z0), weight.x);
+    glm::vec4 c10 = glm::mix(texel(x0, y1, z0), texel(x1, y1, z0), weight.x);
+    glm::vec4 c01 = glm::mix(texel(x0, y0, z1), texel(x1, y0, z1), weight.x);
+    glm::vec4 c11 = glm::mix(texel(x0, y1, z1), texel(x1, y1, z1), weight.x);
+
+    return glm::mix(glm::mix(c00, c10, weight.y), glm::mix(c01, c11, weight.y), weight.z);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool ReferenceTexture::load(const std::string& path)
+{
+    Image image;
+
+    if (!load_png(path, image))
+        return false;
+
+    m_width  = image.width;
+    m_height = image.height;
+    m_texels.resize(size_t(m_width) * m_height);
+
+    for (size_t i = 0; i < m_texels.size(); i++)
+    {
+        glm::vec4 texel = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+
+        for (uint32_t c = 0; c < image.channels; c++)
+            texel[c] = float(image.data[i * image.channels + c]) / 255.0f;
+
+        m_texels[i] = texel;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec4 ReferenceTexture::fetch(int32_t x, int32_t y) const
+{
+    return m_texels[size_t(wrap(y, int32_t(m_height))) * m_width + wrap(x, int32_t(m_width))];
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec4 ReferenceTexture::sample_bilinear(const glm::vec2& uv) const
+{
+    glm::vec2 coord  = uv * glm::vec2(float(m_width), float(m_height)) - 0.5f;
+    glm::vec2 base   = glm::floor(coord);
+    glm::vec2 weight = coord - base;
+
+    int32_t x = int32_t(base.x);
+    int32_t y = int32_t(base.y);
+
+    return glm::mix(glm::mix(fetch(x, y), fetch(x + 1, y), weight.x), glm::mix(fetch(x, y + 1), fetch(x + 1, y + 1), weight.x), weight.y);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void ReferenceMipTexture::create(const std::vector<std::vector<float>>& mips, uint32_t size)
+{
+    m_size = size;
+    m_mips = mips;
+
+    for (std::vector<float>& mip : m_mips)
+    {
+        for (float& value : mip)
+            value = cpu_noise_half_to_float(cpu_noise_float_to_half(value));
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float ReferenceMipTexture::sample_lod(const glm::vec2& uv, float lod) const
+{
+    // As ReferenceVolume::sample_lod().
+    if (lod <= 0.0f)
+        return sample_bilinear(0, uv);
+
+    float max_lod = float(m_mips.size() - 1);
+
+    if (lod >= max_lod)
+        return sample_bilinear(uint32_t(max_lod), uv);
+
+    uint32_t mip = uint32_t(lod);
+    float    t   = lod - float(mip);
+
+    if (t == 0.0f)
+        return sample_bilinear(mip, uv);
+
+    return glm::mix(sample_bilinear(mip, uv), sample_bilinear(mip + 1, uv), t);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float ReferenceMipTexture::sample_bilinear(uint32_t mip, const glm::vec2& uv) const
+{
+    int32_t   size   = int32_t(std::max(m_size >> mip, 1u));
+    glm::vec2 coord  = uv * float(size) - 0.5f;
+    glm::vec2 base   = glm::floor(coord);
+    glm::vec2 weight = coord - base;
+
+    const std::vector<float>& texels = m_mips[mip];
+
+    int32_t x0 = wrap(int32_t(base.x), size), x1 = wrap(int32_t(base.x) + 1, size);
+    int32_t y0 = wrap(int32_t(base.y), size), y1 = wrap(int32_t(base.y) + 1, size);
+
+    auto texel = [&](int32_t x, int32_t y) { return texels[size_t(y) * size + x]; };
+
+    return glm::mix(glm::mix(texel(x0, y0), texel(x1, y0), weight.x), glm::mix(texel(x0, y1), texel(x1, y1), weight.x), weight.y);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool CloudReference::initialize(const std::string& texture_dir, const CloudParameters& params, uint32_t shape_size, uint32_t detail_size)
+{
+    if (!m_blue_noise.load(texture_dir + "/LDR_LLL1_0.png"))
+        return false;
+
+    if (!m_curl_noise.load(texture_dir + "/curlNoise.png"))
+        return false;
+
+    m_shape_size  = shape_size;
+    m_detail_size = detail_size;
+
+    m_shape_texels.resize(size_t(shape_size) * shape_size * shape_size * 4);
+    m_detail_texels.resize(size_t(detail_size) * detail_size * detail_size * 4);
+
+    cpu_noise_generate(CPU_NOISE_VOLUME_SHAPE, shape_size, params.shape_noise_frequency, cpu_noise_best_backend(), 0, m_shape_texels.data());
+    cpu_noise_generate(CPU_NOISE_VOLUME_DETAIL, detail_size, params.detail_noise_frequency, cpu_noise_best_backend(), 0, m_detail_texels.data());
+
+    build_noise_volumes(params.noise_format);
+
+    std::vector<std::vector<float>> cirrus_mips;
+    cloud_cirrus_texture_generate(CLOUD_CIRRUS_TEXTURE_SIZE, CLOUD_CIRRUS_TEXTURE_FREQUENCY, cirrus_mips);
+    m_cirrus_noise.create(cirrus_mips, CLOUD_CIRRUS_TEXTURE_SIZE);
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void CloudReference::build_noise_volumes(NoiseFormat format)
+{
+    std::vector<float> shape;
+    std::vector<float> detail;
+
+    noise_format_pack(format, CPU_NOISE_VOLUME_SHAPE, m_shape_texels.data(), size_t(m_shape_size) * m_shape_size * m_shape_size, shape);
+    noise_format_pack(format, CPU_NOISE_VOLUME_DETAIL, m_detail_texels.data(), size_t(m_detail_size) * m_detail_size * m_detail_size, detail);
+
+    uint32_t shape_channels = noise_format_channels(format, CPU_NOISE_VOLUME_SHAPE);
+
+    m_shape_noise.create(shape.data(), m_shape_size, shape_channels, format);
+    m_detail_noise.create(detail.data(), m_detail_size, noise_format_channels(format, CPU_NOISE_VOLUME_DETAIL), format);
+
+    // Built from the quantized texels, as the GPU build reads them from the texture.
+    for (float& value : shape)
+        value = noise_format_quantize(format, value);
+
+    empty_space_build_grid(shape.data(), m_shape_size, EMPTY_SPACE_CELL_SIZE, shape_channels, m_empty_space_grid);
+    m_empty_space_grid_size = m_shape_size / EMPTY_SPACE_CELL_SIZE;
+    m_coverage_bound        = *std::max_element(m_empty_space_grid.begin(), m_empty_space_grid.end());
+    m_noise_format          = format;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool CloudReference::load_weather_map(const std::string& path)
+{
+    WeatherMapFile file;
+
+    if (!file.open(path))
+        return false;
+
+    m_weather_header = file.header();
+    m_weather_tiles.resize(size_t(m_weather_header.tiles_x) * m_weather_header.tiles_y * WEATHER_TILE_BYTES);
+
+    for (uint32_t y = 0; y < m_weather_header.tiles_y; y++)
+    {
+        for (uint32_t x = 0; x < m_weather_header.tiles_x; x++)
+        {
+            if (!file.read_tile(glm::ivec2(x, y), &m_weather_tiles[(size_t(y) * m_weather_header.tiles_x + x) * WEATHER_TILE_BYTES]))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void CloudReference::set_parameters(const CloudParameters& params, const CloudCamera& camera, uint32_t width, uint32_t height)
+{
+    glm::mat4 view = glm::lookAt(camera.position, camera.position + camera.forward, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(camera.fov), float(width) / float(height), camera.near_plane, camera.far_plane);
+
+    m_inv_view_proj = glm::inverse(proj * view);
+    m_cam_pos       = camera.position;
+    m_cam_forward   = camera.forward;
+    m_far_plane     = camera.far_plane;
+    m_resolution    = glm::vec2(float(width), float(height));
+
+    float noise_scale = 0.00001f + params.shape_noise_scale * 0.0004f;
+
+    m_planet_center          = glm::vec3(0.0f, -params.planet_radius, 0.0f);
+    m_planet_radius          = params.planet_radius;
+    m_cloud_min_height       = params.cloud_min_height;
+    m_cloud_max_height       = params.cloud_max_height;
+    m_shape_noise_scale      = noise_scale;
+    m_detail_noise_scale     = noise_scale * params.detail_noise_scale;
+    m_detail_noise_modifier  = params.detail_noise_modifier;
+    m_turbulence_noise_scale = noise_scale * params.turbulence_noise_scale;
+    m_turbulence_amount      = params.turbulence_amount;
+    m_cloud_coverage         = params.cloud_coverage;
+    m_wind_direction         = glm::normalize(glm::vec3(cos(params.wind_angle), sin(params.wind_angle), 0.0f));
+    m_wind_speed             = params.wind_speed;
+    m_wind_shear_offset      = params.wind_shear_offset;
+    m_time                   = params.time;
+    m_max_num_steps          = float(params.max_num_steps);
+    m_light_step_length      = params.light_step_length;
+    m_light_cone_radius      = params.light_cone_radius;
+    m_sun_dir                = -glm::normalize(glm::vec3(0.0f, sin(params.sun_angle), cos(params.sun_angle)));
+    m_sun_color              = params.sun_color;
+    m_cloud_base_color       = params.cloud_base_color;
+    m_cloud_top_color        = params.cloud_top_color;
+    m_precipitation          = params.precipitation * 0.01f;
+    m_ambient_light_factor   = params.ambient_light_factor;
+    m_sun_light_factor       = params.sun_light_factor;
+    m_hg_forward             = params.henyey_greenstein_g_forward;
+    m_hg_backward            = params.henyey_greenstein_g_backward;
+    m_exposure               = params.exposure;
+    m_empty_space_skipping   = params.empty_space_skipping;
+
+    m_adaptive_march              = params.adaptive_march;
+    m_coarse_step_scale           = params.coarse_step_scale;
+    m_empty_samples_before_coarse = params.empty_samples_before_coarse;
+    m_transmittance_threshold     = params.transmittance_threshold;
+    m_light_volume                = params.light_volume;
+
+    m_sky_view_lut                = params.sky_view_lut;
+    m_depth_clipping              = params.depth_clipping;
+    m_density_lod                 = params.density_lod;
+    m_lod_pixel_angle             = 2.0f * tanf(glm::radians(camera.fov) * 0.5f) / float(height);
+    m_lod_bias                    = params.lod_bias;
+    m_lod_detail_distance         = params.lod_detail_distance;
+    m_lod_detail_opacity          = params.lod_detail_opacity;
+    m_lod_cone_scale              = params.lod_cone_scale;
+    m_cone_samples                = std::min(std::max(params.cone_samples, 1), NUM_CONE_SAMPLES);
+    m_use_detail_noise            = params.detail_noise;
+    m_ground_height               = params.ground_height;
+    m_ground_extent               = params.ground_extent;
+    m_weather_map                 = params.weather_map && !m_weather_tiles.empty();
+    m_min_coverage                = m_cloud_coverage;
+    m_cirrus_layers               = params.cirrus_layers;
+
+    if (m_cirrus_layers.size() > CLOUD_MAX_CIRRUS_LAYERS)
+        m_cirrus_layers.resize(CLOUD_MAX_CIRRUS_LAYERS);
+
+    if (params.noise_format != m_noise_format)
+        build_noise_volumes(params.noise_format);
+
+    // The window of resident tiles around the camera, as WeatherResidency::update().
+    if (m_weather_map)
+    {
+        m_weather_window_origin = weather_map_tile(m_weather_header, camera.position.x, camera.position.z) - glm::ivec2(WEATHER_WINDOW_TILES / 2);
+
+        for (int32_t y = 0; y < WEATHER_WINDOW_TILES; y++)
+        {
+            for (int32_t x = 0; x < WEATHER_WINDOW_TILES; x++)
+            {
+                glm::ivec2 tile = m_weather_window_origin + glm::ivec2(x, y);
+
+                if (tile.x >= 0 && tile.y >= 0 && tile.x < int32_t(m_weather_header.tiles_x) && tile.y < int32_t(m_weather_header.tiles_y))
+                    m_min_coverage = std::min(m_min_coverage, weather_map_min_coverage(&m_weather_tiles[(size_t(tile.y) * m_weather_header.tiles_x + tile.x) * WEATHER_TILE_BYTES]));
+            }
+        }
+    }
+
+    if (m_light_volume)
+        build_light_volume();
+
+    if (m_sky_view_lut)
+        sky_view_lut_build(m_sun_dir, SKY_TURBIDITY, m_sky_view_lut_texels);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+CloudReference::Ray CloudReference::generate_ray(const glm::vec2& tex_coord) const
+{
+    glm::vec2 tex_coord_neg_to_pos = tex_coord * 2.0f - 1.0f;
+    glm::vec4 target               = m_inv_view_proj * glm::vec4(tex_coord_neg_to_pos.x, tex_coord_neg_to_pos.y, 0.0f, 1.0f);
+    target /= target.w;
+
+    Ray ray;
+
+    ray.origin    = m_cam_pos;
+    ray.direction = glm::normalize(glm::vec3(target.x, target.y, target.z) - ray.origin);
+
+    return ray;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec3 CloudReference::ray_sphere_intersection(const Ray& ray, const glm::vec3& sphere_center, float sphere_radius) const
+{
+    glm::vec3 l = ray.origin - sphere_center;
+    float     a = 1.0f;
+    float     b = 2.0f * glm::dot(ray.direction, l);
+    float     c = glm::dot(l, l) - sphere_radius * sphere_radius;
+    float     D = b * b - 4.0f * a * c;
+
+    if (D < 0.0f)
+        return ray.origin;
+    else if (fabsf(D) - 0.00005f <= 0.0f)
+        return ray.origin + ray.direction * (-0.5f * b / a);
+    else
+    {
+        float q = 0.0f;
+
+        if (b > 0.0f)
+            q = -0.5f * (b + sqrtf(D));
+        else
+            q = -0.5f * (b - sqrtf(D));
+
+        float h1 = q / a;
+        float h2 = c / q;
+        float t  = std::min(h1, h2);
+
+        if (t < 0.0f)
+        {
+            t = std::max(h1, h2);
+
+            if (t < 0.0f)
+                return ray.origin;
+        }
+
+        return ray.origin + t * ray.direction;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float CloudReference::scene_distance(const Ray& ray) const
+{
+    // The scene is the ground plane of the sample, a square at m_ground_height clipped by the far plane like the depth buffer.
+    if (ray.direction.y == 0.0f)
+        return 1e30f;
+
+    float t = (m_ground_height - ray.origin.y) / ray.direction.y;
+
+    if (t <= 0.0f || t * glm::dot(ray.direction, m_cam_forward) > m_far_plane)
+        return 1e30f;
+
+    glm::vec3 position = ray.origin + ray.direction * t;
+
+    if (fabsf(position.x) > m_ground_extent || fabsf(position.z) > m_ground_extent)
+        return 1e30f;
+
+    return t;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float CloudReference::blue_noise(const glm::vec2& pixel) const
+{
+    // The shader samples texel centers, so this is an exact fetch.
+    return m_blue_noise.fetch(int32_t(pixel.x), int32_t(pixel.y)).r * 2.0f - 1.0f;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float CloudReference::height_fraction_for_point(const glm::vec3& position) const
+{
+    return glm::clamp((glm::distance(position, m_planet_center) - (m_planet_radius + m_cloud_min_height)) / (m_cloud_max_height - m_cloud_min_height), 0.0f, 1.0f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+Weather CloudReference::sample_weather(const glm::vec3& position) const
+{
+    Weather weather = { m_cloud_coverage, 1.0f, 0.0f };
+
+    if (!m_weather_map)
+        return weather;
+
+    glm::vec2  texel = (glm::vec2(position.x, position.z) - glm::vec2(m_weather_header.origin_x, m_weather_header.origin_z)) / m_weather_header.texel_size;
+    glm::ivec2 tile  = glm::ivec2(glm::floor(texel / float(WEATHER_TILE_SIZE)));
+    glm::ivec2 cell  = tile - m_weather_window_origin;
+
+    if (cell.x < 0 || cell.y < 0 || cell.x >= WEATHER_WINDOW_TILES || cell.y >= WEATHER_WINDOW_TILES)
+        return weather;
+
+    if (tile.x < 0 || tile.y < 0 || tile.x >= int32_t(m_weather_header.tiles_x) || tile.y >= int32_t(m_weather_header.tiles_y))
+        return weather;
+
+    Weather map  = weather_map_sample_tile(&m_weather_tiles[(size_t(tile.y) * m_weather_header.tiles_x + tile.x) * WEATHER_TILE_BYTES], texel - glm::vec2(tile * WEATHER_TILE_SIZE));
+    float   fade = weather_map_window_fade(texel - glm::vec2(m_weather_window_origin * WEATHER_TILE_SIZE));
+
+    weather.coverage += (map.coverage - weather.coverage) * fade;
+    weather.cloud_type += (map.cloud_type - weather.cloud_type) * fade;
+    weather.precipitation += (map.precipitation - weather.precipitation) * fade;
+
+    return weather;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float CloudReference::sample_cloud_density(glm::vec3 position, float height_fraction, const glm::vec2& lod, int32_t detail, CloudReferenceStats& stats) const
+{
+    stats.density_samples++;
+
+    if (!m_use_detail_noise)
+        detail = std::min(detail, DENSITY_DETAIL_MEAN);
+
+    // The weather map is fixed in the world, only the cloud shapes move with the wind.
+    Weather weather = sample_weather(position);
+
+    // Shear cloud top along wind direction.
+    position += m_wind_direction * m_wind_shear_offset * height_fraction;
+
+    // Animate clouds in wind direction and add a small upward bias to the wind direction.
+    position += (m_wind_direction + glm::vec3(0.0f, 0.1f, 0.0f)) * m_wind_speed * m_time;
+
+    glm::vec4 low_frequency_noises = m_shape_noise.sample_lod(position * m_shape_noise_scale, lod.x);
+    float     base_cloud           = low_frequency_noises.r;
+
+    if (!noise_format_folded(m_noise_format))
+    {
+        float low_freq_fbm = (low_frequency_noises.g * 0.625f) + (low_frequency_noises.b * 0.25f) + (low_frequency_noises.a * 0.125f);
+
+        base_cloud = remap(low_frequency_noises.r, (1.0f - low_freq_fbm), 1.0f, 0.0f, 1.0f);
+    }
+
+    base_cloud *= density_height_gradient_for_point(height_fraction, weather.cloud_type);
+
+    float base_cloud_with_coverage = remap(base_cloud, weather.coverage, 1.0f, 0.0f, 1.0f);
+
+    base_cloud_with_coverage *= weather.coverage;
+
+    if (base_cloud_with_coverage <= 0.0f)
+        return 0.0f;
+
+    float final_cloud = base_cloud_with_coverage;
+
+    if (detail != DENSITY_DETAIL_NONE)
+    {
+        float high_freq_fbm = DETAIL_NOISE_MEAN_FBM;
+
+        if (detail == DENSITY_DETAIL_FULL)
+        {
+            stats.detail_samples++;
+
+            glm::vec4 curl_noise = m_curl_noise.sample_bilinear(glm::vec2(position.x, position.z) * m_turbulence_noise_scale);
+
+            position.x += curl_noise.r * (1.0f - height_fraction) * m_turbulence_amount;
+            position.y += curl_noise.g * (1.0f - height_fraction) * m_turbulence_amount;
+
+            glm::vec4 high_frequency_noises = m_detail_noise.sample_lod(position * m_detail_noise_scale, lod.y);
+
+            high_freq_fbm = noise_format_folded(m_noise_format) ? high_frequency_noises.r : noise_detail_fbm(&high_frequency_noises.x);
+        }
+
+        float high_freq_noise_modifier = glm::mix(1.0f - high_freq_fbm, high_freq_fbm, glm::clamp(height_fraction * 10.0f, 0.0f, 1.0f));
+
+        final_cloud = remap(base_cloud_with_coverage, high_freq_noise_modifier * m_detail_noise_modifier, 1.0f, 0.0f, 1.0f);
+    }
+
+    // Raining clouds are denser, darker and more opaque.
+    return glm::clamp(final_cloud, 0.0f, 1.0f) * (1.0f + weather.precipitation * WEATHER_PRECIPITATION_DENSITY);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec2 CloudReference::density_lod(const glm::vec3& position, float step_size) const
+{
+    if (!m_density_lod)
+        return glm::vec2(0.0f);
+
+    float     footprint = std::max(glm::distance(position, m_cam_pos) * m_lod_pixel_angle, step_size);
+    glm::vec2 texel     = 1.0f / glm::vec2(m_shape_noise_scale * float(m_shape_noise.size()), m_detail_noise_scale * float(m_detail_noise.size()));
+
+    glm::vec2 lod       = glm::vec2(std::max(log2f(footprint / texel.x) + m_lod_bias, 0.0f), std::max(log2f(footprint / texel.y) + m_lod_bias, 0.0f));
+
+    // Coarser shape mips average texels the empty space grid does not bound.
+    if (m_empty_space_skipping)
+        lod.x = std::min(lod.x, EMPTY_SPACE_MAX_SHAPE_LOD);
+
+    return lod;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+int32_t CloudReference::density_detail(const glm::vec3& position, float alpha) const
+{
+    if (!m_density_lod || (alpha < m_lod_detail_opacity && glm::distance(position, m_cam_pos) < m_lod_detail_distance))
+        return DENSITY_DETAIL_FULL;
+
+    return DENSITY_DETAIL_MEAN;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float CloudReference::empty_space_distance(const glm::vec3& position, const glm::vec3& ray_direction, float height_fraction, CloudReferenceStats& stats) const
+{
+    stats.grid_lookups++;
+
+    float grid_size = float(m_empty_space_grid_size);
+
+    glm::vec3 p = position + m_wind_direction * m_wind_shear_offset * height_fraction;
+    p += (m_wind_direction + glm::vec3(0.0f, 0.1f, 0.0f)) * m_wind_speed * m_time;
+
+    glm::vec3 grid_pos = glm::fract(p * m_shape_noise_scale) * grid_size;
+    glm::vec3 cell     = glm::min(glm::floor(grid_pos), glm::vec3(grid_size - 1.0f));
+
+    size_t index = (size_t(cell.z) * m_empty_space_grid_size + size_t(cell.y)) * m_empty_space_grid_size + size_t(cell.x);
+
+    if (m_empty_space_grid[index] > m_min_coverage)
+        return 0.0f;
+
+    float     height_rate = glm::dot(ray_direction, glm::normalize(position - m_planet_center)) / (m_cloud_max_height - m_cloud_min_height);
+    glm::vec3 direction   = (ray_direction + m_wind_direction * m_wind_shear_offset * height_rate) * m_shape_noise_scale * grid_size;
+
+    float t = 1e30f;
+
+    for (int i = 0; i < 3; i++)
+    {
+        float distance = direction[i] >= 0.0f ? cell[i] + 1.0f - grid_pos[i] : grid_pos[i] - cell[i];
+        t              = std::min(t, distance / std::max(fabsf(direction[i]), 1e-6f));
+    }
+
+    return t;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float CloudReference::sample_cloud_density_along_cone(glm::vec3 position, const glm::vec3& light_dir, float lod_offset, CloudReferenceStats& stats) const
+{
+    static const glm::vec3 kNoiseKernel[NUM_CONE_SAMPLES] = {
+        glm::vec3(-0.6f, -0.8f, -0.2f),
+        glm::vec3(1.0f, -0.3f, 0.0f),
+        glm::vec3(-0.7f, 0.0f, 0.7f),
+        glm::vec3(-0.2f, 0.6f, -0.8f),
+        glm::vec3(0.4f, 0.3f, 0.9f),
+        glm::vec3(-0.2f, 0.6f, -0.8f)
+    };
+
+    float density_along_cone = 0.0f;
+
+    stats.cone_samples += m_cone_samples + 1;
+
+    for (int i = 0; i < m_cone_samples; i++)
+    {
+        position += light_dir * m_light_step_length;
+
+        glm::vec3 random_offset = kNoiseKernel[i] * m_light_step_length * m_light_cone_radius * float(i + 1);
+        glm::vec3 p             = position + random_offset;
+
+        int32_t detail = i < 2 ? (float(i) < 2.0f - lod_offset ? DENSITY_DETAIL_FULL : DENSITY_DETAIL_MEAN) : DENSITY_DETAIL_NONE;
+
+        density_along_cone += sample_cloud_density(p, height_fraction_for_point(p), glm::vec2(float(i) * 0.5f + lod_offset), detail, stats);
+    }
+
+    // One more sample further away to account for shadows from distant clouds.
+    position += 32.0f * m_light_step_length * light_dir;
+
+    density_along_cone += sample_cloud_density(position, height_fraction_for_point(position), glm::vec2(2.0f + lod_offset), DENSITY_DETAIL_NONE, stats) * 3.0f;
+
+    return density_along_cone;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void CloudReference::build_light_volume()
+{
+    m_light_volume_origin = m_cam_pos;
+    m_light_volume_extent = light_volume_extent(m_cam_pos, m_planet_center, m_planet_radius, m_cloud_max_height);
+
+    m_light_volume_texels.resize(size_t(LIGHT_VOLUME_SIZE) * LIGHT_VOLUME_SIZE * LIGHT_VOLUME_HEIGHT);
+
+    // light_volume_cs.glsl is built without the defines of the quality tiers, so it always takes every cone sample in full detail.
+    int32_t cone_samples = m_cone_samples;
+    bool    detail_noise = m_use_detail_noise;
+
+    m_cone_samples     = NUM_CONE_SAMPLES;
+    m_use_detail_noise = true;
+
+    // One height slice per job, as the compute shader builds them.
+    SliceScheduler::run(LIGHT_VOLUME_HEIGHT, 0, [this](uint32_t z, uint32_t) {
+        CloudReferenceStats stats;
+
+        for (int32_t y = 0; y < LIGHT_VOLUME_SIZE; y++)
+        {
+            for (int32_t x = 0; x < LIGHT_VOLUME_SIZE; x++)
+            {
+                glm::vec3 position     = light_volume_texel_position(glm::ivec3(x, y, int32_t(z)), m_light_volume_origin, m_light_volume_extent, m_planet_center, m_planet_radius, m_cloud_min_height, m_cloud_max_height);
+                float     cone_density = sample_cloud_density_along_cone(position, m_sun_dir, 0.0f, stats);
+
+                m_light_volume_texels[(size_t(z) * LIGHT_VOLUME_SIZE + size_t(y)) * LIGHT_VOLUME_SIZE + size_t(x)] = cpu_noise_half_to_float(cpu_noise_float_to_half(cone_density));
+            }
+        }
+    });
+
+    m_cone_samples     = cone_samples;
+    m_use_detail_noise = detail_noise;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float CloudReference::sample_light_volume(const glm::vec3& position) const
+{
+    glm::vec3 uvw = glm::vec3((position.x - m_light_volume_origin.x) / m_light_volume_extent + 0.5f,
+                              (position.z - m_light_volume_origin.z) / m_light_volume_extent + 0.5f,
+                              height_fraction_for_point(position));
+
+    // Trilinear filtering with GL_CLAMP_TO_EDGE.
+    glm::ivec3 size   = glm::ivec3(LIGHT_VOLUME_SIZE, LIGHT_VOLUME_SIZE, LIGHT_VOLUME_HEIGHT);
+    glm::vec3  coord  = uvw * glm::vec3(size) - 0.5f;
+    glm::vec3  base   = glm::floor(coord);
+    glm::vec3  weight = coord - base;
+    glm::ivec3 c0     = glm::clamp(glm::ivec3(base), glm::ivec3(0), size - 1);
+    glm::ivec3 c1     = glm::clamp(glm::ivec3(base) + 1, glm::ivec3(0), size - 1);
+
+    auto fetch = [&](int32_t x, int32_t y, int32_t z) {
+        return m_light_volume_texels[(size_t(z) * LIGHT_VOLUME_SIZE + size_t(y)) * LIGHT_VOLUME_SIZE + size_t(x)];
+    };
+
+    float v00 = glm::mix(fetch(c0.x, c0.y, c0.z), fetch(c1.x, c0.y, c0.z), weight.x);
+    float v10 = glm::mix(fetch(c0.x, c1.y, c0.z), fetch(c1.x, c1.y, c0.z), weight.x);
+    float v01 = glm::mix(fetch(c0.x, c0.y, c1.z), fetch(c1.x, c0.y, c1.z), weight.x);
+    float v11 = glm::mix(fetch(c0.x, c1.y, c1.z), fetch(c1.x, c1.y, c1.z), weight.x);
+
+    return glm::mix(glm::mix(v00, v10, weight.y), glm::mix(v01, v11, weight.y), weight.z);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float CloudReference::sun_cone_density(const glm::vec3& position, float accum_transmittance, CloudReferenceStats& stats) const
+{
+    if (m_light_volume)
+    {
+        stats.light_volume_fetches++;
+        return sample_light_volume(position);
+    }
+
+    float lod_offset = m_density_lod ? (1.0f - accum_transmittance) * m_lod_cone_scale : 0.0f;
+
+    return sample_cloud_density_along_cone(position, m_sun_dir, lod_offset, stats);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static float henyey_greenstein_phase(float cos_angle, float g)
+{
+    float g2 = g * g;
+    return ((1.0f - g2) / powf(1.0f + g2 - 2.0f * g * cos_angle, 1.5f)) / 4.0f * 3.1415f;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float CloudReference::calculate_light_energy(float density, float cos_angle, float powder_density) const
+{
+    float d           = -density * m_precipitation;
+    float beer        = std::max(expf(d), expf(d * 0.5f) * 0.7f);
+    float powder      = glm::mix(1.0f, 1.0f - expf(-powder_density * 2.0f), glm::clamp((-cos_angle * 0.5f) + 0.5f, 0.0f, 1.0f));
+    float beer_powder = 2.0f * beer * powder;
+    float HG          = std::max(henyey_greenstein_phase(cos_angle, m_hg_forward), henyey_greenstein_phase(cos_angle, m_hg_backward)) * 0.07f + 0.8f;
+
+    return beer_powder * HG;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec4 CloudReference::ray_march(glm::vec3 ray_origin, const glm::vec3& ray_direction, float cos_angle, float step_size, float num_steps, CloudReferenceStats& stats) const
+{
+    glm::vec3 position            = ray_origin;
+    float     step_increment      = 1.0f;
+    float     accum_transmittance = 1.0f;
+    glm::vec3 accum_scattering    = glm::vec3(0.0f);
+    float     alpha               = 0.0f;
+
+    for (float i = 0.0f; i < num_steps; i += step_increment)
+    {
+        float height_fraction = height_fraction_for_point(position);
+
+        if (m_empty_space_skipping)
+        {
+            float empty_distance = empty_space_distance(position, ray_direction, height_fraction, stats);
+
+            if (empty_distance > 0.0f)
+            {
+                float num_skipped = std::max(ceilf(empty_distance / step_size), 1.0f);
+
+                stats.skipped_samples += uint64_t(std::min(num_skipped, ceilf(num_steps - i)));
+
+                if (m_verify_empty_space)
+                {
+                    CloudReferenceStats verify_stats;
+
+                    for (float j = 0.0f; j < num_skipped && i + j < num_steps; j += 1.0f)
+                    {
+                        glm::vec3 p = position + ray_direction * step_size * j;
+
+                        if (sample_cloud_density(p, height_fraction_for_point(p), density_lod(p, step_size), density_detail(p, alpha), verify_stats) > 0.0f)
+                            stats.skip_violations++;
+                    }
+                }
+
+                for (float j = 0.0f; j < num_skipped; j += step_increment)
+                    position += ray_direction * step_size * step_increment;
+
+                i += num_skipped - step_increment;
+                continue;
+            }
+        }
+
+        float density            = sample_cloud_density(position, height_fraction, density_lod(position, step_size), density_detail(position, alpha), stats);
+        float step_transmittance = expf(-(density * step_size) * m_precipitation);
+
+        accum_transmittance *= step_transmittance;
+
+        if (density > 0.0f)
+        {
+            alpha += (1.0f - step_transmittance) * (1.0f - alpha);
+
+            float cone_density = sun_cone_density(position, accum_transmittance, stats);
+
+            glm::vec3 in_scattered_light = calculate_light_energy(cone_density * step_size, cos_angle, density * step_size) * m_sun_color * m_sun_light_factor * alpha;
+            glm::vec3 ambient_light      = glm::mix(m_cloud_base_color, m_cloud_top_color, height_fraction) * m_ambient_light_factor;
+
+            accum_scattering += (ambient_light + in_scattered_light) * accum_transmittance * density;
+        }
+
+        position += ray_direction * step_size * step_increment;
+    }
+
+    return glm::vec4(accum_scattering, alpha);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint64_t CloudReference::count_dense_samples(const glm::vec3& ray_origin, const glm::vec3& ray_direction, float begin, float end, float step_size, float alpha) const
+{
+    CloudReferenceStats verify_stats;
+    uint64_t            count = 0;
+
+    // Fine samples strictly between the two distances, spaced from 'end' as the fine march would have reached it.
+    for (float t = end - step_size; t > begin; t -= step_size)
+    {
+        glm::vec3 p = ray_origin + ray_direction * t;
+
+        if (sample_cloud_density(p, height_fraction_for_point(p), density_lod(p, step_size), density_detail(p, alpha), verify_stats) > 0.0f)
+            count++;
+    }
+
+    return count;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec4 CloudReference::ray_march_adaptive(const glm::vec3& ray_origin, const glm::vec3& ray_direction, float cos_angle, float step_size, float num_steps, CloudReferenceStats& stats) const
+{
+    float     ray_length          = step_size * num_steps;
+    float     coarse_step_size    = step_size * m_coarse_step_scale;
+    float     t                   = 0.0f;
+    float     coarse_start        = 0.0f;
+    float     coarse_hit          = 0.0f;
+    float     coarse_empty        = 0.0f; // Up to here the coarse march found no density, by a sample or through the empty space grid.
+    bool      coarse              = true;
+    bool      saturated           = false;
+    int32_t   num_empty_samples   = 0;
+    float     accum_transmittance = 1.0f;
+    glm::vec3 accum_scattering    = glm::vec3(0.0f);
+    float     alpha               = 0.0f;
+
+    for (float i = 0.0f; i < num_steps * 2.0f && t < ray_length; i += 1.0f)
+    {
+        glm::vec3 position        = ray_origin + ray_direction * t;
+        float     height_fraction = height_fraction_for_point(position);
+
+        if (coarse)
+        {
+            if (m_empty_space_skipping)
+            {
+                float empty_distance = empty_space_distance(position, ray_direction, height_fraction, stats);
+
+                if (empty_distance > 0.0f)
+                {
+                    t += empty_distance + step_size * 0.001f;
+                    coarse_empty = t;
+                    continue;
+                }
+            }
+
+            if (sample_cloud_density(position, height_fraction, density_lod(position, step_size), DENSITY_DETAIL_NONE, stats) > 0.0f)
+            {
+                coarse_hit        = t;
+                t                 = std::max(t - coarse_step_size, coarse_start);
+                coarse            = false;
+                num_empty_samples = 0;
+
+                // The fine march resumes at t, so every fine sample between the last empty point and t is skipped.
+                if (m_verify_adaptive_march)
+                    stats.backup_violations += count_dense_samples(ray_origin, ray_direction, coarse_empty, t, step_size, alpha);
+            }
+            else
+            {
+                coarse_empty = t;
+                t += coarse_step_size;
+            }
+
+            continue;
+        }
+
+        float density            = sample_cloud_density(position, height_fraction, density_lod(position, step_size), density_detail(position, alpha), stats);
+        float step_transmittance = expf(-(density * step_size) * m_precipitation);
+
+        accum_transmittance *= step_transmittance;
+
+        if (density > 0.0f)
+        {
+            alpha += (1.0f - step_transmittance) * (1.0f - alpha);
+
+            float cone_density = sun_cone_density(position, accum_transmittance, stats);
+
+            glm::vec3 in_scattered_light = calculate_light_energy(cone_density * step_size, cos_angle, density * step_size) * m_sun_color * m_sun_light_factor * alpha;
+            glm::vec3 ambient_light      = glm::mix(m_cloud_base_color, m_cloud_top_color, height_fraction) * m_ambient_light_factor;
+
+            accum_scattering += (ambient_light + in_scattered_light) * accum_transmittance * density;
+
+            num_empty_samples = 0;
+
+            if (accum_transmittance < m_transmittance_threshold)
+            {
+                saturated = true;
+                break;
+            }
+        }
+        else if (++num_empty_samples >= m_empty_samples_before_coarse && t >= coarse_hit)
+        {
+            coarse       = true;
+            coarse_start = t + step_size;
+            coarse_empty = t;
+        }
+
+        t += step_size;
+    }
+
+    // Running out of iterations before reaching the coarse hit would skip the fine samples left up to it.
+    if (m_verify_adaptive_march && !coarse && !saturated && t < coarse_hit)
+        stats.backup_violations += count_dense_samples(ray_origin, ray_direction, t - step_size, std::min(coarse_hit, ray_length), step_size, alpha);
+
+    return glm::vec4(accum_scattering, alpha);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec4 CloudReference::shade_cirrus_layer(uint32_t layer, const glm::vec3& position, float distance, float cos_angle, CloudReferenceStats& stats) const
+{
+    const CloudLayer& cirrus = m_cirrus_layers[layer];
+
+    stats.cirrus_samples++;
+
+    glm::vec2 uv = (glm::vec2(position.x, position.z) + glm::vec2(m_wind_direction.x, m_wind_direction.z) * m_wind_speed * m_time) / cirrus.scale * glm::vec2(1.0f / CIRRUS_STRETCH, 1.0f);
+
+    glm::vec4 curl = m_curl_noise.sample_bilinear(uv * CIRRUS_CURL_SCALE);
+
+    uv += (glm::vec2(curl.r, curl.g) - 0.5f) * CIRRUS_CURL_AMOUNT;
+
+    uv += float(layer) * CIRRUS_LAYER_OFFSET;
+
+    float lod   = std::max(log2f(distance * m_lod_pixel_angle * float(m_cirrus_noise.size()) / cirrus.scale), 0.0f);
+    float noise = m_cirrus_noise.sample_lod(uv, lod);
+    float alpha = glm::clamp(remap(noise, 1.0f - cirrus.coverage, 1.0f, 0.0f, 1.0f), 0.0f, 1.0f) * cirrus.opacity;
+
+    float     HG    = std::max(henyey_greenstein_phase(cos_angle, m_hg_forward), henyey_greenstein_phase(cos_angle, m_hg_backward)) * 0.07f + 0.8f;
+    glm::vec3 light = m_sun_color * m_sun_light_factor * HG + m_cloud_top_color * m_ambient_light_factor;
+
+    return glm::vec4(light * alpha, alpha);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec4 CloudReference::composite_cloud_layers(const Ray& ray, const glm::vec4& clouds, float clouds_distance, float geometry_distance, CloudReferenceStats& stats) const
+{
+    if (m_cirrus_layers.empty())
+        return clouds;
+
+    // -1 stands for the volumetric layer.
+    std::pair<float, int32_t> layers[CLOUD_MAX_LAYERS];
+    uint32_t                  count = 0;
+
+    layers[count++] = std::make_pair(clouds_distance, -1);
+
+    for (uint32_t i = 0; i < m_cirrus_layers.size(); i++)
+    {
+        float d = cloud_layer_distance(ray.origin, ray.direction, m_planet_center, m_planet_radius + m_cirrus_layers[i].min_height);
+
+        if (d >= 0.0f && d < geometry_distance)
+            layers[count++] = std::make_pair(d, int32_t(i));
+    }
+
+    // Stable, as the insertion sort of the shader.
+    std::stable_sort(layers, layers + count, [](const std::pair<float, int32_t>& a, const std::pair<float, int32_t>& b) { return a.first < b.first; });
+
+    float     cos_angle = glm::dot(ray.direction, m_sun_dir);
+    glm::vec4 result    = glm::vec4(0.0f);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        glm::vec4 layer = layers[i].second < 0 ? clouds : shade_cirrus_layer(uint32_t(layers[i].second), ray.origin + ray.direction * layers[i].first, layers[i].first, cos_angle, stats);
+
+        result += (1.0f - result.w) * layer;
+    }
+
+    return result;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec3 CloudReference::shade_pixel(uint32_t x, uint32_t y, CloudReferenceStats& stats) const
+{
+    stats.rays++;
+
+    glm::vec2 pixel     = glm::vec2(float(x), float(y));
+    glm::vec2 tex_coord = (pixel + 0.5f) / m_resolution;
+
+    Ray ray = generate_ray(tex_coord);
+
+    glm::vec3 ray_start = ray_sphere_intersection(ray, m_planet_center, m_planet_radius + m_cloud_min_height);
+    glm::vec3 ray_end   = ray_sphere_intersection(ray, m_planet_center, m_planet_radius + m_cloud_max_height);
+
+    // Reject pixels whose scene geometry is in front of the cloud layer before any texture fetch.
+    float geometry_distance = scene_distance(ray);
+
+    if (m_depth_clipping && geometry_distance <= glm::length(ray_start - ray.origin))
+    {
+        stats.occluded_rays++;
+
+        glm::vec4 clouds = composite_cloud_layers(ray, glm::vec4(0.0f), 0.0f, geometry_distance, stats);
+
+        return glm::vec3(clouds.x, clouds.y, clouds.z);
+    }
+
+    float rng       = blue_noise(pixel);
+    float max_steps = m_max_num_steps;
+    float min_steps = (m_max_num_steps * 0.5f) + (rng * 2.0f);
+    float num_steps = glm::mix(max_steps, min_steps, ray.direction.y);
+    float step_size = glm::length(ray_start - ray_end) / num_steps;
+
+    ray_start += step_size * ray.direction * rng;
+
+    // End the march at the first opaque surface.
+    if (m_depth_clipping)
+        num_steps = std::min(num_steps, std::max(geometry_distance - glm::length(ray_start - ray.origin), 0.0f) / step_size);
+
+    float     cos_angle = glm::dot(ray.direction, m_sun_dir);
+    glm::vec4 clouds    = m_adaptive_march ? ray_march_adaptive(ray_start, ray.direction, cos_angle, step_size, num_steps, stats) : ray_march(ray_start, ray.direction, cos_angle, step_size, num_steps, stats);
+
+    clouds = composite_cloud_layers(ray, clouds, glm::length(ray_start - ray.origin), m_depth_clipping ? geometry_distance : 1e30f, stats);
+
+    // Geometry pixels hold the clouds over a black scene, as the cloud pass blends them premultiplied over the ground.
+    if (geometry_distance < 1e30f)
+        return glm::vec3(clouds.x, clouds.y, clouds.z);
+
+    glm::vec3 sky       = (m_sky_view_lut ? sky_view_lut_sample(m_sky_view_lut_texels, ray.direction) : calculate_sky_luminance_rgb(m_sun_dir, ray.direction, SKY_TURBIDITY)) * 0.05f;
+
+    return glm::vec3(clouds.x, clouds.y, clouds.z) + (1.0f - clouds.w) * sky;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool CloudReference::pixel_needs_march(uint32_t x, uint32_t y) const
+{
+    if (m_min_coverage >= m_coverage_bound)
+        return false;
+
+    glm::vec2 tex_coord = (glm::vec2(float(x), float(y)) + 0.5f) / m_resolution;
+
+    Ray ray = generate_ray(tex_coord);
+
+    glm::vec3 ray_start = ray_sphere_intersection(ray, m_planet_center, m_planet_radius + m_cloud_min_height);
+    glm::vec3 ray_end   = ray_sphere_intersection(ray, m_planet_center, m_planet_radius + m_cloud_max_height);
+
+    // Both intersections return the origin when the ray misses the shell.
+    if (ray_start == ray.origin && ray_end == ray.origin)
+        return false;
+
+    return !m_depth_clipping || scene_distance(ray) > glm::length(ray_start - ray.origin);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec3 CloudReference::shade_empty_pixel(uint32_t x, uint32_t y, CloudReferenceStats& stats) const
+{
+    stats.rays++;
+
+    glm::vec2 tex_coord = (glm::vec2(float(x), float(y)) + 0.5f) / m_resolution;
+
+    Ray ray = generate_ray(tex_coord);
+
+    // The cirrus layers are not marched, so they are shaded even where the volumetric layer is empty.
+    float     geometry_distance = scene_distance(ray);
+    glm::vec4 clouds            = composite_cloud_layers(ray, glm::vec4(0.0f), 0.0f, m_depth_clipping ? geometry_distance : 1e30f, stats);
+
+    if (geometry_distance < 1e30f)
+    {
+        if (m_depth_clipping)
+            stats.occluded_rays++;
+
+        return glm::vec3(clouds.x, clouds.y, clouds.z);
+    }
+
+    glm::vec3 sky = (m_sky_view_lut ? sky_view_lut_sample(m_sky_view_lut_texels, ray.direction) : calculate_sky_luminance_rgb(m_sun_dir, ray.direction, SKY_TURBIDITY)) * 0.05f;
+
+    return glm::vec3(clouds.x, clouds.y, clouds.z) + (1.0f - clouds.w) * sky;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec3 CloudReference::tonemap(const glm::vec3& color) const
+{
+    const float a = 2.51f;
+    const float b = 0.03f;
+    const float c = 2.43f;
+    const float d = 0.59f;
+    const float e = 0.14f;
+
+    glm::vec3 x = color * m_exposure;
+
+    return glm::clamp((x * (a * x + b)) / (x * (c * x + d) + e), 0.0f, 1.0f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static glm::vec3 perez_luminance_Yxy(float theta, float gamma, const glm::vec3& A, const glm::vec3& B, const glm::vec3& C, const glm::vec3& D, const glm::vec3& E)
+{
+    return (1.0f + A * glm::exp(B / cosf(theta))) * (1.0f + C * glm::exp(D * gamma) + E * cosf(gamma) * cosf(gamma));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec3 calculate_sky_luminance_rgb(const glm::vec3& s, const glm::vec3& e, float t)
+{
+    const float kPi = 3.14159265359f;
+
+    glm::vec3 A = glm::vec3(0.1787f * t - 1.4630f, -0.0193f * t - 0.2592f, -0.0167f * t - 0.2608f);
+    glm::vec3 B = glm::vec3(-0.3554f * t + 0.4275f, -0.0665f * t + 0.0008f, -0.0950f * t + 0.0092f);
+    glm::vec3 C = glm::vec3(-0.0227f * t + 5.3251f, -0.0004f * t + 0.2125f, -0.0079f * t + 0.2102f);
+    glm::vec3 D = glm::vec3(0.1206f * t - 2.5771f, -0.0641f * t - 0.8989f, -0.0441f * t - 1.6537f);
+    glm::vec3 E = glm::vec3(-0.0670f * t + 0.3703f, -0.0033f * t + 0.0452f, -0.0109f * t + 0.0529f);
+
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+
+    float thetaS = acosf(std::max(glm::dot(s, up), 0.0f));
+    float thetaE = acosf(std::max(glm::dot(e, up), 0.0f));
+    float gammaE = acosf(std::max(glm::dot(s, e), 0.0f));
+
+    // Zenith luminance.
+    float chi    = (4.0f / 9.0f - t / 120.0f) * (kPi - 2.0f * thetaS);
+    float Yz     = (4.0453f * t - 4.9710f) * tanf(chi) - 0.2155f * t + 2.4192f;
+    float theta2 = thetaS * thetaS;
+    float theta3 = theta2 * thetaS;
+    float T2     = t * t;
+
+    float xz = (0.00165f * theta3 - 0.00375f * theta2 + 0.00209f * thetaS + 0.0f) * T2 +
+               (-0.02903f * theta3 + 0.06377f * theta2 - 0.03202f * thetaS + 0.00394f) * t +
+               (0.11693f * theta3 - 0.21196f * theta2 + 0.06052f * thetaS + 0.25886f);
+
+    float yz = (0.00275f * theta3 - 0.00610f * theta2 + 0.00317f * thetaS + 0.0f) * T2 +
+               (-0.04214f * theta3 + 0.08970f * theta2 - 0.04153f * thetaS + 0.00516f) * t +
+               (0.15346f * theta3 - 0.26756f * theta2 + 0.06670f * thetaS + 0.26688f);
+
+    glm::vec3 fThetaGamma = perez_luminance_Yxy(thetaE, gammaE, A, B, C, D, E);
+    glm::vec3 fZeroThetaS = perez_luminance_Yxy(0.0f, thetaS, A, B, C, D, E);
+    glm::vec3 Yp          = glm::vec3(Yz, xz, yz) * (fThetaGamma / fZeroThetaS);
+
+    // Yxy to XYZ.
+    float X = Yp.y * (Yp.x / Yp.z);
+    float Y = Yp.x;
+    float Z = (1.0f - Yp.y - Yp.z) * (Yp.x / Yp.z);
+
+    // XYZ to RGB (CIE/E). The shader multiplies a row vector with a column-major matrix, so each channel is a dot product with a column.
+    return glm::vec3(2.3706743f * X - 0.9000405f * Y - 0.4706338f * Z,
+                     -0.5138850f * X + 1.4253036f * Y + 0.0885814f * Z,
+                     0.0052982f * X - 0.0146949f * Y + 1.0093968f * Z);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "cloud_layers.h"
+#include "noise_format.h"
+#include "weather_map.h"
+
+// C++ port of clouds_fs.glsl. Used by the reference renderer to produce golden images and a driver independent throughput number on
+// machines without a GPU. Any change to the cloud shader must be mirrored here.
+
+// Parameters of the cloud pass. Mirrors the VolumetricClouds members and their defaults, the derived uniforms (noise scales, sun
+// direction, ...) are computed the same way as in render_clouds().
+struct CloudParameters
+{
+    int32_t   max_num_steps                = 128;
+    float     cloud_min_height             = 1500.0f;
+    float     cloud_max_height             = 4000.0f;
+    float     shape_noise_scale            = 0.3f;
+    float     detail_noise_scale           = 5.5f;
+    float     detail_noise_modifier        = 0.5f;
+    float     turbulence_noise_scale       = 7.44f;
+    float     turbulence_amount            = 1.0f;
+    float     cloud_coverage               = 0.7f;
+    float     wind_angle                   = 0.0f;
+    float     wind_speed                   = 50.0f;
+    float     wind_shear_offset            = 500.0f;
+    float     planet_radius                = 35000.0f;
+    float     light_step_length            = 64.0f;
+    float     light_cone_radius            = 0.4f;
+    glm::vec3 sun_color                    = glm::vec3(1.0f, 1.0f, 1.0f);
+    glm::vec3 cloud_base_color             = glm::vec3(0.78f, 0.86f, 1.0f);
+    glm::vec3 cloud_top_color              = glm::vec3(1.0f);
+    float     precipitation                = 1.0f;
+    float     ambient_light_factor         = 0.12f;
+    float     sun_light_factor             = 1.0f;
+    float     henyey_greenstein_g_forward  = 0.4f;
+    float     henyey_greenstein_g_backward = 0.179f;
+    float     exposure                     = 0.6f;
+    float     shape_noise_frequency        = 4.0f;
+    float     detail_noise_frequency       = 8.0f;
+    float     sun_angle                    = -1.012291f; // -58 degrees
+    float     time                         = 0.0f;
+    bool      empty_space_skipping         = true;
+    bool      adaptive_march               = false;
+    float     coarse_step_scale            = 4.0f;
+    int32_t   empty_samples_before_coarse  = 6;
+    float     transmittance_threshold      = 0.01f;
+    bool      light_volume                 = false;
+    bool      sky_view_lut                 = false;
+    bool      depth_clipping               = true;
+    bool      tiled_march                  = false; // Read by the renderer, the shading does not depend on it.
+    bool      weather_map                  = false; // Needs CloudReference::load_weather_map().
+    NoiseFormat noise_format               = NOISE_FORMAT_RGBA16F;
+    bool      density_lod                  = false;
+    float     lod_bias                     = 0.0f;
+    float     lod_detail_distance          = 12000.0f;
+    float     lod_detail_opacity           = 0.95f;
+    float     lod_cone_scale               = 1.0f;
+    int32_t   cone_samples                 = 6;    // CLOUD_CONE_SAMPLES of the quality tiers, at most NUM_CONE_SAMPLES.
+    bool      detail_noise                 = true; // CLOUD_DETAIL_NOISE of the quality tiers.
+    float     ground_height                = 0.0f;
+    float     ground_extent                = 10000.0f; // Half the side of plane.obj.
+    std::vector<CloudLayer> cirrus_layers; // Above the volumetric shell, at most CLOUD_MAX_CIRRUS_LAYERS.
+};
+
+struct CloudCamera
+{
+    glm::vec3 position   = glm::vec3(0.0f, 5.0f, 0.0f);
+    glm::vec3 forward    = glm::vec3(-1.0f, 0.0f, 0.0f);
+    float     fov        = 60.0f;
+    float     near_plane = 1.0f;
+    float     far_plane  = 1000.0f;
+};
+
+// Per-thread counters, summed up by the caller.
+struct CloudReferenceStats
+{
+    uint64_t rays            = 0;
+    uint64_t density_samples = 0;
+    uint64_t detail_samples  = 0; // Each also fetches the curl noise.
+    uint64_t cone_samples    = 0; // Part of density_samples.
+    uint64_t grid_lookups    = 0;
+    uint64_t skipped_samples = 0;
+    uint64_t skip_violations = 0;
+    uint64_t cirrus_samples  = 0; // One curl and one cirrus noise fetch each.
+
+    uint64_t light_volume_fetches = 0;
+    uint64_t occluded_rays        = 0;
+    uint64_t backup_violations    = 0;
+
+    // Filled by the tiled march of the renderer.
+    uint64_t tiles         = 0;
+    uint64_t marched_tiles = 0;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Float volume of up to four channels with a full mip chain, quantized like the noise textures of 'format'. Missing channels read as
+// zero. Sampled with GL_REPEAT and GL_LINEAR_MIPMAP_LINEAR.
+class ReferenceVolume
+{
+public:
+    void      create(const float* texels, uint32_t size, uint32_t num_channels, NoiseFormat format);
+    glm::vec4 sample_lod(const glm::vec3& uvw, float lod) const;
+    uint32_t  size() const { return m_size; }
+
+private:
+    glm::vec4 sample_trilinear(uint32_t mip, const glm::vec3& uvw) const;
+
+private:
+    std::vector<std::vector<glm::vec4>> m_mips;
+    uint32_t                            m_size = 0;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// 8-bit unorm texture sampled with GL_REPEAT.
+class ReferenceTexture
+{
+public:
+    bool      load(const std::string& path);
+    glm::vec4 fetch(int32_t x, int32_t y) const;
+    glm::vec4 sample_bilinear(const glm::vec2& uv) const;
+    uint32_t  width() const { return m_width; }
+    uint32_t  height() const { return m_height; }
+
+private:
+    std::vector<glm::vec4> m_texels;
+    uint32_t               m_width  = 0;
+    uint32_t               m_height = 0;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Single channel texture with a full mip chain, quantized to half like a GL_R16F texture. Sampled with GL_REPEAT and
+// GL_LINEAR_MIPMAP_LINEAR.
+class ReferenceMipTexture
+{
+public:
+    void     create(const std::vector<std::vector<float>>& mips, uint32_t size);
+    float    sample_lod(const glm::vec2& uv, float lod) const;
+    uint32_t size() const { return m_size; }
+
+private:
+    float sample_bilinear(uint32_t mip, const glm::vec2& uv) const;
+
+private:
+    std::vector<std::vector<float>> m_mips;
+    uint32_t                        m_size = 0;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+class CloudReference
+{
+public:
+    // Loads the blue and curl noise textures from 'texture_dir' and generates the noise volumes on the CPU.
+    bool initialize(const std::string& texture_dir, const CloudParameters& params, uint32_t shape_size = 128, uint32_t detail_size = 32);
+
+    // Reads the whole weather map. Only the window of tiles around the camera is sampled, as if every tile of it was resident.
+    bool load_weather_map(const std::string& path);
+
+    void set_parameters(const CloudParameters& params, const CloudCamera& camera, uint32_t width, uint32_t height);
+
+    // Shades pixel (x, y) with the origin at the bottom left, as gl_FragCoord. Returns the HDR value written to FS_OUT_Color.
+    glm::vec3 shade_pixel(uint32_t x, uint32_t y, CloudReferenceStats& stats) const;
+
+    // False when shade_pixel() is known to find no clouds without marching, as cloud_pixel_needs_march() in cloud_march.glsl.
+    bool pixel_needs_march(uint32_t x, uint32_t y) const;
+
+    // Output of shade_pixel() for a pixel where pixel_needs_march() is false.
+    glm::vec3 shade_empty_pixel(uint32_t x, uint32_t y, CloudReferenceStats& stats) const;
+
+    // Exposure and ACES tone mapping, as tonemap_fs.glsl.
+    glm::vec3 tonemap(const glm::vec3& color) const;
+
+    // Replaces the exposure of the parameters, e.g. with the one picked by auto_exposure_update().
+    void set_exposure(float exposure) { m_exposure = exposure; }
+
+    // Evaluates the density of every sample skipped by the empty space grid and counts the non-zero ones in
+    // CloudReferenceStats::skip_violations. Slow, used to check that the grid is conservative.
+    void set_verify_empty_space(bool verify) { m_verify_empty_space = verify; }
+
+    // Evaluates the fine samples the adaptive march steps over when it backs up from a coarse hit, or when it runs out of iterations
+    // before reaching it, and counts the non-zero ones in CloudReferenceStats::backup_violations. Slow, used to check that switching
+    // between coarse and fine steps never skips a sample the fixed march would have shaded.
+    void set_verify_adaptive_march(bool verify) { m_verify_adaptive_march = verify; }
+
+private:
+    struct Ray
+    {
+        glm::vec3 origin;
+        glm::vec3 direction;
+    };
+
+    Ray       generate_ray(const glm::vec2& tex_coord) const;
+    glm::vec3 ray_sphere_intersection(const Ray& ray, const glm::vec3& sphere_center, float sphere_radius) const;
+    float     scene_distance(const Ray& ray) const;
+    float     blue_noise(const glm::vec2& pixel) const;
+    float     height_fraction_for_point(const glm::vec3& position) const;
+    Weather   sample_weather(const glm::vec3& position) const;
+    void      build_noise_volumes(NoiseFormat format);
+    float     sample_cloud_density(glm::vec3 position, float height_fraction, const glm::vec2& lod, int32_t detail, CloudReferenceStats& stats) const;
+    glm::vec2 density_lod(const glm::vec3& position, float step_size) const;
+    int32_t   density_detail(const glm::vec3& position, float alpha) const;
+    float     empty_space_distance(const glm::vec3& position, const glm::vec3& ray_direction, float height_fraction, CloudReferenceStats& stats) const;
+    float     sample_cloud_density_along_cone(glm::vec3 position, const glm::vec3& light_dir, float lod_offset, CloudReferenceStats& stats) const;
+    void      build_light_volume();
+    float     sample_light_volume(const glm::vec3& position) const;
+    float     sun_cone_density(const glm::vec3& position, float accum_transmittance, CloudReferenceStats& stats) const;
+    float     calculate_light_energy(float density, float cos_angle, float powder_density) const;
+    glm::vec4 ray_march(glm::vec3 ray_origin, const glm::vec3& ray_direction, float cos_angle, float step_size, float num_steps, CloudReferenceStats& stats) const;
+    uint64_t  count_dense_samples(const glm::vec3& ray_origin, const glm::vec3& ray_direction, float begin, float end, float step_size, float alpha) const;
+    glm::vec4 ray_march_adaptive(const glm::vec3& ray_origin, const glm::vec3& ray_direction, float cos_angle, float step_size, float num_steps, CloudReferenceStats& stats) const;
+    glm::vec4 shade_cirrus_layer(uint32_t layer, const glm::vec3& position, float distance, float cos_angle, CloudReferenceStats& stats) const;
+    glm::vec4 composite_cloud_layers(const Ray& ray, const glm::vec4& clouds, float clouds_distance, float geometry_distance, CloudReferenceStats& stats) const;
+
+private:
+    // Noises as generated, packed into the current format by build_noise_volumes().
+    std::vector<float> m_shape_texels;
+    std::vector<float> m_detail_texels;
+    uint32_t           m_shape_size   = 0;
+    uint32_t           m_detail_size  = 0;
+    NoiseFormat        m_noise_format = NOISE_FORMAT_RGBA16F;
+
+    ReferenceVolume  m_shape_noise;
+    ReferenceVolume  m_detail_noise;
+    ReferenceTexture m_blue_noise;
+    ReferenceTexture m_curl_noise;
+
+    ReferenceMipTexture m_cirrus_noise;
+
+    std::vector<float> m_empty_space_grid;
+    uint32_t           m_empty_space_grid_size = 0;
+    float              m_coverage_bound        = 0.0f; // Largest bound of the grid, no cloud survives a coverage above it.
+    bool               m_verify_empty_space    = false;
+    bool               m_verify_adaptive_march = false;
+
+    // Sun transmittance volume, half precision like the GL_R16F texture. Always built for the current time, so unlike the shader no
+    // wind advection is needed when sampling it.
+    std::vector<float> m_light_volume_texels;
+    glm::vec3          m_light_volume_origin;
+    float              m_light_volume_extent = 1.0f;
+
+    std::vector<glm::vec3> m_sky_view_lut_texels;
+
+    WeatherMapHeader     m_weather_header = {};
+    std::vector<uint8_t> m_weather_tiles;
+    glm::ivec2           m_weather_window_origin = glm::ivec2(0);
+
+    // Uniforms, as set by render_clouds().
+    glm::mat4 m_inv_view_proj;
+    glm::vec3 m_cam_pos;
+    glm::vec3 m_cam_forward;
+    float     m_far_plane;
+    glm::vec2 m_resolution;
+    glm::vec3 m_planet_center;
+    float     m_planet_radius;
+    float     m_cloud_min_height;
+    float     m_cloud_max_height;
+    float     m_shape_noise_scale;
+    float     m_detail_noise_scale;
+    float     m_detail_noise_modifier;
+    float     m_turbulence_noise_scale;
+    float     m_turbulence_amount;
+    float     m_cloud_coverage;
+    glm::vec3 m_wind_direction;
+    float     m_wind_speed;
+    float     m_wind_shear_offset;
+    float     m_time;
+    float     m_max_num_steps;
+    float     m_light_step_length;
+    float     m_light_cone_radius;
+    glm::vec3 m_sun_dir;
+    glm::vec3 m_sun_color;
+    glm::vec3 m_cloud_base_color;
+    glm::vec3 m_cloud_top_color;
+    float     m_precipitation;
+    float     m_ambient_light_factor;
+    float     m_sun_light_factor;
+    float     m_hg_forward;
+    float     m_hg_backward;
+    float     m_exposure;
+    bool      m_empty_space_skipping;
+    bool      m_adaptive_march;
+    float     m_coarse_step_scale;
+    int32_t   m_empty_samples_before_coarse;
+    float     m_transmittance_threshold;
+    bool      m_light_volume;
+    bool      m_sky_view_lut;
+    bool      m_depth_clipping;
+    bool      m_density_lod;
+    float     m_lod_pixel_angle;
+    float     m_lod_bias;
+    float     m_lod_detail_distance;
+    float     m_lod_detail_opacity;
+    float     m_lod_cone_scale;
+    int32_t   m_cone_samples;
+    bool      m_use_detail_noise;
+    float     m_ground_height;
+    float     m_ground_extent;
+    bool      m_weather_map;
+    float     m_min_coverage; // min_cloud_coverage() in weather_map.glsl.
+
+    std::vector<CloudLayer> m_cirrus_layers;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Preetham sky model from atmosphere.glsl.
+glm::vec3 calculate_sky_luminance_rgb(const glm::vec3& s, const glm::vec3& e, float t);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
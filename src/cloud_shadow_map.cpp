@@ -0,0 +1,49 @@
+#include "cloud_shadow_map.h"
+
+#include <math.h>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+CloudShadowMapProjection cloud_shadow_map_projection(const glm::vec3& camera_pos, float extent, uint32_t size, float plane_height)
+{
+    CloudShadowMapProjection projection;
+
+    projection.extent       = extent;
+    projection.texel_size   = extent / float(size);
+    projection.plane_height = plane_height;
+
+    // With an even size the centre of the map is a texel corner, so snapping it to the texel grid keeps every texel centre on the grid.
+    projection.origin.x = roundf(camera_pos.x / projection.texel_size) * projection.texel_size;
+    projection.origin.y = roundf(camera_pos.z / projection.texel_size) * projection.texel_size;
+
+    return projection;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec3 cloud_shadow_map_texel_position(const CloudShadowMapProjection& projection, const glm::ivec2& texel, uint32_t size)
+{
+    glm::vec2 xz = projection.origin + ((glm::vec2(texel) + 0.5f) / float(size) - 0.5f) * projection.extent;
+
+    return glm::vec3(xz.x, projection.plane_height, xz.y);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec2 cloud_shadow_map_uv(const CloudShadowMapProjection& projection, const glm::vec3& position, const glm::vec3& sun_dir)
+{
+    // Slide the position along the sun direction down (or up) to the plane, the sun is never below the horizon when this is used.
+    float     t  = (projection.plane_height - position.y) / glm::max(sun_dir.y, 1e-4f);
+    glm::vec2 xz = glm::vec2(position.x, position.z) + glm::vec2(sun_dir.x, sun_dir.z) * t;
+
+    return (xz - projection.origin) / projection.extent + 0.5f;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool cloud_shadow_map_needs_recenter(const CloudShadowMapProjection& projection, const glm::vec3& camera_pos)
+{
+    return glm::length(glm::vec2(camera_pos.x, camera_pos.z) - projection.origin) > projection.extent * 0.25f;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
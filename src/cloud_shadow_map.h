@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+// Cloud shadow map: a top-down 2D map of the optical depth of the clouds along the sun direction, used to shade the ground without
+// marching the clouds per pixel. Each texel stores the optical depth from a point on a horizontal plane (the ground) towards the sun.
+// The map is centred on the camera and its origin snapped to the texel grid, so that texel centres stay at the same world positions
+// as the camera moves and the shadows do not shimmer. cloud_shadow_map_cs.glsl builds it, mesh_fs.glsl samples it.
+
+#define CLOUD_SHADOW_MAP_SIZE 512
+
+// Default side of the map in world units, covers the ground plane from the default camera.
+#define CLOUD_SHADOW_MAP_EXTENT 20000.0f
+
+struct CloudShadowMapProjection
+{
+    glm::vec2 origin       = glm::vec2(0.0f); // World x/z of the centre of the map, a multiple of texel_size.
+    float     extent       = CLOUD_SHADOW_MAP_EXTENT;
+    float     texel_size   = CLOUD_SHADOW_MAP_EXTENT / float(CLOUD_SHADOW_MAP_SIZE);
+    float     plane_height = 0.0f; // Height of the plane the map is projected onto.
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Projection of a 'size' x 'size' map of side 'extent' centred on the texel corner closest to 'camera_pos'. 'size' must be even.
+CloudShadowMapProjection cloud_shadow_map_projection(const glm::vec3& camera_pos, float extent, uint32_t size, float plane_height);
+
+// World space position of the centre of 'texel' on the projection plane. Keep in sync with cloud_shadow_map_texel_position() in
+// cloud_shadow_map_cs.glsl.
+glm::vec3 cloud_shadow_map_texel_position(const CloudShadowMapProjection& projection, const glm::ivec2& texel, uint32_t size);
+
+// Projects 'position' along 'sun_dir' (pointing towards the sun) onto the plane and returns its texture coordinates. Keep in sync with
+// cloud_shadow_map_uv() in mesh_fs.glsl.
+glm::vec2 cloud_shadow_map_uv(const CloudShadowMapProjection& projection, const glm::vec3& position, const glm::vec3& sun_dir);
+
+// True once the camera moved far enough from the centre that part of the visible ground could fall outside the map.
+bool cloud_shadow_map_needs_recenter(const CloudShadowMapProjection& projection, const glm::vec3& camera_pos);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
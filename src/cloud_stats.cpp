@@ -0,0 +1,84 @@
+#include "cloud_stats.h"
+
+// Display names, and the keys of the log in the same order.
+static const char* kCounterNames[CLOUD_STATS_COUNTER_COUNT] = { "Steps", "Density Fetches", "Detail Fetches", "Light Samples" };
+static const char* kCounterKeys[CLOUD_STATS_COUNTER_COUNT]  = { "steps", "density_fetches", "detail_fetches", "light_samples" };
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+const char* cloud_stats_counter_name(CloudStatsCounter counter)
+{
+    return kCounterNames[counter];
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+CloudStatsLog::~CloudStatsLog()
+{
+    close();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool CloudStatsLog::open(const std::string& path)
+{
+    close();
+
+    m_file = fopen(path.c_str(), "w");
+
+    if (!m_file)
+        return false;
+
+    m_json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+
+    if (!m_json)
+    {
+        fprintf(m_file, "frame");
+
+        for (uint32_t i = 0; i < CLOUD_STATS_COUNTER_COUNT; i++)
+            fprintf(m_file, ",%s", kCounterKeys[i]);
+
+        fprintf(m_file, ",occupied_steps,marched_pixels\n");
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void CloudStatsLog::write_frame(uint64_t frame, const CloudStatsTotals& totals)
+{
+    if (!m_file)
+        return;
+
+    if (m_json)
+    {
+        fprintf(m_file, "{\"frame\":%llu", (unsigned long long)frame);
+
+        for (uint32_t i = 0; i < CLOUD_STATS_COUNTER_COUNT; i++)
+            fprintf(m_file, ",\"%s\":%u", kCounterKeys[i], totals.counters[i]);
+
+        fprintf(m_file, ",\"occupied_steps\":%u,\"marched_pixels\":%u}\n", totals.occupied_steps, totals.marched_pixels);
+    }
+    else
+    {
+        fprintf(m_file, "%llu", (unsigned long long)frame);
+
+        for (uint32_t i = 0; i < CLOUD_STATS_COUNTER_COUNT; i++)
+            fprintf(m_file, ",%u", totals.counters[i]);
+
+        fprintf(m_file, ",%u,%u\n", totals.occupied_steps, totals.marched_pixels);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void CloudStatsLog::close()
+{
+    if (m_file)
+        fclose(m_file);
+
+    m_file = nullptr;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
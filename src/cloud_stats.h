@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+// Work counters of the instrumented cloud programs, the variants built with CLOUD_STATS defined. cloud_stats.glsl counts the march
+// steps, noise fetches and light samples of every marched pixel, stores them in an RGBA32UI image for the heatmap view and adds them to
+// the totals of the frame with buffer atomics. Views can then be compared in work done rather than only in milliseconds.
+
+enum CloudStatsCounter
+{
+    CLOUD_STATS_STEPS = 0,       // Iterations of the march loop, including the ones that leap over empty space.
+    CLOUD_STATS_DENSITY_FETCHES, // Shape noise fetches, of the march and of the light cone.
+    CLOUD_STATS_DETAIL_FETCHES,  // Detail noise fetches, each with a curl noise fetch.
+    CLOUD_STATS_LIGHT_SAMPLES,   // Light cone samples or light volume fetches.
+    CLOUD_STATS_COUNTER_COUNT
+};
+
+// Layout of the CloudStats buffer in cloud_stats.glsl, the static asserts below check every member against its std430 offset. The
+// counters are 32 bit and wrap on frames with more than 2^32 fetches.
+struct CloudStatsTotals
+{
+    uint32_t counters[CLOUD_STATS_COUNTER_COUNT]; // Same order as the channels of the per-pixel image.
+    uint32_t occupied_steps;                      // Steps that found density and were shaded.
+    uint32_t marched_pixels;
+    uint32_t padding[2];
+};
+
+static_assert(offsetof(CloudStatsTotals, counters) == 0, "CloudStatsTotals does not match std430");
+static_assert(offsetof(CloudStatsTotals, occupied_steps) == 16, "CloudStatsTotals does not match std430");
+static_assert(offsetof(CloudStatsTotals, marched_pixels) == 20, "CloudStatsTotals does not match std430");
+static_assert(sizeof(CloudStatsTotals) == 32, "CloudStatsTotals does not match std430");
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+const char* cloud_stats_counter_name(CloudStatsCounter counter);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Streams the totals of every frame to disk, as JSON lines if the path ends in .json and as CSV otherwise, like ProfilerLog.
+class CloudStatsLog
+{
+public:
+    ~CloudStatsLog();
+
+    bool open(const std::string& path);
+    void write_frame(uint64_t frame, const CloudStatsTotals& totals);
+    void close();
+
+    inline bool is_open() const { return m_file != nullptr; }
+
+private:
+    FILE* m_file = nullptr;
+    bool  m_json = false;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,71 @@
+#include "cloud_tiles.h"
+#include "slice_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint32_t cloud_tile_count(uint32_t size)
+{
+    return (size + CLOUD_TILE_SIZE - 1) / CLOUD_TILE_SIZE;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint32_t cloud_tile_pack(uint32_t x, uint32_t y)
+{
+    return x | (y << 16);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void cloud_tile_unpack(uint32_t tile, uint32_t& x, uint32_t& y)
+{
+    x = tile & 0xffff;
+    y = tile >> 16;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void cloud_tiles_classify(uint32_t width, uint32_t height, uint32_t num_threads, const std::function<bool(uint32_t x, uint32_t y)>& needs_march, const std::function<void(uint32_t x, uint32_t y, uint32_t thread)>& shade_empty, std::vector<uint32_t>& tiles)
+{
+    uint32_t tiles_x = cloud_tile_count(width);
+    uint32_t tiles_y = cloud_tile_count(height);
+
+    std::atomic<uint32_t> num_tiles(0);
+
+    tiles.resize(size_t(tiles_x) * tiles_y);
+
+    SliceScheduler::run(tiles_x * tiles_y, num_threads, [&](uint32_t slice, uint32_t thread) {
+        uint32_t tile_x = slice % tiles_x;
+        uint32_t tile_y = slice / tiles_x;
+        uint32_t min_x  = tile_x * CLOUD_TILE_SIZE;
+        uint32_t min_y  = tile_y * CLOUD_TILE_SIZE;
+        uint32_t max_x  = std::min(min_x + CLOUD_TILE_SIZE, width);
+        uint32_t max_y  = std::min(min_y + CLOUD_TILE_SIZE, height);
+
+        // The GPU pass evaluates every pixel of the tile, a single one that needs a march is enough here.
+        for (uint32_t y = min_y; y < max_y; y++)
+        {
+            for (uint32_t x = min_x; x < max_x; x++)
+            {
+                if (needs_march(x, y))
+                {
+                    tiles[num_tiles.fetch_add(1)] = cloud_tile_pack(tile_x, tile_y);
+                    return;
+                }
+            }
+        }
+
+        for (uint32_t y = min_y; y < max_y; y++)
+        {
+            for (uint32_t x = min_x; x < max_x; x++)
+                shade_empty(x, y, thread);
+        }
+    });
+
+    tiles.resize(num_tiles.load());
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+
+// Tiled cloud march: the target is split into CLOUD_TILE_SIZE^2 pixel tiles, a classification pass finishes the tiles where no pixel
+// needs a march (the rays miss the cloud layer, the scene geometry is in front of it or the coverage removes every cloud) and compacts
+// the others into a list, and the march only runs over that list. cloud_tile_classify_cs.glsl and clouds_cs.glsl are the GPU passes,
+// cloud_tiles_classify() the CPU emulation used by CloudReference.
+
+// Keep in sync with CLOUD_TILE_SIZE in cloud_tiles.glsl.
+#define CLOUD_TILE_SIZE 16
+
+// Header of the CloudTiles buffer in cloud_tiles.glsl, the tile list follows it. The first three members are the arguments of
+// glDispatchComputeIndirect(), num_groups_x is the number of tiles appended by the classification.
+struct CloudTileHeader
+{
+    uint32_t num_groups_x;
+    uint32_t num_groups_y;
+    uint32_t num_groups_z;
+    uint32_t padding;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Number of tiles covering 'size' pixels along one axis.
+uint32_t cloud_tile_count(uint32_t size);
+
+// Keep in sync with cloud_tile_pack() in cloud_tiles.glsl.
+uint32_t cloud_tile_pack(uint32_t x, uint32_t y);
+
+void cloud_tile_unpack(uint32_t tile, uint32_t& x, uint32_t& y);
+
+// Classifies every tile of a 'width' x 'height' target on 'num_threads' threads (0 uses all of them). Calls 'shade_empty' with the
+// index of the calling thread for each pixel of the tiles where 'needs_march' is false for every pixel, and appends the other tiles
+// to 'tiles' in no particular order, like the atomic append of the GPU pass.
+void cloud_tiles_classify(uint32_t width, uint32_t height, uint32_t num_threads, const std::function<bool(uint32_t x, uint32_t y)>& needs_march, const std::function<void(uint32_t x, uint32_t y, uint32_t thread)>& shade_empty, std::vector<uint32_t>& tiles);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
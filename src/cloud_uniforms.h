@@ -0,0 +1,96 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stddef.h>
+#include <stdint.h>
+
+// C++ side of the CloudUniforms std140 block in cloud_density.glsl. Keep the two in sync, the static asserts below check every member
+// against its std140 offset. Parameters that change every frame (time, pixel offset) stay loose uniforms so that the block is only
+// uploaded when a parameter actually changes.
+//
+// Each vec3 is followed by a float that fills the rest of its 16 byte slot, glm::vec3 is 12 bytes with 4 byte alignment so the C++
+// layout matches without any explicit padding.
+
+#define CLOUD_UNIFORMS_BINDING 1
+
+struct CloudUniforms
+{
+    glm::vec3 planet_center;
+    float     planet_radius;
+    glm::vec3 wind_direction;
+    float     wind_speed;
+    glm::vec3 sun_dir;
+    float     wind_shear_offset;
+    glm::vec3 sun_color;
+    float     cloud_min_height;
+    glm::vec3 cloud_base_color;
+    float     cloud_max_height;
+    glm::vec3 cloud_top_color;
+    float     shape_noise_scale;
+    float     detail_noise_scale;
+    float     detail_noise_modifier;
+    float     turbulence_noise_scale;
+    float     turbulence_amount;
+    float     cloud_coverage;
+    float     max_num_steps;
+    float     light_step_length;
+    float     light_cone_radius;
+    float     precipitation;
+    float     ambient_light_factor;
+    float     sun_light_factor;
+    float     henyey_greenstein_g_forward;
+    float     henyey_greenstein_g_backward;
+    int32_t   empty_space_skipping;
+    int32_t   adaptive_march;
+    float     coarse_step_scale;
+    int32_t   empty_samples_before_coarse;
+    float     transmittance_threshold;
+    int32_t   light_volume;
+    int32_t   sky_view_lut;
+    int32_t   depth_clipping;
+    int32_t   weather_map;
+    int32_t   folded_noise;
+    float     padding[1];
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// std140: a vec3 is aligned to 16 bytes, scalars to 4 bytes and the size of the block is rounded up to 16 bytes.
+static_assert(offsetof(CloudUniforms, planet_center) == 0, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, planet_radius) == 12, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, wind_direction) == 16, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, wind_speed) == 28, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, sun_dir) == 32, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, wind_shear_offset) == 44, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, sun_color) == 48, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, cloud_min_height) == 60, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, cloud_base_color) == 64, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, cloud_max_height) == 76, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, cloud_top_color) == 80, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, shape_noise_scale) == 92, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, detail_noise_scale) == 96, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, detail_noise_modifier) == 100, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, turbulence_noise_scale) == 104, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, turbulence_amount) == 108, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, cloud_coverage) == 112, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, max_num_steps) == 116, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, light_step_length) == 120, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, light_cone_radius) == 124, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, precipitation) == 128, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, ambient_light_factor) == 132, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, sun_light_factor) == 136, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, henyey_greenstein_g_forward) == 140, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, henyey_greenstein_g_backward) == 144, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, empty_space_skipping) == 148, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, adaptive_march) == 152, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, coarse_step_scale) == 156, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, empty_samples_before_coarse) == 160, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, transmittance_threshold) == 164, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, light_volume) == 168, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, sky_view_lut) == 172, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, depth_clipping) == 176, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, weather_map) == 180, "CloudUniforms does not match std140");
+static_assert(offsetof(CloudUniforms, folded_noise) == 184, "CloudUniforms does not match std140");
+static_assert(sizeof(CloudUniforms) == 192, "CloudUniforms does not match std140");
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,257 @@
+#include "cpu_noise_kernels.h"
+#include "slice_scheduler.h"
+
+#include <string.h>
+
+#if defined(CPU_NOISE_ENABLE_SIMD) && defined(_MSC_VER)
+#    include <intrin.h>
+#endif
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool cpu_supports_sse41()
+{
+#if defined(CPU_NOISE_ENABLE_SIMD)
+#    if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+#    else
+    return __builtin_cpu_supports("sse4.1");
+#    endif
+#else
+    return false;
+#endif
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool cpu_supports_avx2()
+{
+#if defined(CPU_NOISE_ENABLE_SIMD)
+#    if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+
+    if (info[0] < 7)
+        return false;
+
+    __cpuid(info, 1);
+
+    // AVX and OSXSAVE, plus the OS saving the YMM registers.
+    if ((info[2] & (1 << 28)) == 0 || (info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#    else
+    return __builtin_cpu_supports("avx2");
+#    endif
+#else
+    return false;
+#endif
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool cpu_noise_backend_supported(CpuNoiseBackend backend)
+{
+    switch (backend)
+    {
+        case CPU_NOISE_BACKEND_SCALAR: return true;
+        case CPU_NOISE_BACKEND_SSE41: return cpu_supports_sse41();
+        case CPU_NOISE_BACKEND_AVX2: return cpu_supports_avx2();
+    }
+
+    return false;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+CpuNoiseBackend cpu_noise_best_backend()
+{
+    if (cpu_noise_backend_supported(CPU_NOISE_BACKEND_AVX2))
+        return CPU_NOISE_BACKEND_AVX2;
+
+    if (cpu_noise_backend_supported(CPU_NOISE_BACKEND_SSE41))
+        return CPU_NOISE_BACKEND_SSE41;
+
+    return CPU_NOISE_BACKEND_SCALAR;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+const char* cpu_noise_backend_name(CpuNoiseBackend backend)
+{
+    switch (backend)
+    {
+        case CPU_NOISE_BACKEND_SCALAR: return "Scalar";
+        case CPU_NOISE_BACKEND_SSE41: return "SSE4.1";
+        case CPU_NOISE_BACKEND_AVX2: return "AVX2";
+    }
+
+    return "Unknown";
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void cpu_noise_generate_slice_scalar(CpuNoiseVolume volume, uint32_t size, float frequency, uint32_t z, float* out)
+{
+    noise_generate_slice<NoiseScalarBackend>(volume, size, frequency, z, out);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void cpu_noise_generate(CpuNoiseVolume volume, uint32_t size, float frequency, CpuNoiseBackend backend, uint32_t num_threads, float* out)
+{
+    cpu_noise_generate_slices(volume, size, frequency, backend, num_threads, 0, size, out);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void cpu_noise_generate_slices(CpuNoiseVolume volume, uint32_t size, float frequency, CpuNoiseBackend backend, uint32_t num_threads, uint32_t first_z, uint32_t num_z, float* out)
+{
+    if (!cpu_noise_backend_supported(backend))
+        backend = cpu_noise_best_backend();
+
+    auto generate_slice = cpu_noise_generate_slice_scalar;
+
+    if (backend == CPU_NOISE_BACKEND_AVX2)
+        generate_slice = cpu_noise_generate_slice_avx2;
+    else if (backend == CPU_NOISE_BACKEND_SSE41)
+        generate_slice = cpu_noise_generate_slice_sse41;
+
+    const size_t slice_size = size_t(size) * size * 4;
+
+    SliceScheduler::run(num_z, num_threads, [&](uint32_t z, uint32_t) {
+        generate_slice(volume, size, frequency, first_z + z, out + slice_size * z);
+    });
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint16_t cpu_noise_float_to_half(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+
+    uint32_t sign     = (bits >> 16) & 0x8000;
+    int32_t  exponent = int32_t((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    // NaN and infinity.
+    if (((bits >> 23) & 0xff) == 0xff)
+        return uint16_t(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+    // Overflow.
+    if (exponent >= 31)
+        return uint16_t(sign | 0x7c00);
+
+    // Denormals and underflow.
+    if (exponent <= 0)
+    {
+        if (exponent < -10)
+            return uint16_t(sign);
+
+        mantissa |= 0x800000;
+
+        uint32_t shift     = uint32_t(14 - exponent);
+        uint32_t half      = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway   = 1u << (shift - 1);
+
+        if (remainder > halfway || (remainder == halfway && (half & 1)))
+            half++;
+
+        return uint16_t(sign | half);
+    }
+
+    uint32_t half      = sign | (uint32_t(exponent) << 10) | (mantissa >> 13);
+    uint32_t remainder = mantissa & 0x1fff;
+
+    // Round to nearest even, a carry into the exponent is handled naturally.
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+        half++;
+
+    return uint16_t(half);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float cpu_noise_half_to_float(uint16_t half)
+{
+    uint32_t sign     = uint32_t(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1f;
+    uint32_t mantissa = half & 0x3ff;
+    uint32_t bits;
+
+    if (exponent == 0x1f)
+        bits = sign | 0x7f800000 | (mantissa << 13);
+    else if (exponent != 0)
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    else if (mantissa == 0)
+        bits = sign;
+    else
+    {
+        // Renormalize denormals.
+        exponent = 113;
+
+        while ((mantissa & 0x400) == 0)
+        {
+            mantissa <<= 1;
+            exponent--;
+        }
+
+        bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+    }
+
+    float value;
+    memcpy(&value, &bits, sizeof(float));
+
+    return value;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void cpu_noise_generate_mips(const float* volume, uint32_t size, uint32_t num_channels, std::vector<std::vector<float>>& mips)
+{
+    mips.clear();
+    mips.emplace_back(volume, volume + size_t(size) * size * size * num_channels);
+
+    while (size > 1)
+    {
+        const std::vector<float>& src       = mips.back();
+        uint32_t                  next_size = size / 2;
+        std::vector<float>        dst(size_t(next_size) * next_size * next_size * num_channels);
+
+        for (uint32_t z = 0; z < next_size; z++)
+        {
+            for (uint32_t y = 0; y < next_size; y++)
+            {
+                for (uint32_t x = 0; x < next_size; x++)
+                {
+                    for (uint32_t c = 0; c < num_channels; c++)
+                    {
+                        float sum = 0.0f;
+
+                        for (uint32_t i = 0; i < 8; i++)
+                        {
+                            uint32_t sx = x * 2 + (i & 1);
+                            uint32_t sy = y * 2 + ((i >> 1) & 1);
+                            uint32_t sz = z * 2 + ((i >> 2) & 1);
+
+                            sum += src[((size_t(sz) * size + sy) * size + sx) * num_channels + c];
+                        }
+
+                        dst[((size_t(z) * next_size + y) * next_size + x) * num_channels + c] = sum * 0.125f;
+                    }
+                }
+            }
+        }
+
+        mips.push_back(std::move(dst));
+        size = next_size;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// CPU port of the cloud noise generators. Produces the same volumes as shape_noise_cs.glsl and detail_noise_cs.glsl and can be used to
+// bake noise offline, to generate volumes that are too large for a single blocking compute dispatch, or as a fallback when compute
+// shaders are not available. All backends produce bit-identical results.
+
+enum CpuNoiseBackend
+{
+    CPU_NOISE_BACKEND_SCALAR,
+    CPU_NOISE_BACKEND_SSE41,
+    CPU_NOISE_BACKEND_AVX2
+};
+
+enum CpuNoiseVolume
+{
+    CPU_NOISE_VOLUME_SHAPE,
+    CPU_NOISE_VOLUME_DETAIL
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Returns the fastest backend supported by this build and the CPU it is running on.
+CpuNoiseBackend cpu_noise_best_backend();
+
+bool cpu_noise_backend_supported(CpuNoiseBackend backend);
+
+const char* cpu_noise_backend_name(CpuNoiseBackend backend);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Generates a size^3 RGBA volume into 'out' (size^3 * 4 floats, x varying fastest). 'num_threads' of 0 uses all hardware threads.
+void cpu_noise_generate(CpuNoiseVolume volume, uint32_t size, float frequency, CpuNoiseBackend backend, uint32_t num_threads, float* out);
+
+// Generates z-slices [first_z, first_z + num_z) of a size^3 volume into 'out' (num_z * size^2 * 4 floats).
+void cpu_noise_generate_slices(CpuNoiseVolume volume, uint32_t size, float frequency, CpuNoiseBackend backend, uint32_t num_threads, uint32_t first_z, uint32_t num_z, float* out);
+
+// Generates a single z-slice of a volume (size^2 * 4 floats). These are the per-backend entry points used by cpu_noise_generate().
+void cpu_noise_generate_slice_scalar(CpuNoiseVolume volume, uint32_t size, float frequency, uint32_t z, float* out);
+void cpu_noise_generate_slice_sse41(CpuNoiseVolume volume, uint32_t size, float frequency, uint32_t z, float* out);
+void cpu_noise_generate_slice_avx2(CpuNoiseVolume volume, uint32_t size, float frequency, uint32_t z, float* out);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Converts a float to an IEEE half (round to nearest even), matching what the GPU stores in a GL_RGBA16F texture.
+uint16_t cpu_noise_float_to_half(float value);
+
+// Converts an IEEE half back to a float, exactly.
+float cpu_noise_half_to_float(uint16_t half);
+
+// Builds the full box filtered mip chain of a float volume with 'num_channels' channels per texel, mip 0 first.
+void cpu_noise_generate_mips(const float* volume, uint32_t size, uint32_t num_channels, std::vector<std::vector<float>>& mips);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,74 @@
+#include "cpu_noise_kernels.h"
+
+#if defined(CPU_NOISE_ENABLE_SIMD)
+
+#    include <immintrin.h>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+struct Avx2Float
+{
+    __m256 v;
+};
+
+struct Avx2UInt
+{
+    __m256i v;
+};
+
+static inline Avx2Float operator+(Avx2Float a, Avx2Float b) { return { _mm256_add_ps(a.v, b.v) }; }
+static inline Avx2Float operator-(Avx2Float a, Avx2Float b) { return { _mm256_sub_ps(a.v, b.v) }; }
+static inline Avx2Float operator*(Avx2Float a, Avx2Float b) { return { _mm256_mul_ps(a.v, b.v) }; }
+static inline Avx2Float operator/(Avx2Float a, Avx2Float b) { return { _mm256_div_ps(a.v, b.v) }; }
+static inline Avx2Float operator-(Avx2Float a) { return { _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)) }; }
+static inline Avx2UInt  operator*(Avx2UInt a, Avx2UInt b) { return { _mm256_mullo_epi32(a.v, b.v) }; }
+static inline Avx2UInt  operator^(Avx2UInt a, Avx2UInt b) { return { _mm256_xor_si256(a.v, b.v) }; }
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+struct NoiseAvx2Backend
+{
+    typedef Avx2Float Float;
+    typedef Avx2UInt  UInt;
+
+    static const uint32_t kWidth = 8;
+
+    static inline Float floor(Float x) { return { _mm256_floor_ps(x.v) }; }
+    static inline Float min(Float a, Float b) { return { _mm256_min_ps(a.v, b.v) }; }
+    static inline Float abs(Float x) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x.v) }; }
+    static inline UInt  to_uint(Float x) { return { _mm256_cvttps_epi32(x.v) }; }
+    static inline Float broadcast(float x) { return { _mm256_set1_ps(x) }; }
+    static inline UInt  broadcast(uint32_t x) { return { _mm256_set1_epi32(int32_t(x)) }; }
+    static inline Float sequence(float x) { return { _mm256_setr_ps(x, x + 1.0f, x + 2.0f, x + 3.0f, x + 4.0f, x + 5.0f, x + 6.0f, x + 7.0f) }; }
+    static inline void  store(Float x, float* out) { _mm256_storeu_ps(out, x.v); }
+
+    static inline Float to_float(UInt x)
+    {
+        // Values with the top bit set do not fit in a signed conversion, so halve them (keeping the lowest bit as a sticky bit so that
+        // the rounding is still correct) and double the result.
+        __m256i half       = _mm256_or_si256(_mm256_srli_epi32(x.v, 1), _mm256_and_si256(x.v, _mm256_set1_epi32(1)));
+        __m256  from_half  = _mm256_cvtepi32_ps(half);
+        __m256  from_value = _mm256_cvtepi32_ps(x.v);
+        __m256  high_bit   = _mm256_castsi256_ps(_mm256_srai_epi32(x.v, 31));
+
+        return { _mm256_blendv_ps(from_value, _mm256_add_ps(from_half, from_half), high_bit) };
+    }
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void cpu_noise_generate_slice_avx2(CpuNoiseVolume volume, uint32_t size, float frequency, uint32_t z, float* out)
+{
+    noise_generate_slice<NoiseAvx2Backend>(volume, size, frequency, z, out);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+#else
+
+void cpu_noise_generate_slice_avx2(CpuNoiseVolume volume, uint32_t size, float frequency, uint32_t z, float* out)
+{
+    noise_generate_slice<NoiseScalarBackend>(volume, size, frequency, z, out);
+}
+
+#endif
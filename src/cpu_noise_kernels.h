@@ -0,0 +1,311 @@
+#pragma once
+
+#include "cpu_noise.h"
+
+#include <stdint.h>
+#include <math.h>
+
+// Generic implementation of the noise functions in shader/noise.glsl and the main() functions of shape_noise_cs.glsl and
+// detail_noise_cs.glsl. Every backend (scalar, SSE4.1, AVX2) instantiates the same templates so that all of them perform exactly the same
+// sequence of IEEE operations as the GLSL code, which is what makes the results bit-identical across backends.
+//
+// A backend B provides:
+//     B::Float, B::UInt                  - lane types supporting the arithmetic operators used below
+//     B::Float B::floor(B::Float)
+//     B::Float B::min(B::Float, B::Float)
+//     B::Float B::abs(B::Float)
+//     B::UInt  B::to_uint(B::Float)      - uvec3(ivec3(x)), truncation towards zero
+//     B::Float B::to_float(B::UInt)      - float(x) for unsigned integers, correctly rounded
+//     B::Float B::broadcast(float)
+//     B::UInt  B::broadcast(uint32_t)
+//     B::Float B::sequence(float)        - (x, x + 1, x + 2, ...) across the lanes
+//     void     B::store(B::Float, float*)
+//     B::kWidth                          - number of lanes
+//
+// Do not reorder any arithmetic in here without making the same change in noise.glsl.
+
+#define NOISE_UI0 1597334673U
+#define NOISE_UI1 3812015801U
+#define NOISE_UI2 2798796415U
+#define NOISE_UIF (1.0f / float(0xffffffffU))
+
+template <typename B>
+struct NoiseKernels
+{
+    typedef typename B::Float Float;
+    typedef typename B::UInt  UInt;
+
+    struct Vec3
+    {
+        Float x;
+        Float y;
+        Float z;
+    };
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    static inline Float f(float value)
+    {
+        return B::broadcast(value);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    static inline Vec3 vec3(Float x, Float y, Float z)
+    {
+        Vec3 v = { x, y, z };
+        return v;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // GLSL mod(): x - y * floor(x / y)
+    static inline Float mod(Float x, Float y)
+    {
+        return x - y * B::floor(x / y);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    static inline Float fract(Float x)
+    {
+        return x - B::floor(x);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    static inline Float dot(const Vec3& a, const Vec3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    static inline Vec3 hash_33(const Vec3& p)
+    {
+        UInt qx = B::to_uint(p.x) * B::broadcast(uint32_t(NOISE_UI0));
+        UInt qy = B::to_uint(p.y) * B::broadcast(uint32_t(NOISE_UI1));
+        UInt qz = B::to_uint(p.z) * B::broadcast(uint32_t(NOISE_UI2));
+
+        UInt q = qx ^ qy ^ qz;
+
+        qx = q * B::broadcast(uint32_t(NOISE_UI0));
+        qy = q * B::broadcast(uint32_t(NOISE_UI1));
+        qz = q * B::broadcast(uint32_t(NOISE_UI2));
+
+        return vec3(f(-1.0f) + f(2.0f) * B::to_float(qx) * f(NOISE_UIF),
+                    f(-1.0f) + f(2.0f) * B::to_float(qy) * f(NOISE_UIF),
+                    f(-1.0f) + f(2.0f) * B::to_float(qz) * f(NOISE_UIF));
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    static inline Float remap(Float x, Float a, Float b, Float c, Float d)
+    {
+        return (((x - a) / (b - a)) * (d - c)) + c;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    static inline Float gradient_corner(const Vec3& p, const Vec3& w, float ox, float oy, float oz, Float freq)
+    {
+        Vec3 g = hash_33(vec3(mod(p.x + f(ox), freq), mod(p.y + f(oy), freq), mod(p.z + f(oz), freq)));
+        return dot(g, vec3(w.x - f(ox), w.y - f(oy), w.z - f(oz)));
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    static inline Float gradient_noise(const Vec3& x, Float freq)
+    {
+        // grid
+        Vec3 p = vec3(B::floor(x.x), B::floor(x.y), B::floor(x.z));
+        Vec3 w = vec3(fract(x.x), fract(x.y), fract(x.z));
+
+        // quintic interpolant
+        Vec3 u = vec3(w.x * w.x * w.x * (w.x * (w.x * f(6.0f) - f(15.0f)) + f(10.0f)),
+                      w.y * w.y * w.y * (w.y * (w.y * f(6.0f) - f(15.0f)) + f(10.0f)),
+                      w.z * w.z * w.z * (w.z * (w.z * f(6.0f) - f(15.0f)) + f(10.0f)));
+
+        // gradients and projections
+        Float va = gradient_corner(p, w, 0.0f, 0.0f, 0.0f, freq);
+        Float vb = gradient_corner(p, w, 1.0f, 0.0f, 0.0f, freq);
+        Float vc = gradient_corner(p, w, 0.0f, 1.0f, 0.0f, freq);
+        Float vd = gradient_corner(p, w, 1.0f, 1.0f, 0.0f, freq);
+        Float ve = gradient_corner(p, w, 0.0f, 0.0f, 1.0f, freq);
+        Float vf = gradient_corner(p, w, 1.0f, 0.0f, 1.0f, freq);
+        Float vg = gradient_corner(p, w, 0.0f, 1.0f, 1.0f, freq);
+        Float vh = gradient_corner(p, w, 1.0f, 1.0f, 1.0f, freq);
+
+        // interpolation
+        return va +
+            u.x * (vb - va) +
+            u.y * (vc - va) +
+            u.z * (ve - va) +
+            u.x * u.y * (va - vb - vc + vd) +
+            u.y * u.z * (va - vc - ve + vg) +
+            u.z * u.x * (va - vb - ve + vf) +
+            u.x * u.y * u.z * (-va + vb + vc - vd + ve - vf - vg + vh);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    static inline Float worley_noise(const Vec3& uv, Float freq)
+    {
+        Vec3 id = vec3(B::floor(uv.x), B::floor(uv.y), B::floor(uv.z));
+        Vec3 p  = vec3(fract(uv.x), fract(uv.y), fract(uv.z));
+
+        Float min_dist = f(10000.0f);
+
+        for (float x = -1.0f; x <= 1.0f; ++x)
+        {
+            for (float y = -1.0f; y <= 1.0f; ++y)
+            {
+                for (float z = -1.0f; z <= 1.0f; ++z)
+                {
+                    Vec3 h = hash_33(vec3(mod(id.x + f(x), freq), mod(id.y + f(y), freq), mod(id.z + f(z), freq)));
+
+                    h = vec3(h.x * f(0.5f) + f(0.5f), h.y * f(0.5f) + f(0.5f), h.z * f(0.5f) + f(0.5f));
+                    h = vec3(h.x + f(x), h.y + f(y), h.z + f(z));
+
+                    Vec3 d = vec3(p.x - h.x, p.y - h.y, p.z - h.z);
+
+                    min_dist = B::min(min_dist, dot(d, d));
+                }
+            }
+        }
+
+        // inverted worley noise
+        return f(1.0f) - min_dist;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    static inline Float perlin_fbm(const Vec3& p, float freq, int octaves)
+    {
+        float G     = exp2f(-0.85f);
+        float amp   = 1.0f;
+        Float noise = f(0.0f);
+
+        for (int i = 0; i < octaves; ++i)
+        {
+            noise = noise + f(amp) * gradient_noise(vec3(p.x * f(freq), p.y * f(freq), p.z * f(freq)), f(freq));
+            freq *= 2.0f;
+            amp *= G;
+        }
+
+        return noise;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    static inline Float worley_fbm(const Vec3& p, float freq)
+    {
+        Vec3 p0 = vec3(p.x * f(freq), p.y * f(freq), p.z * f(freq));
+        Vec3 p1 = vec3(p0.x * f(2.0f), p0.y * f(2.0f), p0.z * f(2.0f));
+        Vec3 p2 = vec3(p0.x * f(4.0f), p0.y * f(4.0f), p0.z * f(4.0f));
+
+        return worley_noise(p0, f(freq)) * f(0.625f) +
+            worley_noise(p1, f(freq * 2.0f)) * f(0.25f) +
+            worley_noise(p2, f(freq * 4.0f)) * f(0.125f);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // main() of shape_noise_cs.glsl
+    static inline void shape_noise(const Vec3& tex_coord, float freq, Float out[4])
+    {
+        Float perlin = f(1.0f) * (f(1.0f) - f(0.5f)) + perlin_fbm(tex_coord, freq, 7) * f(0.5f);
+        perlin       = B::abs(perlin * f(2.0f) - f(1.0f)); // billowy perlin noise
+
+        Float worley0 = worley_fbm(tex_coord, freq);
+        Float worley1 = worley_fbm(tex_coord, freq * 2.0f);
+        Float worley2 = worley_fbm(tex_coord, freq * 4.0f);
+
+        out[0] = remap(perlin, f(0.0f), f(1.0f), worley0, f(1.0f)); // perlin-worley
+        out[1] = worley0;
+        out[2] = worley1;
+        out[3] = worley2;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // main() of detail_noise_cs.glsl
+    static inline void detail_noise(const Vec3& tex_coord, float freq, Float out[4])
+    {
+        out[0] = worley_fbm(tex_coord, freq);
+        out[1] = worley_fbm(tex_coord, freq * 2.0f);
+        out[2] = worley_fbm(tex_coord, freq * 4.0f);
+        out[3] = f(0.0f);
+    }
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+struct NoiseScalarBackend
+{
+    typedef float    Float;
+    typedef uint32_t UInt;
+
+    static const uint32_t kWidth = 1;
+
+    static inline float    floor(float x) { return floorf(x); }
+    static inline float    min(float a, float b) { return a < b ? a : b; }
+    static inline float    abs(float x) { return fabsf(x); }
+    static inline uint32_t to_uint(float x) { return uint32_t(int32_t(x)); }
+    static inline float    to_float(uint32_t x) { return float(x); }
+    static inline float    broadcast(float x) { return x; }
+    static inline uint32_t broadcast(uint32_t x) { return x; }
+    static inline float    sequence(float x) { return x; }
+    static inline void     store(float x, float* out) { out[0] = x; }
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+template <typename B>
+inline void noise_generate_texels(CpuNoiseVolume volume, uint32_t size, float frequency, uint32_t x, uint32_t y, uint32_t z, float* out)
+{
+    typedef NoiseKernels<B>                K;
+    typedef typename NoiseKernels<B>::Vec3 Vec3;
+
+    // tex_coord = (vec3(gl_GlobalInvocationID) + vec3(0.5f)) / float(u_Size)
+    Vec3 tex_coord = K::vec3((B::sequence(float(x)) + B::broadcast(0.5f)) / B::broadcast(float(size)),
+                             B::broadcast((float(y) + 0.5f) / float(size)),
+                             B::broadcast((float(z) + 0.5f) / float(size)));
+
+    typename B::Float result[4];
+
+    if (volume == CPU_NOISE_VOLUME_SHAPE)
+        K::shape_noise(tex_coord, frequency, result);
+    else
+        K::detail_noise(tex_coord, frequency, result);
+
+    float lanes[4][B::kWidth];
+
+    for (uint32_t c = 0; c < 4; c++)
+        B::store(result[c], lanes[c]);
+
+    for (uint32_t i = 0; i < B::kWidth; i++)
+    {
+        for (uint32_t c = 0; c < 4; c++)
+            out[i * 4 + c] = lanes[c][i];
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+template <typename B>
+inline void noise_generate_slice(CpuNoiseVolume volume, uint32_t size, float frequency, uint32_t z, float* out)
+{
+    for (uint32_t y = 0; y < size; y++)
+    {
+        uint32_t x = 0;
+
+        for (; x + B::kWidth <= size; x += B::kWidth)
+            noise_generate_texels<B>(volume, size, frequency, x, y, z, out + (y * size + x) * 4);
+
+        for (; x < size; x++)
+            noise_generate_texels<NoiseScalarBackend>(volume, size, frequency, x, y, z, out + (y * size + x) * 4);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
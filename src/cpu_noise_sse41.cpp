@@ -0,0 +1,74 @@
+#include "cpu_noise_kernels.h"
+
+#if defined(CPU_NOISE_ENABLE_SIMD)
+
+#    include <smmintrin.h>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+struct Sse41Float
+{
+    __m128 v;
+};
+
+struct Sse41UInt
+{
+    __m128i v;
+};
+
+static inline Sse41Float operator+(Sse41Float a, Sse41Float b) { return { _mm_add_ps(a.v, b.v) }; }
+static inline Sse41Float operator-(Sse41Float a, Sse41Float b) { return { _mm_sub_ps(a.v, b.v) }; }
+static inline Sse41Float operator*(Sse41Float a, Sse41Float b) { return { _mm_mul_ps(a.v, b.v) }; }
+static inline Sse41Float operator/(Sse41Float a, Sse41Float b) { return { _mm_div_ps(a.v, b.v) }; }
+static inline Sse41Float operator-(Sse41Float a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+static inline Sse41UInt  operator*(Sse41UInt a, Sse41UInt b) { return { _mm_mullo_epi32(a.v, b.v) }; }
+static inline Sse41UInt  operator^(Sse41UInt a, Sse41UInt b) { return { _mm_xor_si128(a.v, b.v) }; }
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+struct NoiseSse41Backend
+{
+    typedef Sse41Float Float;
+    typedef Sse41UInt  UInt;
+
+    static const uint32_t kWidth = 4;
+
+    static inline Float floor(Float x) { return { _mm_floor_ps(x.v) }; }
+    static inline Float min(Float a, Float b) { return { _mm_min_ps(a.v, b.v) }; }
+    static inline Float abs(Float x) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), x.v) }; }
+    static inline UInt  to_uint(Float x) { return { _mm_cvttps_epi32(x.v) }; }
+    static inline Float broadcast(float x) { return { _mm_set1_ps(x) }; }
+    static inline UInt  broadcast(uint32_t x) { return { _mm_set1_epi32(int32_t(x)) }; }
+    static inline Float sequence(float x) { return { _mm_setr_ps(x, x + 1.0f, x + 2.0f, x + 3.0f) }; }
+    static inline void  store(Float x, float* out) { _mm_storeu_ps(out, x.v); }
+
+    static inline Float to_float(UInt x)
+    {
+        // Values with the top bit set do not fit in a signed conversion, so halve them (keeping the lowest bit as a sticky bit so that
+        // the rounding is still correct) and double the result.
+        __m128i half       = _mm_or_si128(_mm_srli_epi32(x.v, 1), _mm_and_si128(x.v, _mm_set1_epi32(1)));
+        __m128  from_half  = _mm_cvtepi32_ps(half);
+        __m128  from_value = _mm_cvtepi32_ps(x.v);
+        __m128  high_bit   = _mm_castsi128_ps(_mm_srai_epi32(x.v, 31));
+
+        return { _mm_blendv_ps(from_value, _mm_add_ps(from_half, from_half), high_bit) };
+    }
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void cpu_noise_generate_slice_sse41(CpuNoiseVolume volume, uint32_t size, float frequency, uint32_t z, float* out)
+{
+    noise_generate_slice<NoiseSse41Backend>(volume, size, frequency, z, out);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+#else
+
+void cpu_noise_generate_slice_sse41(CpuNoiseVolume volume, uint32_t size, float frequency, uint32_t z, float* out)
+{
+    noise_generate_slice<NoiseScalarBackend>(volume, size, frequency, z, out);
+}
+
+#endif
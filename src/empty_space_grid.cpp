@@ -0,0 +1,71 @@
+#include "empty_space_grid.h"
+
+#include <algorithm>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static inline int32_t wrap(int32_t i, int32_t size)
+{
+    i %= size;
+    return i < 0 ? i + size : i;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float empty_space_base_cloud(const float* texel)
+{
+    float perlin_worley = texel[0];
+    float worley_fbm    = (texel[1] * 0.625f) + (texel[2] * 0.25f) + (texel[3] * 0.125f);
+
+    // Never skip texels where remap() would divide by zero.
+    if (worley_fbm <= 0.0f)
+        return 2.0f;
+
+    return 1.0f - (1.0f - perlin_worley) / worley_fbm;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void empty_space_build_grid(const float* volume, uint32_t size, uint32_t cell_size, uint32_t num_channels, std::vector<float>& grid)
+{
+    int32_t n  = int32_t(size / cell_size);
+    int32_t cs = int32_t(cell_size);
+    int32_t s  = int32_t(size);
+
+    grid.resize(size_t(n) * n * n);
+
+    // Bound of every sample inside a cell, or within one texel of it. A trilinear sample at texel coordinate u reads texels
+    // floor(u - 0.5) and floor(u - 0.5) + 1, so samples inside the cell read one extra texel on each side. The second texel lets a ray
+    // leap to the exit of a cell even though the wind shear bends it slightly in noise space.
+    //
+    // base_cloud = remap(r, 1 - fbm, 1, 0, 1) <= c is equivalent to r + (1 - c) * fbm <= 1, a half-space in (r, fbm). Both are linear
+    // in the texel values, so a trilinear sample is below c whenever all the texels it reads are, and the largest texel value bounds
+    // the sample. A folded volume holds the base cloud shape itself, which trilinear filtering blends linearly.
+    for (int32_t cz = 0; cz < n; cz++)
+    {
+        for (int32_t cy = 0; cy < n; cy++)
+        {
+            for (int32_t cx = 0; cx < n; cx++)
+            {
+                float bound = 0.0f;
+
+                for (int32_t z = cz * cs - 2; z <= (cz + 1) * cs + 1; z++)
+                {
+                    for (int32_t y = cy * cs - 2; y <= (cy + 1) * cs + 1; y++)
+                    {
+                        for (int32_t x = cx * cs - 2; x <= (cx + 1) * cs + 1; x++)
+                        {
+                            const float* texel = volume + ((size_t(wrap(z, s)) * s + wrap(y, s)) * s + wrap(x, s)) * num_channels;
+
+                            bound = std::max(bound, num_channels == 1 ? texel[0] : empty_space_base_cloud(texel));
+                        }
+                    }
+                }
+
+                grid[(size_t(cz) * n + cy) * n + cx] = bound + EMPTY_SPACE_MARGIN;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
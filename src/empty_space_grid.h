@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// Coarse grid over the shape noise volume used to skip empty space in the primary ray march. Each cell stores an upper bound of the
+// base cloud shape (before coverage) over every trilinear sample that can land in the cell or within one texel of it. A sample is
+// guaranteed to have zero density when the bound of its cell is <= the cloud coverage, independent of coverage, wind and time, so the
+// grid only needs to be rebuilt when the shape noise changes. empty_space_grid_cs.glsl is the GPU version of the same build.
+
+// Shape noise texels per grid cell along each axis.
+#define EMPTY_SPACE_CELL_SIZE 4
+
+// Added to every bound to absorb rounding differences between the build and the density evaluation.
+#define EMPTY_SPACE_MARGIN 0.001f
+
+// Coarsest shape noise mip the march may sample while skipping empty space. A texel of mip 1 averages 2^3 texels of mip 0, so its
+// trilinear samples within one texel of a cell still only read the texels the bound covers; mip 2 already blends in texels outside.
+#define EMPTY_SPACE_MAX_SHAPE_LOD 1.0f
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Base cloud shape of a single RGBA shape noise texel, as computed in sample_cloud_density().
+float empty_space_base_cloud(const float* texel);
+
+// Builds the grid from mip 0 of the shape noise (size^3 texels of 'num_channels' floats, x varying fastest). 'num_channels' is 4 for
+// the individual noises and 1 for a volume that already holds the base cloud shape (NOISE_FORMAT_FOLDED). 'grid' receives
+// (size / cell_size)^3 bounds.
+void empty_space_build_grid(const float* volume, uint32_t size, uint32_t cell_size, uint32_t num_channels, std::vector<float>& grid);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
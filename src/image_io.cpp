@@ -0,0 +1,622 @@
+#include "image_io.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+// INFLATE --------------------------------------------------------------------------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+struct BitReader
+{
+    const uint8_t* data;
+    size_t         size;
+    size_t         pos;
+    uint32_t       bit_buffer;
+    uint32_t       bit_count;
+};
+
+struct Huffman
+{
+    uint16_t counts[16];
+    uint16_t symbols[288];
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool read_bits(BitReader& reader, uint32_t count, uint32_t& value)
+{
+    while (reader.bit_count < count)
+    {
+        if (reader.pos >= reader.size)
+            return false;
+
+        reader.bit_buffer |= uint32_t(reader.data[reader.pos++]) << reader.bit_count;
+        reader.bit_count += 8;
+    }
+
+    value = reader.bit_buffer & ((1u << count) - 1);
+
+    reader.bit_buffer >>= count;
+    reader.bit_count -= count;
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static void build_huffman(Huffman& huffman, const uint8_t* lengths, uint32_t count)
+{
+    uint16_t offsets[16];
+
+    memset(huffman.counts, 0, sizeof(huffman.counts));
+
+    for (uint32_t i = 0; i < count; i++)
+        huffman.counts[lengths[i]]++;
+
+    huffman.counts[0] = 0;
+    offsets[1]        = 0;
+
+    for (uint32_t i = 1; i < 15; i++)
+        offsets[i + 1] = offsets[i] + huffman.counts[i];
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (lengths[i])
+            huffman.symbols[offsets[lengths[i]]++] = uint16_t(i);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool decode_symbol(BitReader& reader, const Huffman& huffman, uint32_t& symbol)
+{
+    int code  = 0;
+    int first = 0;
+    int index = 0;
+
+    for (uint32_t length = 1; length < 16; length++)
+    {
+        uint32_t bit;
+
+        if (!read_bits(reader, 1, bit))
+            return false;
+
+        code |= int(bit);
+
+        int count = huffman.counts[length];
+
+        if (code - count < first)
+        {
+            symbol = huffman.symbols[index + (code - first)];
+            return true;
+        }
+
+        index += count;
+        first += count;
+        first <<= 1;
+        code <<= 1;
+    }
+
+    return false;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool inflate_block(BitReader& reader, const Huffman& literals, const Huffman& distances, std::vector<uint8_t>& out)
+{
+    static const uint16_t kLengthBase[29]   = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+    static const uint8_t  kLengthExtra[29]  = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+    static const uint16_t kDistBase[30]     = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+    static const uint8_t  kDistExtra[30]    = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+    while (true)
+    {
+        uint32_t symbol;
+
+        if (!decode_symbol(reader, literals, symbol))
+            return false;
+
+        if (symbol < 256)
+            out.push_back(uint8_t(symbol));
+        else if (symbol == 256)
+            return true;
+        else
+        {
+            symbol -= 257;
+
+            if (symbol >= 29)
+                return false;
+
+            uint32_t extra, distance_symbol, distance_extra;
+
+            if (!read_bits(reader, kLengthExtra[symbol], extra))
+                return false;
+
+            uint32_t length = kLengthBase[symbol] + extra;
+
+            if (!decode_symbol(reader, distances, distance_symbol) || distance_symbol >= 30)
+                return false;
+
+            if (!read_bits(reader, kDistExtra[distance_symbol], distance_extra))
+                return false;
+
+            size_t distance = kDistBase[distance_symbol] + distance_extra;
+
+            if (distance > out.size())
+                return false;
+
+            size_t start = out.size() - distance;
+
+            for (uint32_t i = 0; i < length; i++)
+                out.push_back(out[start + i]);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool inflate_dynamic(BitReader& reader, std::vector<uint8_t>& out)
+{
+    static const uint8_t kCodeOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+    uint32_t num_literals, num_distances, num_codes;
+
+    if (!read_bits(reader, 5, num_literals) || !read_bits(reader, 5, num_distances) || !read_bits(reader, 4, num_codes))
+        return false;
+
+    num_literals += 257;
+    num_distances += 1;
+    num_codes += 4;
+
+    uint8_t lengths[288 + 32] = {};
+
+    for (uint32_t i = 0; i < num_codes; i++)
+    {
+        uint32_t length;
+
+        if (!read_bits(reader, 3, length))
+            return false;
+
+        lengths[kCodeOrder[i]] = uint8_t(length);
+    }
+
+    Huffman code_lengths;
+    build_huffman(code_lengths, lengths, 19);
+
+    memset(lengths, 0, sizeof(lengths));
+
+    uint32_t index = 0;
+
+    while (index < num_literals + num_distances)
+    {
+        uint32_t symbol;
+
+        if (!decode_symbol(reader, code_lengths, symbol))
+            return false;
+
+        if (symbol < 16)
+        {
+            lengths[index++] = uint8_t(symbol);
+            continue;
+        }
+
+        uint32_t repeat = 0;
+        uint8_t  value  = 0;
+
+        if (symbol == 16)
+        {
+            if (index == 0 || !read_bits(reader, 2, repeat))
+                return false;
+
+            value = lengths[index - 1];
+            repeat += 3;
+        }
+        else if (symbol == 17)
+        {
+            if (!read_bits(reader, 3, repeat))
+                return false;
+
+            repeat += 3;
+        }
+        else
+        {
+            if (!read_bits(reader, 7, repeat))
+                return false;
+
+            repeat += 11;
+        }
+
+        if (index + repeat > num_literals + num_distances)
+            return false;
+
+        while (repeat--)
+            lengths[index++] = value;
+    }
+
+    Huffman literals, distances;
+
+    build_huffman(literals, lengths, num_literals);
+    build_huffman(distances, lengths + num_literals, num_distances);
+
+    return inflate_block(reader, literals, distances, out);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool zlib_inflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+    // Skip the two byte zlib header, the adler32 checksum at the end is not verified.
+    if (size < 2 || (data[0] & 0x0f) != 8)
+        return false;
+
+    BitReader reader = { data, size, 2, 0, 0 };
+
+    uint32_t last = 0;
+
+    while (!last)
+    {
+        uint32_t type;
+
+        if (!read_bits(reader, 1, last) || !read_bits(reader, 2, type))
+            return false;
+
+        if (type == 0)
+        {
+            // Stored block, starts at the next byte boundary.
+            reader.bit_buffer = 0;
+            reader.bit_count  = 0;
+
+            if (reader.pos + 4 > reader.size)
+                return false;
+
+            uint32_t length = reader.data[reader.pos] | (reader.data[reader.pos + 1] << 8);
+            reader.pos += 4;
+
+            if (reader.pos + length > reader.size)
+                return false;
+
+            out.insert(out.end(), reader.data + reader.pos, reader.data + reader.pos + length);
+            reader.pos += length;
+        }
+        else if (type == 1)
+        {
+            static Huffman literals, distances;
+            static bool    initialized = false;
+
+            if (!initialized)
+            {
+                uint8_t lengths[288];
+
+                for (uint32_t i = 0; i < 144; i++) lengths[i] = 8;
+                for (uint32_t i = 144; i < 256; i++) lengths[i] = 9;
+                for (uint32_t i = 256; i < 280; i++) lengths[i] = 7;
+                for (uint32_t i = 280; i < 288; i++) lengths[i] = 8;
+
+                build_huffman(literals, lengths, 288);
+
+                for (uint32_t i = 0; i < 30; i++) lengths[i] = 5;
+
+                build_huffman(distances, lengths, 30);
+
+                initialized = true;
+            }
+
+            if (!inflate_block(reader, literals, distances, out))
+                return false;
+        }
+        else if (type == 2)
+        {
+            if (!inflate_dynamic(reader, out))
+                return false;
+        }
+        else
+            return false;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+// PNG ------------------------------------------------------------------------------------------------------------------------------
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static uint32_t read_u32_be(const uint8_t* data)
+{
+    return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | uint32_t(data[3]);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static uint8_t paeth(uint8_t a, uint8_t b, uint8_t c)
+{
+    int p  = int(a) + int(b) - int(c);
+    int pa = abs(p - int(a));
+    int pb = abs(p - int(b));
+    int pc = abs(p - int(c));
+
+    if (pa <= pb && pa <= pc)
+        return a;
+    else if (pb <= pc)
+        return b;
+
+    return c;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool load_png(const std::string& path, Image& image)
+{
+    std::ifstream file(path, std::ios::binary);
+
+    if (!file.is_open())
+        return false;
+
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    static const uint8_t kSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+    if (bytes.size() < 8 || memcmp(bytes.data(), kSignature, 8) != 0)
+        return false;
+
+    std::vector<uint8_t> compressed;
+    uint32_t             color_type = 0;
+    size_t               pos        = 8;
+
+    while (pos + 12 <= bytes.size())
+    {
+        uint32_t       length = read_u32_be(&bytes[pos]);
+        const uint8_t* type   = &bytes[pos + 4];
+        const uint8_t* chunk  = &bytes[pos + 8];
+
+        if (pos + 12 + length > bytes.size())
+            return false;
+
+        if (!memcmp(type, "IHDR", 4))
+        {
+            image.width  = read_u32_be(chunk);
+            image.height = read_u32_be(chunk + 4);
+            color_type   = chunk[9];
+
+            // 8-bit, non-interlaced only.
+            if (chunk[8] != 8 || chunk[12] != 0)
+                return false;
+
+            switch (color_type)
+            {
+                case 0: image.channels = 1; break;
+                case 2: image.channels = 3; break;
+                case 4: image.channels = 2; break;
+                case 6: image.channels = 4; break;
+                default: return false;
+            }
+        }
+        else if (!memcmp(type, "IDAT", 4))
+            compressed.insert(compressed.end(), chunk, chunk + length);
+        else if (!memcmp(type, "IEND", 4))
+            break;
+
+        pos += 12 + length;
+    }
+
+    if (image.channels == 0)
+        return false;
+
+    std::vector<uint8_t> filtered;
+
+    if (!zlib_inflate(compressed.data(), compressed.size(), filtered))
+        return false;
+
+    size_t stride = size_t(image.width) * image.channels;
+
+    if (filtered.size() < (stride + 1) * image.height)
+        return false;
+
+    image.data.resize(stride * image.height);
+
+    for (uint32_t y = 0; y < image.height; y++)
+    {
+        uint8_t        filter = filtered[y * (stride + 1)];
+        const uint8_t* src    = &filtered[y * (stride + 1) + 1];
+        uint8_t*       dst    = &image.data[y * stride];
+        const uint8_t* prev   = y > 0 ? &image.data[(y - 1) * stride] : nullptr;
+
+        for (size_t x = 0; x < stride; x++)
+        {
+            uint8_t a = x >= image.channels ? dst[x - image.channels] : 0;
+            uint8_t b = prev ? prev[x] : 0;
+            uint8_t c = (prev && x >= image.channels) ? prev[x - image.channels] : 0;
+
+            switch (filter)
+            {
+                case 0: dst[x] = src[x]; break;
+                case 1: dst[x] = uint8_t(src[x] + a); break;
+                case 2: dst[x] = uint8_t(src[x] + b); break;
+                case 3: dst[x] = uint8_t(src[x] + ((int(a) + int(b)) >> 1)); break;
+                case 4: dst[x] = uint8_t(src[x] + paeth(a, b, c)); break;
+                default: return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0)
+{
+    static uint32_t table[256];
+    static bool     initialized = false;
+
+    if (!initialized)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+
+            table[i] = c;
+        }
+
+        initialized = true;
+    }
+
+    crc = ~crc;
+
+    for (size_t i = 0; i < size; i++)
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static void write_u32_be(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(uint8_t(value >> 24));
+    out.push_back(uint8_t(value >> 16));
+    out.push_back(uint8_t(value >> 8));
+    out.push_back(uint8_t(value));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static void write_chunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> chunk;
+
+    write_u32_be(chunk, uint32_t(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    write_u32_be(chunk, crc32(&chunk[4], chunk.size() - 4));
+
+    file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool write_png(const std::string& path, uint32_t width, uint32_t height, uint32_t channels, const uint8_t* data)
+{
+    static const uint8_t kColorTypes[5] = { 0, 0, 4, 2, 6 };
+
+    if (channels < 1 || channels > 4)
+        return false;
+
+    std::ofstream file(path, std::ios::binary);
+
+    if (!file.is_open())
+        return false;
+
+    static const uint8_t kSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+    file.write(reinterpret_cast<const char*>(kSignature), 8);
+
+    std::vector<uint8_t> header;
+
+    write_u32_be(header, width);
+    write_u32_be(header, height);
+    header.push_back(8);
+    header.push_back(kColorTypes[channels]);
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+
+    write_chunk(file, "IHDR", header);
+
+    // Unfiltered scanlines in uncompressed deflate blocks. Larger files, but no dependency on zlib.
+    size_t               stride = size_t(width) * channels;
+    std::vector<uint8_t> raw;
+
+    raw.reserve((stride + 1) * height);
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        raw.push_back(0);
+        raw.insert(raw.end(), data + y * stride, data + (y + 1) * stride);
+    }
+
+    std::vector<uint8_t> zlib;
+
+    zlib.push_back(0x78);
+    zlib.push_back(0x01);
+
+    for (size_t pos = 0; pos < raw.size() || pos == 0; pos += 65535)
+    {
+        size_t length = std::min(raw.size() - pos, size_t(65535));
+        bool   last   = pos + length >= raw.size();
+
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(uint8_t(length));
+        zlib.push_back(uint8_t(length >> 8));
+        zlib.push_back(uint8_t(~length));
+        zlib.push_back(uint8_t(~length >> 8));
+        zlib.insert(zlib.end(), raw.begin() + pos, raw.begin() + pos + length);
+
+        if (last)
+            break;
+    }
+
+    uint32_t a = 1, b = 0;
+
+    for (uint8_t byte : raw)
+    {
+        a = (a + byte) % 65521;
+        b = (b + a) % 65521;
+    }
+
+    write_u32_be(zlib, (b << 16) | a);
+
+    write_chunk(file, "IDAT", zlib);
+    write_chunk(file, "IEND", std::vector<uint8_t>());
+
+    return bool(file);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool write_hdr(const std::string& path, uint32_t width, uint32_t height, const float* rgb)
+{
+    std::ofstream file(path, std::ios::binary);
+
+    if (!file.is_open())
+        return false;
+
+    std::string header = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " + std::to_string(height) + " +X " + std::to_string(width) + "\n";
+    file.write(header.data(), header.size());
+
+    std::vector<uint8_t> rgbe(size_t(width) * height * 4);
+
+    for (size_t i = 0; i < size_t(width) * height; i++)
+    {
+        float r = std::max(rgb[i * 3 + 0], 0.0f);
+        float g = std::max(rgb[i * 3 + 1], 0.0f);
+        float b = std::max(rgb[i * 3 + 2], 0.0f);
+        float v = std::max(r, std::max(g, b));
+
+        if (v < 1e-32f)
+        {
+            rgbe[i * 4 + 0] = rgbe[i * 4 + 1] = rgbe[i * 4 + 2] = rgbe[i * 4 + 3] = 0;
+            continue;
+        }
+
+        int   exponent;
+        float scale = frexpf(v, &exponent) * 256.0f / v;
+
+        rgbe[i * 4 + 0] = uint8_t(r * scale);
+        rgbe[i * 4 + 1] = uint8_t(g * scale);
+        rgbe[i * 4 + 2] = uint8_t(b * scale);
+        rgbe[i * 4 + 3] = uint8_t(exponent + 128);
+    }
+
+    file.write(reinterpret_cast<const char*>(rgbe.data()), rgbe.size());
+
+    return bool(file);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
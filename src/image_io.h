@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Minimal, dependency free image IO for the offline tools, which must not link against the sample framework or OpenGL.
+// Only 8-bit non-interlaced PNGs are supported, which covers every texture in data/texture.
+
+struct Image
+{
+    uint32_t             width    = 0;
+    uint32_t             height   = 0;
+    uint32_t             channels = 0;
+    std::vector<uint8_t> data;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool load_png(const std::string& path, Image& image);
+
+// Writes an 8-bit PNG. Rows are given top to bottom.
+bool write_png(const std::string& path, uint32_t width, uint32_t height, uint32_t channels, const uint8_t* data);
+
+// Writes a Radiance RGBE (.hdr) image from RGB floats. Rows are given top to bottom.
+bool write_hdr(const std::string& path, uint32_t width, uint32_t height, const float* rgb);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
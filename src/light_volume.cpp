@@ -0,0 +1,42 @@
+#include "light_volume.h"
+
+#include <algorithm>
+#include <math.h>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float light_volume_extent(const glm::vec3& camera_pos, const glm::vec3& planet_center, float planet_radius, float cloud_max_height)
+{
+    float outer_radius = planet_radius + cloud_max_height;
+    float distance     = glm::length(camera_pos - planet_center);
+    float horizon      = sqrtf(std::max(outer_radius * outer_radius - distance * distance, 0.0f));
+
+    // Above the shell the whole planet is visible from some heights, fall back to the size of the shell.
+    if (horizon <= 0.0f)
+        horizon = outer_radius;
+
+    return 2.0f * horizon * LIGHT_VOLUME_MARGIN;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool light_volume_out_of_range(const glm::vec3& origin, float extent, const glm::vec3& camera_pos)
+{
+    float horizon = extent * 0.5f / LIGHT_VOLUME_MARGIN;
+
+    return glm::length(glm::vec2(camera_pos.x - origin.x, camera_pos.z - origin.z)) > horizon * (LIGHT_VOLUME_MARGIN - 1.0f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec3 light_volume_texel_position(const glm::ivec3& texel, const glm::vec3& origin, float extent, const glm::vec3& planet_center, float planet_radius, float cloud_min_height, float cloud_max_height)
+{
+    glm::vec2 xz     = glm::vec2(origin.x, origin.z) + ((glm::vec2(texel.x, texel.y) + 0.5f) / float(LIGHT_VOLUME_SIZE) - 0.5f) * extent;
+    float     radius = planet_radius + cloud_min_height + (float(texel.z) + 0.5f) / float(LIGHT_VOLUME_HEIGHT) * (cloud_max_height - cloud_min_height);
+    glm::vec2 offset = xz - glm::vec2(planet_center.x, planet_center.z);
+    float     y      = planet_center.y + sqrtf(std::max(radius * radius - glm::dot(offset, offset), 0.0f));
+
+    return glm::vec3(xz.x, y, xz.y);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+// Sun transmittance volume: the density along the light cone (sample_cloud_density_along_cone()) precomputed over the cloud shell
+// around the camera, so the primary march reads it with a single fetch instead of marching the cone at every sample. The x and y axes
+// of the volume cover a square of world x/z centred on the origin it was built at, the z axis follows the height fraction within the
+// shell. light_volume_cs.glsl builds it on the GPU, CloudReference on the CPU.
+
+#define LIGHT_VOLUME_SIZE 256
+#define LIGHT_VOLUME_HEIGHT 32
+
+// Height slices rebuilt per frame, a full rebuild takes LIGHT_VOLUME_HEIGHT / LIGHT_VOLUME_SLICES_PER_FRAME frames.
+#define LIGHT_VOLUME_SLICES_PER_FRAME 4
+
+// The volume extends this much past the horizon so that the camera can move before it has to be rebuilt.
+#define LIGHT_VOLUME_MARGIN 1.1f
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Side of the square covering every point of the shell visible from 'camera_pos', twice the distance to the horizon of the outer
+// shell times LIGHT_VOLUME_MARGIN.
+float light_volume_extent(const glm::vec3& camera_pos, const glm::vec3& planet_center, float planet_radius, float cloud_max_height);
+
+// True once the camera moved far enough from 'origin' for the volume to no longer cover its horizon.
+bool light_volume_out_of_range(const glm::vec3& origin, float extent, const glm::vec3& camera_pos);
+
+// World space position of the centre of 'texel', on the shell at the height fraction of the texel. Keep in sync with
+// light_volume_texel_position() in light_volume_cs.glsl.
+glm::vec3 light_volume_texel_position(const glm::ivec3& texel, const glm::vec3& origin, float extent, const glm::vec3& planet_center, float planet_radius, float cloud_min_height, float cloud_max_height);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -11,19 +11,62 @@
 #include <chrono>
 #include <random>
 #include <fstream>
-
+#include <iterator>
+#include <algorithm>
+
+#include "temporal_reprojection.h"
+#include "noise_cache.h"
+#include "noise_format.h"
+#include "noise_regenerator.h"
+#include "shader_program.h"
+#include "cpu_noise.h"
+#include "empty_space_grid.h"
+#include "cloud_uniforms.h"
+#include "uniform_ring.h"
+#include "profiler.h"
+#include "benchmark_script.h"
+#include "image_io.h"
+#include "light_volume.h"
+#include "cloud_shadow_map.h"
+#include "sky_view_lut.h"
+#include "cloud_tiles.h"
+#include "weather_map.h"
+#include "cloud_budget.h"
+#include "cloud_probe.h"
+#include "cloud_quality.h"
+#include "auto_exposure.h"
+#include "cloud_stats.h"
+#include "cloud_layers.h"
+
+#define CAMERA_FOV 60.0f
+#define CAMERA_NEAR_PLANE 1.0f
 #define CAMERA_FAR_PLANE 1000.0f
+#define SHAPE_NOISE_SIZE 128
+#define DETAIL_NOISE_SIZE 32
+
+// First guesses of the cost of regenerating the noise, until NoiseSlabBudget has measured it.
+#define NOISE_GPU_MS_PER_MTEXEL 10.0f
+#define NOISE_CPU_MS_PER_MTEXEL 50.0f
+#define WEATHER_MAP_PATH "weather.map"
+
+// Size of the procedural weather map written on first run, 64x64 tiles of 6.4 km.
+#define WEATHER_MAP_GENERATED_TILES 64
+#define WEATHER_MAP_GENERATED_TEXEL_SIZE 200.0f
 
 struct GlobalUniforms
 {
     DW_ALIGNED(16)
     glm::mat4 view_proj;
     DW_ALIGNED(16)
+    glm::mat4 prev_view_proj;
+    DW_ALIGNED(16)
     glm::mat4 inv_view_proj;
     DW_ALIGNED(16)
     glm::vec4 cam_pos;
 };
 
+static_assert(sizeof(GlobalUniforms) == 208, "GlobalUniforms does not match std140");
+
 class VolumetricClouds : public dw::Application
 {
 protected:
@@ -31,11 +74,101 @@ protected:
 
     bool init(int argc, const char* argv[]) override
     {
-        m_sun_angle = glm::radians(-58.0f);
+        for (int i = 1; i < argc; i++)
+        {
+            if (!strcmp(argv[i], "--cpu-noise"))
+                m_cpu_noise = true;
+            else if (!strcmp(argv[i], "--no-program-cache"))
+                m_program_cache = false;
+            else if (!strcmp(argv[i], "--noise-format") && i + 1 < argc)
+            {
+                const char* name = argv[++i];
+
+                for (int f = 0; f < NOISE_FORMAT_COUNT; f++)
+                {
+                    if (!strcmp(name, noise_format_name(NoiseFormat(f))))
+                    {
+                        m_noise_format      = NoiseFormat(f);
+                        m_noise_back_format = NoiseFormat(f);
+                    }
+                }
+            }
+            else if (!strcmp(argv[i], "--profile-log") && i + 1 < argc)
+                m_profile_log_path = argv[++i];
+            else if (!strcmp(argv[i], "--benchmark") && i + 1 < argc)
+                m_benchmark_script_path = argv[++i];
+            else if (!strcmp(argv[i], "--benchmark-images") && i + 1 < argc)
+                m_benchmark_image_prefix = argv[++i];
+            else if (!strcmp(argv[i], "--quality") && i + 1 < argc)
+            {
+                if (!cloud_quality_parse(argv[++i], m_quality_tier))
+                    DW_LOG_WARNING(std::string("Unknown quality tier: ") + argv[i]);
+            }
+            else if (!strcmp(argv[i], "--cloud-stats"))
+                m_cloud_stats = true;
+            else if (!strcmp(argv[i], "--cloud-stats-log") && i + 1 < argc)
+            {
+                m_cloud_stats          = true;
+                m_cloud_stats_log_path = argv[++i];
+            }
+            else if (!strcmp(argv[i], "--cirrus") && i + 3 < argc)
+            {
+                CloudLayer layer;
+
+                layer.min_height = float(atof(argv[++i]));
+                layer.max_height = layer.min_height;
+                layer.coverage   = float(atof(argv[++i]));
+                layer.opacity    = float(atof(argv[++i]));
+
+                // Inserted at its height. A layer that would make the stack invalid is dropped, the ones before it are kept.
+                std::vector<CloudLayer> layers = m_cirrus_layers;
+                std::string             error;
+
+                layers.insert(std::upper_bound(layers.begin(), layers.end(), layer, [](const CloudLayer& a, const CloudLayer& b) { return a.min_height < b.min_height; }), layer);
+
+                if (validate_cloud_layers(layers, error))
+                    m_cirrus_layers = layers;
+                else
+                    DW_LOG_WARNING("Ignoring --cirrus " + std::string(argv[i - 2]) + ": " + error);
+            }
+            else if (!strcmp(argv[i], "--auto-exposure"))
+            {
+                m_compute_tonemap = true;
+                m_auto_exposure   = true;
+            }
+            else if (!strcmp(argv[i], "--cloud-budget") && i + 1 < argc)
+            {
+                m_cloud_budget_enabled = true;
+                m_cloud_budget_ms      = float(atof(argv[++i]));
+            }
+        }
+
+        m_sun_angle         = glm::radians(-58.0f);
+        m_cirrus_layers_gui = m_cirrus_layers;
 
         // Create camera.
         create_camera();
 
+        set_quality_tier(m_quality_tier);
+
+        if (!m_benchmark_script_path.empty())
+        {
+            std::string error;
+
+            if (!load_benchmark_script(m_benchmark_script_path, m_benchmark_script, error))
+            {
+                DW_LOG_FATAL("Failed to load benchmark script: " + error);
+                return false;
+            }
+
+            m_benchmark         = true;
+            m_debug_gui         = false;
+            m_shader_hot_reload = false;
+
+            // Frame times would otherwise be quantized to the refresh rate.
+            glfwSwapInterval(0);
+        }
+
         // Create GPU resources.
         if (!create_shaders())
             return false;
@@ -46,13 +179,40 @@ protected:
         if (!create_uniform_buffer())
             return false;
 
+        if (!m_profiler.create())
+            return false;
+
+        if (!m_profile_log_path.empty())
+            m_profiler.open_log(m_profile_log_path);
+
+        if (!m_cloud_stats_log_path.empty() && !m_cloud_stats_log.open(m_cloud_stats_log_path))
+            DW_LOG_ERROR("Failed to open " + m_cloud_stats_log_path);
+
         // Load scene.
         if (!load_scene())
             return false;
 
-        // Generate noise textures.
-        generate_shape_noise_texture();
-        generate_detail_noise_texture();
+        open_weather_map();
+
+        // Generate noise textures. Profiled as a frame of their own since they only run once.
+        m_profiler.begin_frame();
+
+        {
+            ProfileScope scope(m_profiler, "Shape Noise");
+            generate_shape_noise_texture();
+        }
+
+        {
+            ProfileScope scope(m_profiler, "Detail Noise");
+            generate_detail_noise_texture();
+        }
+
+        {
+            ProfileScope scope(m_profiler, "Empty Space Grid");
+            build_empty_space_grid();
+        }
+
+        m_profiler.end_frame();
 
         return true;
     }
@@ -61,17 +221,214 @@ protected:
 
     void update(double delta) override
     {
+        auto frame_start = std::chrono::high_resolution_clock::now();
+
+        m_profiler.begin_frame();
+
         if (m_debug_gui)
             debug_gui();
 
-        // Update camera.
-        update_camera();
+        if (m_benchmark)
+            update_benchmark_state();
+        else
+        {
+            m_prev_time = m_time;
+            m_time      = static_cast<float>(glfwGetTime());
+
+            // Update camera.
+            update_camera();
+        }
+
+        if (m_shader_hot_reload)
+            reload_shaders();
+
+        update_cloud_layers();
+
+        // Before the uniforms, which must see the format of the volumes swapped in this frame.
+        {
+            ProfileScope scope(m_profiler, "Noise Regeneration");
+            update_noise_regeneration();
+        }
 
         update_uniforms();
+        select_cloud_variants();
+
+        {
+            ProfileScope scope(m_profiler, "Weather Map");
+            update_weather_map();
+        }
+
+        {
+            ProfileScope scope(m_profiler, "Sky View LUT");
+            update_sky_view_lut();
+        }
+
+        {
+            ProfileScope scope(m_profiler, "Light Volume");
+            update_light_volume();
+        }
+
+        {
+            ProfileScope scope(m_profiler, "Cloud Shadow Map");
+            update_cloud_shadow_map();
+        }
+
+        {
+            ProfileScope scope(m_profiler, "Cloud Probe");
+            update_cloud_probe();
+        }
+
+        {
+            ProfileScope scope(m_profiler, "Scene");
+            render_scene();
+        }
+
+        update_cloud_budget();
+
+        begin_cloud_stats();
+
+        {
+            ProfileScope scope(m_profiler, "Clouds");
+
+            if (m_temporal_reprojection)
+                render_clouds_temporal();
+            else if (m_cloud_level.scale < 1.0f)
+                render_clouds_scaled();
+            else if (tiled_clouds())
+                render_clouds_tiled(m_hdr_output_texture, true);
+            else
+            {
+                bind_cloud_composite_framebuffer();
+                begin_cloud_composite();
+                render_clouds();
+                end_cloud_composite();
+            }
+        }
 
-        render_scene();
-        render_clouds();
-        tonemap();
+        end_cloud_stats();
+
+        m_global_ubo.end_frame();
+        m_cloud_ubo.end_frame();
+        m_cloud_probe_ubo.end_frame();
+
+        {
+            ProfileScope scope(m_profiler, "Tonemap");
+            tonemap();
+        }
+
+        render_cloud_stats_heatmap();
+
+        m_profiler.end_frame();
+
+        if (m_benchmark)
+            end_benchmark_frame(frame_start);
+
+        m_frame_index++;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Pins the time to the fixed timestep of the script and applies its camera and cloud parameters. Warmup frames render time 0.
+    void update_benchmark_state()
+    {
+        uint32_t measured_frame = m_frame_index < m_benchmark_script.warmup ? 0 : m_frame_index - m_benchmark_script.warmup;
+
+        m_prev_time = m_time;
+        m_time      = float(measured_frame) * m_benchmark_script.timestep;
+
+        BenchmarkKeyframe state = sample_benchmark_script(m_benchmark_script, m_time);
+
+        if (state.mask & (BENCHMARK_POSITION | BENCHMARK_DIRECTION))
+        {
+            glm::vec3 position  = (state.mask & BENCHMARK_POSITION) ? state.position : m_main_camera->m_position;
+            glm::vec3 direction = (state.mask & BENCHMARK_DIRECTION) ? state.direction : m_main_camera->m_forward;
+
+            // Re-aims the existing camera, the orientation is derived from the forward vector.
+            m_main_camera->reset(CAMERA_FOV, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE, float(m_width) / float(m_height), position, direction);
+        }
+
+        if (state.mask & BENCHMARK_SUN_ANGLE)
+            m_sun_angle = state.sun_angle;
+
+        if (state.mask & BENCHMARK_COVERAGE)
+            m_cloud_coverage = state.coverage;
+
+        if (state.mask & BENCHMARK_WIND_ANGLE)
+            m_wind_angle = state.wind_angle;
+
+        if (state.mask & BENCHMARK_WIND_SPEED)
+            m_wind_speed = state.wind_speed;
+
+        m_main_camera->update();
+        update_transforms(m_main_camera.get());
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void end_benchmark_frame(std::chrono::high_resolution_clock::time_point frame_start)
+    {
+        if (m_frame_index < m_benchmark_script.warmup || m_benchmark_frame_times.size() == m_benchmark_script.frames)
+            return;
+
+        // Wait for the GPU so that the frame time covers the execution of the frame and not just its submission.
+        glFinish();
+
+        m_benchmark_frame_times.push_back(std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - frame_start).count());
+
+        // The counters of the frame are ready after the wait, so every measured frame is counted.
+        resolve_cloud_stats();
+
+        const std::vector<BenchmarkKeyframe>& keyframes = m_benchmark_script.keyframes;
+
+        if (!m_benchmark_image_prefix.empty() && m_benchmark_next_keyframe < keyframes.size() && m_time >= keyframes[m_benchmark_next_keyframe].time)
+        {
+            save_screenshot(m_benchmark_image_prefix + "_" + std::to_string(m_benchmark_next_keyframe) + ".png");
+            m_benchmark_next_keyframe++;
+        }
+
+        if (m_benchmark_frame_times.size() == m_benchmark_script.frames)
+        {
+            TimingSummary summary = summarize_timings(m_benchmark_frame_times.data(), uint32_t(m_benchmark_frame_times.size()));
+
+            printf("Benchmark: %u frames at %dx%d after %u warmup frames, %.4f s timestep\n", m_benchmark_script.frames, m_width, m_height, m_benchmark_script.warmup, m_benchmark_script.timestep);
+            printf("Frame time (ms): min %.3f, avg %.3f, p50 %.3f, p95 %.3f, p99 %.3f, max %.3f\n", summary.min, summary.avg, summary.p50, summary.p95, summary.p99, summary.max);
+
+            if (m_benchmark_cloud_stats_frames > 0)
+            {
+                double frames = double(m_benchmark_cloud_stats_frames);
+                double pixels = double(std::max(m_benchmark_cloud_stats[CLOUD_STATS_COUNTER_COUNT + 1], uint64_t(1)));
+
+                printf("Cloud stats per frame (per marched pixel):");
+
+                for (uint32_t i = 0; i < CLOUD_STATS_COUNTER_COUNT; i++)
+                    printf("%s %s %.0f (%.2f)", i == 0 ? "" : ",", cloud_stats_counter_name(CloudStatsCounter(i)), double(m_benchmark_cloud_stats[i]) / frames, double(m_benchmark_cloud_stats[i]) / pixels);
+
+                printf(", Occupied Steps %.0f (%.2f), Marched Pixels %.0f\n", double(m_benchmark_cloud_stats[CLOUD_STATS_COUNTER_COUNT]) / frames, double(m_benchmark_cloud_stats[CLOUD_STATS_COUNTER_COUNT]) / pixels, pixels / frames);
+            }
+
+            request_exit();
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Writes the tone mapped back buffer to a PNG.
+    void save_screenshot(const std::string& path)
+    {
+        std::vector<uint8_t> pixels(size_t(m_width) * m_height * 3);
+        std::vector<uint8_t> flipped(pixels.size());
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, pixels.data());
+
+        size_t row_size = size_t(m_width) * 3;
+
+        for (int y = 0; y < m_height; y++)
+            memcpy(&flipped[size_t(y) * row_size], &pixels[size_t(m_height - 1 - y) * row_size], row_size);
+
+        if (!write_png(path, m_width, m_height, 3, flipped.data()))
+            DW_LOG_ERROR("Failed to write " + path);
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
@@ -98,14 +455,262 @@ protected:
         ImGui::ColorPicker3("Sun Color", &m_sun_color.x);
 
         ImGui::InputFloat("Planet Radius", &m_planet_radius);
-        ImGui::SliderInt("Max Num Steps", &m_max_num_steps, 16, 256);
 
-        ImGui::SliderFloat("Exposure", &m_exposure, 0.0f, 10.0f);
+        // Tiers compile their settings into a variant of the cloud programs, see cloud_quality.h. Changing the steps by hand goes
+        // back to the Custom tier, whose program reads every setting from its uniform.
+        const char* quality_tiers[CLOUD_QUALITY_COUNT];
 
-        m_planet_center = glm::vec3(0.0f, -m_planet_radius, 0.0f);
+        for (int i = 0; i < CLOUD_QUALITY_COUNT; i++)
+            quality_tiers[i] = cloud_quality_name(CloudQualityTier(i));
 
-        m_light_direction = glm::normalize(glm::vec3(0.0f, sin(m_sun_angle), cos(m_sun_angle)));
-        m_wind_direction  = glm::normalize(glm::vec3(cos(m_wind_angle), sin(m_wind_angle), 0.0f));
+        int quality_tier = m_quality_tier;
+
+        if (ImGui::Combo("Quality", &quality_tier, quality_tiers, CLOUD_QUALITY_COUNT))
+            set_quality_tier(CloudQualityTier(quality_tier));
+
+        if (ImGui::SliderInt("Max Num Steps", &m_max_num_steps, 16, 256))
+            m_quality_tier = CLOUD_QUALITY_CUSTOM;
+
+        ImGui::Text("Cloud Program Variants: %u", m_clouds_variants.size());
+
+        // Regenerates both volumes a few slabs per frame, from the caches when they hold the new format. The frame times per format are
+        // in the profiler.
+        const char* noise_formats[NOISE_FORMAT_COUNT];
+
+        for (int i = 0; i < NOISE_FORMAT_COUNT; i++)
+            noise_formats[i] = noise_format_name(NoiseFormat(i));
+
+        int noise_format = m_noise_back_format;
+
+        if (ImGui::Combo("Noise Format", &noise_format, noise_formats, NOISE_FORMAT_COUNT))
+            set_noise_format(NoiseFormat(noise_format));
+
+        if (ImGui::SliderFloat("Shape Noise Frequency", &m_shape_noise_frequency, 1.0f, 16.0f))
+            start_noise_regeneration();
+
+        if (ImGui::SliderFloat("Detail Noise Frequency", &m_detail_noise_frequency, 1.0f, 32.0f))
+            start_noise_regeneration();
+
+        ImGui::SliderFloat("Noise Regeneration Budget (ms)", &m_noise_budget_ms, 0.1f, 8.0f);
+
+        if (m_noise_regenerating)
+            ImGui::Text("Regenerating %s noise: %.0f%% (%.1f ms/Mtexel)", m_noise_back_volume == CPU_NOISE_VOLUME_SHAPE ? "shape" : "detail", m_noise_scheduler.progress() * 100.0f, m_noise_budget.ms_per_mtexel());
+
+        ImGui::Checkbox("Empty Space Skipping", &m_empty_space_skipping);
+
+        ImGui::Checkbox("Adaptive March", &m_adaptive_march);
+
+        if (m_adaptive_march)
+        {
+            ImGui::SliderFloat("Coarse Step Scale", &m_coarse_step_scale, 1.0f, 8.0f);
+            ImGui::SliderInt("Empty Samples Before Coarse", &m_empty_samples_before_coarse, 1, 16);
+            ImGui::SliderFloat("Transmittance Threshold", &m_transmittance_threshold, 0.0f, 0.1f);
+        }
+
+        if (m_light_volume_program)
+            ImGui::Checkbox("Sun Transmittance Volume", &m_light_volume);
+
+        if (m_sky_view_lut_program)
+            ImGui::Checkbox("Sky-View LUT", &m_sky_view_lut);
+
+        if (ImGui::Checkbox("Clip Clouds To Scene Depth", &m_depth_clipping))
+            m_history_valid = false;
+
+        if (m_weather_map_available)
+        {
+            if (ImGui::Checkbox("Weather Map", &m_weather_map))
+                m_history_valid = false;
+
+            if (m_weather_map)
+                ImGui::Text("Resident Weather Tiles: %u / %u", m_weather_residency.resident_tiles(), WEATHER_WINDOW_TILES * WEATHER_WINDOW_TILES);
+        }
+
+        if (m_cloud_shadow_map_program)
+        {
+            ImGui::Checkbox("Cloud Shadows", &m_cloud_shadows);
+
+            if (m_cloud_shadows)
+            {
+                ImGui::SliderFloat("Cloud Shadow Strength", &m_cloud_shadow_strength, 0.0f, 2.0f);
+                ImGui::SliderInt("Cloud Shadow Rows Per Frame", &m_cloud_shadow_rows_per_frame, 8, CLOUD_SHADOW_MAP_SIZE);
+                ImGui::SliderInt("Cloud Shadow Update Interval", &m_cloud_shadow_update_interval, 1, 120);
+            }
+        }
+
+        if (ImGui::Checkbox("Temporal Reprojection", &m_temporal_reprojection))
+            m_history_valid = false;
+
+        if (m_tiled_clouds_program)
+            ImGui::Checkbox("Tiled Compute Clouds", &m_tiled_clouds);
+
+        // Renders one face, or tile of a face, of the probe per frame. The main view only samples it for the ambient light of the ground.
+        if (ImGui::Checkbox("Cloud Probe", &m_cloud_probe))
+            m_cloud_probe_scheduler.reset(CLOUD_PROBE_SIZE, m_cloud_probe_tiles);
+
+        if (m_cloud_probe)
+        {
+            if (ImGui::SliderInt("Cloud Probe Tiles Per Axis", &m_cloud_probe_tiles, 1, 4))
+                m_cloud_probe_scheduler.reset(CLOUD_PROBE_SIZE, m_cloud_probe_tiles);
+
+            ImGui::Checkbox("Cloud Probe Mips", &m_cloud_probe_mips);
+            ImGui::SliderFloat("Cloud Probe Ambient", &m_cloud_probe_ambient, 0.0f, 4.0f);
+            ImGui::Text("Cloud Probe: %ux%u faces, updated every %u frames", CLOUD_PROBE_SIZE, CLOUD_PROBE_SIZE, m_cloud_probe_scheduler.frames_per_cycle());
+        }
+
+        // Samples coarser noise mips along the footprint of the ray and averages out the detail noise far away or behind opaque cloud,
+        // see density_lod() in cloud_march.glsl.
+        if (ImGui::Checkbox("Density LOD", &m_density_lod))
+            m_history_valid = false;
+
+        if (m_density_lod)
+        {
+            ImGui::SliderFloat("LOD Bias", &m_lod_bias, -4.0f, 4.0f);
+            ImGui::SliderFloat("LOD Detail Distance", &m_lod_detail_distance, 1000.0f, 50000.0f);
+            ImGui::SliderFloat("LOD Detail Opacity", &m_lod_detail_opacity, 0.5f, 1.0f);
+            ImGui::SliderFloat("LOD Cone Scale", &m_lod_cone_scale, 0.0f, 4.0f);
+        }
+
+        // Lowers the march steps, then the resolution of the clouds until their GPU time fits the budget, see cloud_budget.h. The
+        // temporal path only lowers its steps.
+        if (ImGui::Checkbox("Cloud Budget", &m_cloud_budget_enabled))
+            m_cloud_budget.reset(cloud_budget_settings());
+
+        if (m_cloud_budget_enabled)
+        {
+            ImGui::SliderFloat("Cloud Budget (ms)", &m_cloud_budget_ms, 0.5f, 33.0f);
+            ImGui::Text("Cloud Resolution: %.0f%%, Steps: %.0f%% (%.2f ms at full quality)", m_cloud_level.scale * 100.0f, m_cloud_level.step_fraction * 100.0f, m_cloud_budget.full_quality_ms());
+        }
+
+        // Tone maps in a compute pass that also builds the luminance histogram of the auto exposure, see auto_exposure.h.
+        if (m_tonemap_compute_program && m_auto_exposure_program)
+            ImGui::Checkbox("Compute Tonemap", &m_compute_tonemap);
+
+        if (compute_tonemap())
+            ImGui::Checkbox("Auto Exposure", &m_auto_exposure);
+
+        if (compute_tonemap() && m_auto_exposure)
+        {
+            ImGui::SliderFloat("Exposure Compensation", &m_auto_exposure_settings.compensation, -4.0f, 4.0f);
+            ImGui::SliderFloat("Exposure Key", &m_auto_exposure_settings.key, 0.05f, 1.0f);
+            ImGui::SliderFloat("Adaptation Speed Up", &m_auto_exposure_settings.speed_up, 0.1f, 10.0f);
+            ImGui::SliderFloat("Adaptation Speed Down", &m_auto_exposure_settings.speed_down, 0.1f, 10.0f);
+        }
+        else
+            ImGui::SliderFloat("Exposure", &m_exposure, 0.0f, 10.0f);
+
+        ImGui::Checkbox("Hot Reload Shaders", &m_shader_hot_reload);
+        ImGui::Text("Program Cache: %u hits, %u misses", m_shader_library.cache_hits(), m_shader_library.cache_misses());
+
+        // Switches to the instrumented variants of the cloud programs, see cloud_stats.h.
+        ImGui::Checkbox("Cloud Stats", &m_cloud_stats);
+
+        if (m_cloud_stats)
+        {
+            const char* heatmaps[CLOUD_STATS_COUNTER_COUNT + 1] = { "Off" };
+
+            for (int i = 0; i < CLOUD_STATS_COUNTER_COUNT; i++)
+                heatmaps[i + 1] = cloud_stats_counter_name(CloudStatsCounter(i));
+
+            ImGui::Combo("Heatmap", &m_cloud_stats_heatmap, heatmaps, CLOUD_STATS_COUNTER_COUNT + 1);
+
+            if (m_cloud_stats_heatmap > 0)
+                ImGui::SliderFloat("Heatmap Max", &m_cloud_stats_heatmap_max, 1.0f, 2048.0f);
+
+            const CloudStatsTotals& totals = m_cloud_stats_totals;
+            float                   pixels = float(std::max(totals.marched_pixels, 1u));
+
+            ImGui::Text("Frame %llu, %u marched pixels", (unsigned long long)m_cloud_stats_frame, totals.marched_pixels);
+
+            for (int i = 0; i < CLOUD_STATS_COUNTER_COUNT; i++)
+                ImGui::Text("%s: %u (%.1f per pixel)", cloud_stats_counter_name(CloudStatsCounter(i)), totals.counters[i], float(totals.counters[i]) / pixels);
+
+            ImGui::Text("Occupied Steps: %u (%.1f per pixel)", totals.occupied_steps, float(totals.occupied_steps) / pixels);
+        }
+
+        // High cloud as 2D cirrus layers above the volumetric shell, see cloud_layers.h.
+        if (ImGui::CollapsingHeader("Cloud Layers"))
+        {
+            ImGui::Text("Volumetric: %.0f to %.0f m", m_cloud_min_height, m_cloud_max_height);
+
+            int remove = -1;
+
+            for (int i = 0; i < int(m_cirrus_layers_gui.size()); i++)
+            {
+                CloudLayer& layer = m_cirrus_layers_gui[i];
+
+                ImGui::PushID(i);
+                ImGui::Text("Cirrus %d", i);
+
+                if (ImGui::InputFloat("Height", &layer.min_height))
+                    layer.max_height = layer.min_height;
+
+                ImGui::SliderFloat("Coverage", &layer.coverage, 0.0f, 1.0f);
+                ImGui::SliderFloat("Opacity", &layer.opacity, 0.0f, 1.0f);
+                ImGui::SliderFloat("Scale", &layer.scale, 1000.0f, 100000.0f);
+
+                if (ImGui::Button("Remove"))
+                    remove = i;
+
+                ImGui::PopID();
+            }
+
+            if (remove >= 0)
+                m_cirrus_layers_gui.erase(m_cirrus_layers_gui.begin() + remove);
+
+            if (m_cirrus_layers_gui.size() < CLOUD_MAX_CIRRUS_LAYERS && ImGui::Button("Add Cirrus Layer"))
+            {
+                CloudLayer layer;
+
+                layer.min_height = (m_cirrus_layers_gui.empty() ? m_cloud_max_height : m_cirrus_layers_gui.back().min_height) + 4000.0f;
+                layer.max_height = layer.min_height;
+
+                m_cirrus_layers_gui.push_back(layer);
+            }
+
+            if (!m_cloud_layers_error.empty())
+                ImGui::Text("Invalid Layers, keeping the last valid ones: %s", m_cloud_layers_error.c_str());
+        }
+
+        if (ImGui::CollapsingHeader("Profiler"))
+            m_profiler.gui();
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Checks the layer stack made of the volumetric shell and the cirrus layers 'cirrus'.
+    bool validate_cloud_layers(const std::vector<CloudLayer>& cirrus, std::string& error)
+    {
+        CloudLayer layers[CLOUD_MAX_LAYERS + 1];
+        uint32_t   count = 0;
+
+        layers[count].type       = CLOUD_LAYER_VOLUMETRIC;
+        layers[count].min_height = m_cloud_min_height;
+        layers[count].max_height = m_cloud_max_height;
+        count++;
+
+        for (size_t i = 0; i < cirrus.size() && count < CLOUD_MAX_LAYERS + 1; i++)
+            layers[count++] = cirrus[i];
+
+        return cloud_layers_validate(layers, count, error);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Applies the layers edited in the GUI if they make a valid stack, otherwise the last valid layers stay in use. Those are dropped
+    // too if the volumetric shell has since been moved into them, the shell alone is always a valid stack.
+    void update_cloud_layers()
+    {
+        if (validate_cloud_layers(m_cirrus_layers_gui, m_cloud_layers_error))
+        {
+            m_cirrus_layers = m_cirrus_layers_gui;
+            m_cloud_layers_error.clear();
+            return;
+        }
+
+        std::string error;
+
+        if (!validate_cloud_layers(m_cirrus_layers, error))
+            m_cirrus_layers.clear();
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
@@ -113,7 +718,7 @@ protected:
     void window_resized(int width, int height) override
     {
         // Override window resized method to update camera projection.
-        m_main_camera->update_projection(60.0f, 1.0f, CAMERA_FAR_PLANE, float(m_width) / float(m_height));
+        m_main_camera->update_projection(CAMERA_FOV, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE, float(m_width) / float(m_height));
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
@@ -199,18 +804,12 @@ private:
 
     bool create_shaders()
     {
-        // Create general shaders
-        m_mesh_vs = dw::gl::Shader::create_from_file(GL_VERTEX_SHADER, "shader/mesh_vs.glsl");
-        m_mesh_fs = dw::gl::Shader::create_from_file(GL_FRAGMENT_SHADER, "shader/mesh_fs.glsl");
+        auto start = std::chrono::high_resolution_clock::now();
 
-        if (!m_mesh_vs || !m_mesh_fs)
-        {
-            DW_LOG_FATAL("Failed to create Shaders");
-            return false;
-        }
+        m_shader_library.create(m_program_cache);
 
         // Create general shader program
-        m_mesh_program = dw::gl::Program::create({ m_mesh_vs, m_mesh_fs });
+        m_mesh_program = m_shader_library.load({ { GL_VERTEX_SHADER, "shader/mesh_vs.glsl" }, { GL_FRAGMENT_SHADER, "shader/mesh_fs.glsl" } });
 
         if (!m_mesh_program)
         {
@@ -218,64 +817,106 @@ private:
             return false;
         }
 
-        // Create clouds shaders
-        m_triangle_vs = dw::gl::Shader::create_from_file(GL_VERTEX_SHADER, "shader/triangle_vs.glsl");
-        m_clouds_fs   = dw::gl::Shader::create_from_file(GL_FRAGMENT_SHADER, "shader/clouds_fs.glsl");
+        // Create clouds shader program. The variants of the quality tiers are built the first time they are selected.
+        m_clouds_variants.create(&m_shader_library, { { GL_VERTEX_SHADER, "shader/triangle_vs.glsl" }, { GL_FRAGMENT_SHADER, "shader/clouds_fs.glsl" } });
+        m_clouds_program = m_clouds_variants.get(ShaderDefines());
 
-        if (!m_triangle_vs || !m_clouds_fs)
+        if (!m_clouds_program)
         {
-            DW_LOG_FATAL("Failed to create Shaders");
+            DW_LOG_FATAL("Failed to create Shader Program");
             return false;
         }
 
-        // Create general shader program
-        m_clouds_program = dw::gl::Program::create({ m_triangle_vs, m_clouds_fs });
+        m_tonemap_program = m_shader_library.load({ { GL_VERTEX_SHADER, "shader/triangle_vs.glsl" }, { GL_FRAGMENT_SHADER, "shader/tonemap_fs.glsl" } });
 
-        if (!m_clouds_program)
+        if (!m_tonemap_program)
         {
             DW_LOG_FATAL("Failed to create Shader Program");
             return false;
         }
 
-        m_tonemap_fs = dw::gl::Shader::create_from_file(GL_FRAGMENT_SHADER, "shader/tonemap_fs.glsl");
+        m_cloud_stats_heatmap_program = m_shader_library.load({ { GL_VERTEX_SHADER, "shader/triangle_vs.glsl" }, { GL_FRAGMENT_SHADER, "shader/cloud_stats_heatmap_fs.glsl" } });
 
-        if (!m_tonemap_fs)
+        if (!m_cloud_stats_heatmap_program)
+            DW_LOG_WARNING("Failed to create cloud stats heatmap program, the heatmap view is not available");
+
+        m_tonemap_compute_program = m_shader_library.load({ { GL_COMPUTE_SHADER, "shader/tonemap_cs.glsl" } });
+        m_auto_exposure_program   = m_shader_library.load({ { GL_COMPUTE_SHADER, "shader/auto_exposure_cs.glsl" } });
+
+        if (!m_tonemap_compute_program || !m_auto_exposure_program)
         {
-            DW_LOG_FATAL("Failed to create Shaders");
-            return false;
+            m_tonemap_compute_program.reset();
+            DW_LOG_WARNING("Failed to create compute tonemap programs, falling back to the full-screen tonemap pass without auto exposure");
         }
 
-        // Create general shader program
-        m_tonemap_program = dw::gl::Program::create({ m_triangle_vs, m_tonemap_fs });
+        // Create temporal reprojection shader programs
+        m_clouds_reconstruct_program = m_shader_library.load({ { GL_VERTEX_SHADER, "shader/triangle_vs.glsl" }, { GL_FRAGMENT_SHADER, "shader/clouds_reconstruct_fs.glsl" } });
+        m_copy_program               = m_shader_library.load({ { GL_VERTEX_SHADER, "shader/triangle_vs.glsl" }, { GL_FRAGMENT_SHADER, "shader/copy_fs.glsl" } });
 
-        if (!m_tonemap_program)
+        if (!m_clouds_reconstruct_program || !m_copy_program)
         {
             DW_LOG_FATAL("Failed to create Shader Program");
             return false;
         }
 
-        m_shape_noise_cs = dw::gl::Shader::create_from_file(GL_COMPUTE_SHADER, "shader/shape_noise_cs.glsl");
-
-        // Create general shader program
-        m_shape_noise_program = dw::gl::Program::create({ m_shape_noise_cs });
+        m_clouds_upsample_program = m_shader_library.load({ { GL_VERTEX_SHADER, "shader/triangle_vs.glsl" }, { GL_FRAGMENT_SHADER, "shader/clouds_upsample_fs.glsl" } });
 
-        if (!m_shape_noise_program)
+        if (!m_clouds_upsample_program)
         {
             DW_LOG_FATAL("Failed to create Shader Program");
             return false;
         }
 
-        m_detail_noise_cs = dw::gl::Shader::create_from_file(GL_COMPUTE_SHADER, "shader/detail_noise_cs.glsl");
+        // The noise compute shaders are optional, the noise volumes are generated on the CPU if they are not available.
+        m_shape_noise_program = m_shader_library.load({ { GL_COMPUTE_SHADER, "shader/shape_noise_cs.glsl" } });
 
-        // Create general shader program
-        m_detail_noise_program = dw::gl::Program::create({ m_detail_noise_cs });
+        if (!m_shape_noise_program)
+            DW_LOG_WARNING("Failed to create shape noise program, falling back to CPU noise generation");
+
+        m_detail_noise_program = m_shader_library.load({ { GL_COMPUTE_SHADER, "shader/detail_noise_cs.glsl" } });
 
         if (!m_detail_noise_program)
+            DW_LOG_WARNING("Failed to create detail noise program, falling back to CPU noise generation");
+
+        m_empty_space_grid_program = m_shader_library.load({ { GL_COMPUTE_SHADER, "shader/empty_space_grid_cs.glsl" } });
+
+        if (!m_empty_space_grid_program)
+            DW_LOG_WARNING("Failed to create empty space grid program, falling back to building it on the CPU");
+
+        m_noise_downsample_program = m_shader_library.load({ { GL_COMPUTE_SHADER, "shader/noise_downsample_cs.glsl" } });
+
+        if (!m_noise_downsample_program)
+            DW_LOG_WARNING("Failed to create noise downsample program, noise regeneration falls back to the CPU");
+
+        m_light_volume_program = m_shader_library.load({ { GL_COMPUTE_SHADER, "shader/light_volume_cs.glsl" } });
+
+        if (!m_light_volume_program)
+            DW_LOG_WARNING("Failed to create light volume program, falling back to cone sampling");
+
+        m_cloud_shadow_map_program = m_shader_library.load({ { GL_COMPUTE_SHADER, "shader/cloud_shadow_map_cs.glsl" } });
+
+        if (!m_cloud_shadow_map_program)
+            DW_LOG_WARNING("Failed to create cloud shadow map program, the ground will not be shadowed by the clouds");
+
+        m_sky_view_lut_program = m_shader_library.load({ { GL_COMPUTE_SHADER, "shader/sky_view_lut_cs.glsl" } });
+
+        if (!m_sky_view_lut_program)
+            DW_LOG_WARNING("Failed to create sky-view LUT program, falling back to evaluating the sky per pixel");
+
+        m_cloud_tile_classify_program = m_shader_library.load({ { GL_COMPUTE_SHADER, "shader/cloud_tile_classify_cs.glsl" } });
+        m_tiled_clouds_variants.create(&m_shader_library, { { GL_COMPUTE_SHADER, "shader/clouds_cs.glsl" } });
+        m_tiled_clouds_program = m_tiled_clouds_variants.get(ShaderDefines());
+
+        if (!m_cloud_tile_classify_program || !m_tiled_clouds_program)
         {
-            DW_LOG_FATAL("Failed to create Shader Program");
-            return false;
+            m_tiled_clouds_program.reset();
+            DW_LOG_WARNING("Failed to create tiled cloud programs, falling back to the full-screen cloud pass");
         }
 
+        auto end = std::chrono::high_resolution_clock::now();
+
+        DW_LOG_INFO("Created shader programs in " + std::to_string(std::chrono::duration<double, std::milli>(end - start).count()) + " ms, " + std::to_string(m_shader_library.cache_hits()) + " from the program cache");
+
         return true;
     }
 
@@ -291,201 +932,1754 @@ private:
 
         m_hdr_output_framebuffer = dw::gl::Framebuffer::create({ m_hdr_output_texture }, m_depth_output_texture);
 
-        m_shape_noise_texture = dw::gl::Texture3D::create(128, 128, 128, -1, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
-        m_shape_noise_texture->set_wrapping(GL_REPEAT, GL_REPEAT, GL_REPEAT);
-        m_shape_noise_texture->set_min_filter(GL_LINEAR_MIPMAP_LINEAR);
+        // Same color target without the depth attachment, for the cloud composite passes that sample the depth texture.
+        m_hdr_composite_framebuffer = dw::gl::Framebuffer::create({ m_hdr_output_texture });
 
-        m_detail_noise_texture = dw::gl::Texture3D::create(32, 32, 32, -1, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
-        m_detail_noise_texture->set_wrapping(GL_REPEAT, GL_REPEAT, GL_REPEAT);
-        m_detail_noise_texture->set_min_filter(GL_LINEAR_MIPMAP_LINEAR);
+        // Written by the compute tonemap, then blitted to the default framebuffer which cannot be bound as an image.
+        m_ldr_output_texture = dw::gl::Texture2D::create(m_width, m_height, 1, 1, 1, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
 
-        m_blue_noise_texture = dw::gl::Texture2D::create_from_file("texture/LDR_LLL1_0.png");
-        m_blue_noise_texture->set_wrapping(GL_REPEAT, GL_REPEAT, GL_REPEAT);
+        glCreateFramebuffers(1, &m_ldr_output_framebuffer);
+        glNamedFramebufferTexture(m_ldr_output_framebuffer, GL_COLOR_ATTACHMENT0, m_ldr_output_texture->id(), 0);
 
-        m_curl_noise_texture = dw::gl::Texture2D::create_from_file("texture/curlNoise.png");
-        m_curl_noise_texture->set_wrapping(GL_REPEAT, GL_REPEAT, GL_REPEAT);
+        // Integer texture, incomplete unless filtered with GL_NEAREST.
+        m_cloud_stats_texture = dw::gl::Texture2D::create(m_width, m_height, 1, 1, 1, GL_RGBA32UI, GL_RGBA_INTEGER, GL_UNSIGNED_INT);
+        m_cloud_stats_texture->set_min_filter(GL_NEAREST);
+        m_cloud_stats_texture->set_mag_filter(GL_NEAREST);
 
-        return true;
+        glCreateBuffers(PROFILER_FRAMES_IN_FLIGHT, m_cloud_stats_buffers);
+
+        for (uint32_t i = 0; i < PROFILER_FRAMES_IN_FLIGHT; i++)
+            glNamedBufferStorage(m_cloud_stats_buffers[i], sizeof(CloudStatsTotals), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        // Starts from the manual exposure, the histogram is cleared by every auto exposure pass.
+        AutoExposureState auto_exposure_state = { m_exposure, m_exposure, 0.0f, 0.0f };
+
+        glCreateBuffers(1, &m_auto_exposure_buffer);
+        glNamedBufferStorage(m_auto_exposure_buffer, sizeof(AutoExposureState) + sizeof(uint32_t) * AUTO_EXPOSURE_HISTOGRAM_BINS, nullptr, GL_DYNAMIC_STORAGE_BIT);
+        glClearNamedBufferData(m_auto_exposure_buffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        glNamedBufferSubData(m_auto_exposure_buffer, 0, sizeof(auto_exposure_state), &auto_exposure_state);
+
+        glm::ivec2 lowres_size = temporal_lowres_size(m_width, m_height);
+
+        m_clouds_lowres_texture = dw::gl::Texture2D::create(lowres_size.x, lowres_size.y, 1, 1, 1, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+        m_clouds_lowres_texture->set_wrapping(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+        m_clouds_lowres_framebuffer = dw::gl::Framebuffer::create({ m_clouds_lowres_texture });
+
+        for (int i = 0; i < 2; i++)
+        {
+            m_clouds_history_texture[i] = dw::gl::Texture2D::create(m_width, m_height, 1, 1, 1, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+            m_clouds_history_texture[i]->set_wrapping(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+            m_clouds_history_framebuffer[i] = dw::gl::Framebuffer::create({ m_clouds_history_texture[i] });
+        }
+
+        m_shape_noise_texture  = create_noise_texture(SHAPE_NOISE_SIZE, CPU_NOISE_VOLUME_SHAPE, m_noise_format);
+        m_detail_noise_texture = create_noise_texture(DETAIL_NOISE_SIZE, CPU_NOISE_VOLUME_DETAIL, m_noise_format);
+
+        glGenQueries(PROFILER_FRAMES_IN_FLIGHT * 2, &m_noise_timer_queries[0][0]);
+
+        const uint32_t EMPTY_SPACE_GRID_SIZE = SHAPE_NOISE_SIZE / EMPTY_SPACE_CELL_SIZE;
+
+        m_empty_space_grid_texture = dw::gl::Texture3D::create(EMPTY_SPACE_GRID_SIZE, EMPTY_SPACE_GRID_SIZE, EMPTY_SPACE_GRID_SIZE, 1, GL_R32F, GL_RED, GL_FLOAT);
+        m_empty_space_grid_texture->set_min_filter(GL_NEAREST);
+        m_empty_space_grid_texture->set_mag_filter(GL_NEAREST);
+
+        glCreateBuffers(1, &m_coverage_bound_buffer);
+        glNamedBufferStorage(m_coverage_bound_buffer, sizeof(float) * EMPTY_SPACE_GRID_SIZE * EMPTY_SPACE_GRID_SIZE * EMPTY_SPACE_GRID_SIZE, nullptr, GL_CLIENT_STORAGE_BIT);
+
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            m_light_volume_texture[i] = dw::gl::Texture3D::create(LIGHT_VOLUME_SIZE, LIGHT_VOLUME_SIZE, LIGHT_VOLUME_HEIGHT, 1, GL_R16F, GL_RED, GL_HALF_FLOAT);
+            m_light_volume_texture[i]->set_min_filter(GL_LINEAR);
+            m_light_volume_texture[i]->set_mag_filter(GL_LINEAR);
+            m_light_volume_texture[i]->set_wrapping(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+        }
+
+        for (uint32_t i = 0; i < 2; i++)
+        {
+            m_cloud_shadow_map_texture[i] = dw::gl::Texture2D::create(CLOUD_SHADOW_MAP_SIZE, CLOUD_SHADOW_MAP_SIZE, 1, 1, 1, GL_R16F, GL_RED, GL_HALF_FLOAT);
+            m_cloud_shadow_map_texture[i]->set_min_filter(GL_LINEAR);
+            m_cloud_shadow_map_texture[i]->set_mag_filter(GL_LINEAR);
+            m_cloud_shadow_map_texture[i]->set_wrapping(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+        }
+
+        // Tile list of the tiled compute path, sized for the full resolution target which also covers the quarter resolution one.
+        GLsizeiptr tile_buffer_size = sizeof(CloudTileHeader) + sizeof(uint32_t) * cloud_tile_count(m_width) * cloud_tile_count(m_height);
+
+        glCreateBuffers(1, &m_cloud_tile_buffer);
+        glNamedBufferStorage(m_cloud_tile_buffer, tile_buffer_size, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+        // Fixed size whatever the size of the weather map, see weather_map.h.
+        m_weather_atlas_texture = dw::gl::Texture2D::create(WEATHER_ATLAS_TILES * WEATHER_TILE_SIZE, WEATHER_ATLAS_TILES * WEATHER_TILE_SIZE, 1, 1, 1, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE);
+        m_weather_atlas_texture->set_min_filter(GL_LINEAR);
+        m_weather_atlas_texture->set_mag_filter(GL_LINEAR);
+        m_weather_atlas_texture->set_wrapping(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+        m_weather_indirection_texture = dw::gl::Texture2D::create(WEATHER_WINDOW_TILES, WEATHER_WINDOW_TILES, 1, 1, 1, GL_RGBA8UI, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE);
+        m_weather_indirection_texture->set_min_filter(GL_NEAREST);
+        m_weather_indirection_texture->set_mag_filter(GL_NEAREST);
+        m_weather_indirection_texture->set_wrapping(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+        // Wraps around the azimuth, clamps at the horizon and the zenith.
+        m_sky_view_lut_texture = dw::gl::Texture2D::create(SKY_VIEW_LUT_WIDTH, SKY_VIEW_LUT_HEIGHT, 1, 1, 1, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+        m_sky_view_lut_texture->set_min_filter(GL_LINEAR);
+        m_sky_view_lut_texture->set_mag_filter(GL_LINEAR);
+        m_sky_view_lut_texture->set_wrapping(GL_REPEAT, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+        m_cloud_probe_texture = dw::gl::TextureCube::create(CLOUD_PROBE_SIZE, CLOUD_PROBE_SIZE, 1, -1, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+        m_cloud_probe_texture->set_min_filter(GL_LINEAR_MIPMAP_LINEAR);
+        m_cloud_probe_texture->set_mag_filter(GL_LINEAR);
+        m_cloud_probe_texture->set_wrapping(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+        glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+
+        // The probe sees no scene geometry, its depth stays at the far plane.
+        float far_depth = 1.0f;
+
+        m_cloud_probe_depth_texture = dw::gl::Texture2D::create(CLOUD_PROBE_SIZE, CLOUD_PROBE_SIZE, 1, 1, 1, GL_DEPTH_COMPONENT32F, GL_DEPTH_COMPONENT, GL_FLOAT);
+        glClearTexImage(m_cloud_probe_depth_texture->id(), 0, GL_DEPTH_COMPONENT, GL_FLOAT, &far_depth);
+
+        glCreateFramebuffers(1, &m_cloud_probe_framebuffer);
+
+        m_cloud_probe_scheduler.reset(CLOUD_PROBE_SIZE, m_cloud_probe_tiles);
+
+        m_blue_noise_texture = dw::gl::Texture2D::create_from_file("texture/LDR_LLL1_0.png");
+        m_blue_noise_texture->set_wrapping(GL_REPEAT, GL_REPEAT, GL_REPEAT);
+
+        m_curl_noise_texture = dw::gl::Texture2D::create_from_file("texture/curlNoise.png");
+        m_curl_noise_texture->set_wrapping(GL_REPEAT, GL_REPEAT, GL_REPEAT);
+
+        // Generated on the CPU with its mips and converted to half there, so that the reference renderer samples the same texels.
+        std::vector<std::vector<float>> cirrus_mips;
+        cloud_cirrus_texture_generate(CLOUD_CIRRUS_TEXTURE_SIZE, CLOUD_CIRRUS_TEXTURE_FREQUENCY, cirrus_mips);
+
+        m_cirrus_noise_texture = dw::gl::Texture2D::create(CLOUD_CIRRUS_TEXTURE_SIZE, CLOUD_CIRRUS_TEXTURE_SIZE, 1, int32_t(cirrus_mips.size()), 1, GL_R16F, GL_RED, GL_HALF_FLOAT);
+        m_cirrus_noise_texture->set_min_filter(GL_LINEAR_MIPMAP_LINEAR);
+        m_cirrus_noise_texture->set_mag_filter(GL_LINEAR);
+        m_cirrus_noise_texture->set_wrapping(GL_REPEAT, GL_REPEAT, GL_REPEAT);
+
+        for (uint32_t i = 0; i < cirrus_mips.size(); i++)
+        {
+            std::vector<uint16_t> half(cirrus_mips[i].size());
+
+            for (size_t j = 0; j < half.size(); j++)
+                half[j] = cpu_noise_float_to_half(cirrus_mips[i][j]);
+
+            int32_t mip_size = int32_t(CLOUD_CIRRUS_TEXTURE_SIZE >> i);
+
+            glTextureSubImage2D(m_cirrus_noise_texture->id(), i, 0, 0, mip_size, mip_size, GL_RED, GL_HALF_FLOAT, half.data());
+        }
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void shutdown() override
+    {
+        m_weather_residency.shutdown();
+
+        m_global_ubo.destroy();
+        m_cloud_ubo.destroy();
+        m_cloud_probe_ubo.destroy();
+        m_profiler.destroy();
+
+        if (m_cloud_tile_buffer)
+            glDeleteBuffers(1, &m_cloud_tile_buffer);
+
+        if (m_coverage_bound_buffer)
+            glDeleteBuffers(1, &m_coverage_bound_buffer);
+
+        if (m_coverage_bound_fence)
+            glDeleteSync(m_coverage_bound_fence);
+
+        if (m_cloud_probe_framebuffer)
+            glDeleteFramebuffers(1, &m_cloud_probe_framebuffer);
+
+        if (m_ldr_output_framebuffer)
+            glDeleteFramebuffers(1, &m_ldr_output_framebuffer);
+
+        if (m_auto_exposure_buffer)
+            glDeleteBuffers(1, &m_auto_exposure_buffer);
+
+        if (m_cloud_stats_buffers[0])
+            glDeleteBuffers(PROFILER_FRAMES_IN_FLIGHT, m_cloud_stats_buffers);
+
+        for (uint32_t i = 0; i < PROFILER_FRAMES_IN_FLIGHT; i++)
+        {
+            if (m_cloud_stats_fences[i])
+                glDeleteSync(m_cloud_stats_fences[i]);
+        }
+
+        glDeleteQueries(PROFILER_FRAMES_IN_FLIGHT * 2, &m_noise_timer_queries[0][0]);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    bool create_uniform_buffer()
+    {
+        // Create uniform buffers for global data and the cloud parameters.
+        if (!m_global_ubo.create(sizeof(GlobalUniforms)))
+            return false;
+
+        if (!m_cloud_ubo.create(sizeof(CloudUniforms)))
+            return false;
+
+        // The view of the cloud probe face being rendered.
+        if (!m_cloud_probe_ubo.create(sizeof(GlobalUniforms)))
+            return false;
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    bool load_scene()
+    {
+        m_placeholder_texture = dw::gl::Texture2D::create_from_file("texture/grid.png", true, true);
+
+        m_plane = dw::Mesh::load("mesh/plane.obj");
+
+        if (!m_plane)
+        {
+            DW_LOG_FATAL("Failed to load mesh: plane");
+            return false;
+        }
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void create_camera()
+    {
+        m_main_camera = std::make_unique<dw::Camera>(CAMERA_FOV, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE, float(m_width) / float(m_height), glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(-1.0f, 0.0, 0.0f));
+        m_main_camera->update();
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Recompiles the programs whose files changed on disk and drops everything that was built with them.
+    void reload_shaders()
+    {
+        if (!m_shader_library.poll(m_reloaded_programs))
+            return;
+
+        for (ShaderProgram* program : m_reloaded_programs)
+        {
+            if (program == m_shape_noise_program.get() || program == m_detail_noise_program.get() || program == m_noise_downsample_program.get())
+                start_noise_regeneration();
+            else if (program == m_empty_space_grid_program.get())
+                build_empty_space_grid();
+        }
+
+        m_sky_view_lut_valid     = false;
+        m_light_volume_valid     = false;
+        m_cloud_shadow_map_valid = false;
+        m_history_valid          = false;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Texture formats of NoiseFormat, see noise_format.h.
+    dw::gl::Texture3D::Ptr create_noise_texture(uint32_t size, CpuNoiseVolume volume, NoiseFormat format)
+    {
+        const GLenum FORMATS[]        = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+        const GLenum UNORM8_FORMATS[] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+
+        uint32_t               channels = noise_format_channels(format, volume);
+        dw::gl::Texture3D::Ptr texture;
+
+        if (format == NOISE_FORMAT_RGBA16F)
+            texture = dw::gl::Texture3D::create(size, size, size, -1, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+        else
+            texture = dw::gl::Texture3D::create(size, size, size, -1, UNORM8_FORMATS[channels - 1], FORMATS[channels - 1], GL_UNSIGNED_BYTE);
+
+        texture->set_wrapping(GL_REPEAT, GL_REPEAT, GL_REPEAT);
+        texture->set_min_filter(GL_LINEAR_MIPMAP_LINEAR);
+
+        return texture;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void set_noise_format(NoiseFormat format)
+    {
+        if (format == m_noise_back_format)
+            return;
+
+        m_noise_back_format = format;
+
+        start_noise_regeneration();
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Restarts the regeneration of both volumes with the current frequencies and m_noise_back_format. The front volumes stay in use
+    // until both back volumes are complete, see update_noise_regeneration().
+    void start_noise_regeneration()
+    {
+        m_shape_noise_back_texture  = create_noise_texture(SHAPE_NOISE_SIZE, CPU_NOISE_VOLUME_SHAPE, m_noise_back_format);
+        m_detail_noise_back_texture = create_noise_texture(DETAIL_NOISE_SIZE, CPU_NOISE_VOLUME_DETAIL, m_noise_back_format);
+
+        // Compute shaders can only store the RGBA16F format, the others are built on the CPU like at startup.
+        m_noise_regenerating        = true;
+        m_noise_regeneration_on_gpu = m_noise_back_format == NOISE_FORMAT_RGBA16F && m_shape_noise_program && m_detail_noise_program && m_noise_downsample_program && !m_cpu_noise;
+
+        m_noise_budget.reset(m_noise_regeneration_on_gpu ? NOISE_GPU_MS_PER_MTEXEL : NOISE_CPU_MS_PER_MTEXEL);
+
+        for (uint32_t i = 0; i < PROFILER_FRAMES_IN_FLIGHT; i++)
+            m_noise_timer_texels[i] = 0;
+
+        begin_noise_volume(CPU_NOISE_VOLUME_SHAPE);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Loads a back volume from its cache if it holds the same volume, otherwise schedules its slabs. Runtime rebuilds never write the
+    // caches, that would need a readback of the whole volume.
+    void begin_noise_volume(CpuNoiseVolume volume)
+    {
+        dw::gl::Texture3D::Ptr texture = noise_back_texture(volume);
+
+        m_noise_back_volume = volume;
+
+        if (load_noise_texture_from_cache(texture, noise_format_cache_path(m_noise_back_format, volume), noise_volume_cache_key(volume, m_noise_back_format)))
+        {
+            m_noise_scheduler.cancel();
+            return;
+        }
+
+        m_noise_scheduler.begin(texture->width(), m_noise_regeneration_on_gpu ? NOISE_SLAB_DEPTH : 1);
+
+        if (!m_noise_regeneration_on_gpu)
+        {
+            uint32_t channels = noise_format_channels(m_noise_back_format, volume);
+
+            m_noise_back_mips.resize(noise_texture_mip_count(texture));
+
+            for (uint32_t i = 0; i < m_noise_back_mips.size(); i++)
+            {
+                size_t size = std::max(texture->width() >> i, 1u);
+                m_noise_back_mips[i].resize(size * size * size * channels);
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Builds the slabs of the back volumes that fit into m_noise_budget_ms and swaps both with the front volumes once they are complete.
+    void update_noise_regeneration()
+    {
+        resolve_coverage_bound();
+        resolve_noise_timers();
+
+        if (!m_noise_regenerating)
+            return;
+
+        if (m_noise_scheduler.active())
+        {
+            uint64_t texels = m_noise_scheduler.advance(m_noise_budget.texels(m_noise_budget_ms), m_noise_ranges);
+
+            if (m_noise_regeneration_on_gpu)
+                build_noise_slabs_on_gpu(texels);
+            else
+                build_noise_slabs_on_cpu(texels);
+        }
+
+        if (m_noise_scheduler.active())
+            return;
+
+        if (m_noise_back_volume == CPU_NOISE_VOLUME_SHAPE)
+        {
+            begin_noise_volume(CPU_NOISE_VOLUME_DETAIL);
+            return;
+        }
+
+        // Make the image stores visible to the passes sampling the volumes from now on.
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        m_shape_noise_texture  = m_shape_noise_back_texture;
+        m_detail_noise_texture = m_detail_noise_back_texture;
+        m_noise_format         = m_noise_back_format;
+
+        m_shape_noise_back_texture.reset();
+        m_detail_noise_back_texture.reset();
+        m_noise_back_mips.clear();
+
+        m_noise_regenerating = false;
+
+        build_empty_space_grid();
+
+        m_density_generation++;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Issues the ranges of this frame without waiting for them. Their GPU time is read back by resolve_noise_timers() a few frames later.
+    void build_noise_slabs_on_gpu(uint64_t texels)
+    {
+        dw::gl::Texture3D::Ptr texture = noise_back_texture(m_noise_back_volume);
+        GLuint*                queries = m_noise_timer_queries[m_noise_timer_next];
+
+        glQueryCounter(queries[0], GL_TIMESTAMP);
+
+        for (const NoiseSliceRange& range : m_noise_ranges)
+        {
+            if (range.mip == 0)
+            {
+                if (m_noise_back_volume == CPU_NOISE_VOLUME_SHAPE)
+                    dispatch_noise_program(m_shape_noise_program, texture, m_shape_noise_frequency, range.first, range.count);
+                else
+                    dispatch_noise_program(m_detail_noise_program, texture, m_detail_noise_frequency, range.first, range.count);
+
+                continue;
+            }
+
+            // The source slices were written by image stores of this or an earlier range.
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+            const uint32_t SIZE        = std::max(texture->width() >> range.mip, 1u);
+            const uint32_t NUM_THREADS = 4;
+
+            m_noise_downsample_program->use();
+            m_noise_downsample_program->set_uniform("u_SourceMip", (int)range.mip - 1);
+            m_noise_downsample_program->set_uniform("u_SliceOffset", (int)range.first);
+            m_noise_downsample_program->set_uniform("u_SliceCount", (int)range.count);
+
+            if (m_noise_downsample_program->set_uniform("s_Noise", 0))
+                texture->bind(0);
+
+            texture->bind_image(0, range.mip, 0, GL_WRITE_ONLY, texture->internal_format());
+
+            glDispatchCompute((SIZE + NUM_THREADS - 1) / NUM_THREADS, (SIZE + NUM_THREADS - 1) / NUM_THREADS, (range.count + NUM_THREADS - 1) / NUM_THREADS);
+        }
+
+        glQueryCounter(queries[1], GL_TIMESTAMP);
+
+        m_noise_timer_texels[m_noise_timer_next] = texels;
+        m_noise_timer_next                       = (m_noise_timer_next + 1) % PROFILER_FRAMES_IN_FLIGHT;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Generates, packs and quantizes the slices of mip 0 and box filters the quantized slices into the mips, like glGenerateMipmap()
+    // does with the startup volumes, then uploads only the slices of this frame.
+    void build_noise_slabs_on_cpu(uint64_t texels)
+    {
+        dw::gl::Texture3D::Ptr texture   = noise_back_texture(m_noise_back_volume);
+        float                  frequency = m_noise_back_volume == CPU_NOISE_VOLUME_SHAPE ? m_shape_noise_frequency : m_detail_noise_frequency;
+        uint32_t               channels  = noise_format_channels(m_noise_back_format, m_noise_back_volume);
+        uint32_t               size      = texture->width();
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        std::vector<float>   rgba;
+        std::vector<float>   packed;
+        std::vector<uint8_t> bytes;
+
+        glBindTexture(GL_TEXTURE_3D, texture->id());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (const NoiseSliceRange& range : m_noise_ranges)
+        {
+            uint32_t mip_size    = std::max(size >> range.mip, 1u);
+            size_t   slice_count = size_t(mip_size) * mip_size * channels;
+            float*   slices      = &m_noise_back_mips[range.mip][range.first * slice_count];
+
+            if (range.mip == 0)
+            {
+                rgba.resize(size_t(size) * size * range.count * 4);
+
+                cpu_noise_generate_slices(m_noise_back_volume, size, frequency, cpu_noise_best_backend(), 0, range.first, range.count, rgba.data());
+                noise_format_pack(m_noise_back_format, m_noise_back_volume, rgba.data(), rgba.size() / 4, packed);
+
+                memcpy(slices, packed.data(), sizeof(float) * packed.size());
+            }
+            else
+                noise_downsample_slices(m_noise_back_mips[range.mip - 1].data(), mip_size * 2, channels, range.first, range.count, m_noise_back_mips[range.mip].data());
+
+            for (size_t i = 0; i < slice_count * range.count; i++)
+                slices[i] = noise_format_quantize(m_noise_back_format, slices[i]);
+
+            noise_format_encode(m_noise_back_format, slices, slice_count * range.count, bytes);
+
+            glTexSubImage3D(GL_TEXTURE_3D, range.mip, 0, 0, range.first, mip_size, mip_size, range.count, texture->format(), texture->type(), bytes.data());
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_3D, 0);
+
+        auto end = std::chrono::high_resolution_clock::now();
+
+        m_noise_budget.report(texels, std::chrono::duration<float, std::milli>(end - start).count());
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Feeds the GPU time of earlier frames into the budget. Never waits, results still pending when their queries are reused are dropped.
+    void resolve_noise_timers()
+    {
+        for (uint32_t i = 0; i < PROFILER_FRAMES_IN_FLIGHT; i++)
+        {
+            if (m_noise_timer_texels[i] == 0)
+                continue;
+
+            GLint available = 0;
+            glGetQueryObjectiv(m_noise_timer_queries[i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+            if (!available && i != m_noise_timer_next)
+                continue;
+
+            if (available)
+            {
+                GLuint64 start = 0;
+                GLuint64 end   = 0;
+
+                glGetQueryObjectui64v(m_noise_timer_queries[i][0], GL_QUERY_RESULT, &start);
+                glGetQueryObjectui64v(m_noise_timer_queries[i][1], GL_QUERY_RESULT, &end);
+
+                m_noise_budget.report(m_noise_timer_texels[i], float(double(end - start) / 1000000.0));
+            }
+
+            m_noise_timer_texels[i] = 0;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Writes z-slices [first, first + count) of mip 0 of an RGBA16F noise volume.
+    void dispatch_noise_program(ShaderProgram::Ptr program, dw::gl::Texture3D::Ptr texture, float frequency, uint32_t first, uint32_t count)
+    {
+        program->use();
+        program->set_uniform("u_Size", (int)texture->width());
+        program->set_uniform("u_Frequency", frequency);
+        program->set_uniform("u_SliceOffset", (int)first);
+
+        texture->bind_image(0, 0, 0, GL_READ_WRITE, texture->internal_format());
+
+        const uint32_t TEXTURE_SIZE = texture->width();
+        const uint32_t NUM_THREADS  = 8;
+
+        glDispatchCompute(TEXTURE_SIZE / NUM_THREADS, TEXTURE_SIZE / NUM_THREADS, count / NUM_THREADS);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Writes mip 0 of a noise volume. The compute shaders write RGBA16F volumes directly. The other formats are generated as RGBA first,
+    // then packed on the CPU by noise_format_pack() like in the reference renderer, there is no rgb8 image format to store to anyway.
+    void generate_noise_texels(dw::gl::Texture3D::Ptr texture, CpuNoiseVolume volume, ShaderProgram::Ptr program, float frequency)
+    {
+        bool use_gpu = program && !m_cpu_noise;
+
+        if (m_noise_format == NOISE_FORMAT_RGBA16F)
+        {
+            if (use_gpu)
+            {
+                dispatch_noise_program(program, texture, frequency, 0, texture->width());
+                glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+            }
+            else
+                generate_noise_texture_on_cpu(texture, volume, frequency);
+
+            return;
+        }
+
+        uint32_t             size = texture->width();
+        std::vector<float>   texels(size_t(size) * size * size * 4);
+        std::vector<float>   packed;
+        std::vector<uint8_t> bytes;
+
+        if (use_gpu)
+        {
+            dw::gl::Texture3D::Ptr rgba = dw::gl::Texture3D::create(size, size, size, 1, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+
+            dispatch_noise_program(program, rgba, frequency, 0, size);
+            glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+
+            glBindTexture(GL_TEXTURE_3D, rgba->id());
+            glGetTexImage(GL_TEXTURE_3D, 0, GL_RGBA, GL_FLOAT, texels.data());
+        }
+        else
+            cpu_noise_generate(volume, size, frequency, cpu_noise_best_backend(), 0, texels.data());
+
+        noise_format_pack(m_noise_format, volume, texels.data(), texels.size() / 4, packed);
+        noise_format_encode(m_noise_format, packed.data(), packed.size(), bytes);
+
+        glBindTexture(GL_TEXTURE_3D, texture->id());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, size, size, size, texture->format(), texture->type(), bytes.data());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_3D, 0);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // The startup volumes are built in one go, before the first frame, and written to the caches.
+    void generate_shape_noise_texture()
+    {
+        uint64_t    key  = noise_volume_cache_key(CPU_NOISE_VOLUME_SHAPE, m_noise_format);
+        std::string path = noise_format_cache_path(m_noise_format, CPU_NOISE_VOLUME_SHAPE);
+
+        if (load_noise_texture_from_cache(m_shape_noise_texture, path, key))
+            return;
+
+        generate_noise_texels(m_shape_noise_texture, CPU_NOISE_VOLUME_SHAPE, m_shape_noise_program, m_shape_noise_frequency);
+
+        m_shape_noise_texture->generate_mipmaps();
+
+        save_noise_texture_to_cache(m_shape_noise_texture, path, key);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void generate_detail_noise_texture()
+    {
+        uint64_t    key  = noise_volume_cache_key(CPU_NOISE_VOLUME_DETAIL, m_noise_format);
+        std::string path = noise_format_cache_path(m_noise_format, CPU_NOISE_VOLUME_DETAIL);
+
+        if (load_noise_texture_from_cache(m_detail_noise_texture, path, key))
+            return;
+
+        generate_noise_texels(m_detail_noise_texture, CPU_NOISE_VOLUME_DETAIL, m_detail_noise_program, m_detail_noise_frequency);
+
+        m_detail_noise_texture->generate_mipmaps();
+
+        save_noise_texture_to_cache(m_detail_noise_texture, path, key);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Must run after the shape noise changes. The grid is independent of coverage, wind and time.
+    void build_empty_space_grid()
+    {
+        const uint32_t NOISE_SIZE = m_shape_noise_texture->width();
+        const uint32_t GRID_SIZE  = m_empty_space_grid_texture->width();
+
+        if (m_empty_space_grid_program)
+        {
+            m_empty_space_grid_program->use();
+            m_empty_space_grid_program->set_uniform("u_CellSize", (int)EMPTY_SPACE_CELL_SIZE);
+            m_empty_space_grid_program->set_uniform("u_GridSize", (int)GRID_SIZE);
+            m_empty_space_grid_program->set_uniform("u_FoldedNoise", (int)noise_format_folded(m_noise_format));
+
+            if (m_empty_space_grid_program->set_uniform("s_ShapeNoise", 1))
+                m_shape_noise_texture->bind(1);
+
+            m_empty_space_grid_texture->bind_image(0, 0, 0, GL_WRITE_ONLY, GL_R32F);
+
+            const uint32_t NUM_THREADS = 4;
+
+            glDispatchCompute(GRID_SIZE / NUM_THREADS, GRID_SIZE / NUM_THREADS, GRID_SIZE / NUM_THREADS);
+            glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
+        }
+        else
+        {
+            uint32_t           channels = noise_format_channels(m_noise_format, CPU_NOISE_VOLUME_SHAPE);
+            std::vector<float> noise(size_t(NOISE_SIZE) * NOISE_SIZE * NOISE_SIZE * channels);
+            std::vector<float> grid;
+
+            glBindTexture(GL_TEXTURE_3D, m_shape_noise_texture->id());
+            glGetTexImage(GL_TEXTURE_3D, 0, m_shape_noise_texture->format(), GL_FLOAT, noise.data());
+
+            empty_space_build_grid(noise.data(), NOISE_SIZE, EMPTY_SPACE_CELL_SIZE, channels, grid);
+
+            glBindTexture(GL_TEXTURE_3D, m_empty_space_grid_texture->id());
+            glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, GRID_SIZE, GRID_SIZE, GRID_SIZE, GL_RED, GL_FLOAT, grid.data());
+            glBindTexture(GL_TEXTURE_3D, 0);
+        }
+
+        // No cloud survives a coverage above the largest bound, which lets the tile classification skip the march entirely. The grid
+        // is copied into a buffer and read back by resolve_coverage_bound() once the copy is done, until then nothing is skipped.
+        if (m_coverage_bound_fence)
+            glDeleteSync(m_coverage_bound_fence);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_coverage_bound_buffer);
+        glBindTexture(GL_TEXTURE_3D, m_empty_space_grid_texture->id());
+        glGetTexImage(GL_TEXTURE_3D, 0, GL_RED, GL_FLOAT, nullptr);
+        glBindTexture(GL_TEXTURE_3D, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        m_coverage_bound_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_coverage_bound       = 1e30f;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void resolve_coverage_bound()
+    {
+        if (!m_coverage_bound_fence)
+            return;
+
+        GLenum status = glClientWaitSync(m_coverage_bound_fence, 0, 0);
+
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            return;
+
+        const uint32_t GRID_SIZE = m_empty_space_grid_texture->width();
+
+        std::vector<float> bounds(size_t(GRID_SIZE) * GRID_SIZE * GRID_SIZE);
+
+        glGetNamedBufferSubData(m_coverage_bound_buffer, 0, sizeof(float) * bounds.size(), bounds.data());
+        glDeleteSync(m_coverage_bound_fence);
+
+        m_coverage_bound       = *std::max_element(bounds.begin(), bounds.end());
+        m_coverage_bound_fence = nullptr;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Writes the procedural weather map on first run, like the noise caches. Without a map the clouds use the global parameters.
+    void open_weather_map()
+    {
+        std::ifstream existing(WEATHER_MAP_PATH, std::ios::binary);
+
+        if (!existing)
+        {
+            WeatherMapHeader     header;
+            std::vector<uint8_t> tiles;
+
+            weather_map_generate(WEATHER_MAP_GENERATED_TILES, WEATHER_MAP_GENERATED_TILES, WEATHER_MAP_GENERATED_TEXEL_SIZE, 0, header, tiles);
+
+            if (!weather_map_write(WEATHER_MAP_PATH, header, tiles))
+                DW_LOG_WARNING("Failed to write weather map: " WEATHER_MAP_PATH);
+        }
+
+        if (!m_weather_map_file.open(WEATHER_MAP_PATH))
+        {
+            DW_LOG_WARNING("Failed to open weather map " WEATHER_MAP_PATH ", falling back to the global cloud parameters");
+            return;
+        }
+
+        const WeatherMapHeader& header = m_weather_map_file.header();
+
+        // Only the worker thread reads the file from here on.
+        m_weather_residency.initialize(glm::ivec2(header.tiles_x, header.tiles_y), [this](const glm::ivec2& tile, uint8_t* texels) { return m_weather_map_file.read_tile(tile, texels); }, true);
+
+        m_weather_map_available = true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Streams the tiles around the camera into the atlas. The lighting caches built from the density are rebuilt once the resident
+    // tiles change, see m_density_generation.
+    void update_weather_map()
+    {
+        if (!m_weather_map_available || !m_weather_map)
+            return;
+
+        glm::vec3  camera_pos  = m_main_camera->m_position;
+        glm::ivec2 camera_tile = weather_map_tile(m_weather_map_file.header(), camera_pos.x, camera_pos.z);
+        glm::ivec2 origin      = m_weather_residency.window_origin();
+
+        m_weather_residency.update(camera_tile, m_weather_uploads);
+
+        for (const WeatherTileUpload& upload : m_weather_uploads)
+        {
+            uint32_t x = (upload.slot % WEATHER_ATLAS_TILES) * WEATHER_TILE_SIZE;
+            uint32_t y = (upload.slot / WEATHER_ATLAS_TILES) * WEATHER_TILE_SIZE;
+
+            glTextureSubImage2D(m_weather_atlas_texture->id(), 0, x, y, WEATHER_TILE_SIZE, WEATHER_TILE_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, upload.texels.data());
+        }
+
+        if (m_weather_uploads.empty() && origin == m_weather_residency.window_origin() && m_weather_indirection_valid)
+            return;
+
+        glTextureSubImage2D(m_weather_indirection_texture->id(), 0, 0, 0, WEATHER_WINDOW_TILES, WEATHER_WINDOW_TILES, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE, m_weather_residency.indirection().data());
+
+        m_weather_indirection_valid = true;
+        m_density_generation++;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Inputs of weather_map.glsl, needed by every pass that samples the cloud density.
+    void set_weather_uniforms(ShaderProgram* program)
+    {
+        if (program->set_uniform("s_WeatherAtlas", 8))
+            m_weather_atlas_texture->bind(8);
+
+        if (program->set_uniform("s_WeatherIndirection", 9))
+            m_weather_indirection_texture->bind(9);
+
+        const WeatherMapHeader& header = m_weather_map_file.header();
+
+        program->set_uniform("u_WeatherMapOrigin", glm::vec2(header.origin_x, header.origin_z));
+        program->set_uniform("u_WeatherTexelSize", header.texel_size);
+        program->set_uniform("u_WeatherWindowOrigin", glm::vec2(m_weather_residency.window_origin()));
+        program->set_uniform("u_WeatherMinCoverage", m_weather_residency.min_coverage());
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // The sky only depends on the view and sun directions, so the LUT is only rebuilt when the sun moves.
+    void update_sky_view_lut()
+    {
+        if (!m_sky_view_lut_program || !m_sky_view_lut)
+            return;
+
+        glm::vec3 sun_dir = -m_light_direction;
+
+        if (m_sky_view_lut_valid && sun_dir == m_sky_view_lut_sun_dir)
+            return;
+
+        m_sky_view_lut_program->use();
+        m_sky_view_lut_program->set_uniform("u_SunDir", sun_dir);
+        m_sky_view_lut_program->set_uniform("u_Turbidity", SKY_TURBIDITY);
+
+        m_sky_view_lut_texture->bind_image(0, 0, 0, GL_WRITE_ONLY, GL_RGBA16F);
+
+        const uint32_t NUM_THREADS = 8;
+
+        glDispatchCompute(SKY_VIEW_LUT_WIDTH / NUM_THREADS, SKY_VIEW_LUT_HEIGHT / NUM_THREADS, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        m_sky_view_lut_sun_dir = sun_dir;
+        m_sky_view_lut_valid   = true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Rebuilds the back light volume a few height slices per frame and swaps it to the front once it is complete. A rebuild starts
+    // whenever the cloud parameters change, the wind moved the clouds or the camera left the area covered by the front volume.
+    void update_light_volume()
+    {
+        if (!m_light_volume_program || !m_light_volume)
+            return;
+
+        uint32_t back = 1 - m_light_volume_front;
+
+        // Slices built with different parameters would not match, so a change restarts the rebuild.
+        bool parameters_changed = memcmp(&m_cloud_uniforms, &m_light_volume_uniforms, sizeof(CloudUniforms)) != 0;
+
+        if (m_light_volume_next_slice == 0 || parameters_changed)
+        {
+            glm::vec3 camera_pos      = m_main_camera->m_position;
+            bool      wind_changed    = m_wind_speed != 0.0f && m_time != m_light_volume_time[m_light_volume_front];
+            bool      out_of_range    = light_volume_out_of_range(m_light_volume_origin[m_light_volume_front], m_light_volume_extent[m_light_volume_front], camera_pos);
+            bool      density_changed = m_density_generation != m_light_volume_density_generation;
+
+            if (m_light_volume_valid && !parameters_changed && !wind_changed && !out_of_range && !density_changed)
+                return;
+
+            m_light_volume_uniforms           = m_cloud_uniforms;
+            m_light_volume_density_generation = m_density_generation;
+            m_light_volume_origin[back]       = camera_pos;
+            m_light_volume_extent[back]       = light_volume_extent(camera_pos, m_planet_center, m_planet_radius, m_cloud_max_height);
+            m_light_volume_time[back]         = m_time;
+            m_light_volume_next_slice         = 0;
+        }
+
+        // Without a valid front volume there is nothing to show in the meantime, so build every slice at once.
+        uint32_t num_slices = m_light_volume_valid ? LIGHT_VOLUME_SLICES_PER_FRAME : LIGHT_VOLUME_HEIGHT;
+        num_slices          = std::min(num_slices, LIGHT_VOLUME_HEIGHT - m_light_volume_next_slice);
+
+        m_light_volume_program->use();
+
+        m_cloud_ubo.bind(CLOUD_UNIFORMS_BINDING);
+
+        if (m_light_volume_program->set_uniform("s_ShapeNoise", 0))
+            m_shape_noise_texture->bind(0);
+
+        if (m_light_volume_program->set_uniform("s_DetailNoise", 1))
+            m_detail_noise_texture->bind(1);
+
+        if (m_light_volume_program->set_uniform("s_CurlNoise", 2))
+            m_curl_noise_texture->bind(2);
+
+        set_weather_uniforms(m_light_volume_program.get());
+
+        m_light_volume_program->set_uniform("u_Time", m_light_volume_time[back]);
+        m_light_volume_program->set_uniform("u_LightVolumeOrigin", m_light_volume_origin[back]);
+        m_light_volume_program->set_uniform("u_LightVolumeExtent", m_light_volume_extent[back]);
+        m_light_volume_program->set_uniform("u_SliceOffset", (int)m_light_volume_next_slice);
+
+        m_light_volume_texture[back]->bind_image(0, 0, 0, GL_WRITE_ONLY, GL_R16F);
+
+        const uint32_t NUM_THREADS = 8;
+
+        glDispatchCompute(LIGHT_VOLUME_SIZE / NUM_THREADS, LIGHT_VOLUME_SIZE / NUM_THREADS, num_slices);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        m_light_volume_next_slice += num_slices;
+
+        if (m_light_volume_next_slice == LIGHT_VOLUME_HEIGHT)
+        {
+            m_light_volume_front      = back;
+            m_light_volume_next_slice = 0;
+            m_light_volume_valid      = true;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Rebuilds the back cloud shadow map m_cloud_shadow_rows_per_frame rows at a time and swaps it to the front once it is complete. A
+    // rebuild starts when the cloud parameters change, the camera moved away from the centre of the map or, while the wind moves the
+    // clouds, every m_cloud_shadow_update_interval frames.
+    void update_cloud_shadow_map()
+    {
+        if (!m_cloud_shadow_map_program || !m_cloud_shadows)
+            return;
+
+        uint32_t back = 1 - m_cloud_shadow_map_front;
+
+        bool parameters_changed = memcmp(&m_cloud_uniforms, &m_cloud_shadow_map_uniforms, sizeof(CloudUniforms)) != 0;
+
+        if (m_cloud_shadow_map_next_row == 0 || parameters_changed)
+        {
+            glm::vec3 camera_pos   = m_main_camera->m_position;
+            bool      wind_changed = m_wind_speed != 0.0f && m_frame_index - m_cloud_shadow_map_build_frame >= (uint32_t)m_cloud_shadow_update_interval;
+            bool      out_of_range = cloud_shadow_map_needs_recenter(m_cloud_shadow_map_projection[m_cloud_shadow_map_front], camera_pos);
+            bool      density_changed = m_density_generation != m_cloud_shadow_map_density_generation;
+
+            if (m_cloud_shadow_map_valid && !parameters_changed && !wind_changed && !out_of_range && !density_changed)
+                return;
+
+            m_cloud_shadow_map_uniforms           = m_cloud_uniforms;
+            m_cloud_shadow_map_density_generation = m_density_generation;
+            m_cloud_shadow_map_projection[back] = cloud_shadow_map_projection(camera_pos, CLOUD_SHADOW_MAP_EXTENT, CLOUD_SHADOW_MAP_SIZE, 0.0f);
+            m_cloud_shadow_map_time[back]       = m_time;
+            m_cloud_shadow_map_build_frame      = m_frame_index;
+            m_cloud_shadow_map_next_row         = 0;
+        }
+
+        // Without a valid front map there is nothing to show in the meantime, so build every row at once.
+        uint32_t num_rows = m_cloud_shadow_map_valid ? (uint32_t)m_cloud_shadow_rows_per_frame : CLOUD_SHADOW_MAP_SIZE;
+        num_rows          = std::min(num_rows, CLOUD_SHADOW_MAP_SIZE - m_cloud_shadow_map_next_row);
+
+        const CloudShadowMapProjection& projection = m_cloud_shadow_map_projection[back];
+
+        m_cloud_shadow_map_program->use();
+
+        m_cloud_ubo.bind(CLOUD_UNIFORMS_BINDING);
+
+        if (m_cloud_shadow_map_program->set_uniform("s_ShapeNoise", 0))
+            m_shape_noise_texture->bind(0);
+
+        set_weather_uniforms(m_cloud_shadow_map_program.get());
+
+        m_cloud_shadow_map_program->set_uniform("u_Time", m_cloud_shadow_map_time[back]);
+        m_cloud_shadow_map_program->set_uniform("u_CloudShadowMapOrigin", projection.origin);
+        m_cloud_shadow_map_program->set_uniform("u_CloudShadowMapExtent", projection.extent);
+        m_cloud_shadow_map_program->set_uniform("u_CloudShadowMapPlaneHeight", projection.plane_height);
+        m_cloud_shadow_map_program->set_uniform("u_RowOffset", (int)m_cloud_shadow_map_next_row);
+
+        m_cloud_shadow_map_texture[back]->bind_image(0, 0, 0, GL_WRITE_ONLY, GL_R16F);
+
+        const uint32_t NUM_THREADS = 8;
+
+        glDispatchCompute(CLOUD_SHADOW_MAP_SIZE / NUM_THREADS, (num_rows + NUM_THREADS - 1) / NUM_THREADS, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        m_cloud_shadow_map_next_row += num_rows;
+
+        if (m_cloud_shadow_map_next_row == CLOUD_SHADOW_MAP_SIZE)
+        {
+            m_cloud_shadow_map_front    = back;
+            m_cloud_shadow_map_next_row = 0;
+            m_cloud_shadow_map_valid    = true;
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void generate_noise_texture_on_cpu(dw::gl::Texture3D::Ptr texture, CpuNoiseVolume volume, float frequency)
+    {
+        uint32_t           size = texture->width();
+        std::vector<float> data(size_t(size) * size * size * 4);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        cpu_noise_generate(volume, size, frequency, cpu_noise_best_backend(), 0, data.data());
+
+        auto end = std::chrono::high_resolution_clock::now();
+
+        DW_LOG_INFO("Generated " + std::to_string(size) + "^3 noise on the CPU (" + cpu_noise_backend_name(cpu_noise_best_backend()) + ") in " + std::to_string(std::chrono::duration<double, std::milli>(end - start).count()) + " ms");
+
+        glBindTexture(GL_TEXTURE_3D, texture->id());
+        glTexSubImage3D(GL_TEXTURE_3D, 0, 0, 0, 0, size, size, size, GL_RGBA, GL_FLOAT, data.data());
+        glBindTexture(GL_TEXTURE_3D, 0);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    std::string read_text_file(const std::string& path)
+    {
+        std::ifstream file(path);
+
+        if (!file.is_open())
+            return "";
+
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    dw::gl::Texture3D::Ptr noise_back_texture(CpuNoiseVolume volume)
+    {
+        return volume == CPU_NOISE_VOLUME_SHAPE ? m_shape_noise_back_texture : m_detail_noise_back_texture;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Key of a volume generated with the current frequencies and stored in 'format'. The texture format is also checked on load.
+    uint64_t noise_volume_cache_key(CpuNoiseVolume volume, NoiseFormat format)
+    {
+        if (volume == CPU_NOISE_VOLUME_SHAPE)
+            return noise_cache_key({ read_text_file("shader/shape_noise_cs.glsl"), read_text_file("shader/noise.glsl") }, SHAPE_NOISE_SIZE, { m_shape_noise_frequency }, format);
+
+        return noise_cache_key({ read_text_file("shader/detail_noise_cs.glsl"), read_text_file("shader/noise.glsl") }, DETAIL_NOISE_SIZE, { m_detail_noise_frequency }, format);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Bytes per texel as read back with the format and type of the texture.
+    uint32_t noise_texture_texel_size(dw::gl::Texture3D::Ptr texture)
+    {
+        uint32_t channels = texture->format() == GL_RGBA ? 4 : (texture->format() == GL_RGB ? 3 : (texture->format() == GL_RG ? 2 : 1));
+
+        return channels * (texture->type() == GL_HALF_FLOAT ? 2 : 1);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    uint32_t noise_texture_mip_count(dw::gl::Texture3D::Ptr texture)
+    {
+        uint32_t size = std::max(texture->width(), std::max(texture->height(), texture->depth()));
+        uint32_t mips = 1;
+
+        while (size > 1)
+        {
+            size /= 2;
+            mips++;
+        }
+
+        return mips;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    bool load_noise_texture_from_cache(dw::gl::Texture3D::Ptr texture, const std::string& path, uint64_t key)
+    {
+        NoiseCacheFile file;
+        NoiseVolume    volume;
+
+        if (!file.open(path) || !noise_cache_parse(file.data(), file.size(), key, volume))
+            return false;
+
+        uint32_t num_mips = noise_texture_mip_count(texture);
+
+        if (volume.internal_format != texture->internal_format() || volume.mips.size() != num_mips)
+            return false;
+
+        for (uint32_t i = 0; i < num_mips; i++)
+        {
+            const NoiseCacheMip& mip = volume.mips[i];
+
+            if (mip.width != std::max(texture->width() >> i, 1u) || mip.height != std::max(texture->height() >> i, 1u) || mip.depth != std::max(texture->depth() >> i, 1u))
+                return false;
+
+            if (mip.size != uint64_t(mip.width) * mip.height * mip.depth * noise_texture_texel_size(texture))
+                return false;
+        }
+
+        glBindTexture(GL_TEXTURE_3D, texture->id());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+        for (uint32_t i = 0; i < num_mips; i++)
+        {
+            const NoiseCacheMip& mip = volume.mips[i];
+            glTexSubImage3D(GL_TEXTURE_3D, i, 0, 0, 0, mip.width, mip.height, mip.depth, volume.format, volume.type, volume.mip_data[i]);
+        }
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_3D, 0);
+
+        DW_LOG_INFO("Loaded noise texture from cache: " + path);
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void save_noise_texture_to_cache(dw::gl::Texture3D::Ptr texture, const std::string& path, uint64_t key)
+    {
+        uint32_t num_mips = noise_texture_mip_count(texture);
+
+        NoiseVolume                       volume;
+        std::vector<std::vector<uint8_t>> mip_data(num_mips);
+
+        volume.key             = key;
+        volume.internal_format = texture->internal_format();
+        volume.format          = texture->format();
+        volume.type            = texture->type();
+
+        glBindTexture(GL_TEXTURE_3D, texture->id());
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+
+        for (uint32_t i = 0; i < num_mips; i++)
+        {
+            NoiseCacheMip mip;
+
+            mip.width   = std::max(texture->width() >> i, 1u);
+            mip.height  = std::max(texture->height() >> i, 1u);
+            mip.depth   = std::max(texture->depth() >> i, 1u);
+            mip.padding = 0;
+            mip.offset  = 0;
+            mip.size    = uint64_t(mip.width) * mip.height * mip.depth * noise_texture_texel_size(texture);
+
+            mip_data[i].resize(mip.size);
+
+            glGetTexImage(GL_TEXTURE_3D, i, volume.format, volume.type, mip_data[i].data());
+
+            volume.mips.push_back(mip);
+            volume.mip_data.push_back(mip_data[i].data());
+        }
+
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_3D, 0);
+
+        if (!noise_cache_write(path, volume))
+            DW_LOG_WARNING("Failed to write noise cache: " + path);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void render_mesh(dw::Mesh::Ptr mesh, glm::mat4 model)
+    {
+        if (m_mesh_program->set_uniform("s_Diffuse", 0))
+            m_placeholder_texture->bind(0);
+
+        m_mesh_program->set_uniform("u_LightDirection", m_light_direction);
+        m_mesh_program->set_uniform("u_Model", model);
+
+        const CloudShadowMapProjection& projection = m_cloud_shadow_map_projection[m_cloud_shadow_map_front];
+
+        if (m_mesh_program->set_uniform("s_CloudShadowMap", 1))
+            m_cloud_shadow_map_texture[m_cloud_shadow_map_front]->bind(1);
+
+        // The map was built with the clouds at m_cloud_shadow_map_time, shift the lookup by the wind advection since then as the
+        // density does (see sample_cloud_density()).
+        glm::vec3 advection = m_wind_direction * m_wind_speed * (m_time - m_cloud_shadow_map_time[m_cloud_shadow_map_front]);
+
+        m_mesh_program->set_uniform("u_CloudShadows", (int)(m_cloud_shadows && m_cloud_shadow_map_valid));
+        m_mesh_program->set_uniform("u_CloudShadowMapOrigin", projection.origin);
+        m_mesh_program->set_uniform("u_CloudShadowMapExtent", projection.extent);
+        m_mesh_program->set_uniform("u_CloudShadowMapPlaneHeight", projection.plane_height);
+        m_mesh_program->set_uniform("u_CloudShadowMapOffset", glm::vec2(advection.x, advection.z));
+        m_mesh_program->set_uniform("u_CloudShadowDensityScale", m_cloud_uniforms.precipitation * m_cloud_shadow_strength);
+
+        bool cloud_probe = m_cloud_probe && m_cloud_probe_scheduler.complete();
+
+        if (m_mesh_program->set_uniform("s_CloudProbe", 2))
+            m_cloud_probe_texture->bind(2);
+
+        // The smallest mip averages the whole sky, without mips only the top level is written.
+        m_mesh_program->set_uniform("u_CloudProbeAmbient", cloud_probe ? m_cloud_probe_ambient : 0.0f);
+        m_mesh_program->set_uniform("u_CloudProbeLod", m_cloud_probe_mips ? float(m_cloud_probe_texture->mip_levels() - 1) : 0.0f);
+
+        // Bind vertex array.
+        mesh->mesh_vertex_array()->bind();
+
+        const auto& submeshes = mesh->sub_meshes();
+
+        for (uint32_t i = 0; i < submeshes.size(); i++)
+        {
+            const dw::SubMesh& submesh = submeshes[i];
+
+            // Issue draw call.
+            glDrawElementsBaseVertex(GL_TRIANGLES, submesh.index_count, GL_UNSIGNED_INT, (void*)(sizeof(unsigned int) * submesh.base_index), submesh.base_vertex);
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void render_scene()
+    {
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_LEQUAL);
+        glDisable(GL_BLEND);
+        glEnable(GL_CULL_FACE);
+        glCullFace(GL_BACK);
+
+        m_hdr_output_framebuffer->bind();
+        glViewport(0, 0, m_width, m_height);
+
+        glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
+        glClearDepth(1.0);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // Bind shader program.
+        m_mesh_program->use();
+
+        // Bind uniform buffers.
+        m_global_ubo.bind(0);
+
+        // Draw scene.
+        render_mesh(m_plane, glm::mat4(1.0f));
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Binds the inputs of cloud_march.glsl shared by the full-screen pass and the tiled compute path.
+    void set_cloud_march_uniforms(ShaderProgram* program)
+    {
+        if (program->set_uniform("s_ShapeNoise", 0))
+            m_shape_noise_texture->bind(0);
+
+        if (program->set_uniform("s_DetailNoise", 1))
+            m_detail_noise_texture->bind(1);
+
+        if (program->set_uniform("s_BlueNoise", 2))
+            m_blue_noise_texture->bind(2);
+
+        if (program->set_uniform("s_CurlNoise", 3))
+            m_curl_noise_texture->bind(3);
+
+        if (program->set_uniform("s_EmptySpaceGrid", 4))
+            m_empty_space_grid_texture->bind(4);
+
+        if (program->set_uniform("s_SkyViewLUT", 6))
+            m_sky_view_lut_texture->bind(6);
+
+        if (program->set_uniform("s_Depth", 7))
+            m_depth_output_texture->bind(7);
+
+        if (program->set_uniform("s_LightVolume", 5))
+            m_light_volume_texture[m_light_volume_front]->bind(5);
+
+        if (program->set_uniform("s_CirrusNoise", 10))
+            m_cirrus_noise_texture->bind(10);
+
+        program->set_uniform("u_LightVolumeOrigin", m_light_volume_origin[m_light_volume_front]);
+        program->set_uniform("u_LightVolumeExtent", m_light_volume_extent[m_light_volume_front]);
+        program->set_uniform("u_LightVolumeTime", m_light_volume_time[m_light_volume_front]);
+        program->set_uniform("u_CoverageBound", m_coverage_bound);
+
+        set_weather_uniforms(program);
+
+        m_global_ubo.bind(0);
+        m_cloud_ubo.bind(CLOUD_UNIFORMS_BINDING);
+
+        program->set_uniform("u_Time", m_time);
+        program->set_uniform("u_FullResolution", glm::vec2(m_width, m_height));
+        program->set_uniform("u_StepFraction", m_cloud_level.step_fraction);
+        program->set_uniform("u_CloudStatsWrite", (int)m_cloud_stats);
+        program->set_uniform("u_NumCirrusLayers", int(m_cirrus_layers.size()));
+
+        for (size_t i = 0; i < m_cirrus_layers.size(); i++)
+            program->set_uniform("u_CirrusLayers[" + std::to_string(i) + "]", cloud_layer_cirrus_uniform(m_cirrus_layers[i]));
+
+        // The temporal path resolves a full resolution image, so its footprint is a full resolution pixel whatever its stride.
+        float pixel_angle = 2.0f * tanf(glm::radians(CAMERA_FOV) * 0.5f) / float(m_height);
+
+        if (m_temporal_reprojection)
+        {
+            glm::ivec2 offset = temporal_pixel_offset(m_frame_index);
+
+            program->set_uniform("u_PixelOffset", glm::vec2(offset));
+            program->set_uniform("u_PixelStride", float(TEMPORAL_BLOCK_SIZE));
+        }
+        else
+        {
+            // Below full resolution every texel shades the full resolution position under its center.
+            float stride = 1.0f / m_cloud_level.scale;
+
+            program->set_uniform("u_PixelOffset", glm::vec2(0.5f * stride - 0.5f));
+            program->set_uniform("u_PixelStride", stride);
+
+            pixel_angle *= stride;
+        }
+
+        program->set_uniform("u_DensityLod", int(m_density_lod));
+        program->set_uniform("u_LodPixelAngle", pixel_angle);
+        program->set_uniform("u_LodBias", m_lod_bias);
+        program->set_uniform("u_LodDetailDistance", m_lod_detail_distance);
+        program->set_uniform("u_LodDetailOpacity", m_lod_detail_opacity);
+        program->set_uniform("u_LodConeScale", m_lod_cone_scale);
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
 
-    bool create_uniform_buffer()
+    // Applies the settings of a quality tier, Custom keeps the current ones. The variant of the cloud programs is picked by
+    // select_cloud_variants().
+    void set_quality_tier(CloudQualityTier tier)
     {
-        // Create uniform buffer for global data
-        m_global_ubo = dw::gl::Buffer::create(GL_UNIFORM_BUFFER, GL_MAP_WRITE_BIT, sizeof(GlobalUniforms));
+        m_quality_tier  = tier;
+        m_history_valid = false;
 
-        return true;
+        if (tier == CLOUD_QUALITY_CUSTOM)
+            return;
+
+        const CloudQualityPreset& preset = cloud_quality_preset(tier);
+
+        m_max_num_steps = preset.max_num_steps;
+        m_light_volume  = preset.light_volume;
+        m_sky_view_lut  = preset.sky_view_lut;
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
 
-    bool load_scene()
+    // Switches the cloud programs to the variant of the current tier, with the light march and sky model in use, and builds it if it
+    // is used for the first time. A variant that fails to build leaves the current programs in place.
+    void select_cloud_variants()
     {
-        m_placeholder_texture = dw::gl::Texture2D::create_from_file("texture/grid.png", true, true);
+        CloudPermutation permutation = cloud_quality_permutation(m_quality_tier, m_light_volume && m_light_volume_program, m_sky_view_lut && m_sky_view_lut_program);
+        ShaderDefines    defines;
 
-        m_plane = dw::Mesh::load("mesh/plane.obj");
+        cloud_permutation_defines(permutation, defines);
 
-        if (!m_plane)
+        if (m_cloud_stats)
+            defines.push_back({ "CLOUD_STATS", "1" });
+
+        if (ShaderProgram::Ptr program = m_clouds_variants.get(defines))
+            m_clouds_program = program;
+
+        if (m_tiled_clouds_program)
         {
-            DW_LOG_FATAL("Failed to load mesh: plane");
-            return false;
+            if (ShaderProgram::Ptr program = m_tiled_clouds_variants.get(defines))
+                m_tiled_clouds_program = program;
         }
+    }
 
-        return true;
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Renders the next tile of the cloud probe with clouds_fs.glsl, from the position the camera had at the start of the cycle. See
+    // cloud_probe.h.
+    void update_cloud_probe()
+    {
+        if (!m_cloud_probe)
+            return;
+
+        CloudProbeTile tile = m_cloud_probe_scheduler.next();
+        uint32_t       size = m_cloud_probe_scheduler.size();
+
+        if (tile.first_of_cycle)
+            m_cloud_probe_position = m_main_camera->m_position;
+
+        GlobalUniforms uniforms;
+
+        uniforms.view_proj      = cloud_probe_face_view_proj(tile.face, m_cloud_probe_position, CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE);
+        uniforms.prev_view_proj = uniforms.view_proj;
+        uniforms.inv_view_proj  = glm::inverse(uniforms.view_proj);
+        uniforms.cam_pos        = glm::vec4(m_cloud_probe_position, 0.0f);
+
+        m_cloud_probe_ubo.update(&uniforms);
+
+        glNamedFramebufferTextureLayer(m_cloud_probe_framebuffer, GL_COLOR_ATTACHMENT0, m_cloud_probe_texture->id(), 0, tile.face);
+        glBindFramebuffer(GL_FRAMEBUFFER, m_cloud_probe_framebuffer);
+        glViewport(0, 0, size, size);
+
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(tile.x, tile.y, tile.width, tile.height);
+
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_BLEND);
+
+        m_clouds_program->use();
+
+        set_cloud_march_uniforms(m_clouds_program.get());
+
+        // Every pixel of the face is marched with all steps, whatever the main view does.
+        if (m_clouds_program->set_uniform("s_Depth", 7))
+            m_cloud_probe_depth_texture->bind(7);
+
+        m_clouds_program->set_uniform("u_FullResolution", glm::vec2(float(size)));
+        m_clouds_program->set_uniform("u_PixelOffset", glm::vec2(0.0f));
+        m_clouds_program->set_uniform("u_PixelStride", 1.0f);
+        m_clouds_program->set_uniform("u_StepFraction", 1.0f);
+        m_clouds_program->set_uniform("u_LodPixelAngle", 2.0f / float(size));
+        m_clouds_program->set_uniform("u_CloudStatsWrite", 0);
+
+        m_cloud_probe_ubo.bind(0);
+
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        glDisable(GL_SCISSOR_TEST);
+
+        if (tile.last_of_face && m_cloud_probe_mips)
+            m_cloud_probe_texture->generate_mipmaps();
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
 
-    void create_camera()
+    void render_clouds()
     {
-        m_main_camera = std::make_unique<dw::Camera>(60.0f, 1.0f, CAMERA_FAR_PLANE, float(m_width) / float(m_height), glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(-1.0f, 0.0, 0.0f));
-        m_main_camera->update();
+        m_clouds_program->use();
+
+        set_cloud_march_uniforms(m_clouds_program.get());
+
+        glDrawArrays(GL_TRIANGLES, 0, 3);
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
 
-    void generate_shape_noise_texture()
+    bool tiled_clouds() const
+    {
+        return m_tiled_clouds && m_tiled_clouds_program;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Tiled compute version of render_clouds(). The classification finishes the tiles where no pixel needs a march and appends the
+    // others to m_cloud_tile_buffer, which then drives an indirect dispatch of the march over those tiles only. With
+    // 'blend_over_scene' the clouds are blended into 'target' as begin_cloud_composite() does, otherwise they overwrite it.
+    void render_clouds_tiled(dw::gl::Texture2D::Ptr target, bool blend_over_scene)
     {
-        m_shape_noise_program->use();
-        m_shape_noise_program->set_uniform("u_Size", (int)m_shape_noise_texture->width());
+        CloudTileHeader header = { 0, 1, 1, 0 };
 
-        m_shape_noise_texture->bind_image(0, 0, 0, GL_READ_WRITE, m_shape_noise_texture->internal_format());
+        glNamedBufferSubData(m_cloud_tile_buffer, 0, sizeof(header), &header);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_cloud_tile_buffer);
 
-        const uint32_t TEXTURE_SIZE = m_shape_noise_texture->width();
-        const uint32_t NUM_THREADS  = 8;
+        target->bind_image(0, 0, 0, blend_over_scene ? GL_READ_WRITE : GL_WRITE_ONLY, GL_RGBA16F);
 
-        glDispatchCompute(TEXTURE_SIZE / NUM_THREADS, TEXTURE_SIZE / NUM_THREADS, TEXTURE_SIZE / NUM_THREADS);
+        m_cloud_tile_classify_program->use();
+        m_cloud_tile_classify_program->set_uniform("u_BlendOverScene", (int)blend_over_scene);
 
-        glFinish();
+        set_cloud_march_uniforms(m_cloud_tile_classify_program.get());
 
-        m_shape_noise_texture->generate_mipmaps();
+        glDispatchCompute(cloud_tile_count(target->width()), cloud_tile_count(target->height()), 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+        m_tiled_clouds_program->use();
+        m_tiled_clouds_program->set_uniform("u_BlendOverScene", (int)blend_over_scene);
+
+        set_cloud_march_uniforms(m_tiled_clouds_program.get());
+
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, m_cloud_tile_buffer);
+        glDispatchComputeIndirect(0);
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
 
-    void generate_detail_noise_texture()
+    void render_clouds_temporal()
     {
-        m_detail_noise_program->use();
-        m_detail_noise_program->set_uniform("u_Size", (int)m_detail_noise_texture->width());
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
 
-        m_detail_noise_texture->bind_image(0, 0, 0, GL_READ_WRITE, m_detail_noise_texture->internal_format());
+        // March one pixel out of every 4x4 block into the quarter resolution buffer.
+        glm::ivec2 lowres_size = temporal_lowres_size(m_width, m_height);
 
-        const uint32_t TEXTURE_SIZE = m_detail_noise_texture->width();
-        const uint32_t NUM_THREADS  = 8;
+        if (tiled_clouds())
+            render_clouds_tiled(m_clouds_lowres_texture, false);
+        else
+        {
+            m_clouds_lowres_framebuffer->bind();
+            glViewport(0, 0, lowres_size.x, lowres_size.y);
+
+            render_clouds();
+        }
 
-        glDispatchCompute(TEXTURE_SIZE / NUM_THREADS, TEXTURE_SIZE / NUM_THREADS, TEXTURE_SIZE / NUM_THREADS);
+        // Reconstruct the full resolution clouds from the new pixels and the reprojected history.
+        uint32_t current  = m_frame_index % 2;
+        uint32_t previous = 1 - current;
 
-        glFinish();
+        m_clouds_history_framebuffer[current]->bind();
+        glViewport(0, 0, m_width, m_height);
 
-        m_detail_noise_texture->generate_mipmaps();
+        m_clouds_reconstruct_program->use();
+
+        if (m_clouds_reconstruct_program->set_uniform("s_CurrentClouds", 0))
+            m_clouds_lowres_texture->bind(0);
+
+        if (m_clouds_reconstruct_program->set_uniform("s_HistoryClouds", 1))
+            m_clouds_history_texture[previous]->bind(1);
+
+        if (m_clouds_reconstruct_program->set_uniform("s_Depth", 2))
+            m_depth_output_texture->bind(2);
+
+        float delta_time = m_time - m_prev_time;
+
+        m_clouds_reconstruct_program->set_uniform("u_PixelOffset", glm::vec2(temporal_pixel_offset(m_frame_index)));
+        m_clouds_reconstruct_program->set_uniform("u_HistoryValid", m_history_valid ? 1 : 0);
+        m_clouds_reconstruct_program->set_uniform("u_PlanetCenter", m_planet_center);
+        m_clouds_reconstruct_program->set_uniform("u_PlanetRadius", m_planet_radius);
+        m_clouds_reconstruct_program->set_uniform("u_CloudMinHeight", m_cloud_min_height);
+        m_clouds_reconstruct_program->set_uniform("u_CloudMaxHeight", m_cloud_max_height);
+        m_clouds_reconstruct_program->set_uniform("u_CloudAdvection", temporal_cloud_advection(m_wind_direction, m_wind_speed, delta_time));
+
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        m_history_valid = true;
+
+        // Composite the reconstructed clouds over the scene.
+        bind_cloud_composite_framebuffer();
+        begin_cloud_composite();
+
+        m_copy_program->use();
+
+        if (m_copy_program->set_uniform("s_Color", 0))
+            m_clouds_history_texture[current]->bind(0);
+
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        end_cloud_composite();
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
 
-    void render_mesh(dw::Mesh::Ptr mesh, glm::mat4 model)
+    CloudBudgetSettings cloud_budget_settings() const
     {
-        if (m_mesh_program->set_uniform("s_Diffuse", 0))
-            m_placeholder_texture->bind(0);
+        CloudBudgetSettings settings;
 
-        m_mesh_program->set_uniform("u_LightDirection", m_light_direction);
-        m_mesh_program->set_uniform("u_Model", model);
+        settings.target_ms = m_cloud_budget_ms;
 
-        // Bind vertex array.
-        mesh->mesh_vertex_array()->bind();
+        // The results of a change only come back PROFILER_FRAMES_IN_FLIGHT frames later.
+        settings.settle_frames = PROFILER_FRAMES_IN_FLIGHT + 1;
 
-        const auto& submeshes = mesh->sub_meshes();
+        // The temporal path already marches one pixel out of every 4x4 block.
+        if (m_temporal_reprojection)
+            settings.min_scale = 1.0f;
 
-        for (uint32_t i = 0; i < submeshes.size(); i++)
+        return settings;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Feeds the controller the time of the cloud pass of the frame the profiler resolved this frame and picks the level of this one.
+    // The level every frame was rendered with is kept until its time comes back.
+    void update_cloud_budget()
+    {
+        CloudBudgetLevel level = { 1.0f, 1.0f };
+
+        if (m_cloud_budget_enabled)
         {
-            const dw::SubMesh& submesh = submeshes[i];
+            CloudBudgetSettings settings = cloud_budget_settings();
 
-            // Issue draw call.
-            glDrawElementsBaseVertex(GL_TRIANGLES, submesh.index_count, GL_UNSIGNED_INT, (void*)(sizeof(unsigned int) * submesh.base_index), submesh.base_vertex);
+            if (settings.target_ms != m_cloud_budget.settings().target_ms || settings.min_scale != m_cloud_budget.settings().min_scale)
+                m_cloud_budget.reset(settings);
+
+            uint64_t frame = 0;
+            float    ms    = 0.0f;
+
+            if (m_profiler.resolved_gpu_ms("Clouds", frame, ms) && frame != m_cloud_budget_frame)
+            {
+                m_cloud_budget_frame = frame;
+                m_cloud_budget.update(ms, m_cloud_budget_levels[frame % PROFILER_FRAMES_IN_FLIGHT]);
+            }
+
+            level = m_cloud_budget.level();
         }
+
+        m_cloud_level = level;
+        m_cloud_budget_levels[m_profiler.frame_index() % PROFILER_FRAMES_IN_FLIGHT] = level;
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
 
-    void render_scene()
+    // Marches the clouds at m_cloud_level.scale of the resolution and upsamples them over the scene with clouds_upsample_fs.glsl.
+    void render_clouds_scaled()
     {
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
-        glDisable(GL_BLEND);
-        glEnable(GL_CULL_FACE);
-        glCullFace(GL_BACK);
+        glm::ivec2 size = glm::max(glm::ivec2(glm::vec2(m_width, m_height) * m_cloud_level.scale), glm::ivec2(1));
+
+        if (!m_clouds_scaled_texture || int(m_clouds_scaled_texture->width()) != size.x || int(m_clouds_scaled_texture->height()) != size.y)
+        {
+            m_clouds_scaled_texture = dw::gl::Texture2D::create(size.x, size.y, 1, 1, 1, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT);
+            m_clouds_scaled_texture->set_wrapping(GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE, GL_CLAMP_TO_EDGE);
+
+            m_clouds_scaled_framebuffer = dw::gl::Framebuffer::create({ m_clouds_scaled_texture });
+        }
+
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_CULL_FACE);
+
+        if (tiled_clouds())
+            render_clouds_tiled(m_clouds_scaled_texture, false);
+        else
+        {
+            m_clouds_scaled_framebuffer->bind();
+            glViewport(0, 0, size.x, size.y);
+
+            render_clouds();
+        }
+
+        bind_cloud_composite_framebuffer();
+        begin_cloud_composite();
+
+        m_clouds_upsample_program->use();
+
+        if (m_clouds_upsample_program->set_uniform("s_Clouds", 0))
+            m_clouds_scaled_texture->bind(0);
+
+        if (m_clouds_upsample_program->set_uniform("s_Depth", 1))
+            m_depth_output_texture->bind(1);
+
+        float stride = 1.0f / m_cloud_level.scale;
+
+        m_clouds_upsample_program->set_uniform("u_PixelStride", stride);
+        m_clouds_upsample_program->set_uniform("u_PixelOffset", glm::vec2(0.5f * stride - 0.5f));
+        m_clouds_upsample_program->set_uniform("u_NearFar", glm::vec2(CAMERA_NEAR_PLANE, CAMERA_FAR_PLANE));
+
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+
+        end_cloud_composite();
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // With depth clipping the cloud passes sample m_depth_output_texture, so they write to the color-only framebuffer: sampling a
+    // texture attached to the bound framebuffer is a feedback loop. Without it the depth attachment is needed for the depth test.
+    void bind_cloud_composite_framebuffer()
+    {
+        if (m_depth_clipping)
+            m_hdr_composite_framebuffer->bind();
+        else
+            m_hdr_output_framebuffer->bind();
 
-        m_hdr_output_framebuffer->bind();
         glViewport(0, 0, m_width, m_height);
+    }
 
-        glClearColor(0.3f, 0.3f, 0.3f, 1.0f);
-        glClearDepth(1.0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // -----------------------------------------------------------------------------------------------------------------------------------
 
-        // Bind shader program.
-        m_mesh_program->use();
+    // The clouds are premultiplied by their alpha and blended over the scene. With depth clipping the cloud shader stops at the scene
+    // geometry itself and the depth buffer is sampled, so the depth test is disabled and nothing writes depth. Without it the clouds
+    // are opaque and the depth test keeps them behind the scene.
+    void begin_cloud_composite()
+    {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        glDepthMask(GL_FALSE);
 
-        // Bind uniform buffers.
-        m_global_ubo->bind_base(0);
+        if (m_depth_clipping)
+            glDisable(GL_DEPTH_TEST);
+        else
+        {
+            glEnable(GL_DEPTH_TEST);
+            glDepthFunc(GL_LEQUAL);
+        }
+    }
 
-        // Draw scene.
-        render_mesh(m_plane, glm::mat4(1.0f));
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void end_cloud_composite()
+    {
+        glDisable(GL_BLEND);
+        glDepthMask(GL_TRUE);
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
 
-    void render_clouds()
+    // Clears the counters of this frame and binds them to the instrumented cloud programs. The totals are read back
+    // PROFILER_FRAMES_IN_FLIGHT frames later like the profiler queries, so the read never stalls.
+    void begin_cloud_stats()
     {
-        m_clouds_program->use();
+        resolve_cloud_stats();
 
-        if (m_clouds_program->set_uniform("s_ShapeNoise", 0))
-            m_shape_noise_texture->bind(0);
+        if (!m_cloud_stats)
+            return;
 
-        if (m_clouds_program->set_uniform("s_DetailNoise", 1))
-            m_detail_noise_texture->bind(1);
+        uint32_t slot = m_frame_index % PROFILER_FRAMES_IN_FLIGHT;
 
-        if (m_clouds_program->set_uniform("s_BlueNoise", 2))
-            m_blue_noise_texture->bind(2);
+        // Still pending after a full round, the GPU is too far behind: drop that frame.
+        if (m_cloud_stats_fences[slot])
+        {
+            glDeleteSync(m_cloud_stats_fences[slot]);
+            m_cloud_stats_fences[slot] = nullptr;
+        }
 
-        if (m_clouds_program->set_uniform("s_CurlNoise", 3))
-            m_curl_noise_texture->bind(3);
+        glClearNamedBufferData(m_cloud_stats_buffers[slot], GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+        glClearTexImage(m_cloud_stats_texture->id(), 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, nullptr);
 
-        float noise_scale = 0.00001f + m_shape_noise_scale * 0.0004f;
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_cloud_stats_buffers[slot]);
+        m_cloud_stats_texture->bind_image(1, 0, 0, GL_WRITE_ONLY, GL_RGBA32UI);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
 
-        m_clouds_program->set_uniform("u_PlanetCenter", m_planet_center);
-        m_clouds_program->set_uniform("u_PlanetRadius", m_planet_radius);
-        m_clouds_program->set_uniform("u_CloudMinHeight", m_cloud_min_height);
-        m_clouds_program->set_uniform("u_CloudMaxHeight", m_cloud_max_height);
-        m_clouds_program->set_uniform("u_ShapeNoiseScale", noise_scale);
-        m_clouds_program->set_uniform("u_DetailNoiseScale", noise_scale * m_detail_noise_scale);
-        m_clouds_program->set_uniform("u_DetailNoiseModifier", m_detail_noise_modifier);
-        m_clouds_program->set_uniform("u_TurbulenceNoiseScale", noise_scale * m_turbulence_noise_scale);
-        m_clouds_program->set_uniform("u_TurbulenceAmount", m_turbulence_amount);
-        m_clouds_program->set_uniform("u_CloudCoverage", m_cloud_coverage);
-        m_clouds_program->set_uniform("u_WindDirection", m_wind_direction);
-        m_clouds_program->set_uniform("u_WindSpeed", m_wind_speed);
-        m_clouds_program->set_uniform("u_WindShearOffset", m_wind_shear_offset);
-        m_clouds_program->set_uniform("u_Time", static_cast<float>(glfwGetTime()));
-        m_clouds_program->set_uniform("u_MaxNumSteps", (float)m_max_num_steps);
-        m_clouds_program->set_uniform("u_LightStepLength", m_light_step_length);
-        m_clouds_program->set_uniform("u_LightConeRadius", m_light_cone_radius);
-        m_clouds_program->set_uniform("u_SunDir", -m_light_direction);
-        m_clouds_program->set_uniform("u_SunColor", m_sun_color);
-        m_clouds_program->set_uniform("u_CloudBaseColor", m_cloud_base_color);
-        m_clouds_program->set_uniform("u_CloudTopColor", m_cloud_top_color);
-        m_clouds_program->set_uniform("u_Precipitation", m_precipitation * 0.01f);
-        m_clouds_program->set_uniform("u_AmbientLightFactor", m_ambient_light_factor);
-        m_clouds_program->set_uniform("u_SunLightFactor", m_sun_light_factor);
-        m_clouds_program->set_uniform("u_HenyeyGreensteinGForward", m_henyey_greenstein_g_forward);
-        m_clouds_program->set_uniform("u_HenyeyGreensteinGBackward", m_henyey_greenstein_g_backward);
+    void end_cloud_stats()
+    {
+        if (!m_cloud_stats)
+            return;
+
+        uint32_t slot = m_frame_index % PROFILER_FRAMES_IN_FLIGHT;
+
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+
+        m_cloud_stats_fences[slot]      = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_cloud_stats_fence_frame[slot] = m_frame_index;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Reads back the totals of every frame the GPU has finished, oldest first, and streams them to the log.
+    void resolve_cloud_stats()
+    {
+        for (uint32_t i = 1; i <= PROFILER_FRAMES_IN_FLIGHT; i++)
+        {
+            uint32_t slot = (m_frame_index + i) % PROFILER_FRAMES_IN_FLIGHT;
+
+            if (!m_cloud_stats_fences[slot])
+                continue;
+
+            GLenum status = glClientWaitSync(m_cloud_stats_fences[slot], 0, 0);
+
+            if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                continue;
+
+            glGetNamedBufferSubData(m_cloud_stats_buffers[slot], 0, sizeof(CloudStatsTotals), &m_cloud_stats_totals);
+            glDeleteSync(m_cloud_stats_fences[slot]);
+
+            m_cloud_stats_fences[slot] = nullptr;
+            m_cloud_stats_frame        = m_cloud_stats_fence_frame[slot];
+
+            m_cloud_stats_log.write_frame(m_cloud_stats_frame, m_cloud_stats_totals);
+
+            if (m_benchmark && m_cloud_stats_frame >= m_benchmark_script.warmup && m_benchmark_cloud_stats_frames < m_benchmark_script.frames)
+            {
+                for (uint32_t c = 0; c < CLOUD_STATS_COUNTER_COUNT; c++)
+                    m_benchmark_cloud_stats[c] += m_cloud_stats_totals.counters[c];
+
+                m_benchmark_cloud_stats[CLOUD_STATS_COUNTER_COUNT] += m_cloud_stats_totals.occupied_steps;
+                m_benchmark_cloud_stats[CLOUD_STATS_COUNTER_COUNT + 1] += m_cloud_stats_totals.marched_pixels;
+                m_benchmark_cloud_stats_frames++;
+            }
+        }
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Replaces the tone mapped image with one counter of every pixel, from blue at zero to red at m_cloud_stats_heatmap_max.
+    void render_cloud_stats_heatmap()
+    {
+        if (!m_cloud_stats || m_cloud_stats_heatmap == 0 || !m_cloud_stats_heatmap_program)
+            return;
+
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glViewport(0, 0, m_width, m_height);
+
+        m_cloud_stats_heatmap_program->use();
+
+        if (m_cloud_stats_heatmap_program->set_uniform("s_CloudStats", 0))
+            m_cloud_stats_texture->bind(0);
+
+        m_cloud_stats_heatmap_program->set_uniform("u_Counter", m_cloud_stats_heatmap - 1);
+        m_cloud_stats_heatmap_program->set_uniform("u_MaxValue", m_cloud_stats_heatmap_max);
 
         glDrawArrays(GL_TRIANGLES, 0, 3);
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
 
+    bool compute_tonemap() const
+    {
+        return m_compute_tonemap && m_tonemap_compute_program;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
     void tonemap()
     {
+        if (compute_tonemap())
+        {
+            tonemap_compute();
+            return;
+        }
+
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         glViewport(0, 0, m_width, m_height);
 
@@ -505,14 +2699,102 @@ private:
 
     // -----------------------------------------------------------------------------------------------------------------------------------
 
+    // Compute version of tonemap(). The tone mapping pass adds every pixel to the luminance histogram as it reads it, so the auto
+    // exposure costs no extra read of the HDR image, and auto_exposure_cs.glsl reduces the histogram to the exposure of the next frame.
+    // The reduction also runs with the manual exposure, which keeps the histogram cleared and the exposure adapted for when it is
+    // turned back on.
+    void tonemap_compute()
+    {
+        glm::vec2 log2_luminance_range = glm::vec2(m_auto_exposure_settings.min_log2_luminance, m_auto_exposure_settings.max_log2_luminance);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_auto_exposure_buffer);
+
+        m_ldr_output_texture->bind_image(0, 0, 0, GL_WRITE_ONLY, GL_RGBA8);
+
+        m_tonemap_compute_program->use();
+
+        if (m_tonemap_compute_program->set_uniform("s_HDR", 0))
+            m_hdr_output_texture->bind(0);
+
+        m_tonemap_compute_program->set_uniform("u_AutoExposure", (int)m_auto_exposure);
+        m_tonemap_compute_program->set_uniform("u_Exposure", m_exposure);
+        m_tonemap_compute_program->set_uniform("u_Log2LuminanceRange", log2_luminance_range);
+
+        const uint32_t NUM_THREADS = 16;
+
+        glDispatchCompute((m_width + NUM_THREADS - 1) / NUM_THREADS, (m_height + NUM_THREADS - 1) / NUM_THREADS, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_FRAMEBUFFER_BARRIER_BIT);
+
+        m_auto_exposure_program->use();
+        m_auto_exposure_program->set_uniform("u_Log2LuminanceRange", log2_luminance_range);
+        m_auto_exposure_program->set_uniform("u_Percentiles", glm::vec2(m_auto_exposure_settings.low_percentile, m_auto_exposure_settings.high_percentile));
+        m_auto_exposure_program->set_uniform("u_Key", m_auto_exposure_settings.key);
+        m_auto_exposure_program->set_uniform("u_Compensation", m_auto_exposure_settings.compensation);
+        m_auto_exposure_program->set_uniform("u_ExposureRange", glm::vec2(m_auto_exposure_settings.min_exposure, m_auto_exposure_settings.max_exposure));
+        m_auto_exposure_program->set_uniform("u_AdaptationSpeed", glm::vec2(m_auto_exposure_settings.speed_up, m_auto_exposure_settings.speed_down));
+        m_auto_exposure_program->set_uniform("u_DeltaTime", m_time - m_prev_time);
+
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+        glDisable(GL_SCISSOR_TEST);
+        glBlitNamedFramebuffer(m_ldr_output_framebuffer, 0, 0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
     void update_uniforms()
     {
+        // Derived from the GUI and benchmark parameters, updated even when the GUI is hidden.
+        m_planet_center = glm::vec3(0.0f, -m_planet_radius, 0.0f);
+
+        m_light_direction = glm::normalize(glm::vec3(0.0f, sin(m_sun_angle), cos(m_sun_angle)));
+        m_wind_direction  = glm::normalize(glm::vec3(cos(m_wind_angle), sin(m_wind_angle), 0.0f));
+
         // Global
-        {
-            void* ptr = m_global_ubo->map(GL_WRITE_ONLY);
-            memcpy(ptr, &m_global_uniforms, sizeof(GlobalUniforms));
-            m_global_ubo->unmap();
-        }
+        m_global_ubo.update(&m_global_uniforms);
+
+        // Clouds
+        float noise_scale = 0.00001f + m_shape_noise_scale * 0.0004f;
+
+        m_cloud_uniforms.planet_center                = m_planet_center;
+        m_cloud_uniforms.planet_radius                = m_planet_radius;
+        m_cloud_uniforms.wind_direction               = m_wind_direction;
+        m_cloud_uniforms.wind_speed                   = m_wind_speed;
+        m_cloud_uniforms.sun_dir                      = -m_light_direction;
+        m_cloud_uniforms.wind_shear_offset            = m_wind_shear_offset;
+        m_cloud_uniforms.sun_color                    = m_sun_color;
+        m_cloud_uniforms.cloud_min_height             = m_cloud_min_height;
+        m_cloud_uniforms.cloud_base_color             = m_cloud_base_color;
+        m_cloud_uniforms.cloud_max_height             = m_cloud_max_height;
+        m_cloud_uniforms.cloud_top_color              = m_cloud_top_color;
+        m_cloud_uniforms.shape_noise_scale            = noise_scale;
+        m_cloud_uniforms.detail_noise_scale           = noise_scale * m_detail_noise_scale;
+        m_cloud_uniforms.detail_noise_modifier        = m_detail_noise_modifier;
+        m_cloud_uniforms.turbulence_noise_scale       = noise_scale * m_turbulence_noise_scale;
+        m_cloud_uniforms.turbulence_amount            = m_turbulence_amount;
+        m_cloud_uniforms.cloud_coverage               = m_cloud_coverage;
+        m_cloud_uniforms.max_num_steps                = (float)m_max_num_steps;
+        m_cloud_uniforms.light_step_length            = m_light_step_length;
+        m_cloud_uniforms.light_cone_radius            = m_light_cone_radius;
+        m_cloud_uniforms.precipitation                = m_precipitation * 0.01f;
+        m_cloud_uniforms.ambient_light_factor         = m_ambient_light_factor;
+        m_cloud_uniforms.sun_light_factor             = m_sun_light_factor;
+        m_cloud_uniforms.henyey_greenstein_g_forward  = m_henyey_greenstein_g_forward;
+        m_cloud_uniforms.henyey_greenstein_g_backward = m_henyey_greenstein_g_backward;
+        m_cloud_uniforms.empty_space_skipping         = (int32_t)m_empty_space_skipping;
+        m_cloud_uniforms.adaptive_march               = (int32_t)m_adaptive_march;
+        m_cloud_uniforms.coarse_step_scale            = m_coarse_step_scale;
+        m_cloud_uniforms.empty_samples_before_coarse  = m_empty_samples_before_coarse;
+        m_cloud_uniforms.transmittance_threshold      = m_transmittance_threshold;
+        m_cloud_uniforms.light_volume                 = (int32_t)(m_light_volume && m_light_volume_program);
+        m_cloud_uniforms.sky_view_lut                 = (int32_t)(m_sky_view_lut && m_sky_view_lut_program);
+        m_cloud_uniforms.depth_clipping               = (int32_t)m_depth_clipping;
+        m_cloud_uniforms.weather_map                  = (int32_t)(m_weather_map && m_weather_map_available);
+        m_cloud_uniforms.folded_noise                 = (int32_t)noise_format_folded(m_noise_format);
+
+        // Skipped when none of the parameters changed since the last frame.
+        m_cloud_ubo.update(&m_cloud_uniforms);
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
@@ -520,9 +2802,10 @@ private:
     void update_transforms(dw::Camera* camera)
     {
         // Update camera matrices.
-        m_global_uniforms.view_proj     = camera->m_projection * camera->m_view;
-        m_global_uniforms.inv_view_proj = glm::inverse(camera->m_projection * camera->m_view);
-        m_global_uniforms.cam_pos       = glm::vec4(camera->m_position, 0.0f);
+        m_global_uniforms.prev_view_proj = m_frame_index == 0 ? camera->m_projection * camera->m_view : m_global_uniforms.view_proj;
+        m_global_uniforms.view_proj      = camera->m_projection * camera->m_view;
+        m_global_uniforms.inv_view_proj  = glm::inverse(camera->m_projection * camera->m_view);
+        m_global_uniforms.cam_pos        = glm::vec4(camera->m_position, 0.0f);
     }
 
     // -----------------------------------------------------------------------------------------------------------------------------------
@@ -562,27 +2845,85 @@ private:
 
 private:
     // General GPU resources.
-    dw::gl::Shader::Ptr      m_mesh_vs;
-    dw::gl::Shader::Ptr      m_mesh_fs;
-    dw::gl::Shader::Ptr      m_triangle_vs;
-    dw::gl::Shader::Ptr      m_clouds_fs;
-    dw::gl::Shader::Ptr      m_tonemap_fs;
-    dw::gl::Shader::Ptr      m_shape_noise_cs;
-    dw::gl::Shader::Ptr      m_detail_noise_cs;
-    dw::gl::Program::Ptr     m_mesh_program;
-    dw::gl::Program::Ptr     m_clouds_program;
-    dw::gl::Program::Ptr     m_tonemap_program;
-    dw::gl::Program::Ptr     m_shape_noise_program;
-    dw::gl::Program::Ptr     m_detail_noise_program;
-    dw::gl::Buffer::Ptr      m_global_ubo;
+    ShaderProgram::Ptr       m_mesh_program;
+    ShaderProgram::Ptr       m_clouds_program;
+    ShaderVariants           m_clouds_variants;
+    ShaderVariants           m_tiled_clouds_variants;
+    ShaderProgram::Ptr       m_tonemap_program;
+    ShaderProgram::Ptr       m_tonemap_compute_program;
+    ShaderProgram::Ptr       m_auto_exposure_program;
+    ShaderProgram::Ptr       m_cloud_stats_heatmap_program;
+    ShaderProgram::Ptr       m_clouds_reconstruct_program;
+    ShaderProgram::Ptr       m_copy_program;
+    ShaderProgram::Ptr       m_clouds_upsample_program;
+    ShaderProgram::Ptr       m_shape_noise_program;
+    ShaderProgram::Ptr       m_detail_noise_program;
+    ShaderProgram::Ptr       m_empty_space_grid_program;
+    ShaderProgram::Ptr       m_noise_downsample_program;
+    ShaderProgram::Ptr       m_light_volume_program;
+    ShaderProgram::Ptr       m_cloud_shadow_map_program;
+    ShaderProgram::Ptr       m_sky_view_lut_program;
+    ShaderProgram::Ptr       m_cloud_tile_classify_program;
+    ShaderProgram::Ptr       m_tiled_clouds_program;
+    ShaderLibrary            m_shader_library;
+    GLuint                   m_cloud_tile_buffer       = 0;
+    GLuint                   m_coverage_bound_buffer   = 0;
+    GLsync                   m_coverage_bound_fence    = nullptr;
+    GLuint                   m_cloud_probe_framebuffer = 0;
+    GLuint                   m_ldr_output_framebuffer  = 0;
+    GLuint                   m_auto_exposure_buffer    = 0;
+    UniformRing              m_global_ubo;
+    UniformRing              m_cloud_ubo;
+    UniformRing              m_cloud_probe_ubo;
+    Profiler                 m_profiler;
+    std::string              m_profile_log_path;
+
+    // Program binary cache and hot reload of the shader files, see shader_program.h.
+    bool                        m_program_cache     = true;
+    bool                        m_shader_hot_reload = true;
+    std::vector<ShaderProgram*> m_reloaded_programs;
+
+    // Benchmark mode.
+    bool               m_benchmark = false;
+    std::string        m_benchmark_script_path;
+    std::string        m_benchmark_image_prefix;
+    BenchmarkScript    m_benchmark_script;
+    std::vector<float> m_benchmark_frame_times;
+    uint32_t           m_benchmark_next_keyframe = 0;
+
+    // Sums of the cloud stats counters over the measured frames, then occupied steps and marched pixels.
+    uint64_t m_benchmark_cloud_stats[CLOUD_STATS_COUNTER_COUNT + 2] = {};
+    uint32_t m_benchmark_cloud_stats_frames                        = 0;
     dw::gl::Texture2D::Ptr   m_hdr_output_texture;
     dw::gl::Texture2D::Ptr   m_depth_output_texture;
     dw::gl::Texture2D::Ptr   m_placeholder_texture;
     dw::gl::Texture2D::Ptr   m_blue_noise_texture;
     dw::gl::Texture2D::Ptr   m_curl_noise_texture;
+    dw::gl::Texture2D::Ptr   m_cirrus_noise_texture;
     dw::gl::Texture3D::Ptr   m_shape_noise_texture;
     dw::gl::Texture3D::Ptr   m_detail_noise_texture;
+    dw::gl::Texture3D::Ptr   m_shape_noise_back_texture;
+    dw::gl::Texture3D::Ptr   m_detail_noise_back_texture;
+    dw::gl::Texture3D::Ptr   m_empty_space_grid_texture;
+    dw::gl::Texture3D::Ptr   m_light_volume_texture[2];
+    dw::gl::Texture2D::Ptr   m_cloud_shadow_map_texture[2];
+    dw::gl::Texture2D::Ptr   m_sky_view_lut_texture;
+    dw::gl::Texture2D::Ptr   m_weather_atlas_texture;
+    dw::gl::Texture2D::Ptr   m_weather_indirection_texture;
     dw::gl::Framebuffer::Ptr m_hdr_output_framebuffer;
+    dw::gl::Framebuffer::Ptr m_hdr_composite_framebuffer;
+    dw::gl::Texture2D::Ptr   m_ldr_output_texture;
+    dw::gl::Texture2D::Ptr   m_cloud_stats_texture;
+    dw::gl::Texture2D::Ptr   m_clouds_lowres_texture;
+    dw::gl::Framebuffer::Ptr m_clouds_lowres_framebuffer;
+    dw::gl::Texture2D::Ptr   m_clouds_history_texture[2];
+    dw::gl::Framebuffer::Ptr m_clouds_history_framebuffer[2];
+    dw::gl::Texture2D::Ptr   m_clouds_scaled_texture;
+    dw::gl::Framebuffer::Ptr m_clouds_scaled_framebuffer;
+    dw::gl::TextureCube::Ptr m_cloud_probe_texture;
+    dw::gl::Texture2D::Ptr   m_cloud_probe_depth_texture;
+
+    CloudQualityTier m_quality_tier = CLOUD_QUALITY_CUSTOM;
 
     int32_t   m_max_num_steps       = 128;
     float     m_cloud_min_height    = 1500.0f;
@@ -610,6 +2951,140 @@ private:
     float     m_henyey_greenstein_g_forward  = 0.4f;
     float     m_henyey_greenstein_g_backward = 0.179f;
     float     m_exposure                     = 0.6f;
+    float     m_shape_noise_frequency        = 4.0f;
+    float     m_detail_noise_frequency       = 8.0f;
+
+    // Cirrus layers above the volumetric shell, at most CLOUD_MAX_CIRRUS_LAYERS.
+    std::vector<CloudLayer> m_cirrus_layers;
+    std::vector<CloudLayer> m_cirrus_layers_gui;  // Edited by the GUI, copied to m_cirrus_layers while they make a valid stack.
+    std::string             m_cloud_layers_error; // Why m_cirrus_layers_gui is not in use, empty if it is.
+
+    // Instrumented cloud programs, see cloud_stats.h. The buffers hold the totals of the frames in flight.
+    bool             m_cloud_stats             = false;
+    int32_t          m_cloud_stats_heatmap     = 0; // 0 is off, otherwise the counter shown plus one.
+    float            m_cloud_stats_heatmap_max = 256.0f;
+    GLuint           m_cloud_stats_buffers[PROFILER_FRAMES_IN_FLIGHT]     = {};
+    GLsync           m_cloud_stats_fences[PROFILER_FRAMES_IN_FLIGHT]      = {};
+    uint64_t         m_cloud_stats_fence_frame[PROFILER_FRAMES_IN_FLIGHT] = {};
+    CloudStatsTotals m_cloud_stats_totals                                 = {};
+    uint64_t         m_cloud_stats_frame                                  = 0;
+    std::string      m_cloud_stats_log_path;
+    CloudStatsLog    m_cloud_stats_log;
+
+    // Compute tonemap with histogram auto exposure, see auto_exposure.h.
+    bool                 m_compute_tonemap = false;
+    bool                 m_auto_exposure   = false;
+    AutoExposureSettings m_auto_exposure_settings;
+
+    // Generate the noise volumes on the CPU even if compute shaders are available.
+    bool m_cpu_noise = false;
+
+    // Storage format of the noise volumes, see noise_format.h.
+    NoiseFormat m_noise_format = NOISE_FORMAT_RGBA16F;
+
+    // Incremental regeneration of the noise volumes into the back textures, see noise_regenerator.h. The shape volume is built first,
+    // then the detail volume, and both are swapped with the front ones together.
+    bool                            m_noise_regenerating        = false;
+    bool                            m_noise_regeneration_on_gpu = false;
+    float                           m_noise_budget_ms           = 1.0f;
+    NoiseFormat                     m_noise_back_format         = NOISE_FORMAT_RGBA16F;
+    CpuNoiseVolume                  m_noise_back_volume         = CPU_NOISE_VOLUME_SHAPE;
+    NoiseSlabScheduler              m_noise_scheduler;
+    NoiseSlabBudget                 m_noise_budget;
+    std::vector<NoiseSliceRange>    m_noise_ranges;
+    std::vector<std::vector<float>> m_noise_back_mips; // Quantized texels of every mip, CPU only.
+    GLuint                          m_noise_timer_queries[PROFILER_FRAMES_IN_FLIGHT][2];
+    uint64_t                        m_noise_timer_texels[PROFILER_FRAMES_IN_FLIGHT] = {}; // 0 if the queries are not pending.
+    uint32_t                        m_noise_timer_next = 0;
+
+    // Leap over cells of the shape noise that cannot contain clouds at the current coverage.
+    bool m_empty_space_skipping = true;
+
+    // Adaptive march: coarse steps through empty space, fine steps inside clouds and early termination once the ray is opaque.
+    bool    m_adaptive_march              = false;
+    float   m_coarse_step_scale           = 4.0f;
+    int32_t m_empty_samples_before_coarse = 6;
+    float   m_transmittance_threshold     = 0.01f;
+
+    // Ends the cloud march at the scene geometry and skips pixels where the geometry is in front of the cloud layer.
+    bool m_depth_clipping = true;
+
+    // Classifies 16x16 tiles first and only marches the tiles that can contain clouds, see cloud_tiles.h.
+    bool  m_tiled_clouds   = false;
+    float m_coverage_bound = 1e30f;
+
+    // Counts the changes of the density inputs that are not in CloudUniforms (resident weather tiles, noise volumes). The light volume
+    // and the cloud shadow map remember the generation they were built with.
+    uint32_t m_density_generation = 0;
+
+    // Streamed weather map. Off by default, inside the window it replaces the Cloud Coverage slider and the coverage of the benchmark
+    // keyframes.
+    bool                           m_weather_map               = false;
+    bool                           m_weather_map_available     = false;
+    bool                           m_weather_indirection_valid = false;
+    WeatherMapFile                 m_weather_map_file;
+    WeatherResidency               m_weather_residency;
+    std::vector<WeatherTileUpload> m_weather_uploads;
+
+    // Sky-view LUT, rebuilt whenever the sun direction differs from the one it was built for.
+    bool      m_sky_view_lut         = false;
+    bool      m_sky_view_lut_valid   = false;
+    glm::vec3 m_sky_view_lut_sun_dir = glm::vec3(0.0f);
+
+    // Sun transmittance volume, double buffered so that the front one stays valid while the back one is rebuilt over several frames.
+    bool          m_light_volume            = false;
+    bool          m_light_volume_valid      = false;
+    uint32_t      m_light_volume_front      = 0;
+    uint32_t      m_light_volume_next_slice = 0;
+    glm::vec3     m_light_volume_origin[2]  = { glm::vec3(0.0f), glm::vec3(0.0f) };
+    float         m_light_volume_extent[2]  = { 1.0f, 1.0f };
+    float         m_light_volume_time[2]    = { 0.0f, 0.0f };
+    CloudUniforms m_light_volume_uniforms   = {};
+    uint32_t      m_light_volume_density_generation = 0;
+
+    // Cloud shadow map, double buffered like the light volume. The rows per frame bound the cost of a rebuild.
+    bool                     m_cloud_shadows                  = true;
+    float                    m_cloud_shadow_strength          = 1.0f;
+    int32_t                  m_cloud_shadow_rows_per_frame    = 64;
+    int32_t                  m_cloud_shadow_update_interval   = 30;
+    bool                     m_cloud_shadow_map_valid         = false;
+    uint32_t                 m_cloud_shadow_map_front         = 0;
+    uint32_t                 m_cloud_shadow_map_next_row      = 0;
+    uint32_t                 m_cloud_shadow_map_build_frame   = 0;
+    CloudShadowMapProjection m_cloud_shadow_map_projection[2] = {};
+    float                    m_cloud_shadow_map_time[2]       = { 0.0f, 0.0f };
+    CloudUniforms            m_cloud_shadow_map_uniforms      = {};
+    uint32_t                 m_cloud_shadow_map_density_generation = 0;
+
+    // Cloud probe, see cloud_probe.h.
+    bool                m_cloud_probe          = false;
+    bool                m_cloud_probe_mips     = true;
+    int32_t             m_cloud_probe_tiles    = 1;
+    float               m_cloud_probe_ambient  = 1.0f;
+    glm::vec3           m_cloud_probe_position = glm::vec3(0.0f);
+    CloudProbeScheduler m_cloud_probe_scheduler;
+
+    // Density LOD of the primary march, defaults from volumetric-clouds-reference --compare-density-lod.
+    bool  m_density_lod         = false;
+    float m_lod_bias            = 0.0f;
+    float m_lod_detail_distance = 12000.0f;
+    float m_lod_detail_opacity  = 0.95f;
+    float m_lod_cone_scale      = 1.0f;
+
+    // Cloud budget controller, see cloud_budget.h. m_cloud_budget_levels holds the level of the frames the profiler has in flight.
+    bool                  m_cloud_budget_enabled = false;
+    float                 m_cloud_budget_ms      = 4.0f;
+    CloudBudgetController m_cloud_budget;
+    CloudBudgetLevel      m_cloud_level = { 1.0f, 1.0f };
+    CloudBudgetLevel      m_cloud_budget_levels[PROFILER_FRAMES_IN_FLIGHT];
+    uint64_t              m_cloud_budget_frame = UINT64_MAX;
+
+    // Temporal reprojection.
+    bool     m_temporal_reprojection = false;
+    bool     m_history_valid         = false;
+    uint32_t m_frame_index           = 0;
+    float    m_time                  = 0.0f;
+    float    m_prev_time             = 0.0f;
 
     dw::Mesh::Ptr               m_plane;
     std::unique_ptr<dw::Camera> m_main_camera;
@@ -617,6 +3092,7 @@ private:
     float          m_sun_angle = 0.0f;
     glm::vec3      m_light_direction;
     GlobalUniforms m_global_uniforms;
+    CloudUniforms  m_cloud_uniforms = {};
 
     // Camera controls.
     bool  m_mouse_look         = false;
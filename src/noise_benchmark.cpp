@@ -0,0 +1,255 @@
+#include "cpu_noise.h"
+#include "noise_cache.h"
+#include "noise_format.h"
+#include "slice_scheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// Benchmarks the CPU noise generators and optionally bakes noise cache files that the sample picks up on startup.
+//
+// Usage:
+//     noise-benchmark [--size N] [--threads N] [--detail]
+//     noise-benchmark --bake <shader directory> [--shape-size N] [--detail-size N]
+//     noise-benchmark --format-report [--shape-size N] [--detail-size N]
+//
+// --format-report prints the size of the noise volumes in every NoiseFormat and the error of what the ray march reads out of them
+// against RGBA16F. Frame times per format come from the profiler of the sample or from volumetric-clouds-reference
+// --compare-noise-formats.
+
+// OpenGL enums stored in the cache header. Duplicated here so that the tool does not depend on GL headers.
+#define NOISE_GL_RGBA16F 0x881A
+#define NOISE_GL_RGBA 0x1908
+#define NOISE_GL_HALF_FLOAT 0x140B
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static std::string read_text_file(const std::string& path)
+{
+    std::ifstream file(path);
+
+    if (!file.is_open())
+        return "";
+
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static double benchmark(CpuNoiseVolume volume, uint32_t size, float frequency, CpuNoiseBackend backend, uint32_t num_threads, std::vector<float>& out)
+{
+    out.resize(size_t(size) * size * size * 4);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    cpu_noise_generate(volume, size, frequency, backend, num_threads, out.data());
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+
+    return double(size) * size * size / seconds;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Bakes the volume in RGBA16F, the default format of the sample.
+static bool bake(const std::string& shader_dir, CpuNoiseVolume type, const char* shader, uint32_t size, float frequency)
+{
+    std::string path          = noise_format_cache_path(NOISE_FORMAT_RGBA16F, type);
+    std::string noise_source  = read_text_file(shader_dir + "/noise.glsl");
+    std::string shader_source = read_text_file(shader_dir + "/" + shader);
+
+    if (noise_source.empty() || shader_source.empty())
+    {
+        printf("Failed to read shader sources from %s\n", shader_dir.c_str());
+        return false;
+    }
+
+    std::vector<float> data(size_t(size) * size * size * 4);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    cpu_noise_generate(type, size, frequency, cpu_noise_best_backend(), 0, data.data());
+
+    std::vector<std::vector<float>> mips;
+    cpu_noise_generate_mips(data.data(), size, 4, mips);
+
+    std::vector<std::vector<uint16_t>> half_mips(mips.size());
+
+    NoiseVolume volume;
+
+    volume.key             = noise_cache_key({ shader_source, noise_source }, size, { frequency }, NOISE_FORMAT_RGBA16F);
+    volume.internal_format = NOISE_GL_RGBA16F;
+    volume.format          = NOISE_GL_RGBA;
+    volume.type            = NOISE_GL_HALF_FLOAT;
+
+    for (size_t i = 0; i < mips.size(); i++)
+    {
+        half_mips[i].resize(mips[i].size());
+
+        for (size_t j = 0; j < mips[i].size(); j++)
+            half_mips[i][j] = cpu_noise_float_to_half(mips[i][j]);
+
+        uint32_t mip_size = std::max(size >> i, 1u);
+
+        NoiseCacheMip mip;
+
+        mip.width   = mip_size;
+        mip.height  = mip_size;
+        mip.depth   = mip_size;
+        mip.padding = 0;
+        mip.offset  = 0;
+        mip.size    = half_mips[i].size() * sizeof(uint16_t);
+
+        volume.mips.push_back(mip);
+        volume.mip_data.push_back(reinterpret_cast<const uint8_t*>(half_mips[i].data()));
+    }
+
+    if (!noise_cache_write(path, volume))
+    {
+        printf("Failed to write %s\n", path.c_str());
+        return false;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    printf("Baked %s (%u^3) in %.2f s\n", path.c_str(), size, std::chrono::duration<double>(end - start).count());
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static void format_report(uint32_t shape_size, uint32_t detail_size)
+{
+    const CpuNoiseVolume volumes[]     = { CPU_NOISE_VOLUME_SHAPE, CPU_NOISE_VOLUME_DETAIL };
+    const uint32_t       sizes[]       = { shape_size, detail_size };
+    const float          frequencies[] = { 4.0f, 8.0f };
+
+    printf("%-8s %-10s %12s %12s %12s %12s %12s\n", "Volume", "Format", "Bytes (KB)", "Max", "RMS", "Max (mid)", "RMS (mid)");
+
+    for (int v = 0; v < 2; v++)
+    {
+        std::vector<float> texels(size_t(sizes[v]) * sizes[v] * sizes[v] * 4);
+
+        cpu_noise_generate(volumes[v], sizes[v], frequencies[v], cpu_noise_best_backend(), 0, texels.data());
+
+        for (int f = 0; f < NOISE_FORMAT_COUNT; f++)
+        {
+            NoiseFormat      format = NoiseFormat(f);
+            NoiseFormatError at_texels;
+            NoiseFormatError between_texels;
+
+            noise_format_error(format, volumes[v], texels.data(), sizes[v], at_texels, between_texels);
+
+            // A full mip chain adds a seventh.
+            double bytes = double(sizes[v]) * sizes[v] * sizes[v] * noise_format_texel_size(format, volumes[v]) * 8.0 / 7.0;
+
+            printf("%-8s %-10s %12.0f %12.6f %12.6f %12.6f %12.6f\n", v == 0 ? "Shape" : "Detail", noise_format_name(format), bytes / 1024.0, at_texels.max_error, at_texels.rms_error, between_texels.max_error, between_texels.rms_error);
+        }
+    }
+
+    printf("\nShape: base cloud shape in [0, 1], detail: Worley FBM. (mid) is half way between texels, after trilinear filtering.\n");
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, const char* argv[])
+{
+    uint32_t       size        = 64;
+    uint32_t       num_threads = 0;
+    uint32_t       shape_size  = 128;
+    uint32_t       detail_size = 32;
+    CpuNoiseVolume volume      = CPU_NOISE_VOLUME_SHAPE;
+    bool           report      = false;
+    std::string    shader_dir;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--size") && i + 1 < argc)
+            size = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            num_threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--detail"))
+            volume = CPU_NOISE_VOLUME_DETAIL;
+        else if (!strcmp(argv[i], "--bake") && i + 1 < argc)
+            shader_dir = argv[++i];
+        else if (!strcmp(argv[i], "--format-report"))
+            report = true;
+        else if (!strcmp(argv[i], "--shape-size") && i + 1 < argc)
+            shape_size = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--detail-size") && i + 1 < argc)
+            detail_size = atoi(argv[++i]);
+        else
+        {
+            printf("Unknown argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (!shader_dir.empty())
+    {
+        if (!bake(shader_dir, CPU_NOISE_VOLUME_SHAPE, "shape_noise_cs.glsl", shape_size, 4.0f))
+            return 1;
+
+        if (!bake(shader_dir, CPU_NOISE_VOLUME_DETAIL, "detail_noise_cs.glsl", detail_size, 8.0f))
+            return 1;
+
+        return 0;
+    }
+
+    if (report)
+    {
+        format_report(shape_size, detail_size);
+        return 0;
+    }
+
+    float frequency = volume == CPU_NOISE_VOLUME_SHAPE ? 4.0f : 8.0f;
+
+    if (num_threads == 0)
+        num_threads = SliceScheduler::hardware_threads();
+
+    printf("%s noise, %u^3 texels\n\n", volume == CPU_NOISE_VOLUME_SHAPE ? "Shape" : "Detail", size);
+    printf("%-10s %8s %16s %10s %10s\n", "Backend", "Threads", "Texels/sec", "Speedup", "Matches");
+
+    std::vector<float> reference;
+    double             reference_rate = benchmark(volume, size, frequency, CPU_NOISE_BACKEND_SCALAR, 1, reference);
+
+    printf("%-10s %8u %16.0f %9.2fx %10s\n", cpu_noise_backend_name(CPU_NOISE_BACKEND_SCALAR), 1u, reference_rate, 1.0, "-");
+
+    const CpuNoiseBackend backends[] = { CPU_NOISE_BACKEND_SSE41, CPU_NOISE_BACKEND_AVX2 };
+
+    for (CpuNoiseBackend backend : backends)
+    {
+        if (!cpu_noise_backend_supported(backend))
+        {
+            printf("%-10s %8s %16s %10s %10s\n", cpu_noise_backend_name(backend), "-", "unsupported", "-", "-");
+            continue;
+        }
+
+        std::vector<float> result;
+        double             rate    = benchmark(volume, size, frequency, backend, 1, result);
+        bool               matches = memcmp(result.data(), reference.data(), reference.size() * sizeof(float)) == 0;
+
+        printf("%-10s %8u %16.0f %9.2fx %10s\n", cpu_noise_backend_name(backend), 1u, rate, rate / reference_rate, matches ? "yes" : "NO");
+    }
+
+    CpuNoiseBackend best = cpu_noise_best_backend();
+
+    std::vector<float> result;
+    double             rate    = benchmark(volume, size, frequency, best, num_threads, result);
+    bool               matches = memcmp(result.data(), reference.data(), reference.size() * sizeof(float)) == 0;
+
+    printf("%-10s %8u %16.0f %9.2fx %10s\n", cpu_noise_backend_name(best), num_threads, rate, rate / reference_rate, matches ? "yes" : "NO");
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,274 @@
+#include "noise_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+
+#if defined(_WIN32)
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static uint64_t align_offset(uint64_t offset)
+{
+    return (offset + NOISE_CACHE_ALIGNMENT - 1) & ~uint64_t(NOISE_CACHE_ALIGNMENT - 1);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint64_t noise_cache_hash(const void* data, size_t size, uint64_t seed)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t       hash  = seed;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return hash;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint64_t noise_cache_key(const std::vector<std::string>& shader_sources, uint32_t size, const std::vector<float>& frequencies, uint32_t format)
+{
+    uint32_t version = NOISE_CACHE_VERSION;
+    uint64_t key     = noise_cache_hash(&version, sizeof(version));
+
+    for (const auto& source : shader_sources)
+    {
+        uint64_t length = source.size();
+
+        key = noise_cache_hash(&length, sizeof(length), key);
+        key = noise_cache_hash(source.data(), source.size(), key);
+    }
+
+    key = noise_cache_hash(&size, sizeof(size), key);
+
+    for (float frequency : frequencies)
+        key = noise_cache_hash(&frequency, sizeof(frequency), key);
+
+    return noise_cache_hash(&format, sizeof(format), key);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void noise_cache_serialize(const NoiseVolume& volume, std::vector<uint8_t>& out)
+{
+    NoiseCacheHeader header;
+
+    header.magic           = NOISE_CACHE_MAGIC;
+    header.version         = NOISE_CACHE_VERSION;
+    header.key             = volume.key;
+    header.internal_format = volume.internal_format;
+    header.format          = volume.format;
+    header.type            = volume.type;
+    header.num_mips        = static_cast<uint32_t>(volume.mips.size());
+
+    std::vector<NoiseCacheMip> mips = volume.mips;
+
+    uint64_t offset = align_offset(sizeof(NoiseCacheHeader) + sizeof(NoiseCacheMip) * mips.size());
+
+    for (auto& mip : mips)
+    {
+        mip.padding = 0;
+        mip.offset  = offset;
+        offset      = align_offset(offset + mip.size);
+    }
+
+    out.assign(offset, 0);
+
+    memcpy(out.data(), &header, sizeof(NoiseCacheHeader));
+
+    if (!mips.empty())
+        memcpy(out.data() + sizeof(NoiseCacheHeader), mips.data(), sizeof(NoiseCacheMip) * mips.size());
+
+    for (size_t i = 0; i < mips.size(); i++)
+        memcpy(out.data() + mips[i].offset, volume.mip_data[i], mips[i].size);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool noise_cache_parse(const uint8_t* data, size_t size, uint64_t expected_key, NoiseVolume& volume)
+{
+    if (!data || size < sizeof(NoiseCacheHeader))
+        return false;
+
+    NoiseCacheHeader header;
+    memcpy(&header, data, sizeof(NoiseCacheHeader));
+
+    if (header.magic != NOISE_CACHE_MAGIC || header.version != NOISE_CACHE_VERSION || header.key != expected_key)
+        return false;
+
+    if (header.num_mips == 0 || sizeof(NoiseCacheHeader) + uint64_t(sizeof(NoiseCacheMip)) * header.num_mips > size)
+        return false;
+
+    volume.key             = header.key;
+    volume.internal_format = header.internal_format;
+    volume.format          = header.format;
+    volume.type            = header.type;
+
+    volume.mips.resize(header.num_mips);
+    volume.mip_data.resize(header.num_mips);
+
+    memcpy(volume.mips.data(), data + sizeof(NoiseCacheHeader), sizeof(NoiseCacheMip) * header.num_mips);
+
+    for (uint32_t i = 0; i < header.num_mips; i++)
+    {
+        const NoiseCacheMip& mip = volume.mips[i];
+
+        if (mip.offset > size || mip.size > size - mip.offset)
+            return false;
+
+        volume.mip_data[i] = data + mip.offset;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+NoiseCacheFile::NoiseCacheFile()
+{
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+NoiseCacheFile::~NoiseCacheFile()
+{
+    close();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool NoiseCacheFile::open(const std::string& path)
+{
+    close();
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER file_size;
+
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file    = file;
+    m_mapping = mapping;
+    m_data    = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    m_size    = static_cast<size_t>(file_size.QuadPart);
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+
+    if (file < 0)
+        return false;
+
+    struct stat file_stat;
+
+    if (fstat(file, &file_stat) != 0 || file_stat.st_size == 0)
+    {
+        ::close(file);
+        return false;
+    }
+
+    void* ptr = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+    if (ptr == MAP_FAILED)
+    {
+        ::close(file);
+        return false;
+    }
+
+    m_file = file;
+    m_data = static_cast<const uint8_t*>(ptr);
+    m_size = static_cast<size_t>(file_stat.st_size);
+#endif
+
+    if (!m_data)
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void NoiseCacheFile::close()
+{
+#if defined(_WIN32)
+    if (m_data)
+        UnmapViewOfFile(m_data);
+
+    if (m_mapping)
+        CloseHandle(m_mapping);
+
+    if (m_file)
+        CloseHandle(m_file);
+
+    m_file    = nullptr;
+    m_mapping = nullptr;
+#else
+    if (m_data)
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+
+    if (m_file >= 0)
+        ::close(m_file);
+
+    m_file = -1;
+#endif
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool noise_cache_write(const std::string& path, const NoiseVolume& volume)
+{
+    std::vector<uint8_t> data;
+    noise_cache_serialize(volume, data);
+
+    // Write to a temporary file first so that a partially written cache is never picked up.
+    std::string   temp_path = path + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open())
+        return false;
+
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    file.close();
+
+    if (!file)
+        return false;
+
+    std::remove(path.c_str());
+
+    return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Versioned binary cache for the baked noise volumes. A cache file stores every mip level of a volume and is keyed by a hash of the
+// noise shader sources and the parameters that were used to generate it, so that it is invalidated whenever any of them change.
+//
+// Layout:
+//     NoiseCacheHeader
+//     NoiseCacheMip[num_mips]
+//     mip data (each mip starts at a 16-byte aligned offset from the start of the file)
+
+#define NOISE_CACHE_MAGIC 0x4843564E // 'NVCH'
+#define NOISE_CACHE_VERSION 1
+#define NOISE_CACHE_ALIGNMENT 16
+
+struct NoiseCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t internal_format;
+    uint32_t format;
+    uint32_t type;
+    uint32_t num_mips;
+};
+
+struct NoiseCacheMip
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t depth;
+    uint32_t padding;
+    uint64_t offset;
+    uint64_t size;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// 64-bit FNV-1a hash. Pass the result of a previous call as the seed to hash several blocks of data.
+uint64_t noise_cache_hash(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
+
+// Builds the cache key from the shader sources, the volume size, the noise frequencies and the format the texels are stored in (a
+// NoiseFormat).
+uint64_t noise_cache_key(const std::vector<std::string>& shader_sources, uint32_t size, const std::vector<float>& frequencies, uint32_t format);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Describes an in-memory volume, either to be serialized or parsed out of a cache file. For parsed volumes the mip data pointers
+// point into the memory of the cache file.
+struct NoiseVolume
+{
+    uint64_t                    key             = 0;
+    uint32_t                    internal_format = 0;
+    uint32_t                    format          = 0;
+    uint32_t                    type            = 0;
+    std::vector<NoiseCacheMip>  mips;
+    std::vector<const uint8_t*> mip_data;
+};
+
+// Serializes the volume into a single contiguous block that can be written to disk as is.
+void noise_cache_serialize(const NoiseVolume& volume, std::vector<uint8_t>& out);
+
+// Parses a block produced by noise_cache_serialize. Fails if the block is truncated, has the wrong magic or version, or if it was
+// generated with a different key.
+bool noise_cache_parse(const uint8_t* data, size_t size, uint64_t expected_key, NoiseVolume& volume);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Read-only memory mapping of a cache file.
+class NoiseCacheFile
+{
+public:
+    NoiseCacheFile();
+    ~NoiseCacheFile();
+
+    bool open(const std::string& path);
+    void close();
+
+    inline const uint8_t* data() const { return m_data; }
+    inline size_t         size() const { return m_size; }
+
+private:
+    NoiseCacheFile(const NoiseCacheFile&) = delete;
+    NoiseCacheFile& operator=(const NoiseCacheFile&) = delete;
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t         m_size = 0;
+#if defined(_WIN32)
+    void* m_file    = nullptr;
+    void* m_mapping = nullptr;
+#else
+    int m_file = -1;
+#endif
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool noise_cache_write(const std::string& path, const NoiseVolume& volume);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,207 @@
+#include "noise_format.h"
+#include "empty_space_grid.h"
+
+#include <ctype.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static inline int32_t wrap(int32_t i, int32_t size)
+{
+    i %= size;
+    return i < 0 ? i + size : i;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// The base cloud shape only matters in [0, 1], remap() with the coverage sends anything below 0 to zero density and it never exceeds 1.
+// Texels where remap() would divide by zero are never empty, as in the empty space grid.
+static inline float folded_base_cloud(const float* texel)
+{
+    return std::min(std::max(empty_space_base_cloud(texel), 0.0f), 1.0f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static inline void accumulate(NoiseFormatError& error, float reference, float value)
+{
+    float difference = fabsf(reference - value);
+
+    error.max_error = std::max(error.max_error, difference);
+    error.rms_error += double(difference) * difference;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+const char* noise_format_name(NoiseFormat format)
+{
+    switch (format)
+    {
+        case NOISE_FORMAT_RGBA16F:
+            return "RGBA16F";
+        case NOISE_FORMAT_UNORM8:
+            return "UNORM8";
+        case NOISE_FORMAT_FOLDED:
+            return "FOLDED";
+        default:
+            return "Unknown";
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint32_t noise_format_channels(NoiseFormat format, CpuNoiseVolume volume)
+{
+    if (format == NOISE_FORMAT_FOLDED)
+        return 1;
+    else if (format == NOISE_FORMAT_UNORM8 && volume == CPU_NOISE_VOLUME_DETAIL)
+        return 3;
+
+    return 4;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint32_t noise_format_texel_size(NoiseFormat format, CpuNoiseVolume volume)
+{
+    return noise_format_channels(format, volume) * (format == NOISE_FORMAT_RGBA16F ? 2 : 1);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+std::string noise_format_cache_path(NoiseFormat format, CpuNoiseVolume volume)
+{
+    std::string name = noise_format_name(format);
+
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+
+    return std::string(volume == CPU_NOISE_VOLUME_SHAPE ? "shape_noise_" : "detail_noise_") + name + ".cache";
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float noise_detail_fbm(const float* texel)
+{
+    return (texel[0] * 0.625f) + (texel[1] * 0.25f) + (texel[2] * 0.125f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void noise_format_pack(NoiseFormat format, CpuNoiseVolume volume, const float* texels, size_t num_texels, std::vector<float>& out)
+{
+    uint32_t channels = noise_format_channels(format, volume);
+
+    out.resize(num_texels * channels);
+
+    for (size_t i = 0; i < num_texels; i++)
+    {
+        const float* texel = texels + i * 4;
+
+        if (format != NOISE_FORMAT_FOLDED)
+            memcpy(&out[i * channels], texel, sizeof(float) * channels);
+        else if (volume == CPU_NOISE_VOLUME_SHAPE)
+            out[i] = folded_base_cloud(texel);
+        else
+            out[i] = noise_detail_fbm(texel);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float noise_format_quantize(NoiseFormat format, float value)
+{
+    if (format == NOISE_FORMAT_RGBA16F)
+        return cpu_noise_half_to_float(cpu_noise_float_to_half(value));
+
+    return floorf(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f) / 255.0f;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void noise_format_encode(NoiseFormat format, const float* channels, size_t count, std::vector<uint8_t>& out)
+{
+    if (format == NOISE_FORMAT_RGBA16F)
+    {
+        out.resize(count * sizeof(uint16_t));
+
+        for (size_t i = 0; i < count; i++)
+        {
+            uint16_t half = cpu_noise_float_to_half(channels[i]);
+            memcpy(&out[i * sizeof(uint16_t)], &half, sizeof(uint16_t));
+        }
+    }
+    else
+    {
+        out.resize(count);
+
+        for (size_t i = 0; i < count; i++)
+            out[i] = uint8_t(floorf(std::min(std::max(channels[i], 0.0f), 1.0f) * 255.0f + 0.5f));
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void noise_format_error(NoiseFormat format, CpuNoiseVolume volume, const float* texels, uint32_t size, NoiseFormatError& at_texels, NoiseFormatError& between_texels)
+{
+    size_t num_texels = size_t(size) * size * size;
+
+    // What each format stores, quantized.
+    std::vector<float> reference;
+    std::vector<float> packed;
+
+    noise_format_pack(NOISE_FORMAT_RGBA16F, volume, texels, num_texels, reference);
+    noise_format_pack(format, volume, texels, num_texels, packed);
+
+    for (float& value : reference)
+        value = noise_format_quantize(NOISE_FORMAT_RGBA16F, value);
+
+    for (float& value : packed)
+        value = noise_format_quantize(format, value);
+
+    uint32_t channels = noise_format_channels(format, volume);
+
+    // Value read out of 'n' texels blended with equal weights, what sample_cloud_density() derives from them.
+    auto derive = [&](const std::vector<float>& data, uint32_t data_channels, const size_t* indices, int n) {
+        float texel[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+        for (int i = 0; i < n; i++)
+        {
+            for (uint32_t c = 0; c < data_channels; c++)
+                texel[c] += data[indices[i] * data_channels + c] / float(n);
+        }
+
+        if (data_channels == 1)
+            return texel[0];
+
+        return volume == CPU_NOISE_VOLUME_SHAPE ? folded_base_cloud(texel) : noise_detail_fbm(texel);
+    };
+
+    at_texels      = NoiseFormatError();
+    between_texels = NoiseFormatError();
+
+    int32_t s = int32_t(size);
+
+    for (int32_t z = 0; z < s; z++)
+    {
+        for (int32_t y = 0; y < s; y++)
+        {
+            for (int32_t x = 0; x < s; x++)
+            {
+                size_t indices[8];
+
+                for (int i = 0; i < 8; i++)
+                    indices[i] = (size_t(wrap(z + ((i >> 2) & 1), s)) * s + wrap(y + ((i >> 1) & 1), s)) * s + wrap(x + (i & 1), s);
+
+                accumulate(at_texels, derive(reference, 4, indices, 1), derive(packed, channels, indices, 1));
+                accumulate(between_texels, derive(reference, 4, indices, 8), derive(packed, channels, indices, 8));
+            }
+        }
+    }
+
+    at_texels.rms_error      = sqrt(at_texels.rms_error / double(num_texels));
+    between_texels.rms_error = sqrt(between_texels.rms_error / double(num_texels));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "cpu_noise.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// Storage formats of the shape and detail noise volumes. The noises are always generated as RGBA floats, then packed into the channels
+// the format stores, quantized and uploaded as is, so that the sample, the reference renderer and the error report read the same texels.
+//
+//     Format    Shape                                  Detail                             Bytes per texel (shape / detail)
+//     RGBA16F   Perlin-Worley, 3 Worley octaves        3 Worley octaves, unused alpha     8 / 8
+//     UNORM8    Perlin-Worley, 3 Worley octaves        3 Worley octaves                   4 / 3
+//     FOLDED    Base cloud shape                       Worley FBM                         1 / 1
+//
+// The folded format moves the FBM combinations of sample_cloud_density() into the volumes. The detail FBM is linear in the texels so
+// trilinear filtering commutes with it, the base cloud shape is not and is filtered after the fold, which is the error the report
+// measures half way between texels.
+
+enum NoiseFormat
+{
+    NOISE_FORMAT_RGBA16F,
+    NOISE_FORMAT_UNORM8,
+    NOISE_FORMAT_FOLDED,
+    NOISE_FORMAT_COUNT
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+const char* noise_format_name(NoiseFormat format);
+
+// True if the volumes hold the base cloud shape and the Worley FBM instead of the individual noises.
+inline bool noise_format_folded(NoiseFormat format) { return format == NOISE_FORMAT_FOLDED; }
+
+// Channels stored per texel of 'volume', 1 to 4.
+uint32_t noise_format_channels(NoiseFormat format, CpuNoiseVolume volume);
+
+// Bytes per texel of 'volume', as uploaded.
+uint32_t noise_format_texel_size(NoiseFormat format, CpuNoiseVolume volume);
+
+// Noise cache file of 'volume' stored in 'format', e.g. "shape_noise_unorm8.cache". Every format has its own file, so switching
+// between them does not overwrite the cache of the others.
+std::string noise_format_cache_path(NoiseFormat format, CpuNoiseVolume volume);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Worley FBM of a detail texel, as computed in sample_cloud_density().
+float noise_detail_fbm(const float* texel);
+
+// Converts 'num_texels' RGBA texels as generated by cpu_noise_generate() into the channels of the format, without quantizing them.
+void noise_format_pack(NoiseFormat format, CpuNoiseVolume volume, const float* texels, size_t num_texels, std::vector<float>& out);
+
+// Value a texture of the format stores for 'value'.
+float noise_format_quantize(NoiseFormat format, float value);
+
+// Encodes packed channels into the bytes uploaded to the texture, halfs for RGBA16F and unorm bytes otherwise.
+void noise_format_encode(NoiseFormat format, const float* channels, size_t count, std::vector<uint8_t>& out);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+struct NoiseFormatError
+{
+    float  max_error = 0.0f;
+    double rms_error = 0.0;
+};
+
+// Error of what sample_cloud_density() reads out of a size^3 volume stored in 'format' against RGBA16F: the base cloud shape clamped to
+// [0, 1] for the shape volume, the Worley FBM for the detail volume. Measured at the texel centres and half way between texels, where
+// trilinear filtering blends eight texels.
+void noise_format_error(NoiseFormat format, CpuNoiseVolume volume, const float* texels, uint32_t size, NoiseFormatError& at_texels, NoiseFormatError& between_texels);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
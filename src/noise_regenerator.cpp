@@ -0,0 +1,144 @@
+#include "noise_regenerator.h"
+
+#include <algorithm>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void NoiseSlabBudget::reset(float initial_ms_per_mtexel)
+{
+    m_ms_per_mtexel = initial_ms_per_mtexel;
+    m_measured      = false;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void NoiseSlabBudget::report(uint64_t texels, float ms)
+{
+    if (texels == 0 || ms < 0.0f)
+        return;
+
+    float ms_per_mtexel = ms * 1000000.0f / float(texels);
+
+    // The first measurement replaces the guess, later ones are smoothed so that a single slow frame does not halve the slabs.
+    if (m_measured)
+        m_ms_per_mtexel += (ms_per_mtexel - m_ms_per_mtexel) * NOISE_BUDGET_SMOOTHING;
+    else
+        m_ms_per_mtexel = ms_per_mtexel;
+
+    m_measured = true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint64_t NoiseSlabBudget::texels(float budget_ms) const
+{
+    if (budget_ms <= 0.0f || m_ms_per_mtexel <= 0.0f)
+        return 0;
+
+    return uint64_t(double(budget_ms) / double(m_ms_per_mtexel) * 1000000.0);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void NoiseSlabScheduler::begin(uint32_t size, uint32_t slab_depth)
+{
+    m_size       = size;
+    m_slab_depth = slab_depth;
+    m_active     = true;
+
+    uint32_t num_mips = 1;
+
+    while ((size >> num_mips) > 0)
+        num_mips++;
+
+    m_built.assign(num_mips, 0);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void NoiseSlabScheduler::cancel()
+{
+    m_active = false;
+    m_built.clear();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint64_t NoiseSlabScheduler::advance(uint64_t max_texels, std::vector<NoiseSliceRange>& ranges)
+{
+    ranges.clear();
+
+    if (!m_active)
+        return 0;
+
+    uint64_t slab_texels = uint64_t(m_size) * m_size * m_slab_depth;
+    uint64_t num_slabs   = std::max(max_texels / slab_texels, uint64_t(1));
+    uint32_t count       = uint32_t(std::min(num_slabs * m_slab_depth, uint64_t(m_size - m_built[0])));
+
+    if (count > 0)
+    {
+        ranges.push_back({ 0, m_built[0], count });
+        m_built[0] += count;
+    }
+
+    // Slice k of a mip averages slices 2k and 2k + 1 of the mip above it.
+    for (uint32_t mip = 1; mip < m_built.size(); mip++)
+    {
+        uint32_t ready = m_built[mip - 1] / 2;
+
+        if (ready > m_built[mip])
+        {
+            ranges.push_back({ mip, m_built[mip], ready - m_built[mip] });
+            m_built[mip] = ready;
+        }
+    }
+
+    if (m_built.back() == 1)
+        m_active = false;
+
+    return uint64_t(count) * m_size * m_size;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float NoiseSlabScheduler::progress() const
+{
+    if (!m_active)
+        return 1.0f;
+
+    return float(m_built[0]) / float(m_size);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void noise_downsample_slices(const float* src, uint32_t src_size, uint32_t num_channels, uint32_t first, uint32_t count, float* dst)
+{
+    uint32_t size = src_size / 2;
+
+    for (uint32_t z = first; z < first + count; z++)
+    {
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                for (uint32_t c = 0; c < num_channels; c++)
+                {
+                    float sum = 0.0f;
+
+                    for (uint32_t i = 0; i < 8; i++)
+                    {
+                        uint32_t sx = x * 2 + (i & 1);
+                        uint32_t sy = y * 2 + ((i >> 1) & 1);
+                        uint32_t sz = z * 2 + ((i >> 2) & 1);
+
+                        sum += src[((size_t(sz) * src_size + sy) * src_size + sx) * num_channels + c];
+                    }
+
+                    dst[((size_t(z) * size + y) * size + x) * num_channels + c] = sum * 0.125f;
+                }
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+// Incremental regeneration of the noise volumes at runtime. A rebuild fills a back volume front to back in slabs of z-slices,
+// NoiseSlabBudget turns a time budget into the number of slabs of a frame from the measured cost of the previous ones, and
+// every mip slice is built as soon as the two slices it averages are, so the back volume is complete with its mips when its last slab
+// is and can be swapped with the front one. Nothing here depends on OpenGL, main.cpp builds what NoiseSlabScheduler hands out, on the
+// GPU or on the CPU, and reports how long it took.
+
+// z size of the work groups of shape_noise_cs.glsl and detail_noise_cs.glsl, the depth of the slabs built on the GPU. The CPU builds
+// single slices.
+#define NOISE_SLAB_DEPTH 8
+
+// Weight of a new measurement in the running estimate of the cost of a texel.
+#define NOISE_BUDGET_SMOOTHING 0.25f
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Running estimate of the cost of generating a texel, in milliseconds per million texels.
+class NoiseSlabBudget
+{
+public:
+    // 'initial_ms_per_mtexel' is used until the first measurement.
+    void reset(float initial_ms_per_mtexel);
+
+    // Feeds the measured time of 'texels' texels of mip 0, the mips they completed included.
+    void report(uint64_t texels, float ms);
+
+    // Texels of mip 0 that fit into 'budget_ms'.
+    uint64_t texels(float budget_ms) const;
+
+    inline float ms_per_mtexel() const { return m_ms_per_mtexel; }
+
+private:
+    float m_ms_per_mtexel = 1.0f;
+    bool  m_measured      = false;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Slices [first, first + count) of a mip of the volume.
+struct NoiseSliceRange
+{
+    uint32_t mip;
+    uint32_t first;
+    uint32_t count;
+};
+
+// Order in which the slices of a size^3 volume and its full mip chain are built.
+class NoiseSlabScheduler
+{
+public:
+    // 'size' must be a power of two and a multiple of 'slab_depth'.
+    void begin(uint32_t size, uint32_t slab_depth);
+    void cancel();
+
+    // Hands out the slabs of mip 0 that fit into 'max_texels', at least one, followed by the mip slices they complete. The ranges must
+    // be built in order. Returns the number of texels of mip 0 handed out.
+    uint64_t advance(uint64_t max_texels, std::vector<NoiseSliceRange>& ranges);
+
+    // True from begin() until every slice of every mip was handed out.
+    inline bool active() const { return m_active; }
+
+    // Fraction of mip 0 handed out.
+    float progress() const;
+
+    inline uint32_t size() const { return m_size; }
+
+private:
+    uint32_t              m_size       = 0;
+    uint32_t              m_slab_depth = 1;
+    bool                  m_active     = false;
+    std::vector<uint32_t> m_built; // Slices handed out per mip.
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Box filters slices [first, first + count) of a mip from the mip above it ('src_size'^3 texels of 'num_channels' floats), as
+// cpu_noise_generate_mips(). 'dst' holds the whole mip.
+void noise_downsample_slices(const float* src, uint32_t src_size, uint32_t num_channels, uint32_t first, uint32_t count, float* dst);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
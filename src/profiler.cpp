@@ -0,0 +1,230 @@
+#include "profiler.h"
+
+#include <imgui.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool Profiler::create()
+{
+    for (uint32_t i = 0; i < PROFILER_FRAMES_IN_FLIGHT; i++)
+        glGenQueries(PROFILER_MAX_PASSES * 2, m_frames[i].queries);
+
+    GLint bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+
+    if (bits == 0)
+        DW_LOG_WARNING("GL_TIMESTAMP queries are not supported, GPU times will read zero");
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void Profiler::destroy()
+{
+    for (uint32_t i = 0; i < PROFILER_FRAMES_IN_FLIGHT; i++)
+        glDeleteQueries(PROFILER_MAX_PASSES * 2, m_frames[i].queries);
+
+    m_log.close();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void Profiler::begin_frame()
+{
+    m_current = uint32_t(m_frame_index % PROFILER_FRAMES_IN_FLIGHT);
+
+    FrameQueries& frame = m_frames[m_current];
+
+    // The pool is about to be reused, read back what the GPU recorded into it PROFILER_FRAMES_IN_FLIGHT frames ago.
+    if (frame.pending)
+        resolve(frame);
+
+    frame.frame      = m_frame_index;
+    frame.num_passes = 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void Profiler::end_frame()
+{
+    m_frames[m_current].pending = true;
+    m_frame_index++;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void Profiler::begin_pass(const char* name)
+{
+    FrameQueries& frame = m_frames[m_current];
+
+    if (m_in_pass || frame.num_passes == PROFILER_MAX_PASSES)
+    {
+        DW_LOG_WARNING("Profiler pass '" + std::string(name) + "' is nested or exceeds PROFILER_MAX_PASSES, ignoring");
+        return;
+    }
+
+    frame.names[frame.num_passes] = name;
+
+    glQueryCounter(frame.queries[frame.num_passes * 2], GL_TIMESTAMP);
+
+    m_in_pass    = true;
+    m_pass_start = std::chrono::high_resolution_clock::now();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void Profiler::end_pass()
+{
+    if (!m_in_pass)
+        return;
+
+    FrameQueries& frame = m_frames[m_current];
+
+    // CPU time covers recording and submitting the pass, not its execution.
+    frame.cpu_ms[frame.num_passes] = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - m_pass_start).count();
+
+    glQueryCounter(frame.queries[frame.num_passes * 2 + 1], GL_TIMESTAMP);
+
+    frame.num_passes++;
+    m_in_pass = false;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void Profiler::resolve(FrameQueries& frame)
+{
+    frame.pending = false;
+
+    if (frame.num_passes == 0)
+        return;
+
+    // The queries complete in order, so the last one being available means all of them are.
+    GLint available = 0;
+    glGetQueryObjectiv(frame.queries[frame.num_passes * 2 - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+    m_samples.resize(frame.num_passes);
+    m_resolved = frame.frame;
+
+    for (uint32_t i = 0; i < frame.num_passes; i++)
+    {
+        PassSample& sample = m_samples[i];
+
+        sample.name   = frame.names[i];
+        sample.cpu_ms = frame.cpu_ms[i];
+        sample.gpu_ms = -1.0f;
+
+        if (available)
+        {
+            GLuint64 start = 0;
+            GLuint64 end   = 0;
+
+            glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &start);
+            glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+
+            sample.gpu_ms = float(double(end - start) / 1000000.0);
+        }
+
+        PassHistory& pass = history(frame.names[i]);
+
+        pass.cpu.add(sample.cpu_ms);
+
+        if (available)
+            pass.gpu.add(sample.gpu_ms);
+    }
+
+    m_log.write_frame(frame.frame, m_samples);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool Profiler::resolved_gpu_ms(const char* name, uint64_t& frame, float& ms) const
+{
+    for (const PassSample& sample : m_samples)
+    {
+        if (sample.name == name && sample.gpu_ms >= 0.0f)
+        {
+            frame = m_resolved;
+            ms    = sample.gpu_ms;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+Profiler::PassHistory& Profiler::history(const char* name)
+{
+    for (PassHistory& pass : m_history)
+    {
+        if (pass.name == name)
+            return pass;
+    }
+
+    m_history.push_back(PassHistory());
+    m_history.back().name = name;
+
+    return m_history.back();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void Profiler::gui()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        ImGui::Text(i == 0 ? "CPU (ms)" : "GPU (ms)");
+        ImGui::Separator();
+
+        ImGui::Columns(5, i == 0 ? "ProfilerCPU" : "ProfilerGPU");
+
+        ImGui::Text("Pass");
+        ImGui::NextColumn();
+        ImGui::Text("Min");
+        ImGui::NextColumn();
+        ImGui::Text("Avg");
+        ImGui::NextColumn();
+        ImGui::Text("P95");
+        ImGui::NextColumn();
+        ImGui::Text("P99");
+        ImGui::NextColumn();
+
+        for (const PassHistory& pass : m_history)
+        {
+            TimingSummary summary = i == 0 ? pass.cpu.summary() : pass.gpu.summary();
+
+            ImGui::Text("%s", pass.name.c_str());
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", summary.min);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", summary.avg);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", summary.p95);
+            ImGui::NextColumn();
+            ImGui::Text("%.3f", summary.p99);
+            ImGui::NextColumn();
+        }
+
+        ImGui::Columns(1);
+        ImGui::Separator();
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool Profiler::open_log(const std::string& path)
+{
+    if (!m_log.open(path))
+    {
+        DW_LOG_ERROR("Failed to open profiler log: " + path);
+        return false;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
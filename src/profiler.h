@@ -0,0 +1,95 @@
+#pragma once
+
+#include <ogl.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "profiler_stats.h"
+
+// Per-pass CPU and GPU profiler. Every pass records a pair of GL_TIMESTAMP queries into the query pool of the current frame. The pools
+// are only read back PROFILER_FRAMES_IN_FLIGHT frames later, when the GPU is done with them, so resolving never stalls. If the results
+// are still not available by then the GPU times of that frame are dropped. Passes must not nest.
+
+#define PROFILER_FRAMES_IN_FLIGHT 3
+#define PROFILER_MAX_PASSES 16
+
+class Profiler
+{
+public:
+    bool create();
+
+    // Must be called while the context is still current.
+    void destroy();
+
+    void begin_frame();
+    void end_frame();
+    void begin_pass(const char* name);
+    void end_pass();
+
+    // Draws the rolling statistics of every pass into the current ImGui window.
+    void gui();
+
+    // Streams every resolved frame to 'path', see ProfilerLog.
+    bool open_log(const std::string& path);
+
+    // GPU time of pass 'name' in the most recently resolved frame, and the index of that frame. Returns false if that frame has no such
+    // pass or its GPU times were dropped.
+    bool resolved_gpu_ms(const char* name, uint64_t& frame, float& ms) const;
+
+    // Index of the frame being recorded, between begin_frame() and end_frame().
+    inline uint64_t frame_index() const { return m_frame_index; }
+
+private:
+    struct FrameQueries
+    {
+        uint64_t    frame      = 0;
+        uint32_t    num_passes = 0;
+        bool        pending    = false;
+        GLuint      queries[PROFILER_MAX_PASSES * 2];
+        const char* names[PROFILER_MAX_PASSES];
+        float       cpu_ms[PROFILER_MAX_PASSES];
+    };
+
+    struct PassHistory
+    {
+        std::string   name;
+        TimingHistory cpu;
+        TimingHistory gpu;
+    };
+
+    void         resolve(FrameQueries& frame);
+    PassHistory& history(const char* name);
+
+    FrameQueries                                   m_frames[PROFILER_FRAMES_IN_FLIGHT];
+    uint32_t                                       m_current     = 0;
+    uint64_t                                       m_frame_index = 0;
+    uint64_t                                       m_resolved    = 0;
+    bool                                           m_in_pass     = false;
+    std::chrono::high_resolution_clock::time_point m_pass_start;
+    std::vector<PassHistory>                       m_history;
+    std::vector<PassSample>                        m_samples;
+    ProfilerLog                                    m_log;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler& profiler, const char* name) :
+        m_profiler(profiler)
+    {
+        m_profiler.begin_pass(name);
+    }
+
+    ~ProfileScope()
+    {
+        m_profiler.end_pass();
+    }
+
+private:
+    Profiler& m_profiler;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
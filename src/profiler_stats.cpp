@@ -0,0 +1,145 @@
+#include "profiler_stats.h"
+
+#include <algorithm>
+#include <math.h>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static float nearest_rank(const std::vector<float>& sorted, float p)
+{
+    uint32_t count = uint32_t(sorted.size());
+    uint32_t rank  = uint32_t(ceilf(p / 100.0f * float(count)));
+
+    return sorted[std::min(std::max(rank, 1u), count) - 1];
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TimingSummary summarize_timings(const float* samples, uint32_t count)
+{
+    TimingSummary summary;
+
+    if (count == 0)
+        return summary;
+
+    std::vector<float> sorted(samples, samples + count);
+    std::sort(sorted.begin(), sorted.end());
+
+    double sum = 0.0;
+
+    for (float sample : sorted)
+        sum += sample;
+
+    summary.min = sorted.front();
+    summary.max = sorted.back();
+    summary.avg = float(sum / double(count));
+    summary.p50 = nearest_rank(sorted, 50.0f);
+    summary.p95 = nearest_rank(sorted, 95.0f);
+    summary.p99 = nearest_rank(sorted, 99.0f);
+
+    return summary;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TimingHistory::TimingHistory() :
+    m_next(0), m_count(0)
+{
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void TimingHistory::add(float ms)
+{
+    m_samples[m_next] = ms;
+    m_next            = (m_next + 1) % PROFILER_HISTORY_SIZE;
+    m_count           = std::min(m_count + 1, uint32_t(PROFILER_HISTORY_SIZE));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint32_t TimingHistory::count() const
+{
+    return m_count;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TimingSummary TimingHistory::summary() const
+{
+    // The ring is only partially filled until PROFILER_HISTORY_SIZE samples were added, but always starts at index 0.
+    return summarize_timings(m_samples, m_count);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+ProfilerLog::~ProfilerLog()
+{
+    close();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool ProfilerLog::open(const std::string& path)
+{
+    close();
+
+    m_file = fopen(path.c_str(), "w");
+
+    if (!m_file)
+        return false;
+
+    m_json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+
+    if (!m_json)
+        fprintf(m_file, "frame,pass,cpu_ms,gpu_ms\n");
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void ProfilerLog::write_frame(uint64_t frame, const std::vector<PassSample>& samples)
+{
+    if (!m_file)
+        return;
+
+    if (m_json)
+    {
+        fprintf(m_file, "{\"frame\":%llu,\"passes\":[", (unsigned long long)frame);
+
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            fprintf(m_file, "%s{\"name\":\"%s\",\"cpu_ms\":%.4f,", i == 0 ? "" : ",", samples[i].name.c_str(), samples[i].cpu_ms);
+
+            if (samples[i].gpu_ms < 0.0f)
+                fprintf(m_file, "\"gpu_ms\":null}");
+            else
+                fprintf(m_file, "\"gpu_ms\":%.4f}", samples[i].gpu_ms);
+        }
+
+        fprintf(m_file, "]}\n");
+    }
+    else
+    {
+        for (const PassSample& sample : samples)
+        {
+            if (sample.gpu_ms < 0.0f)
+                fprintf(m_file, "%llu,%s,%.4f,\n", (unsigned long long)frame, sample.name.c_str(), sample.cpu_ms);
+            else
+                fprintf(m_file, "%llu,%s,%.4f,%.4f\n", (unsigned long long)frame, sample.name.c_str(), sample.cpu_ms, sample.gpu_ms);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void ProfilerLog::close()
+{
+    if (m_file)
+        fclose(m_file);
+
+    m_file = nullptr;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+// CPU side of the pass profiler: rolling timing statistics and the per-frame sample log. Does not depend on OpenGL, profiler.h feeds
+// it with the resolved GL_TIMESTAMP queries.
+
+// Number of frames kept by each rolling window.
+#define PROFILER_HISTORY_SIZE 256
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+struct TimingSummary
+{
+    float min = 0.0f;
+    float max = 0.0f;
+    float avg = 0.0f;
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Summary of 'count' timings. Percentiles use the nearest-rank method.
+TimingSummary summarize_timings(const float* samples, uint32_t count);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Fixed size ring of the most recent timings in milliseconds.
+class TimingHistory
+{
+public:
+    TimingHistory();
+
+    void          add(float ms);
+    uint32_t      count() const;
+    TimingSummary summary() const;
+
+private:
+    float    m_samples[PROFILER_HISTORY_SIZE];
+    uint32_t m_next;
+    uint32_t m_count;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Timings of one pass in one frame. A negative GPU time means the queries were not available in time and the sample was dropped.
+struct PassSample
+{
+    std::string name;
+    float       cpu_ms;
+    float       gpu_ms;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Streams per-frame samples to disk. Files ending in .json are written as JSON lines (one object per frame), anything else as CSV
+// with one row per pass.
+class ProfilerLog
+{
+public:
+    ~ProfilerLog();
+
+    bool open(const std::string& path);
+    void write_frame(uint64_t frame, const std::vector<PassSample>& samples);
+    void close();
+
+    inline bool is_open() const { return m_file != nullptr; }
+
+private:
+    FILE* m_file = nullptr;
+    bool  m_json = false;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,794 @@
+#include "auto_exposure.h"
+#include "cloud_quality.h"
+#include "cloud_reference.h"
+#include "cloud_tiles.h"
+#include "image_io.h"
+#include "sky_view_lut.h"
+#include "slice_scheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+// Headless CPU renderer for the cloud pass. Writes the HDR output of clouds_fs.glsl along with a tone mapped PNG, and reports the
+// throughput of the ray march. Only the sky and clouds are rendered, the ground plane only clips the clouds.
+//
+// Usage:
+//     volumetric-clouds-reference [--width N] [--height N] [--output NAME] [--textures DIR] [--threads N] [--tile-size N]
+//                                 [--shape-size N] [--detail-size N] [--camera-pos X Y Z] [--camera-dir X Y Z] [--fov DEGREES]
+//                                 [--no-empty-space-skipping] [--verify-empty-space] [--adaptive-march] [--compare-march-modes]
+//                                 [--light-volume] [--compare-light-modes] [--sky-view-lut] [--sky-lut-report]
+//                                 [--no-depth-clipping] [--compare-depth-modes] [--tiled-march] [--compare-tile-modes]
+//                                 [--weather-map FILE] [--compare-weather-modes] [--noise-format RGBA16F|UNORM8|FOLDED]
+//                                 [--compare-noise-formats] [--density-lod] [--compare-density-lod] [--quality TIER]
+//                                 [--auto-exposure] [--exposure-compensation EV] [--cirrus HEIGHT COVERAGE OPACITY SCALE]
+//                                 [--<parameter> VALUE...]
+//
+// Parameters are the VolumetricClouds members with dashes instead of underscores, e.g. --cloud-coverage 0.5 or
+// --sun-color 1 0.9 0.8. Angles are in degrees. --verify-empty-space evaluates every sample skipped by the empty space grid and fails
+// if any of them has a non-zero density. --compare-march-modes renders both the fixed step and the adaptive march and reports their cost
+// and the difference between the two images, --compare-light-modes does the same for the light cone and the sun transmittance volume.
+// --compare-depth-modes compares marching every pixel in full against clipping the march to the ground plane of the sample, which
+// --ground-height and --ground-extent move and resize. Ground pixels hold the clouds in front of a black ground.
+// --tiled-march classifies 16x16 tiles first and only marches the tiles with a pixel that needs it, as the tiled compute path of the
+// sample. --compare-tile-modes compares it against marching every pixel.
+// --weather-map reads coverage, cloud type and precipitation from a weather map written by the sample (weather.map), with the tiles
+// of the window around the camera resident. --compare-weather-modes compares it against the global parameters.
+// --noise-format stores the noise volumes as the sample does with that format, see noise_format.h. --compare-noise-formats renders
+// every format and compares it against RGBA16F, noise-benchmark --format-report prints the error of the texels themselves.
+// --density-lod picks the noise mip levels of the primary march from the footprint of each sample and skips the detail noise far away or
+// behind opaque cloud, tuned with --lod-bias, --lod-detail-distance, --lod-detail-opacity and --lod-cone-scale. --compare-density-lod
+// compares it against sampling every noise at full detail.
+// --quality renders with the settings of a quality tier of the sample (Custom, Low, Medium, High or Ultra, see cloud_quality.h), later
+// arguments override them.
+// --auto-exposure tone maps the PNG with the exposure the auto exposure of the sample converges to on the image, offset by
+// --exposure-compensation stops, and prints its luminance histogram.
+// --cirrus adds a 2D cirrus layer above the volumetric shell, up to three, see cloud_layers.h. Each costs one curl and one cirrus noise
+// fetch per pixel that crosses it, counted apart from the density samples.
+// --sky-lut-report prints the error of the sky-view LUT against the Preetham model and the estimated per-frame cost of both.
+
+#define DEFAULT_TILE_SIZE 32
+
+struct ParameterDesc
+{
+    const char* name;
+    float*      value;
+    uint32_t    num_components;
+    bool        angle;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool parse_floats(int argc, const char* argv[], int& i, float* out, uint32_t count)
+{
+    if (i + int(count) >= argc)
+        return false;
+
+    for (uint32_t c = 0; c < count; c++)
+        out[c] = float(atof(argv[++i]));
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Renders the image tile by tile and returns the time taken in seconds. Rows of 'hdr' are written top to bottom. With 'tiled' the tiles
+// are CLOUD_TILE_SIZE pixels and only the ones cloud_tiles_classify() keeps are marched, 'tile_size' is ignored.
+static double render(const CloudReference& reference, bool tiled, uint32_t width, uint32_t height, uint32_t tile_size, uint32_t num_threads, std::vector<float>& hdr, CloudReferenceStats& stats)
+{
+    std::vector<CloudReferenceStats> thread_stats(num_threads);
+
+    hdr.resize(size_t(width) * height * 3);
+
+    auto store = [&](uint32_t x, uint32_t y, glm::vec3 color) {
+        // The sky model is undefined below the horizon (it divides by cos(theta) = 0), the sample covers those pixels with the
+        // ground mesh. Write black so the golden images stay deterministic.
+        if (!std::isfinite(color.x) || !std::isfinite(color.y) || !std::isfinite(color.z))
+            color = glm::vec3(0.0f);
+
+        // gl_FragCoord starts at the bottom left, images are written top to bottom.
+        float* out = &hdr[(size_t(height - 1 - y) * width + x) * 3];
+
+        out[0] = color.x;
+        out[1] = color.y;
+        out[2] = color.z;
+    };
+
+    std::vector<uint32_t> marched_tiles;
+
+    if (tiled)
+        tile_size = CLOUD_TILE_SIZE;
+
+    uint32_t num_tiles_x = (width + tile_size - 1) / tile_size;
+    uint32_t num_tiles_y = (height + tile_size - 1) / tile_size;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    // The classification shades the empty tiles itself.
+    if (tiled)
+    {
+        cloud_tiles_classify(
+            width, height, num_threads, [&](uint32_t x, uint32_t y) { return reference.pixel_needs_march(x, y); },
+            [&](uint32_t x, uint32_t y, uint32_t thread) { store(x, y, reference.shade_empty_pixel(x, y, thread_stats[thread])); },
+            marched_tiles);
+    }
+
+    uint32_t num_jobs = tiled ? uint32_t(marched_tiles.size()) : num_tiles_x * num_tiles_y;
+
+    SliceScheduler::run(num_jobs, num_threads, [&](uint32_t job, uint32_t thread) {
+        uint32_t tile_x = job % num_tiles_x;
+        uint32_t tile_y = job / num_tiles_x;
+
+        if (tiled)
+            cloud_tile_unpack(marched_tiles[job], tile_x, tile_y);
+
+        uint32_t x0 = tile_x * tile_size;
+        uint32_t y0 = tile_y * tile_size;
+        uint32_t x1 = std::min(x0 + tile_size, width);
+        uint32_t y1 = std::min(y0 + tile_size, height);
+
+        for (uint32_t y = y0; y < y1; y++)
+        {
+            for (uint32_t x = x0; x < x1; x++)
+                store(x, y, reference.shade_pixel(x, y, thread_stats[thread]));
+        }
+    });
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    stats = CloudReferenceStats();
+
+    for (const CloudReferenceStats& s : thread_stats)
+    {
+        stats.rays += s.rays;
+        stats.density_samples += s.density_samples;
+        stats.detail_samples += s.detail_samples;
+        stats.cone_samples += s.cone_samples;
+        stats.grid_lookups += s.grid_lookups;
+        stats.skipped_samples += s.skipped_samples;
+        stats.skip_violations += s.skip_violations;
+        stats.cirrus_samples += s.cirrus_samples;
+        stats.light_volume_fetches += s.light_volume_fetches;
+        stats.occluded_rays += s.occluded_rays;
+    }
+
+    if (tiled)
+    {
+        stats.tiles         = uint64_t(num_tiles_x) * num_tiles_y;
+        stats.marched_tiles = marched_tiles.size();
+    }
+
+    return std::chrono::duration<double>(end - start).count();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Writes NAME.hdr and a tone mapped NAME.png.
+static bool write_images(const CloudReference& reference, const std::string& name, uint32_t width, uint32_t height, const std::vector<float>& hdr)
+{
+    std::vector<uint8_t> ldr(size_t(width) * height * 3);
+
+    for (size_t i = 0; i < size_t(width) * height; i++)
+    {
+        glm::vec3 color = reference.tonemap(glm::vec3(hdr[i * 3 + 0], hdr[i * 3 + 1], hdr[i * 3 + 2]));
+
+        for (int c = 0; c < 3; c++)
+            ldr[i * 3 + c] = uint8_t(color[c] * 255.0f + 0.5f);
+    }
+
+    if (!write_hdr(name + ".hdr", width, height, hdr.data()) || !write_png(name + ".png", width, height, 3, ldr.data()))
+    {
+        printf("Failed to write %s\n", name.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Sets the exposure the auto exposure of the sample converges to on 'hdr', and prints the histogram it was derived from.
+static void apply_auto_exposure(CloudReference& reference, const AutoExposureSettings& settings, const std::vector<float>& hdr)
+{
+    uint32_t histogram[AUTO_EXPOSURE_HISTOGRAM_BINS] = {};
+
+    auto_exposure_histogram(hdr.data(), hdr.size() / 3, 3, settings, histogram);
+
+    // Without a previous exposure the first update jumps to the target.
+    AutoExposureState state = {};
+
+    auto_exposure_update(histogram, 0.0f, settings, state);
+
+    if (state.exposure <= 0.0f)
+    {
+        printf("Auto exposure: no pixel in the luminance range, keeping the exposure\n");
+        return;
+    }
+
+    uint32_t largest = *std::max_element(histogram, histogram + AUTO_EXPOSURE_HISTOGRAM_BINS);
+
+    printf("Luminance histogram (log2 luminance, pixels):\n");
+    printf("  < %6.2f  %8u\n", settings.min_log2_luminance, histogram[0]);
+
+    for (uint32_t i = 1; i < AUTO_EXPOSURE_HISTOGRAM_BINS; i++)
+    {
+        if (histogram[i] > 0)
+            printf("    %6.2f  %8u  %s\n", auto_exposure_bin_log2_luminance(i, settings), histogram[i], std::string(size_t(40.0 * histogram[i] / largest + 0.5), '#').c_str());
+    }
+
+    printf("Auto exposure: %.4f, average log2 luminance %.3f\n", state.exposure, state.average_log2_luminance);
+
+    reference.set_exposure(state.exposure);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Renders the image with 'mode' off and on, with the same parameters otherwise, and reports the cost and the difference of the second
+// mode. The setup time includes building the sun transmittance volume.
+// RMSE and largest difference of the tone mapped images.
+static void image_difference(const CloudReference& reference, const std::vector<float>& hdr_a, const std::vector<float>& hdr_b, size_t num_pixels, double& rmse, float& max_error)
+{
+    double squared_error = 0.0;
+
+    max_error = 0.0f;
+
+    for (size_t i = 0; i < num_pixels; i++)
+    {
+        glm::vec3 a = reference.tonemap(glm::vec3(hdr_a[i * 3 + 0], hdr_a[i * 3 + 1], hdr_a[i * 3 + 2]));
+        glm::vec3 b = reference.tonemap(glm::vec3(hdr_b[i * 3 + 0], hdr_b[i * 3 + 1], hdr_b[i * 3 + 2]));
+
+        for (int c = 0; c < 3; c++)
+        {
+            float error = fabsf(a[c] - b[c]);
+
+            squared_error += double(error) * error;
+            max_error = std::max(max_error, error);
+        }
+    }
+
+    rmse = sqrt(squared_error / (double(num_pixels) * 3.0));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static int compare_modes(CloudReference& reference, CloudParameters& params, bool& mode, const CloudCamera& camera, const std::string& output, const char* off_name, const char* on_name, uint32_t width, uint32_t height, uint32_t tile_size, uint32_t num_threads)
+{
+    std::vector<float>  hdr[2];
+    CloudReferenceStats stats[2];
+    double              setup_seconds[2];
+    double              render_seconds[2];
+    const char*         names[2] = { off_name, on_name };
+
+    for (int i = 0; i < 2; i++)
+    {
+        mode = i == 1;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        reference.set_parameters(params, camera, width, height);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        setup_seconds[i]  = std::chrono::duration<double>(end - start).count();
+        render_seconds[i] = render(reference, params.tiled_march, width, height, tile_size, num_threads, hdr[i], stats[i]);
+
+        std::string suffix = names[i];
+        std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::tolower);
+
+        if (!write_images(reference, output + "_" + suffix, width, height, hdr[i]))
+            return 1;
+    }
+
+    double rmse;
+    float  max_error;
+
+    image_difference(reference, hdr[0], hdr[1], size_t(width) * height, rmse, max_error);
+
+    double pixels = double(width) * height;
+
+    printf("%-10s %10s %10s %20s %14s\n", "Mode", "Setup (s)", "Time (s)", "Fetches per pixel", "Rejected (%)");
+
+    for (int i = 0; i < 2; i++)
+        printf("%-10s %10.3f %10.3f %20.1f %14.1f\n", names[i], setup_seconds[i], render_seconds[i], double(stats[i].density_samples + stats[i].light_volume_fetches) / pixels, double(stats[i].occluded_rays) * 100.0 / pixels);
+
+    for (int i = 0; i < 2; i++)
+    {
+        printf("%s: %.1f primary and %.1f light cone density samples per pixel, %.1f with detail and curl noise\n", names[i], double(stats[i].density_samples - stats[i].cone_samples) / pixels, double(stats[i].cone_samples) / pixels, double(stats[i].detail_samples) / pixels);
+
+        if (stats[i].tiles > 0)
+            printf("%s: marched %llu of %llu tiles\n", names[i], (unsigned long long)stats[i].marched_tiles, (unsigned long long)stats[i].tiles);
+    }
+
+    printf("Tone mapped difference: RMSE %.5f, max %.5f\n", rmse, max_error);
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Renders with every noise format and reports their cost, the bytes of texels they store and their difference to RGBA16F.
+static int compare_noise_formats(CloudReference& reference, CloudParameters& params, const CloudCamera& camera, const std::string& output, uint32_t shape_size, uint32_t detail_size, uint32_t width, uint32_t height, uint32_t tile_size, uint32_t num_threads)
+{
+    std::vector<float>  hdr[NOISE_FORMAT_COUNT];
+    CloudReferenceStats stats[NOISE_FORMAT_COUNT];
+    double              setup_seconds[NOISE_FORMAT_COUNT];
+    double              render_seconds[NOISE_FORMAT_COUNT];
+
+    for (int i = 0; i < NOISE_FORMAT_COUNT; i++)
+    {
+        params.noise_format = NoiseFormat(i);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        reference.set_parameters(params, camera, width, height);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        setup_seconds[i]  = std::chrono::duration<double>(end - start).count();
+        render_seconds[i] = render(reference, params.tiled_march, width, height, tile_size, num_threads, hdr[i], stats[i]);
+
+        std::string suffix = noise_format_name(params.noise_format);
+        std::transform(suffix.begin(), suffix.end(), suffix.begin(), ::tolower);
+
+        if (!write_images(reference, output + "_" + suffix, width, height, hdr[i]))
+            return 1;
+    }
+
+    double pixels = double(width) * height;
+
+    printf("%-10s %10s %10s %20s %12s %12s %12s\n", "Format", "Setup (s)", "Time (s)", "Fetches per pixel", "Bytes (KB)", "RMSE", "Max");
+
+    for (int i = 0; i < NOISE_FORMAT_COUNT; i++)
+    {
+        NoiseFormat format = NoiseFormat(i);
+        double      bytes  = double(shape_size) * shape_size * shape_size * noise_format_texel_size(format, CPU_NOISE_VOLUME_SHAPE) + double(detail_size) * detail_size * detail_size * noise_format_texel_size(format, CPU_NOISE_VOLUME_DETAIL);
+        double      rmse;
+        float       max_error;
+
+        image_difference(reference, hdr[0], hdr[i], size_t(width) * height, rmse, max_error);
+
+        // A full mip chain adds a seventh.
+        printf("%-10s %10.3f %10.3f %20.1f %12.0f %12.5f %12.5f\n", noise_format_name(format), setup_seconds[i], render_seconds[i], double(stats[i].density_samples + stats[i].light_volume_fetches) / pixels, bytes * 8.0 / 7.0 / 1024.0, rmse, max_error);
+    }
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Compares the sky-view LUT against the Preetham model over the upper hemisphere for a range of sun elevations, and times both on one
+// thread to estimate the per-frame cost of the sky in the cloud pass.
+static int sky_lut_report(CloudReference& reference, CloudParameters params, const CloudCamera& camera)
+{
+    const uint32_t kAzimuthSamples   = 720;
+    const uint32_t kElevationSamples = 360;
+    const float    kPi               = 3.14159265359f;
+    const float    kSunElevations[]  = { 2.0f, 5.0f, 15.0f, 30.0f, 58.0f, 85.0f };
+
+    // The tone mapping only needs the exposure, skip building the other tables.
+    params.light_volume = false;
+    params.sky_view_lut = false;
+    reference.set_parameters(params, camera, 1, 1);
+
+    // Uniform in solid angle over the upper hemisphere.
+    std::vector<glm::vec3> directions;
+    directions.reserve(kAzimuthSamples * kElevationSamples);
+
+    for (uint32_t j = 0; j < kElevationSamples; j++)
+    {
+        float y = (float(j) + 0.5f) / float(kElevationSamples);
+        float r = sqrtf(1.0f - y * y);
+
+        for (uint32_t i = 0; i < kAzimuthSamples; i++)
+        {
+            float azimuth = (float(i) + 0.5f) / float(kAzimuthSamples) * 2.0f * kPi;
+            directions.push_back(glm::vec3(r * cosf(azimuth), y, r * sinf(azimuth)));
+        }
+    }
+
+    std::vector<glm::vec3> lut;
+
+    printf("%-16s %16s %16s %20s\n", "Sun elevation", "Tone mapped RMSE", "Tone mapped max", "Max relative error");
+
+    for (float elevation : kSunElevations)
+    {
+        float     sun_angle = -elevation * kPi / 180.0f;
+        glm::vec3 sun_dir   = -glm::normalize(glm::vec3(0.0f, sinf(sun_angle), cosf(sun_angle)));
+
+        sky_view_lut_build(sun_dir, SKY_TURBIDITY, lut);
+
+        double squared_error  = 0.0;
+        float  max_error      = 0.0f;
+        float  max_rel_error  = 0.0f;
+
+        for (const glm::vec3& direction : directions)
+        {
+            glm::vec3 expected = calculate_sky_luminance_rgb(sun_dir, direction, SKY_TURBIDITY);
+            glm::vec3 actual   = sky_view_lut_sample(lut, direction);
+            glm::vec3 a        = reference.tonemap(expected * 0.05f);
+            glm::vec3 b        = reference.tonemap(actual * 0.05f);
+
+            for (int c = 0; c < 3; c++)
+            {
+                float error = fabsf(a[c] - b[c]);
+
+                squared_error += double(error) * error;
+                max_error     = std::max(max_error, error);
+                max_rel_error = std::max(max_rel_error, fabsf(actual[c] - expected[c]) / std::max(fabsf(expected[c]), 1e-3f));
+            }
+        }
+
+        printf("%-16.1f %16.5f %16.5f %20.5f\n", elevation, sqrt(squared_error / (double(directions.size()) * 3.0)), max_error, max_rel_error);
+    }
+
+    // Time both paths over the same directions, summing the results so that the loops are not optimized away.
+    glm::vec3 sun_dir = -glm::normalize(glm::vec3(0.0f, sinf(params.sun_angle), cosf(params.sun_angle)));
+    glm::vec3 sum     = glm::vec3(0.0f);
+
+    sky_view_lut_build(sun_dir, SKY_TURBIDITY, lut);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (const glm::vec3& direction : directions)
+        sum += calculate_sky_luminance_rgb(sun_dir, direction, SKY_TURBIDITY);
+
+    auto middle = std::chrono::high_resolution_clock::now();
+
+    for (const glm::vec3& direction : directions)
+        sum += sky_view_lut_sample(lut, direction);
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    double model_ns = std::chrono::duration<double, std::nano>(middle - start).count() / double(directions.size());
+    double lut_ns   = std::chrono::duration<double, std::nano>(end - middle).count() / double(directions.size());
+
+    auto build_start = std::chrono::high_resolution_clock::now();
+    sky_view_lut_build(sun_dir, SKY_TURBIDITY, lut);
+    auto build_end = std::chrono::high_resolution_clock::now();
+
+    printf("\nPer evaluation (one thread): Preetham %.1f ns, LUT %.1f ns, LUT build %.3f ms (checksum %g)\n", model_ns, lut_ns, std::chrono::duration<double, std::milli>(build_end - build_start).count(), double(sum.x + sum.y + sum.z));
+    printf("%-12s %14s %14s %14s\n", "Resolution", "Preetham (ms)", "LUT (ms)", "Saved (ms)");
+
+    const glm::uvec2 resolutions[] = { glm::uvec2(1920, 1080), glm::uvec2(3840, 2160) };
+
+    for (const glm::uvec2& resolution : resolutions)
+    {
+        // One sky evaluation per cloud pass fragment, a sixteenth of the pixels with temporal reprojection.
+        double pixels = double(resolution.x) * resolution.y;
+        char   name[32];
+
+        snprintf(name, sizeof(name), "%ux%u", resolution.x, resolution.y);
+        printf("%-12s %14.3f %14.3f %14.3f\n", name, pixels * model_ns * 1e-6, pixels * lut_ns * 1e-6, pixels * (model_ns - lut_ns) * 1e-6);
+
+        snprintf(name, sizeof(name), "%ux%u/16", resolution.x, resolution.y);
+        printf("%-12s %14.3f %14.3f %14.3f\n", name, pixels * model_ns * 1e-6 / 16.0, pixels * lut_ns * 1e-6 / 16.0, pixels * (model_ns - lut_ns) * 1e-6 / 16.0);
+    }
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, const char* argv[])
+{
+    uint32_t        width       = 1280;
+    uint32_t        height      = 720;
+    uint32_t        num_threads = 0;
+    uint32_t        tile_size   = DEFAULT_TILE_SIZE;
+    uint32_t        shape_size  = 128;
+    uint32_t        detail_size = 32;
+    std::string     output      = "reference";
+    std::string     texture_dir = "texture";
+    bool            verify      = false;
+    bool            compare_march = false;
+    bool            compare_light = false;
+    bool            sky_report    = false;
+    bool            compare_depth = false;
+    bool            compare_tiles = false;
+    bool            compare_weather = false;
+    bool            compare_noise   = false;
+    bool            compare_lod     = false;
+    bool            auto_exposure   = false;
+    std::string     weather_map_path;
+    AutoExposureSettings exposure_settings;
+    CloudParameters params;
+    CloudCamera     camera;
+
+    const ParameterDesc parameters[] = {
+        { "cloud-min-height", &params.cloud_min_height, 1, false },
+        { "cloud-max-height", &params.cloud_max_height, 1, false },
+        { "shape-noise-scale", &params.shape_noise_scale, 1, false },
+        { "detail-noise-scale", &params.detail_noise_scale, 1, false },
+        { "detail-noise-modifier", &params.detail_noise_modifier, 1, false },
+        { "turbulence-noise-scale", &params.turbulence_noise_scale, 1, false },
+        { "turbulence-amount", &params.turbulence_amount, 1, false },
+        { "cloud-coverage", &params.cloud_coverage, 1, false },
+        { "wind-angle", &params.wind_angle, 1, true },
+        { "wind-speed", &params.wind_speed, 1, false },
+        { "wind-shear-offset", &params.wind_shear_offset, 1, false },
+        { "planet-radius", &params.planet_radius, 1, false },
+        { "light-step-length", &params.light_step_length, 1, false },
+        { "light-cone-radius", &params.light_cone_radius, 1, false },
+        { "sun-color", &params.sun_color.x, 3, false },
+        { "cloud-base-color", &params.cloud_base_color.x, 3, false },
+        { "cloud-top-color", &params.cloud_top_color.x, 3, false },
+        { "precipitation", &params.precipitation, 1, false },
+        { "ambient-light-factor", &params.ambient_light_factor, 1, false },
+        { "sun-light-factor", &params.sun_light_factor, 1, false },
+        { "henyey-greenstein-g-forward", &params.henyey_greenstein_g_forward, 1, false },
+        { "henyey-greenstein-g-backward", &params.henyey_greenstein_g_backward, 1, false },
+        { "exposure", &params.exposure, 1, false },
+        { "shape-noise-frequency", &params.shape_noise_frequency, 1, false },
+        { "detail-noise-frequency", &params.detail_noise_frequency, 1, false },
+        { "sun-angle", &params.sun_angle, 1, true },
+        { "time", &params.time, 1, false },
+        { "coarse-step-scale", &params.coarse_step_scale, 1, false },
+        { "transmittance-threshold", &params.transmittance_threshold, 1, false },
+        { "ground-height", &params.ground_height, 1, false },
+        { "ground-extent", &params.ground_extent, 1, false },
+        { "lod-bias", &params.lod_bias, 1, false },
+        { "lod-detail-distance", &params.lod_detail_distance, 1, false },
+        { "lod-detail-opacity", &params.lod_detail_opacity, 1, false },
+        { "lod-cone-scale", &params.lod_cone_scale, 1, false }
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool valid = true;
+
+        if (!strcmp(argv[i], "--width") && i + 1 < argc)
+            width = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--height") && i + 1 < argc)
+            height = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc)
+            output = argv[++i];
+        else if (!strcmp(argv[i], "--textures") && i + 1 < argc)
+            texture_dir = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc)
+            num_threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--tile-size") && i + 1 < argc)
+            tile_size = std::max(atoi(argv[++i]), 1);
+        else if (!strcmp(argv[i], "--shape-size") && i + 1 < argc)
+            shape_size = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--detail-size") && i + 1 < argc)
+            detail_size = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--max-num-steps") && i + 1 < argc)
+            params.max_num_steps = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--no-empty-space-skipping"))
+            params.empty_space_skipping = false;
+        else if (!strcmp(argv[i], "--verify-empty-space"))
+            verify = true;
+        else if (!strcmp(argv[i], "--adaptive-march"))
+            params.adaptive_march = true;
+        else if (!strcmp(argv[i], "--empty-samples-before-coarse") && i + 1 < argc)
+            params.empty_samples_before_coarse = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--compare-march-modes"))
+            compare_march = true;
+        else if (!strcmp(argv[i], "--light-volume"))
+            params.light_volume = true;
+        else if (!strcmp(argv[i], "--compare-light-modes"))
+            compare_light = true;
+        else if (!strcmp(argv[i], "--sky-view-lut"))
+            params.sky_view_lut = true;
+        else if (!strcmp(argv[i], "--sky-lut-report"))
+            sky_report = true;
+        else if (!strcmp(argv[i], "--no-depth-clipping"))
+            params.depth_clipping = false;
+        else if (!strcmp(argv[i], "--compare-depth-modes"))
+            compare_depth = true;
+        else if (!strcmp(argv[i], "--tiled-march"))
+            params.tiled_march = true;
+        else if (!strcmp(argv[i], "--compare-tile-modes"))
+            compare_tiles = true;
+        else if (!strcmp(argv[i], "--weather-map") && i + 1 < argc)
+        {
+            weather_map_path   = argv[++i];
+            params.weather_map = true;
+        }
+        else if (!strcmp(argv[i], "--compare-weather-modes"))
+            compare_weather = true;
+        else if (!strcmp(argv[i], "--noise-format") && i + 1 < argc)
+        {
+            const char* name = argv[++i];
+
+            valid = false;
+
+            for (int f = 0; f < NOISE_FORMAT_COUNT; f++)
+            {
+                if (!strcmp(name, noise_format_name(NoiseFormat(f))))
+                {
+                    params.noise_format = NoiseFormat(f);
+                    valid               = true;
+                }
+            }
+        }
+        else if (!strcmp(argv[i], "--compare-noise-formats"))
+            compare_noise = true;
+        else if (!strcmp(argv[i], "--quality") && i + 1 < argc)
+        {
+            CloudQualityTier tier;
+
+            valid = cloud_quality_parse(argv[++i], tier);
+
+            if (valid)
+            {
+                const CloudQualityPreset& preset = cloud_quality_preset(tier);
+
+                params.max_num_steps = preset.max_num_steps;
+                params.cone_samples  = preset.cone_samples;
+                params.detail_noise  = preset.detail_noise;
+                params.light_volume  = preset.light_volume;
+                params.sky_view_lut  = preset.sky_view_lut;
+            }
+        }
+        else if (!strcmp(argv[i], "--density-lod"))
+            params.density_lod = true;
+        else if (!strcmp(argv[i], "--compare-density-lod"))
+            compare_lod = true;
+        else if (!strcmp(argv[i], "--auto-exposure"))
+            auto_exposure = true;
+        else if (!strcmp(argv[i], "--exposure-compensation"))
+            valid = parse_floats(argc, argv, i, &exposure_settings.compensation, 1);
+        else if (!strcmp(argv[i], "--cirrus"))
+        {
+            float values[4];
+
+            valid = params.cirrus_layers.size() < CLOUD_MAX_CIRRUS_LAYERS && parse_floats(argc, argv, i, values, 4);
+
+            CloudLayer layer;
+
+            layer.min_height = values[0];
+            layer.max_height = values[0];
+            layer.coverage   = values[1];
+            layer.opacity    = values[2];
+            layer.scale      = values[3];
+
+            // Kept from the bottom up whatever the order of the arguments.
+            if (valid)
+                params.cirrus_layers.insert(std::upper_bound(params.cirrus_layers.begin(), params.cirrus_layers.end(), layer, [](const CloudLayer& a, const CloudLayer& b) { return a.min_height < b.min_height; }), layer);
+        }
+        else if (!strcmp(argv[i], "--camera-pos"))
+            valid = parse_floats(argc, argv, i, &camera.position.x, 3);
+        else if (!strcmp(argv[i], "--camera-dir"))
+            valid = parse_floats(argc, argv, i, &camera.forward.x, 3);
+        else if (!strcmp(argv[i], "--fov"))
+            valid = parse_floats(argc, argv, i, &camera.fov, 1);
+        else
+        {
+            valid = false;
+
+            for (const ParameterDesc& desc : parameters)
+            {
+                if (strncmp(argv[i], "--", 2) || strcmp(argv[i] + 2, desc.name))
+                    continue;
+
+                valid = parse_floats(argc, argv, i, desc.value, desc.num_components);
+
+                if (desc.angle)
+                    *desc.value = *desc.value * 3.14159265359f / 180.0f;
+
+                break;
+            }
+        }
+
+        if (!valid)
+        {
+            printf("Invalid argument: %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (num_threads == 0)
+        num_threads = SliceScheduler::hardware_threads();
+
+    camera.forward = glm::normalize(camera.forward);
+
+    if (!params.cirrus_layers.empty())
+    {
+        std::vector<CloudLayer> layers(1);
+
+        layers[0].type       = CLOUD_LAYER_VOLUMETRIC;
+        layers[0].min_height = params.cloud_min_height;
+        layers[0].max_height = params.cloud_max_height;
+
+        layers.insert(layers.end(), params.cirrus_layers.begin(), params.cirrus_layers.end());
+
+        std::string error;
+
+        if (!cloud_layers_validate(layers.data(), uint32_t(layers.size()), error))
+        {
+            printf("Invalid cloud layers: %s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    CloudReference reference;
+
+    if (!reference.initialize(texture_dir, params, shape_size, detail_size))
+    {
+        printf("Failed to load textures from %s\n", texture_dir.c_str());
+        return 1;
+    }
+
+    if (!weather_map_path.empty() && !reference.load_weather_map(weather_map_path))
+    {
+        printf("Failed to load weather map %s\n", weather_map_path.c_str());
+        return 1;
+    }
+
+    if (compare_weather && weather_map_path.empty())
+    {
+        printf("--compare-weather-modes needs --weather-map\n");
+        return 1;
+    }
+
+    if (sky_report)
+        return sky_lut_report(reference, params, camera);
+
+    reference.set_parameters(params, camera, width, height);
+    reference.set_verify_empty_space(verify);
+
+    if (compare_march)
+        return compare_modes(reference, params, params.adaptive_march, camera, output, "Fixed", "Adaptive", width, height, tile_size, num_threads);
+
+    if (compare_light)
+        return compare_modes(reference, params, params.light_volume, camera, output, "Cone", "Volume", width, height, tile_size, num_threads);
+
+    if (compare_depth)
+        return compare_modes(reference, params, params.depth_clipping, camera, output, "Full", "Clipped", width, height, tile_size, num_threads);
+
+    if (compare_tiles)
+        return compare_modes(reference, params, params.tiled_march, camera, output, "Fragment", "Tiled", width, height, tile_size, num_threads);
+
+    if (compare_weather)
+        return compare_modes(reference, params, params.weather_map, camera, output, "Global", "Weather", width, height, tile_size, num_threads);
+
+    if (compare_lod)
+        return compare_modes(reference, params, params.density_lod, camera, output, "Full", "LOD", width, height, tile_size, num_threads);
+
+    if (compare_noise)
+        return compare_noise_formats(reference, params, camera, output, shape_size, detail_size, width, height, tile_size, num_threads);
+
+    std::vector<float>  hdr;
+    CloudReferenceStats stats;
+
+    double seconds = render(reference, params.tiled_march, width, height, tile_size, num_threads, hdr, stats);
+
+    if (auto_exposure)
+        apply_auto_exposure(reference, exposure_settings, hdr);
+
+    if (!write_images(reference, output, width, height, hdr))
+        return 1;
+
+    printf("Rendered %ux%u in %.3f s on %u threads (%ux%u tiles)\n", width, height, seconds, num_threads, tile_size, tile_size);
+
+    if (params.tiled_march)
+        printf("Marched %llu of %llu tiles\n", (unsigned long long)stats.marched_tiles, (unsigned long long)stats.tiles);
+    printf("Density samples: %llu (%llu with detail noise), %.1f per ray\n", (unsigned long long)stats.density_samples, (unsigned long long)stats.detail_samples, double(stats.density_samples) / double(stats.rays));
+    printf("Throughput: %.0f samples/sec\n", double(stats.density_samples) / seconds);
+
+    if (!params.cirrus_layers.empty())
+        printf("Cirrus samples: %llu, %.2f per ray\n", (unsigned long long)stats.cirrus_samples, double(stats.cirrus_samples) / double(stats.rays));
+
+    // The adaptive march does not leap along the fixed step lattice, so the samples it skips are not counted.
+    if (params.empty_space_skipping && !params.adaptive_march)
+    {
+        // Skipped samples have zero density and would not have sampled the light cone, so each one is exactly one fetch saved.
+        double pixels = double(stats.rays);
+
+        printf("Density fetches per pixel: %.1f, %.1f without empty space skipping (%.1f grid lookups per pixel)\n", double(stats.density_samples) / pixels, double(stats.density_samples + stats.skipped_samples) / pixels, double(stats.grid_lookups) / pixels);
+
+        if (verify)
+        {
+            printf("Empty space verification: %llu of %llu skipped samples had a non-zero density\n", (unsigned long long)stats.skip_violations, (unsigned long long)stats.skipped_samples);
+
+            if (stats.skip_violations > 0)
+                return 1;
+        }
+    }
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,49 @@
+// Shared by tonemap_cs.glsl, which builds the luminance histogram, and auto_exposure_cs.glsl, which reduces it to the exposure of the
+// next frame. Keep in sync with auto_exposure.h.
+
+#define AUTO_EXPOSURE_HISTOGRAM_BINS 64
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Matches AutoExposureState followed by the histogram, which auto_exposure_cs.glsl clears once it has read it.
+layout(std430, binding = 0) buffer AutoExposure
+{
+    float exposure;
+    float target_exposure;
+    float average_log2_luminance;
+    float padding;
+    uint  histogram[AUTO_EXPOSURE_HISTOGRAM_BINS];
+};
+
+// Minimum and maximum log2 luminance of the histogram.
+uniform vec2 u_Log2LuminanceRange;
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Keep in sync with auto_exposure_bin() in auto_exposure.cpp.
+uint auto_exposure_bin(vec3 color)
+{
+    float luminance = dot(color, vec3(0.2126f, 0.7152f, 0.0722f));
+
+    if (!(luminance >= exp2(u_Log2LuminanceRange.x)))
+        return 0;
+
+    float t = clamp((log2(luminance) - u_Log2LuminanceRange.x) / (u_Log2LuminanceRange.y - u_Log2LuminanceRange.x), 0.0f, 1.0f);
+
+    return min(uint(t * float(AUTO_EXPOSURE_HISTOGRAM_BINS - 1)), uint(AUTO_EXPOSURE_HISTOGRAM_BINS - 2)) + 1;
+}
+
+// ------------------------------------------------------------------
+
+float auto_exposure_bin_log2_luminance(uint bin)
+{
+    float t = (float(bin) - 0.5f) / float(AUTO_EXPOSURE_HISTOGRAM_BINS - 1);
+
+    return mix(u_Log2LuminanceRange.x, u_Log2LuminanceRange.y, t);
+}
+
+// ------------------------------------------------------------------
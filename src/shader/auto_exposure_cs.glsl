@@ -0,0 +1,103 @@
+#include <auto_exposure.glsl>
+
+// ------------------------------------------------------------------
+// INPUTS -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(local_size_x = AUTO_EXPOSURE_HISTOGRAM_BINS, local_size_y = 1, local_size_z = 1) in;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Fractions of the pixels, darkest first, between which the luminance is averaged.
+uniform vec2 u_Percentiles;
+
+uniform float u_Key;
+uniform float u_Compensation;
+uniform vec2  u_ExposureRange;
+
+// Adaptation rate when the exposure rises and when it falls, per second.
+uniform vec2  u_AdaptationSpeed;
+uniform float u_DeltaTime;
+
+// ------------------------------------------------------------------
+// SHARED -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+shared uint  g_Prefix[AUTO_EXPOSURE_HISTOGRAM_BINS];
+shared float g_Weight[AUTO_EXPOSURE_HISTOGRAM_BINS];
+shared float g_WeightedLog2[AUTO_EXPOSURE_HISTOGRAM_BINS];
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+// One work group, one thread per bin. Keep in sync with auto_exposure_update() in auto_exposure.cpp.
+void main()
+{
+    uint bin   = gl_LocalInvocationIndex;
+    uint count = bin == 0 ? 0u : histogram[bin];
+
+    // Inclusive prefix sum of the counts, without the pixels darker than the range in bin 0.
+    g_Prefix[bin] = count;
+
+    barrier();
+
+    for (uint offset = 1; offset < AUTO_EXPOSURE_HISTOGRAM_BINS; offset <<= 1)
+    {
+        uint previous = bin >= offset ? g_Prefix[bin - offset] : 0u;
+
+        barrier();
+
+        g_Prefix[bin] += previous;
+
+        barrier();
+    }
+
+    // The part of the bin inside the percentile range.
+    float total   = float(g_Prefix[AUTO_EXPOSURE_HISTOGRAM_BINS - 1]);
+    float low     = u_Percentiles.x * total;
+    float high    = u_Percentiles.y * total;
+    float clipped = clamp(float(g_Prefix[bin]), low, high) - clamp(float(g_Prefix[bin] - count), low, high);
+
+    g_Weight[bin]       = clipped;
+    g_WeightedLog2[bin] = bin == 0 ? 0.0f : clipped * auto_exposure_bin_log2_luminance(bin);
+
+    barrier();
+
+    for (uint stride = AUTO_EXPOSURE_HISTOGRAM_BINS / 2; stride > 0; stride >>= 1)
+    {
+        if (bin < stride)
+        {
+            g_Weight[bin] += g_Weight[bin + stride];
+            g_WeightedLog2[bin] += g_WeightedLog2[bin + stride];
+        }
+
+        barrier();
+    }
+
+    // Ready for the next frame.
+    histogram[bin] = 0u;
+
+    if (bin == 0 && g_Weight[0] > 0.0f)
+    {
+        float average = g_WeightedLog2[0] / g_Weight[0];
+        float target  = clamp(u_Key * exp2(u_Compensation - average), u_ExposureRange.x, u_ExposureRange.y);
+
+        average_log2_luminance = average;
+        target_exposure        = target;
+
+        if (exposure <= 0.0f)
+            exposure = target;
+        else if (u_DeltaTime > 0.0f)
+        {
+            float speed  = target > exposure ? u_AdaptationSpeed.x : u_AdaptationSpeed.y;
+            float amount = 1.0f - exp(-u_DeltaTime * speed);
+
+            exposure = exp2(mix(log2(exposure), log2(target), amount));
+        }
+    }
+}
+
+// ------------------------------------------------------------------
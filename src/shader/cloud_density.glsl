@@ -0,0 +1,263 @@
+// Cloud density field shared by the cloud pass and the passes that precompute lighting from it.
+
+// Permutation defines of the quality tiers, see cloud_quality.h. The defaults are those of the program built without defines.
+#ifndef CLOUD_CONE_SAMPLES
+#define CLOUD_CONE_SAMPLES 6
+#endif
+
+#ifndef CLOUD_DETAIL_NOISE
+#define CLOUD_DETAIL_NOISE 1
+#endif
+
+#define NUM_CONE_SAMPLES CLOUD_CONE_SAMPLES
+
+// Detail noise of a density sample: none, the average erosion of the detail noise without fetching it, or the full curl and detail noise.
+#define DENSITY_DETAIL_NONE 0
+#define DENSITY_DETAIL_MEAN 1
+#define DENSITY_DETAIL_FULL 2
+
+// Average of the detail Worley FBM over the volume, about the same for every detail noise frequency.
+#define DETAIL_NOISE_MEAN_FBM 0.7f
+
+#include <cloud_stats.glsl>
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+uniform sampler3D s_ShapeNoise;
+uniform sampler3D s_DetailNoise;
+uniform sampler2D s_CurlNoise;
+
+// Keep in sync with CloudUniforms in cloud_uniforms.h.
+layout(std140, binding = 1) uniform CloudUniforms
+{
+    vec3  u_PlanetCenter;
+    float u_PlanetRadius;
+    vec3  u_WindDirection;
+    float u_WindSpeed;
+    vec3  u_SunDir;
+    float u_WindShearOffset;
+    vec3  u_SunColor;
+    float u_CloudMinHeight;
+    vec3  u_CloudBaseColor;
+    float u_CloudMaxHeight;
+    vec3  u_CloudTopColor;
+    float u_ShapeNoiseScale;
+    float u_DetailNoiseScale;
+    float u_DetailNoiseModifier;
+    float u_TurbulenceNoiseScale;
+    float u_TurbulenceAmount;
+    float u_CloudCoverage;
+    float u_MaxNumSteps;
+    float u_LightStepLength;
+    float u_LightConeRadius;
+    float u_Precipitation;
+    float u_AmbientLightFactor;
+    float u_SunLightFactor;
+    float u_HenyeyGreensteinGForward;
+    float u_HenyeyGreensteinGBackward;
+    int   u_EmptySpaceSkipping;
+    int   u_AdaptiveMarch;
+    float u_CoarseStepScale;
+    int   u_EmptySamplesBeforeCoarse;
+    float u_TransmittanceThreshold;
+    int   u_LightVolume;
+    int   u_SkyViewLUT;
+    int   u_DepthClipping;
+    int   u_WeatherMap;
+    int   u_FoldedNoise;
+};
+
+// Changes every frame, kept out of the block so that the block is only uploaded when a parameter changes.
+uniform float u_Time;
+
+#include <weather_map.glsl>
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+float remap(float original_value, float original_min, float original_max, float new_min, float new_max)
+{
+	return new_min + (((original_value - original_min) / (original_max - original_min)) * (new_max - new_min));
+}
+
+// ------------------------------------------------------------------
+
+// returns height fraction [0, 1] for point in cloud
+float height_fraction_for_point(vec3 _position)
+{
+	return clamp((distance(_position,  u_PlanetCenter) - (u_PlanetRadius + u_CloudMinHeight)) / (u_CloudMaxHeight - u_CloudMinHeight), 0.0f, 1.0f);
+}
+
+// ------------------------------------------------------------------
+
+// Cloud type 0 is a thin stratus layer at the bottom of the shell, 1 fills the whole shell so that the default weather leaves the
+// shape unchanged. Keep in sync with density_height_gradient_for_point() in cloud_reference.cpp.
+float density_height_gradient_for_point(float _height_fraction, float _cloud_type)
+{
+	float top = mix(0.35f, 1.2f, _cloud_type);
+
+	return 1.0f - smoothstep(top - 0.2f, top, _height_fraction);
+}
+
+// ------------------------------------------------------------------
+
+// _lod holds the mip levels of the shape and detail noise, which the primary march picks separately from the footprint of each sample.
+float sample_cloud_density_lod(vec3 _position, float _height_fraction, vec2 _lod, int _detail)
+{
+#if CLOUD_DETAIL_NOISE == 0
+    // Variants without detail noise erode every detailed sample by its average instead.
+    _detail = min(_detail, DENSITY_DETAIL_MEAN);
+#endif
+
+    // The weather map is fixed in the world, only the cloud shapes move with the wind.
+    Weather weather = sample_weather(_position);
+
+    // Shear cloud top along wind direction.
+    vec3 position = _position + u_WindDirection * u_WindShearOffset * _height_fraction; 
+
+    // Animate clouds in wind direction and add a small upward bias to the wind direction.
+    position += (u_WindDirection + vec3(0.0f, 0.1f, 0.0f)) * u_WindSpeed * u_Time;
+
+    // Read the low-frequency Perlin-Worley and Worley noises.
+    vec4 low_frequency_noises = textureLod(s_ShapeNoise, position * u_ShapeNoiseScale, _lod.x);
+
+    CLOUD_STATS_ADD(CLOUD_STATS_DENSITY_FETCHES, 1);
+
+    float base_cloud;
+
+    // The folded shape noise already stores the base cloud shape, see noise_format.h.
+    if (u_FoldedNoise == 1)
+        base_cloud = low_frequency_noises.r;
+    else
+    {
+        // Build an FBM out of the low-frequency Worley noises to add detail to the low-frequeny Perlin-Worley noise.
+        float low_freq_fbm = (low_frequency_noises.g * 0.625f) + (low_frequency_noises.b * 0.25f) + (low_frequency_noises.a * 0.125f);
+
+        // Define the base cloud shape by dilating it with the low-frequency FBM made of Worley noise.
+        base_cloud = remap(low_frequency_noises.r, (1.0f - low_freq_fbm), 1.0f, 0.0f, 1.0f);
+    }
+
+    // Get the density-height gradient using the density height function.
+    float density_height_gradient = density_height_gradient_for_point(_height_fraction, weather.cloud_type);
+
+    // Apply the height function to the base cloud shape.
+    base_cloud *= density_height_gradient;
+
+    // Fetch cloud coverage value.
+    float cloud_coverage = weather.coverage;
+
+    // Remap to apply the cloud coverage attribute.
+    float base_cloud_with_coverage = remap(base_cloud, cloud_coverage, 1.0f, 0.0f, 1.0f);
+
+    // Multiply result by the cloud coverage attribute so that smaller clouds are lighter and more aesthetically pleasing.
+    base_cloud_with_coverage *= cloud_coverage;
+
+    // Exit out if base cloud density is zero.
+    if (base_cloud_with_coverage <= 0.0f)
+        return 0.0f;
+
+    float final_cloud = base_cloud_with_coverage;
+
+    if (_detail != DENSITY_DETAIL_NONE)
+    {
+        // Skipping the erosion altogether would make the clouds denser than with the detail noise.
+        float high_freq_fbm = DETAIL_NOISE_MEAN_FBM;
+
+        if (_detail == DENSITY_DETAIL_FULL)
+        {
+            // Sample curl noise texture.
+            vec2 curl_noise = textureLod(s_CurlNoise, position.xz * u_TurbulenceNoiseScale, 0.0f).rg;
+
+            // Add some turbulence to bottom of clouds.
+            position.xy += curl_noise * (1.0f - _height_fraction) * u_TurbulenceAmount;
+
+            // Sample high-frequency noises.
+            vec3 high_frequency_noises = textureLod(s_DetailNoise, position * u_DetailNoiseScale, _lod.y).rgb;
+
+            CLOUD_STATS_ADD(CLOUD_STATS_DETAIL_FETCHES, 1);
+
+            // Build high-frequency Worley noise FBM, unless the folded detail noise already stores it.
+            high_freq_fbm = u_FoldedNoise == 1 ? high_frequency_noises.r : (high_frequency_noises.r * 0.625f) + (high_frequency_noises.g * 0.25f) + (high_frequency_noises.b * 0.125f);
+        }
+
+        // Transition from wispy shapes to billowy shapes over height.
+        float high_freq_noise_modifier = mix(1.0f - high_freq_fbm, high_freq_fbm, clamp(_height_fraction * 10.0f, 0.0f, 1.0f));
+
+        // Erode the base cloud shape with the distorted high-frequency Worley noise.
+        final_cloud = remap(base_cloud_with_coverage, high_freq_noise_modifier * u_DetailNoiseModifier, 1.0f, 0.0f, 1.0f);
+    }
+
+    // Raining clouds are denser, darker and more opaque.
+    return clamp(final_cloud, 0.0f, 1.0f) * (1.0f + weather.precipitation * WEATHER_PRECIPITATION_DENSITY);
+}
+
+// ------------------------------------------------------------------
+
+float sample_cloud_density(vec3 _position, float _height_fraction, float _lod, bool _use_detail)
+{
+    return sample_cloud_density_lod(_position, _height_fraction, vec2(_lod), _use_detail ? DENSITY_DETAIL_FULL : DENSITY_DETAIL_NONE);
+}
+
+// ------------------------------------------------------------------
+
+// _lod_offset coarsens every sample of the cone and replaces the detail noise of one of the two detailed samples per mip level by its
+// average, the primary march raises it as the transmittance in front of the sample falls.
+float sample_cloud_density_along_cone(vec3 _position, vec3 _light_dir, float _lod_offset)
+{
+	const vec3 noise_kernel[6] = 
+	{
+		{ -0.6, -0.8, -0.2 },
+		{ 1.0, -0.3, 0.0 },
+		{ -0.7, 0.0, 0.7 },
+		{ -0.2, 0.6, -0.8 },
+		{ 0.4, 0.3, 0.9 },
+		{ -0.2, 0.6, -0.8 }
+	};
+
+	float density_along_cone = 0.0f;
+
+	for (int i = 0; i < NUM_CONE_SAMPLES; i++) 
+	{
+        // March ray forward along light direction.
+		_position += _light_dir * u_LightStepLength;
+
+        // Compute offset within the cone. 
+		vec3 random_offset = noise_kernel[i] * u_LightStepLength * u_LightConeRadius * (float(i + 1));
+
+        // Add offset to position.
+		vec3 p = _position + random_offset;
+		
+        // Compute height fraction for the current position.
+		float height_fraction = height_fraction_for_point(p);
+
+		// Skipping detail noise based on accumulated density causes some banding artefacts 
+		// so only use detail noise for the first two samples.   
+        int detail = i < 2 ? (float(i) < 2.0f - _lod_offset ? DENSITY_DETAIL_FULL : DENSITY_DETAIL_MEAN) : DENSITY_DETAIL_NONE;
+            
+        // Sample the cloud density at this point within the cone.
+        density_along_cone += sample_cloud_density_lod(p, height_fraction, vec2(float(i) * 0.5f + _lod_offset), detail);
+	}
+
+    // Get one more sample further away to account for shadows from distant clouds.
+	_position += 32.0f * u_LightStepLength * _light_dir; 
+
+    // Compute height fraction for the distant position.
+	float height_fraction = height_fraction_for_point(_position);
+
+    // Sample the cloud density for the distant position.
+	density_along_cone += sample_cloud_density(_position, height_fraction, 2.0f + _lod_offset, false) * 3.0f;
+	
+	return density_along_cone;
+}
+
+// ------------------------------------------------------------------
+
+float sample_cloud_density_along_cone(vec3 _position, vec3 _light_dir)
+{
+    return sample_cloud_density_along_cone(_position, _light_dir, 0.0f);
+}
+
+// ------------------------------------------------------------------
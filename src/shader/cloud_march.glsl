@@ -0,0 +1,662 @@
+#include <atmosphere.glsl>
+#include <cloud_density.glsl>
+#include <sky_view_lut.glsl>
+
+// Cloud ray march shared by the full-screen pass (clouds_fs.glsl) and the tiled compute path (clouds_cs.glsl).
+
+// ------------------------------------------------------------------
+// STRUCTURES -------------------------------------------------------
+// ------------------------------------------------------------------
+
+struct Ray
+{
+    vec3 origin;
+    vec3 direction;
+};
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(std140, binding = 0) uniform GlobalUniforms
+{
+    mat4 view_proj;
+    mat4 prev_view_proj;
+    mat4 inv_view_proj;
+    vec4 cam_pos;
+};
+
+uniform sampler2D s_BlueNoise;
+uniform sampler3D s_EmptySpaceGrid;
+uniform sampler3D s_LightVolume;
+uniform sampler2D s_SkyViewLUT;
+uniform sampler2D s_Depth;
+
+// Placement of the sun transmittance volume, see light_volume_cs.glsl.
+uniform vec3  u_LightVolumeOrigin;
+uniform float u_LightVolumeExtent;
+uniform float u_LightVolumeTime;
+
+// Upper bound of the base cloud shape over the whole shape noise, the largest value of the empty space grid.
+uniform float u_CoverageBound;
+
+// Change every frame, kept out of CloudUniforms so that the block is only uploaded when a parameter changes.
+uniform vec2  u_PixelOffset;
+uniform float u_PixelStride;
+uniform vec2  u_FullResolution;
+
+// Fraction of MAX_NUM_STEPS marched, lowered by the cloud budget controller. Kept out of CloudUniforms so that changing it does not
+// restart the light volume and the shadow map.
+uniform float u_StepFraction;
+
+// Level of detail of the density samples of the primary march, see density_lod(). Disabled when u_DensityLod is 0.
+uniform int   u_DensityLod;
+uniform float u_LodPixelAngle;     // Width of a pixel in radians at unit distance, including the pixel stride.
+uniform float u_LodBias;           // Added to the mip levels of the footprint.
+uniform float u_LodDetailDistance; // Detail and curl noise are skipped past this distance...
+uniform float u_LodDetailOpacity;  // ...or once the ray is this opaque.
+uniform float u_LodConeScale;      // Cone mip offset once the ray is fully opaque.
+
+// Coarsest shape mip while skipping empty space, keep in sync with empty_space_grid.h.
+#define EMPTY_SPACE_MAX_SHAPE_LOD 1.0f
+
+// Cirrus layers of the cloud layer stack, see cloud_layers.h. Each entry holds the height above the surface, the coverage, the opacity
+// and the width of one repeat of the noise in meters.
+#define CLOUD_MAX_CIRRUS_LAYERS 3
+
+uniform int  u_NumCirrusLayers;
+uniform vec4 u_CirrusLayers[CLOUD_MAX_CIRRUS_LAYERS];
+
+// Tileable cirrus texture generated on the CPU by cloud_cirrus_texture_generate(), with its mip chain.
+uniform sampler2D s_CirrusNoise;
+
+// Settings a quality tier folds into constants, see cloud_quality.h. Without their define they are read from CloudUniforms.
+#ifdef CLOUD_MAX_NUM_STEPS
+#define MAX_NUM_STEPS float(CLOUD_MAX_NUM_STEPS)
+#else
+#define MAX_NUM_STEPS u_MaxNumSteps
+#endif
+
+#ifdef CLOUD_LIGHT_VOLUME
+#define LIGHT_VOLUME (CLOUD_LIGHT_VOLUME == 1)
+#else
+#define LIGHT_VOLUME (u_LightVolume == 1)
+#endif
+
+#ifdef CLOUD_SKY_VIEW_LUT
+#define SKY_VIEW_LUT (CLOUD_SKY_VIEW_LUT == 1)
+#else
+#define SKY_VIEW_LUT (u_SkyViewLUT == 1)
+#endif
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+Ray generate_ray(vec2 _tex_coord)
+{
+    vec2 tex_coord_neg_to_pos = _tex_coord * 2.0f - 1.0f;
+    vec4 target = inv_view_proj * vec4(tex_coord_neg_to_pos, 0.0f, 1.0f);
+    target /= target.w;
+
+    Ray ray;
+
+    ray.origin 	  = cam_pos.xyz;
+    ray.direction = normalize(target.xyz - ray.origin);
+
+    return ray;
+}
+
+// ------------------------------------------------------------------
+
+vec3 ray_sphere_intersection(in Ray ray, in vec3 sphere_center, in float sphere_radius)
+{
+    vec3 l = ray.origin - sphere_center;
+	float a = 1.0;
+	float b = 2.0 * dot(ray.direction, l);
+	float c = dot(l, l) - pow(sphere_radius, 2);
+	float D = pow(b, 2) - 4.0 * a * c;
+	
+    if (D < 0.0)
+		return ray.origin;
+	else if (abs(D) - 0.00005 <= 0.0)
+		return ray.origin + ray.direction * (-0.5 * b / a);
+	else
+	{
+		float q = 0.0;
+		if (b > 0.0) 
+            q = -0.5 * (b + sqrt(D));
+		else 
+            q = -0.5 * (b - sqrt(D));
+		
+		float h1 = q / a;
+		float h2 = c / q;
+		vec2 t = vec2(min(h1, h2), max(h1, h2));
+
+		if (t.x < 0.0) 
+        {
+			t.x = t.y;
+			
+            if (t.x < 0.0)
+				return ray.origin;
+		}
+        
+		return ray.origin + t.x * ray.direction;
+	}
+}
+
+// ------------------------------------------------------------------
+
+float blue_noise(vec2 _pixel)
+{
+	ivec2 size = textureSize(s_BlueNoise, 0);
+
+	vec2 interleaved_pos = (mod(_pixel, float(size.x)));
+	vec2 tex_coord 	     = interleaved_pos / float(size.x) + vec2(0.5f / float(size.x), 0.5f / float(size.x));
+	
+	return texture(s_BlueNoise, tex_coord).r * 2.0f - 1.0f;
+}
+
+// ------------------------------------------------------------------
+
+// Returns the distance along the ray to the exit of the empty space grid cell containing _position, or 0.0 if the cell may contain
+// clouds. The grid is built over the shape noise, so the position goes through the same wind offsets as in sample_cloud_density().
+float empty_space_distance(vec3 _position, vec3 _ray_direction, float _height_fraction)
+{
+    float grid_size = float(textureSize(s_EmptySpaceGrid, 0).x);
+
+    vec3 position = _position + u_WindDirection * u_WindShearOffset * _height_fraction;
+    position += (u_WindDirection + vec3(0.0f, 0.1f, 0.0f)) * u_WindSpeed * u_Time;
+
+    vec3 grid_pos = fract(position * u_ShapeNoiseScale) * grid_size;
+    vec3 cell     = min(floor(grid_pos), vec3(grid_size - 1.0f));
+
+    if (texelFetch(s_EmptySpaceGrid, ivec3(cell), 0).r > min_cloud_coverage())
+        return 0.0f;
+
+    // Direction of the ray in grid space, including the shear offset changing with height. This is a linear approximation, the grid
+    // bounds extend one texel past each cell to cover the error.
+    float height_rate = dot(_ray_direction, normalize(_position - u_PlanetCenter)) / (u_CloudMaxHeight - u_CloudMinHeight);
+    vec3  direction   = (_ray_direction + u_WindDirection * u_WindShearOffset * height_rate) * u_ShapeNoiseScale * grid_size;
+
+    vec3 t = mix(grid_pos - cell, cell + 1.0f - grid_pos, step(0.0f, direction)) / max(abs(direction), vec3(1e-6f));
+
+    return min(t.x, min(t.y, t.z));
+}
+
+// ------------------------------------------------------------------
+
+// Density along the light cone, precomputed by light_volume_cs.glsl. The volume was built with the clouds at u_LightVolumeTime, so the
+// position is moved by the wind advection since then.
+float sample_light_volume(vec3 _position)
+{
+    vec3 position = _position + (u_WindDirection + vec3(0.0f, 0.1f, 0.0f)) * u_WindSpeed * (u_Time - u_LightVolumeTime);
+    vec2 uv       = (position.xz - u_LightVolumeOrigin.xz) / u_LightVolumeExtent + 0.5f;
+
+    return textureLod(s_LightVolume, vec3(uv, height_fraction_for_point(position)), 0.0f).r;
+}
+
+// ------------------------------------------------------------------
+
+// Mip levels of the shape and detail noise whose texels cover the footprint of a sample: the width of the pixel at its distance or the
+// step between two samples, whichever is larger. Finer texels would only alias into noise. Coarser shape mips than the empty space grid
+// bounds would let the march skip samples with a non-zero density.
+vec2 density_lod(vec3 _position, float _step_size)
+{
+    if (u_DensityLod == 0)
+        return vec2(0.0f);
+
+    float footprint = max(distance(_position, cam_pos.xyz) * u_LodPixelAngle, _step_size);
+    vec2  texel     = 1.0f / vec2(u_ShapeNoiseScale * float(textureSize(s_ShapeNoise, 0).x), u_DetailNoiseScale * float(textureSize(s_DetailNoise, 0).x));
+    vec2  lod       = max(log2(footprint / texel) + u_LodBias, vec2(0.0f));
+
+    if (u_EmptySpaceSkipping == 1)
+        lod.x = min(lod.x, EMPTY_SPACE_MAX_SHAPE_LOD);
+
+    return lod;
+}
+
+// ------------------------------------------------------------------
+
+// The detail and curl noise are replaced by their average far away, where the detail noise is mostly filtered out, and behind enough
+// cloud that the erosion barely shows.
+int density_detail(vec3 _position, float _alpha)
+{
+    if (u_DensityLod == 0 || (_alpha < u_LodDetailOpacity && distance(_position, cam_pos.xyz) < u_LodDetailDistance))
+        return DENSITY_DETAIL_FULL;
+
+    return DENSITY_DETAIL_MEAN;
+}
+
+// ------------------------------------------------------------------
+
+float sun_cone_density(vec3 _position, float _accum_transmittance)
+{
+    CLOUD_STATS_ADD(CLOUD_STATS_LIGHT_SAMPLES, LIGHT_VOLUME ? 1 : NUM_CONE_SAMPLES + 1);
+
+    if (LIGHT_VOLUME)
+        return sample_light_volume(_position);
+
+    // Light scattered behind dense cloud is mostly hidden, so its cone can be sampled coarsely.
+    float lod_offset = u_DensityLod == 1 ? (1.0f - _accum_transmittance) * u_LodConeScale : 0.0f;
+
+    return sample_cloud_density_along_cone(_position, u_SunDir, lod_offset);
+}
+
+// ------------------------------------------------------------------
+
+// Distance from the camera to the opaque scene seen through the fragment, infinite where the depth buffer was not written.
+float scene_distance(vec2 _pixel, vec2 _tex_coord)
+{
+    float depth = texelFetch(s_Depth, ivec2(_pixel), 0).r;
+
+    if (depth >= 1.0f)
+        return 1e30f;
+
+    vec4 world_pos = inv_view_proj * vec4(vec3(_tex_coord, depth) * 2.0f - 1.0f, 1.0f);
+
+    return distance(world_pos.xyz / world_pos.w, cam_pos.xyz);
+}
+
+// ------------------------------------------------------------------
+
+// Sky behind the clouds, read from the sky-view LUT built by sky_view_lut_cs.glsl for the current sun direction.
+vec3 sky_luminance(vec3 _direction)
+{
+    if (SKY_VIEW_LUT)
+        return textureLod(s_SkyViewLUT, sky_view_lut_uv(_direction, textureSize(s_SkyViewLUT, 0)), 0.0f).rgb;
+
+    return calculate_sky_luminance_rgb(u_SunDir, _direction, 2.0f);
+}
+
+// ------------------------------------------------------------------
+
+float beer_lambert_law(float _density)
+{
+    return exp(-_density * u_Precipitation);
+}
+
+// ------------------------------------------------------------------
+
+float beer_law(float density)
+{
+	float d = -density * u_Precipitation;
+	return max(exp(d), exp(d * 0.5f) * 0.7f);
+}
+
+// ------------------------------------------------------------------
+
+float henyey_greenstein_phase(float cos_angle, float g)
+{
+	float g2 = g * g;
+	return ((1.0f - g2) / pow(1.0f + g2 - 2.0f * g * cos_angle, 1.5f)) / 4.0f * 3.1415f;
+}
+
+// ------------------------------------------------------------------
+
+float powder_effect(float _density, float _cos_angle)
+{
+	float powder = 1.0f - exp(-_density * 2.0f);
+	return mix(1.0f, powder, clamp((-_cos_angle * 0.5f) + 0.5f, 0.0f, 1.0f));
+}
+
+// ------------------------------------------------------------------
+
+float calculate_light_energy(float _density, float _cos_angle, float _powder_density) 
+{ 
+	float beer_powder = 2.0f * beer_law(_density) * powder_effect(_powder_density, _cos_angle);
+	float HG = max(henyey_greenstein_phase(_cos_angle, u_HenyeyGreensteinGForward), henyey_greenstein_phase(_cos_angle, u_HenyeyGreensteinGBackward)) * 0.07f + 0.8f;
+	return beer_powder * HG;
+}
+
+// ------------------------------------------------------------------
+
+#define CIRRUS_STRETCH      4.0f                // Streaks are this many times longer along x than across.
+#define CIRRUS_CURL_SCALE   4.0f                // Repeats of the curl noise per repeat of the cirrus texture.
+#define CIRRUS_CURL_AMOUNT  0.05f               // Distortion of the streaks, in repeats of the cirrus texture.
+#define CIRRUS_LAYER_OFFSET vec2(0.31f, 0.57f)  // Between stacked layers, so that they do not repeat each other.
+
+// Distance along the ray to where it first crosses the sphere of radius '_radius' around the planet center, negative if it does not.
+// Keep in sync with cloud_layer_distance() in cloud_layers.cpp.
+float cloud_layer_distance(Ray _ray, float _radius)
+{
+    vec3  l = _ray.origin - u_PlanetCenter;
+    float b = dot(_ray.direction, l);
+    float d = b * b - dot(l, l) + _radius * _radius;
+
+    if (d < 0.0f)
+        return -1.0f;
+
+    float s = sqrt(d);
+
+    return -b - s > 0.0f ? -b - s : -b + s;
+}
+
+// ------------------------------------------------------------------
+
+// Premultiplied color of cirrus layer '_layer' at '_position', '_distance' from the camera: a single curl noise and cirrus texture fetch
+// instead of a march, lit by the sun and the ambient top color as a thin sheet.
+vec4 shade_cirrus_layer(int _layer, vec3 _position, float _distance, float _cos_angle)
+{
+    vec4 layer = u_CirrusLayers[_layer];
+
+    vec2 uv = (_position.xz + u_WindDirection.xz * u_WindSpeed * u_Time) / layer.w * vec2(1.0f / CIRRUS_STRETCH, 1.0f);
+
+    uv += (textureLod(s_CurlNoise, uv * CIRRUS_CURL_SCALE, 0.0f).rg - 0.5f) * CIRRUS_CURL_AMOUNT;
+
+    uv += float(_layer) * CIRRUS_LAYER_OFFSET;
+
+    // Mip of the pixel footprint, the sheet is seen at grazing angles near the horizon and aliases badly at mip 0.
+    float lod   = max(log2(_distance * u_LodPixelAngle * float(textureSize(s_CirrusNoise, 0).x) / layer.w), 0.0f);
+    float noise = textureLod(s_CirrusNoise, uv, lod).r;
+    float alpha = clamp(remap(noise, 1.0f - layer.y, 1.0f, 0.0f, 1.0f), 0.0f, 1.0f) * layer.z;
+
+    float HG    = max(henyey_greenstein_phase(_cos_angle, u_HenyeyGreensteinGForward), henyey_greenstein_phase(_cos_angle, u_HenyeyGreensteinGBackward)) * 0.07f + 0.8f;
+    vec3  light = u_SunColor * u_SunLightFactor * HG + u_CloudTopColor * u_AmbientLightFactor;
+
+    return vec4(light * alpha, alpha);
+}
+
+// ------------------------------------------------------------------
+
+// Composites the cirrus layers crossed before '_geometry_distance' with the volumetric clouds '_clouds', which start '_clouds_distance'
+// along the ray, front to back in the order the ray crosses them. Keep in sync with CloudReference::composite_cloud_layers().
+vec4 composite_cloud_layers(Ray _ray, vec4 _clouds, float _clouds_distance, float _geometry_distance)
+{
+    if (u_NumCirrusLayers == 0)
+        return _clouds;
+
+    float distances[CLOUD_MAX_CIRRUS_LAYERS + 1];
+    int   layers[CLOUD_MAX_CIRRUS_LAYERS + 1];
+    int   count = 1;
+
+    // -1 stands for the volumetric layer.
+    distances[0] = _clouds_distance;
+    layers[0]    = -1;
+
+    for (int i = 0; i < u_NumCirrusLayers; i++)
+    {
+        float d = cloud_layer_distance(_ray, u_PlanetRadius + u_CirrusLayers[i].x);
+
+        if (d < 0.0f || d >= _geometry_distance)
+            continue;
+
+        int j = count++;
+
+        for (; j > 0 && distances[j - 1] > d; j--)
+        {
+            distances[j] = distances[j - 1];
+            layers[j]    = layers[j - 1];
+        }
+
+        distances[j] = d;
+        layers[j]    = i;
+    }
+
+    float cos_angle = dot(_ray.direction, u_SunDir);
+    vec4  result    = vec4(0.0f);
+
+    for (int i = 0; i < count; i++)
+    {
+        vec4 layer = layers[i] < 0 ? _clouds : shade_cirrus_layer(layers[i], _ray.origin + _ray.direction * distances[i], distances[i], cos_angle);
+
+        result += (1.0f - result.a) * layer;
+    }
+
+    return result;
+}
+
+// ------------------------------------------------------------------
+
+vec4 ray_march(vec3 _ray_origin, vec3 _ray_direction, float _cos_angle, float _step_size, float _num_steps)
+{
+	vec3  position            = _ray_origin;
+	float step_increment      = 1.0f;
+    float accum_transmittance = 1.0f;
+    vec3  accum_scattering    = vec3(0.0f);
+    float alpha               = 0.0f;
+
+	vec3 sun_color = u_SunColor;
+
+	for (float i = 0.0f; i < _num_steps; i+= step_increment)
+	{
+		CLOUD_STATS_ADD(CLOUD_STATS_STEPS, 1);
+
+		float height_fraction = height_fraction_for_point(position);
+
+		if (u_EmptySpaceSkipping == 1)
+		{
+			float empty_distance = empty_space_distance(position, _ray_direction, height_fraction);
+
+			// Leap over every step inside the empty cell. The position is advanced one step at a time so that the remaining samples
+			// land exactly where they would without skipping.
+			if (empty_distance > 0.0f)
+			{
+				float num_skipped = max(ceil(empty_distance / _step_size), 1.0f);
+
+				for (float j = 0.0f; j < num_skipped; j += step_increment)
+					position += _ray_direction * _step_size * step_increment;
+
+				i += num_skipped - step_increment;
+				continue;
+			}
+		}
+
+		float density            = sample_cloud_density_lod(position, height_fraction, density_lod(position, _step_size), density_detail(position, alpha));
+        float step_transmittance = beer_lambert_law(density * _step_size);
+
+        accum_transmittance *= step_transmittance;
+
+		if (density > 0.0f)
+		{
+            CLOUD_STATS_OCCUPIED();
+
+            alpha += (1.0f - step_transmittance) * (1.0f - alpha);
+            
+            float cone_density = sun_cone_density(position, accum_transmittance);
+
+            vec3 in_scattered_light = calculate_light_energy(cone_density * _step_size, _cos_angle, density * _step_size) * sun_color * u_SunLightFactor * alpha;
+            vec3 ambient_light      = mix(u_CloudBaseColor, u_CloudTopColor, height_fraction) * u_AmbientLightFactor;
+
+            accum_scattering += (ambient_light + in_scattered_light) * accum_transmittance * density;
+		}
+
+		position += _ray_direction * _step_size * step_increment;
+	}
+
+	return vec4(accum_scattering, alpha);
+}
+
+// ------------------------------------------------------------------
+
+// Takes large steps with the shape noise only until it finds density, then backs up one coarse step and continues with fine detailed
+// steps. Goes back to coarse steps after u_EmptySamplesBeforeCoarse consecutive empty samples and stops once the transmittance drops
+// below u_TransmittanceThreshold. Detail noise only erodes the shape, so a coarse sample with zero density is also zero when detailed.
+vec4 ray_march_adaptive(vec3 _ray_origin, vec3 _ray_direction, float _cos_angle, float _step_size, float _num_steps)
+{
+	float ray_length          = _step_size * _num_steps;
+	float coarse_step_size    = _step_size * u_CoarseStepScale;
+	float t                   = 0.0f;
+	float coarse_start        = 0.0f;
+	float coarse_hit          = 0.0f;
+	bool  coarse              = true;
+	int   num_empty_samples   = 0;
+    float accum_transmittance = 1.0f;
+    vec3  accum_scattering    = vec3(0.0f);
+    float alpha               = 0.0f;
+
+	vec3 sun_color = u_SunColor;
+
+	// Bounded so that a degenerate step size can never hang the GPU.
+	for (float i = 0.0f; i < _num_steps * 2.0f && t < ray_length; i += 1.0f)
+	{
+		vec3  position        = _ray_origin + _ray_direction * t;
+		float height_fraction = height_fraction_for_point(position);
+
+		CLOUD_STATS_ADD(CLOUD_STATS_STEPS, 1);
+
+		if (coarse)
+		{
+			if (u_EmptySpaceSkipping == 1)
+			{
+				float empty_distance = empty_space_distance(position, _ray_direction, height_fraction);
+
+				// Nudge past the cell boundary so that the next lookup lands in the next cell.
+				if (empty_distance > 0.0f)
+				{
+					t += empty_distance + _step_size * 0.001f;
+					continue;
+				}
+			}
+
+			// Same shape mip as the fine samples, so that an empty coarse sample is still empty when detailed.
+			if (sample_cloud_density_lod(position, height_fraction, density_lod(position, _step_size), DENSITY_DETAIL_NONE) > 0.0f)
+			{
+				// Back up to the last empty coarse sample and march the interval with fine steps.
+				coarse_hit        = t;
+				t                 = max(t - coarse_step_size, coarse_start);
+				coarse            = false;
+				num_empty_samples = 0;
+			}
+			else
+				t += coarse_step_size;
+
+			continue;
+		}
+
+		float density            = sample_cloud_density_lod(position, height_fraction, density_lod(position, _step_size), density_detail(position, alpha));
+        float step_transmittance = beer_lambert_law(density * _step_size);
+
+        accum_transmittance *= step_transmittance;
+
+		if (density > 0.0f)
+		{
+            CLOUD_STATS_OCCUPIED();
+
+            alpha += (1.0f - step_transmittance) * (1.0f - alpha);
+            
+            float cone_density = sun_cone_density(position, accum_transmittance);
+
+            vec3 in_scattered_light = calculate_light_energy(cone_density * _step_size, _cos_angle, density * _step_size) * sun_color * u_SunLightFactor * alpha;
+            vec3 ambient_light      = mix(u_CloudBaseColor, u_CloudTopColor, height_fraction) * u_AmbientLightFactor;
+
+            accum_scattering += (ambient_light + in_scattered_light) * accum_transmittance * density;
+
+			num_empty_samples = 0;
+
+			if (accum_transmittance < u_TransmittanceThreshold)
+				break;
+		}
+		else if (++num_empty_samples >= u_EmptySamplesBeforeCoarse && t >= coarse_hit)
+		{
+			coarse       = true;
+			coarse_start = t + _step_size;
+		}
+
+		t += _step_size;
+	}
+
+	return vec4(accum_scattering, alpha);
+}
+
+// ------------------------------------------------------------------
+
+// Final premultiplied color of full resolution pixel '_pixel': the clouds over the sky, or over the scene where geometry was drawn.
+vec4 shade_cloud_pixel(vec2 _pixel)
+{
+	vec2 tex_coord = (_pixel + vec2(0.5f)) / u_FullResolution;
+
+	// Generate a camera ray to the current fragment.
+	Ray ray = generate_ray(tex_coord);
+
+	// Figure out where our ray will intersect the sphere that represents the beginning of the cloud layer. 
+	vec3 ray_start = ray_sphere_intersection(ray, u_PlanetCenter, u_PlanetRadius + u_CloudMinHeight);
+
+	// Similarly, figure out where the ray intersects the end of the cloud layer.
+	vec3 ray_end   = ray_sphere_intersection(ray, u_PlanetCenter, u_PlanetRadius + u_CloudMaxHeight);
+
+	// Reject pixels whose scene geometry is in front of the cloud layer before any texture fetch.
+	float geometry_distance = u_DepthClipping == 1 ? scene_distance(_pixel, tex_coord) : 1e30f;
+
+	if (geometry_distance <= distance(ray.origin, ray_start))
+		return composite_cloud_layers(ray, vec4(0.0f), 0.0f, geometry_distance);
+
+	// Get a random number that we'll use to jitter our ray.
+	const float rng = blue_noise(_pixel);
+	
+	// The maximum number of ray march steps to use.
+	const float max_steps = MAX_NUM_STEPS * u_StepFraction;
+	
+	// The minimum number of ray march steps to use with an added offset to prevent banding.
+	const float min_steps = (max_steps * 0.5f) + (rng * 2.0f);
+
+	// The number of ray march steps is determined depending on how steep the viewing angle is.
+	float num_steps = mix(max_steps, min_steps, ray.direction.y);
+
+	// Using the number of steps we can determine the step size of our ray march.
+	float step_size = length(ray_start - ray_end) / num_steps;
+
+	// Jitter the ray to prevent banding.
+	ray_start += step_size * ray.direction * rng;
+
+	// End the march at the first opaque surface. Both marches take fixed size steps from ray_start, so this clips them exactly.
+	num_steps = min(num_steps, max(geometry_distance - distance(ray.origin, ray_start), 0.0f) / step_size);
+
+	float cos_angle = dot(ray.direction, u_SunDir);
+	vec4  clouds    = u_AdaptiveMarch == 1 ? ray_march_adaptive(ray_start, ray.direction, cos_angle, step_size, num_steps) : ray_march(ray_start, ray.direction, cos_angle, step_size, num_steps);
+
+	cloud_stats_write(_pixel);
+
+	clouds = composite_cloud_layers(ray, clouds, distance(ray.origin, ray_start), geometry_distance);
+
+	// Premultiplied alpha, blended over the scene. The sky is only composited where no geometry was drawn.
+	if (geometry_distance < 1e30f)
+		return clouds;
+
+	vec3 sky = sky_luminance(ray.direction) * 0.05f;
+
+	return vec4(clouds.rgb + (1.0f - clouds.a) * sky, 1.0f);
+}
+
+// ------------------------------------------------------------------
+
+// False when shade_cloud_pixel() is known to find no clouds without marching: the ray misses the cloud layer, the scene geometry is
+// in front of the layer or the coverage removes every cloud. Keep in sync with CloudReference::pixel_needs_march().
+bool cloud_pixel_needs_march(vec2 _pixel)
+{
+	if (min_cloud_coverage() >= u_CoverageBound)
+		return false;
+
+	vec2 tex_coord = (_pixel + vec2(0.5f)) / u_FullResolution;
+	Ray  ray       = generate_ray(tex_coord);
+
+	vec3 ray_start = ray_sphere_intersection(ray, u_PlanetCenter, u_PlanetRadius + u_CloudMinHeight);
+	vec3 ray_end   = ray_sphere_intersection(ray, u_PlanetCenter, u_PlanetRadius + u_CloudMaxHeight);
+
+	if (ray_start == ray.origin && ray_end == ray.origin)
+		return false;
+
+	float geometry_distance = u_DepthClipping == 1 ? scene_distance(_pixel, tex_coord) : 1e30f;
+
+	return geometry_distance > distance(ray.origin, ray_start);
+}
+
+// ------------------------------------------------------------------
+
+// Output of shade_cloud_pixel() for a pixel where cloud_pixel_needs_march() is false.
+vec4 empty_cloud_pixel(vec2 _pixel)
+{
+	vec2 tex_coord = (_pixel + vec2(0.5f)) / u_FullResolution;
+	Ray  ray       = generate_ray(tex_coord);
+
+	// The cirrus layers are not marched, so they are shaded even where the volumetric layer is empty.
+	float geometry_distance = u_DepthClipping == 1 ? scene_distance(_pixel, tex_coord) : 1e30f;
+	vec4  clouds            = composite_cloud_layers(ray, vec4(0.0f), 0.0f, geometry_distance);
+
+	if (geometry_distance < 1e30f)
+		return clouds;
+
+	return vec4(clouds.rgb + (1.0f - clouds.a) * sky_luminance(ray.direction) * 0.05f, 1.0f);
+}
+
+// ------------------------------------------------------------------
@@ -0,0 +1,77 @@
+#include <cloud_density.glsl>
+
+// Density samples along the sun ray through the cloud shell.
+#define NUM_SHADOW_STEPS 16
+
+// ------------------------------------------------------------------
+// INPUTS -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(binding = 0, r16f) uniform image2D i_CloudShadowMap;
+
+uniform vec2  u_CloudShadowMapOrigin;
+uniform float u_CloudShadowMapExtent;
+uniform float u_CloudShadowMapPlaneHeight;
+uniform int   u_RowOffset;
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Keep in sync with cloud_shadow_map_texel_position() in cloud_shadow_map.cpp.
+vec3 cloud_shadow_map_texel_position(ivec2 texel, ivec2 size)
+{
+    vec2 xz = u_CloudShadowMapOrigin + ((vec2(texel) + 0.5f) / vec2(size) - 0.5f) * u_CloudShadowMapExtent;
+
+    return vec3(xz.x, u_CloudShadowMapPlaneHeight, xz.y);
+}
+
+// ------------------------------------------------------------------
+
+// Distance from a point inside the sphere to where the ray leaves it.
+float ray_sphere_exit(vec3 origin, vec3 direction, float radius)
+{
+    vec3  l = origin - u_PlanetCenter;
+    float b = dot(direction, l);
+    float c = dot(l, l) - radius * radius;
+
+    return -b + sqrt(max(b * b - c, 0.0f));
+}
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+void main()
+{
+    ivec2 size  = imageSize(i_CloudShadowMap);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy) + ivec2(0, u_RowOffset);
+
+    if (any(greaterThanEqual(texel, size)))
+        return;
+
+    vec3  origin = cloud_shadow_map_texel_position(texel, size);
+    float start  = ray_sphere_exit(origin, u_SunDir, u_PlanetRadius + u_CloudMinHeight);
+    float end    = ray_sphere_exit(origin, u_SunDir, u_PlanetRadius + u_CloudMaxHeight);
+    float step   = (end - start) / float(NUM_SHADOW_STEPS);
+
+    float optical_depth = 0.0f;
+
+    // Base shape only, the detail noise erodes edges that are far below the resolution of the map.
+    for (int i = 0; i < NUM_SHADOW_STEPS; i++)
+    {
+        vec3 position = origin + u_SunDir * (start + (float(i) + 0.5f) * step);
+
+        optical_depth += sample_cloud_density(position, height_fraction_for_point(position), 1.0f, false) * step;
+    }
+
+    imageStore(i_CloudShadowMap, texel, vec4(optical_depth));
+}
+
+// ------------------------------------------------------------------
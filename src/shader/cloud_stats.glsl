@@ -0,0 +1,69 @@
+// Work counters of the cloud march, compiled in by the CLOUD_STATS define of the instrumented variants and to nothing otherwise. Keep
+// in sync with cloud_stats.h.
+
+#define CLOUD_STATS_STEPS 0
+#define CLOUD_STATS_DENSITY_FETCHES 1
+#define CLOUD_STATS_DETAIL_FETCHES 2
+#define CLOUD_STATS_LIGHT_SAMPLES 3
+
+#ifdef CLOUD_STATS
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Counters of every marched pixel, one channel per counter.
+layout(binding = 1, rgba32ui) uniform writeonly uimage2D i_CloudStats;
+
+// Matches CloudStatsTotals.
+layout(std430, binding = 1) buffer CloudStats
+{
+    uint stats_counters[4];
+    uint stats_occupied_steps;
+    uint stats_marched_pixels;
+    uint stats_padding[2];
+};
+
+// 0 for the passes that share the program but are not part of the view, like the cloud probe.
+uniform int u_CloudStatsWrite;
+
+// ------------------------------------------------------------------
+// GLOBALS ----------------------------------------------------------
+// ------------------------------------------------------------------
+
+uvec4 g_CloudStats         = uvec4(0);
+uint  g_CloudStatsOccupied = 0u;
+
+#define CLOUD_STATS_ADD(_counter, _count) g_CloudStats[_counter] += uint(_count)
+#define CLOUD_STATS_OCCUPIED() g_CloudStatsOccupied++
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+void cloud_stats_write(vec2 _pixel)
+{
+    if (u_CloudStatsWrite == 0)
+        return;
+
+    imageStore(i_CloudStats, ivec2(_pixel), g_CloudStats);
+
+    for (int i = 0; i < 4; i++)
+        atomicAdd(stats_counters[i], g_CloudStats[i]);
+
+    atomicAdd(stats_occupied_steps, g_CloudStatsOccupied);
+    atomicAdd(stats_marched_pixels, 1u);
+}
+
+#else
+
+#define CLOUD_STATS_ADD(_counter, _count)
+#define CLOUD_STATS_OCCUPIED()
+
+void cloud_stats_write(vec2 _pixel)
+{
+}
+
+#endif
+
+// ------------------------------------------------------------------
@@ -0,0 +1,50 @@
+// ------------------------------------------------------------------
+// OUTPUT VARIABLES  ------------------------------------------------
+// ------------------------------------------------------------------
+
+out vec3 FS_OUT_Color;
+
+// ------------------------------------------------------------------
+// INPUT VARIABLES  -------------------------------------------------
+// ------------------------------------------------------------------
+
+in vec2 FS_IN_TexCoord;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Per-pixel counters written by the instrumented cloud programs, see cloud_stats.glsl.
+uniform usampler2D s_CloudStats;
+
+uniform int   u_Counter;
+uniform float u_MaxValue;
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Blue through cyan, green and yellow to red.
+vec3 heatmap(float _t)
+{
+    const vec3 colors[5] = { vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 1.0f, 1.0f), vec3(0.0f, 1.0f, 0.0f), vec3(1.0f, 1.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f) };
+
+    float x = clamp(_t, 0.0f, 1.0f) * 4.0f;
+    int   i = min(int(x), 3);
+
+    return mix(colors[i], colors[i + 1], x - float(i));
+}
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Pixels that were not marched this frame stay black. The temporal and reduced resolution paths only march some of the pixels.
+void main()
+{
+    uint count = texelFetch(s_CloudStats, ivec2(gl_FragCoord.xy), 0)[u_Counter];
+
+    FS_OUT_Color = count == 0u ? vec3(0.0f) : heatmap(float(count) / u_MaxValue);
+}
+
+// ------------------------------------------------------------------
@@ -0,0 +1,43 @@
+#include <cloud_march.glsl>
+#include <cloud_tiles.glsl>
+
+// ------------------------------------------------------------------
+// SHARED -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+shared uint g_NeedsMarch;
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+// One work group per tile. Tiles where no pixel needs a march are finished here, the others are appended to the tile list.
+void main()
+{
+    ivec2 target_pixel = ivec2(gl_GlobalInvocationID.xy);
+    bool  inside       = all(lessThan(target_pixel, imageSize(i_Clouds)));
+    vec2  pixel        = cloud_target_pixel_coord(target_pixel);
+
+    if (gl_LocalInvocationIndex == 0)
+        g_NeedsMarch = 0;
+
+    barrier();
+
+    if (inside && cloud_pixel_needs_march(pixel))
+        atomicOr(g_NeedsMarch, 1);
+
+    barrier();
+
+    if (g_NeedsMarch == 0)
+    {
+        if (inside)
+            write_cloud_pixel(target_pixel, pixel, empty_cloud_pixel(pixel));
+    }
+    else if (gl_LocalInvocationIndex == 0)
+    {
+        uint index   = atomicAdd(num_groups_x, 1);
+        tiles[index] = cloud_tile_pack(gl_WorkGroupID.xy);
+    }
+}
+
+// ------------------------------------------------------------------
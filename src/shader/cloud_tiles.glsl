@@ -0,0 +1,77 @@
+// Shared by the two passes of the tiled compute path: cloud_tile_classify_cs.glsl and clouds_cs.glsl. Keep in sync with
+// cloud_tiles.h.
+
+#define CLOUD_TILE_SIZE 16
+
+// ------------------------------------------------------------------
+// INPUTS -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(local_size_x = CLOUD_TILE_SIZE, local_size_y = CLOUD_TILE_SIZE, local_size_z = 1) in;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Matches CloudTileHeader followed by the tile list. The classification appends every tile that needs a march and counts them in
+// num_groups_x, so the header doubles as the arguments of glDispatchComputeIndirect().
+layout(std430, binding = 0) buffer CloudTiles
+{
+    uint num_groups_x;
+    uint num_groups_y;
+    uint num_groups_z;
+    uint padding;
+    uint tiles[];
+};
+
+// The quarter resolution clouds in temporal mode, otherwise the HDR scene the clouds are blended over.
+layout(binding = 0, rgba16f) uniform image2D i_Clouds;
+
+uniform int u_BlendOverScene;
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Keep in sync with cloud_tile_pack() in cloud_tiles.cpp.
+uint cloud_tile_pack(uvec2 tile)
+{
+    return tile.x | (tile.y << 16);
+}
+
+// ------------------------------------------------------------------
+
+uvec2 cloud_tile_unpack(uint tile)
+{
+    return uvec2(tile & 0xffff, tile >> 16);
+}
+
+// ------------------------------------------------------------------
+
+// Full resolution pixel shaded by 'target_pixel' of i_Clouds, as pixel_coord() in clouds_fs.glsl.
+vec2 cloud_target_pixel_coord(ivec2 target_pixel)
+{
+    return vec2(target_pixel) * u_PixelStride + u_PixelOffset;
+}
+
+// ------------------------------------------------------------------
+
+// Writes the premultiplied 'color' the way the full-screen pass writes it: as is in temporal mode, otherwise blended over the scene
+// with the depth test of begin_cloud_composite().
+void write_cloud_pixel(ivec2 target_pixel, vec2 pixel, vec4 color)
+{
+    if (u_BlendOverScene == 0)
+    {
+        imageStore(i_Clouds, target_pixel, color);
+        return;
+    }
+
+    if (u_DepthClipping == 0 && texelFetch(s_Depth, ivec2(pixel), 0).r < 1.0f)
+        return;
+
+    vec4 scene = imageLoad(i_Clouds, target_pixel);
+
+    imageStore(i_Clouds, target_pixel, vec4(color.rgb + (1.0f - color.a) * scene.rgb, scene.a));
+}
+
+// ------------------------------------------------------------------
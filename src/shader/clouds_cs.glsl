@@ -0,0 +1,32 @@
+#include <cloud_march.glsl>
+#include <cloud_tiles.glsl>
+
+// ------------------------------------------------------------------
+// SHARED -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+shared uvec2 g_Tile;
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Dispatched indirectly with one work group per tile appended by cloud_tile_classify_cs.glsl.
+void main()
+{
+    if (gl_LocalInvocationIndex == 0)
+        g_Tile = cloud_tile_unpack(tiles[gl_WorkGroupID.x]);
+
+    barrier();
+
+    ivec2 target_pixel = ivec2(g_Tile * CLOUD_TILE_SIZE + gl_LocalInvocationID.xy);
+
+    if (any(greaterThanEqual(target_pixel, imageSize(i_Clouds))))
+        return;
+
+    vec2 pixel = cloud_target_pixel_coord(target_pixel);
+
+    write_cloud_pixel(target_pixel, pixel, shade_cloud_pixel(pixel));
+}
+
+// ------------------------------------------------------------------
@@ -0,0 +1,155 @@
+// ------------------------------------------------------------------
+// OUTPUT VARIABLES  ------------------------------------------------
+// ------------------------------------------------------------------
+
+out vec4 FS_OUT_Color;
+
+// ------------------------------------------------------------------
+// INPUT VARIABLES  -------------------------------------------------
+// ------------------------------------------------------------------
+
+in vec2 FS_IN_TexCoord;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(std140, binding = 0) uniform GlobalUniforms
+{
+    mat4 view_proj;
+    mat4 prev_view_proj;
+    mat4 inv_view_proj;
+    vec4 cam_pos;
+};
+
+uniform sampler2D s_CurrentClouds;
+uniform sampler2D s_HistoryClouds;
+uniform sampler2D s_Depth;
+
+uniform vec2  u_PixelOffset;
+uniform int   u_HistoryValid;
+uniform vec3  u_PlanetCenter;
+uniform float u_PlanetRadius;
+uniform float u_CloudMinHeight;
+uniform float u_CloudMaxHeight;
+uniform vec3  u_CloudAdvection;
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Distance along the ray to the cloud layer, used as the depth of the pixel for reprojection. The nearest crossing in front of the
+// camera is taken, so a camera above the base looking down hits the near side. Rays that never reach the base fall back to the
+// thickness of the layer. Mirrored by temporal_cloud_layer_distance().
+float distance_to_cloud_layer(vec3 _origin, vec3 _direction)
+{
+    vec3  l = _origin - u_PlanetCenter;
+    float b = dot(_direction, l);
+    float c = dot(l, l) - pow(u_PlanetRadius + u_CloudMinHeight, 2);
+    float D = b * b - c;
+
+    if (D < 0.0)
+        return u_CloudMaxHeight - u_CloudMinHeight;
+
+    float s = sqrt(D);
+    float t = (-b - s > 0.0) ? -b - s : -b + s;
+
+    if (t < 0.0)
+        return u_CloudMaxHeight - u_CloudMinHeight;
+
+    return t;
+}
+
+// ------------------------------------------------------------------
+
+// Returns true and writes the previous frame texture coordinate if the point was visible last frame.
+bool reproject(vec3 _world_pos, out vec2 _uv)
+{
+    vec4 clip_pos = prev_view_proj * vec4(_world_pos, 1.0f);
+
+    if (clip_pos.w <= 0.0f)
+        return false;
+
+    _uv = (clip_pos.xy / clip_pos.w) * 0.5f + 0.5f;
+
+    return all(greaterThanEqual(_uv, vec2(0.0f))) && all(lessThanEqual(_uv, vec2(1.0f)));
+}
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+void main()
+{
+    ivec2 pixel        = ivec2(gl_FragCoord.xy);
+    ivec2 block        = pixel / 4;
+    ivec2 lowres_size  = textureSize(s_CurrentClouds, 0);
+    vec4  current      = texelFetch(s_CurrentClouds, block, 0);
+
+    // This pixel was ray marched this frame.
+    if (all(equal(pixel % 4, ivec2(u_PixelOffset))))
+    {
+        FS_OUT_Color = current;
+        return;
+    }
+
+    // Upsampled current frame, used whenever the history has to be rejected. Texel t holds pixel 4t + u_PixelOffset, so the lookup is
+    // shifted to that pixel rather than the centre of the block. Mirrored by temporal_upsample_uv().
+    vec2 upsampled_uv = (gl_FragCoord.xy - 0.5f - u_PixelOffset + 2.0f) / (4.0f * vec2(lowres_size));
+    vec4 upsampled    = texture(s_CurrentClouds, upsampled_uv);
+
+    if (u_HistoryValid == 0)
+    {
+        FS_OUT_Color = upsampled;
+        return;
+    }
+
+    // Reconstruct the world position of the clouds seen through this pixel.
+    vec4 target = inv_view_proj * vec4(FS_IN_TexCoord * 2.0f - 1.0f, 0.0f, 1.0f);
+    target /= target.w;
+
+    vec3 direction = normalize(target.xyz - cam_pos.xyz);
+    vec3 world_pos = cam_pos.xyz + direction * distance_to_cloud_layer(cam_pos.xyz, direction);
+
+    // Clouds clipped by the scene are anchored to the geometry in front of them.
+    float depth = texelFetch(s_Depth, pixel, 0).r;
+
+    if (depth < 1.0f)
+    {
+        vec4 scene_pos = inv_view_proj * vec4(vec3(FS_IN_TexCoord, depth) * 2.0f - 1.0f, 1.0f);
+        scene_pos /= scene_pos.w;
+
+        if (distance(scene_pos.xyz, cam_pos.xyz) < distance(world_pos, cam_pos.xyz))
+            world_pos = scene_pos.xyz;
+    }
+
+    // Move the point to where the clouds were on the previous frame.
+    vec2 history_uv;
+
+    if (!reproject(world_pos + u_CloudAdvection, history_uv))
+    {
+        FS_OUT_Color = upsampled;
+        return;
+    }
+
+    vec4 history = texture(s_HistoryClouds, history_uv);
+
+    // Clamp the history to the neighbourhood of the freshly marched pixels to reject stale data.
+    vec4 neighbourhood_min = current;
+    vec4 neighbourhood_max = current;
+
+    for (int y = -1; y <= 1; y++)
+    {
+        for (int x = -1; x <= 1; x++)
+        {
+            vec4 c = texelFetch(s_CurrentClouds, clamp(block + ivec2(x, y), ivec2(0), lowres_size - 1), 0);
+
+            neighbourhood_min = min(neighbourhood_min, c);
+            neighbourhood_max = max(neighbourhood_max, c);
+        }
+    }
+
+    FS_OUT_Color = clamp(history, neighbourhood_min, neighbourhood_max);
+}
+
+// ------------------------------------------------------------------
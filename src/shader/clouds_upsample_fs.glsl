@@ -0,0 +1,70 @@
+// ------------------------------------------------------------------
+// OUTPUT VARIABLES  ------------------------------------------------
+// ------------------------------------------------------------------
+
+out vec4 FS_OUT_Color;
+
+// ------------------------------------------------------------------
+// INPUT VARIABLES  -------------------------------------------------
+// ------------------------------------------------------------------
+
+in vec2 FS_IN_TexCoord;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Clouds rendered at a reduced resolution, texel t shading full resolution pixel t * u_PixelStride + u_PixelOffset.
+uniform sampler2D s_Clouds;
+uniform sampler2D s_Depth;
+
+uniform float u_PixelStride;
+uniform vec2  u_PixelOffset;
+uniform vec2  u_NearFar;
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+float linear_depth(ivec2 _pixel)
+{
+    float z = texelFetch(s_Depth, _pixel, 0).r * 2.0f - 1.0f;
+
+    return 2.0f * u_NearFar.x * u_NearFar.y / (u_NearFar.y + u_NearFar.x - z * (u_NearFar.y - u_NearFar.x));
+}
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Bilinear upsample whose weights fall off with the difference between the depth of the pixel and the depth each low resolution texel
+// was shaded at, so that the clouds do not bleed across the edges of the scene geometry.
+void main()
+{
+    ivec2 pixel     = ivec2(gl_FragCoord.xy);
+    ivec2 size      = textureSize(s_Clouds, 0);
+    ivec2 full_size = textureSize(s_Depth, 0);
+    vec2  position  = (vec2(pixel) - u_PixelOffset) / u_PixelStride;
+    ivec2 base      = ivec2(floor(position));
+    vec2  f         = position - vec2(base);
+    float depth     = linear_depth(pixel);
+
+    vec4  color        = vec4(0.0f);
+    float total_weight = 0.0f;
+
+    for (int i = 0; i < 4; i++)
+    {
+        ivec2 offset   = ivec2(i & 1, i >> 1);
+        ivec2 texel    = clamp(base + offset, ivec2(0), size - 1);
+        ivec2 shaded   = clamp(ivec2(vec2(texel) * u_PixelStride + u_PixelOffset), ivec2(0), full_size - 1);
+        vec2  bilinear = mix(vec2(1.0f) - f, f, vec2(offset));
+        float weight   = bilinear.x * bilinear.y / (abs(linear_depth(shaded) - depth) / depth + 0.001f);
+
+        color += texelFetch(s_Clouds, texel, 0) * weight;
+        total_weight += weight;
+    }
+
+    FS_OUT_Color = color / total_weight;
+}
+
+// ------------------------------------------------------------------
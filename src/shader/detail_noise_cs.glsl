@@ -12,7 +12,9 @@ layout(local_size_x = 8, local_size_y = 8, local_size_z = 8) in;
 
 layout(binding = 0, rgba16f) uniform image3D i_Noise;
 
-uniform int u_Size;
+uniform int   u_Size;
+uniform float u_Frequency;
+uniform int   u_SliceOffset; // First z-slice of the dispatch, see noise_regenerator.h.
 
 // ------------------------------------------------------------------
 // MAIN -------------------------------------------------------------
@@ -20,9 +22,10 @@ uniform int u_Size;
 
 void main()
 {
-    vec3 tex_coord = (vec3(gl_GlobalInvocationID) + vec3(0.5f)) / float(u_Size);
+    ivec3 texel     = ivec3(gl_GlobalInvocationID) + ivec3(0, 0, u_SliceOffset);
+    vec3  tex_coord = (vec3(texel) + vec3(0.5f)) / float(u_Size);
 
-    float freq = 8.0f;
+    float freq = u_Frequency;
 
     float worley0 = worley_fbm(tex_coord, freq);
     float worley1 = worley_fbm(tex_coord, freq * 2.0f);
@@ -30,7 +33,7 @@ void main()
  
     vec4 worley = vec4(worley0, worley1, worley2, 0.0f); 
     
-    imageStore(i_Noise, ivec3(gl_GlobalInvocationID), worley);
+    imageStore(i_Noise, texel, worley);
 }
 
 // ------------------------------------------------------------------
\ No newline at end of file
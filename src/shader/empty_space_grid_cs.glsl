@@ -0,0 +1,61 @@
+// ------------------------------------------------------------------
+// INPUTS -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(binding = 0, r32f) uniform image3D i_EmptySpaceGrid;
+
+uniform sampler3D s_ShapeNoise;
+
+uniform int u_CellSize;
+uniform int u_GridSize;
+uniform int u_FoldedNoise; // The red channel already holds the base cloud shape, see noise_format.h.
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Keep in sync with empty_space_base_cloud() in empty_space_grid.cpp.
+float base_cloud(vec4 texel)
+{
+    if (u_FoldedNoise == 1)
+        return texel.r;
+
+    float worley_fbm = (texel.g * 0.625f) + (texel.b * 0.25f) + (texel.a * 0.125f);
+
+    if (worley_fbm <= 0.0f)
+        return 2.0f;
+
+    return 1.0f - (1.0f - texel.r) / worley_fbm;
+}
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+void main()
+{
+    ivec3 cell  = ivec3(gl_GlobalInvocationID);
+    int   size  = u_GridSize * u_CellSize;
+    float bound = 0.0f;
+
+    // Samples inside the cell read one extra texel on each side, and the second texel covers rays bent by the wind shear. The base
+    // cloud is quasi-convex in the texel values, so the largest texel value bounds every trilinear sample in between.
+    for (int z = cell.z * u_CellSize - 2; z <= (cell.z + 1) * u_CellSize + 1; z++)
+    {
+        for (int y = cell.y * u_CellSize - 2; y <= (cell.y + 1) * u_CellSize + 1; y++)
+        {
+            for (int x = cell.x * u_CellSize - 2; x <= (cell.x + 1) * u_CellSize + 1; x++)
+                bound = max(bound, base_cloud(texelFetch(s_ShapeNoise, (ivec3(x, y, z) + size) % size, 0)));
+        }
+    }
+
+    imageStore(i_EmptySpaceGrid, cell, vec4(bound + 0.001f));
+}
+
+// ------------------------------------------------------------------
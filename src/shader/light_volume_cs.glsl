@@ -0,0 +1,52 @@
+#include <cloud_density.glsl>
+
+// ------------------------------------------------------------------
+// INPUTS -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(binding = 0, r16f) uniform image3D i_LightVolume;
+
+uniform vec3  u_LightVolumeOrigin;
+uniform float u_LightVolumeExtent;
+uniform int   u_SliceOffset;
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Keep in sync with light_volume_texel_position() in light_volume.cpp.
+vec3 light_volume_texel_position(ivec3 texel, ivec3 size)
+{
+    vec2  xz     = u_LightVolumeOrigin.xz + ((vec2(texel.xy) + 0.5f) / vec2(size.xy) - 0.5f) * u_LightVolumeExtent;
+    float radius = u_PlanetRadius + u_CloudMinHeight + (float(texel.z) + 0.5f) / float(size.z) * (u_CloudMaxHeight - u_CloudMinHeight);
+    vec2  offset = xz - u_PlanetCenter.xz;
+    float y      = u_PlanetCenter.y + sqrt(max(radius * radius - dot(offset, offset), 0.0f));
+
+    return vec3(xz.x, y, xz.y);
+}
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+void main()
+{
+    ivec3 size  = imageSize(i_LightVolume);
+    ivec3 texel = ivec3(gl_GlobalInvocationID) + ivec3(0, 0, u_SliceOffset);
+
+    if (any(greaterThanEqual(texel, size)))
+        return;
+
+    // u_Time is the time the volume is built for, it stays the same for every slice of a rebuild.
+    float cone_density = sample_cloud_density_along_cone(light_volume_texel_position(texel, size), u_SunDir);
+
+    imageStore(i_LightVolume, texel, vec4(cone_density));
+}
+
+// ------------------------------------------------------------------
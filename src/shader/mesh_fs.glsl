@@ -20,6 +20,7 @@ in vec4 FS_IN_NDCFragPos;
 layout(std140, binding = 0) uniform GlobalUniforms
 {
     mat4 view_proj;
+    mat4 prev_view_proj;
     mat4 inv_view_proj;
     vec4 cam_pos;
 };
@@ -27,6 +28,45 @@ layout(std140, binding = 0) uniform GlobalUniforms
 uniform sampler2D s_Diffuse;
 uniform vec3      u_LightDirection;
 
+// Cloud optical depth along the sun direction, see cloud_shadow_map_cs.glsl.
+uniform sampler2D s_CloudShadowMap;
+uniform int       u_CloudShadows;
+uniform vec2      u_CloudShadowMapOrigin;
+uniform float     u_CloudShadowMapExtent;
+uniform float     u_CloudShadowMapPlaneHeight;
+uniform vec2      u_CloudShadowMapOffset; // Wind advection since the map was built.
+uniform float     u_CloudShadowDensityScale;
+
+// Sky and clouds around the camera, see cloud_probe.h. 0 ambient disables the lookup.
+uniform samplerCube s_CloudProbe;
+uniform float       u_CloudProbeAmbient;
+uniform float       u_CloudProbeLod;
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Keep in sync with cloud_shadow_map_uv() in cloud_shadow_map.cpp.
+vec2 cloud_shadow_map_uv(vec3 position, vec3 sun_dir)
+{
+    float t  = (u_CloudShadowMapPlaneHeight - position.y) / max(sun_dir.y, 1e-4f);
+    vec2  xz = position.xz + sun_dir.xz * t;
+
+    return (xz - u_CloudShadowMapOrigin) / u_CloudShadowMapExtent + 0.5f;
+}
+
+// ------------------------------------------------------------------
+
+float cloud_shadow(vec3 position, vec3 sun_dir)
+{
+    if (u_CloudShadows == 0)
+        return 1.0f;
+
+    vec2 uv = cloud_shadow_map_uv(position + vec3(u_CloudShadowMapOffset.x, 0.0f, u_CloudShadowMapOffset.y), sun_dir);
+
+    return exp(-textureLod(s_CloudShadowMap, uv, 0.0f).r * u_CloudShadowDensityScale);
+}
+
 // ------------------------------------------------------------------
 // MAIN -------------------------------------------------------------
 // ------------------------------------------------------------------
@@ -37,7 +77,10 @@ void main()
     vec3 N      = normalize(FS_IN_Normal);
     vec3 L      = -u_LightDirection; // FragPos -> LightPos vector
 
-    FS_OUT_Color = albedo * clamp(dot(N, L), 0.0, 1.0);
+    FS_OUT_Color = albedo * clamp(dot(N, L), 0.0, 1.0) * cloud_shadow(FS_IN_WorldPos, L);
+
+    if (u_CloudProbeAmbient > 0.0f)
+        FS_OUT_Color += albedo * textureLod(s_CloudProbe, N, u_CloudProbeLod).rgb * u_CloudProbeAmbient;
 }
 
 // ------------------------------------------------------------------
\ No newline at end of file
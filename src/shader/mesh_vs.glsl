@@ -24,6 +24,7 @@ out vec4 FS_IN_NDCFragPos;
 layout(std140, binding = 0) uniform GlobalUniforms
 {
     mat4 view_proj;
+    mat4 prev_view_proj;
     mat4 inv_view_proj;
     vec4 cam_pos;
 };
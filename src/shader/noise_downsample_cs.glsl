@@ -0,0 +1,41 @@
+// ------------------------------------------------------------------
+// INPUTS -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(local_size_x = 4, local_size_y = 4, local_size_z = 4) in;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(binding = 0, rgba16f) uniform writeonly image3D i_Mip;
+
+// The same texture, read one level above the one i_Mip writes to.
+uniform sampler3D s_Noise;
+
+uniform int u_SourceMip;
+uniform int u_SliceOffset;
+uniform int u_SliceCount;
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Box filters a range of z-slices of a mip of a noise volume, as glGenerateMipmap() but only over the slices whose sources are
+// finished, see noise_regenerator.h. Keep in sync with noise_downsample_slices() in noise_regenerator.cpp.
+void main()
+{
+    ivec3 texel = ivec3(gl_GlobalInvocationID) + ivec3(0, 0, u_SliceOffset);
+
+    if (any(greaterThanEqual(texel, imageSize(i_Mip))) || texel.z >= u_SliceOffset + u_SliceCount)
+        return;
+
+    vec4 sum = vec4(0.0f);
+
+    for (int i = 0; i < 8; i++)
+        sum += texelFetch(s_Noise, texel * 2 + ivec3(i & 1, (i >> 1) & 1, (i >> 2) & 1), u_SourceMip);
+
+    imageStore(i_Mip, texel, sum * 0.125f);
+}
+
+// ------------------------------------------------------------------
@@ -0,0 +1,29 @@
+// Lat-long parameterization of the sky-view LUT, see sky_view_lut.h.
+
+#define SKY_VIEW_LUT_PI 3.14159265359
+
+// ------------------------------------------------------------------
+
+// Keep in sync with sky_view_lut_uv() in sky_view_lut.cpp.
+vec2 sky_view_lut_uv(vec3 direction, ivec2 size)
+{
+    float azimuth   = atan(direction.z, direction.x);
+    float elevation = asin(clamp(direction.y, 0.0f, 1.0f));
+    float v         = sqrt(elevation / (SKY_VIEW_LUT_PI * 0.5f));
+
+    return vec2(azimuth / (2.0f * SKY_VIEW_LUT_PI) + 0.5f, (0.5f + v * float(size.y - 1)) / float(size.y));
+}
+
+// ------------------------------------------------------------------
+
+// Keep in sync with sky_view_lut_direction() in sky_view_lut.cpp.
+vec3 sky_view_lut_direction(ivec2 texel, ivec2 size)
+{
+    float azimuth   = ((float(texel.x) + 0.5f) / float(size.x) - 0.5f) * 2.0f * SKY_VIEW_LUT_PI;
+    float v         = float(texel.y) / float(size.y - 1);
+    float elevation = v * v * SKY_VIEW_LUT_PI * 0.5f;
+
+    return vec3(cos(elevation) * cos(azimuth), sin(elevation), cos(elevation) * sin(azimuth));
+}
+
+// ------------------------------------------------------------------
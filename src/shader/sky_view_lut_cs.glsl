@@ -0,0 +1,36 @@
+#include <atmosphere.glsl>
+#include <sky_view_lut.glsl>
+
+// ------------------------------------------------------------------
+// INPUTS -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(binding = 0, rgba16f) uniform image2D i_SkyViewLUT;
+
+uniform vec3  u_SunDir;
+uniform float u_Turbidity;
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+void main()
+{
+    ivec2 size  = imageSize(i_SkyViewLUT);
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+
+    if (any(greaterThanEqual(texel, size)))
+        return;
+
+    vec3 sky = calculate_sky_luminance_rgb(u_SunDir, sky_view_lut_direction(texel, size), u_Turbidity);
+
+    imageStore(i_SkyViewLUT, texel, vec4(sky, 1.0f));
+}
+
+// ------------------------------------------------------------------
@@ -0,0 +1,59 @@
+#include <auto_exposure.glsl>
+#include <tonemap.glsl>
+
+// ------------------------------------------------------------------
+// INPUTS -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(local_size_x = 16, local_size_y = 16, local_size_z = 1) in;
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+layout(binding = 0, rgba8) uniform writeonly image2D i_LDR;
+
+uniform sampler2D s_HDR;
+
+// Applies the exposure auto_exposure_cs.glsl derived from the previous frame instead of u_Exposure.
+uniform int   u_AutoExposure;
+uniform float u_Exposure;
+
+// ------------------------------------------------------------------
+// SHARED -----------------------------------------------------------
+// ------------------------------------------------------------------
+
+shared uint g_Histogram[AUTO_EXPOSURE_HISTOGRAM_BINS];
+
+// ------------------------------------------------------------------
+// MAIN -------------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Tone maps one pixel per thread and adds it to the luminance histogram, so that auto exposure reads the HDR image once along with the
+// tone mapping. The work group counts its pixels in shared memory first and only adds its non-empty bins to the buffer.
+void main()
+{
+    ivec2 pixel  = ivec2(gl_GlobalInvocationID.xy);
+    bool  inside = all(lessThan(pixel, imageSize(i_LDR)));
+
+    if (gl_LocalInvocationIndex < AUTO_EXPOSURE_HISTOGRAM_BINS)
+        g_Histogram[gl_LocalInvocationIndex] = 0u;
+
+    barrier();
+
+    if (inside)
+    {
+        vec3 color = texelFetch(s_HDR, pixel, 0).rgb;
+
+        atomicAdd(g_Histogram[auto_exposure_bin(color)], 1u);
+
+        imageStore(i_LDR, pixel, vec4(aces_film(color * (u_AutoExposure != 0 ? exposure : u_Exposure)), 1.0f));
+    }
+
+    barrier();
+
+    if (gl_LocalInvocationIndex < AUTO_EXPOSURE_HISTOGRAM_BINS && g_Histogram[gl_LocalInvocationIndex] > 0)
+        atomicAdd(histogram[gl_LocalInvocationIndex], g_Histogram[gl_LocalInvocationIndex]);
+}
+
+// ------------------------------------------------------------------
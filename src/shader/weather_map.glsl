@@ -0,0 +1,97 @@
+// Streamed weather map, see weather_map.h. Included by cloud_density.glsl after the CloudUniforms block.
+
+// Keep in sync with weather_map.h.
+#define WEATHER_TILE_SIZE 32
+#define WEATHER_WINDOW_TILES 7
+#define WEATHER_ATLAS_TILES 8
+
+// Density multiplier of fully raining clouds.
+#define WEATHER_PRECIPITATION_DENSITY 1.5f
+
+// ------------------------------------------------------------------
+// STRUCTURES -------------------------------------------------------
+// ------------------------------------------------------------------
+
+struct Weather
+{
+    float coverage;
+    float cloud_type;
+    float precipitation;
+};
+
+// ------------------------------------------------------------------
+// UNIFORMS ---------------------------------------------------------
+// ------------------------------------------------------------------
+
+uniform sampler2D  s_WeatherAtlas;
+uniform usampler2D s_WeatherIndirection;
+
+uniform vec2  u_WeatherMapOrigin;
+uniform float u_WeatherTexelSize;
+uniform vec2  u_WeatherWindowOrigin; // Integer tile, a vec2 as the framework has no ivec2 setter.
+
+// Smallest coverage of the resident tiles, the empty space skipping can only skip what is empty at every coverage in view.
+uniform float u_WeatherMinCoverage;
+
+// ------------------------------------------------------------------
+// FUNCTIONS --------------------------------------------------------
+// ------------------------------------------------------------------
+
+// Weight of the map against the global parameters at '_texel' (in texels from the corner of the window), falls to 0 over the outer
+// tile of the window. Keep in sync with weather_map_window_fade() in weather_map.cpp.
+float weather_window_fade(vec2 _texel)
+{
+    vec2 edge = min(_texel, vec2(float(WEATHER_WINDOW_TILES * WEATHER_TILE_SIZE)) - _texel) / float(WEATHER_TILE_SIZE);
+
+    return clamp(min(edge.x, edge.y), 0.0f, 1.0f);
+}
+
+// ------------------------------------------------------------------
+
+// Weather at world position '_position', the global parameters where no tile is resident and blended towards them at the edge of the
+// window. Keep in sync with CloudReference::sample_weather().
+Weather sample_weather(vec3 _position)
+{
+    Weather weather;
+
+    weather.coverage      = u_CloudCoverage;
+    weather.cloud_type    = 1.0f;
+    weather.precipitation = 0.0f;
+
+    if (u_WeatherMap == 0)
+        return weather;
+
+    vec2  texel = (_position.xz - u_WeatherMapOrigin) / u_WeatherTexelSize;
+    ivec2 tile  = ivec2(floor(texel / float(WEATHER_TILE_SIZE)));
+    ivec2 cell  = tile - ivec2(u_WeatherWindowOrigin);
+
+    if (any(lessThan(cell, ivec2(0))) || any(greaterThanEqual(cell, ivec2(WEATHER_WINDOW_TILES))))
+        return weather;
+
+    uvec4 slot = texelFetch(s_WeatherIndirection, cell, 0);
+
+    if (slot.b == 0)
+        return weather;
+
+    // The slots have no border, stay half a texel inside so that the filter never reads the neighbouring slot.
+    vec2 local = clamp(texel - vec2(tile * WEATHER_TILE_SIZE), vec2(0.5f), vec2(WEATHER_TILE_SIZE - 0.5f));
+    vec4 value = textureLod(s_WeatherAtlas, (vec2(slot.xy) * float(WEATHER_TILE_SIZE) + local) / float(WEATHER_ATLAS_TILES * WEATHER_TILE_SIZE), 0.0f);
+
+    float fade = weather_window_fade(texel - u_WeatherWindowOrigin * float(WEATHER_TILE_SIZE));
+
+    weather.coverage      = mix(weather.coverage, value.r, fade);
+    weather.cloud_type    = mix(weather.cloud_type, value.g, fade);
+    weather.precipitation = mix(weather.precipitation, value.b, fade);
+
+    return weather;
+}
+
+// ------------------------------------------------------------------
+
+// Lower bound of the coverage of every sample, used to decide that a region is empty. The fade only blends towards u_CloudCoverage.
+float min_cloud_coverage()
+{
+    return u_WeatherMap == 1 ? min(u_CloudCoverage, u_WeatherMinCoverage) : u_CloudCoverage;
+}
+
+// ------------------------------------------------------------------
@@ -0,0 +1,409 @@
+#include "shader_program.h"
+#include "noise_cache.h"
+
+#include <stdio.h>
+#include <algorithm>
+
+// The shader files have no #version directive of their own.
+#define SHADER_VERSION_DIRECTIVE "#version 450 core\n"
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Name of the cache file of a program, after the files of its stages, e.g. "triangle_vs.clouds_fs.program". Variants add the key of
+// their defines, e.g. "triangle_vs.clouds_fs.1a2b3c4d5e6f7a8b.program".
+static std::string cache_path(const std::vector<ShaderStage>& stages, const ShaderDefines& defines)
+{
+    std::string path;
+
+    for (const auto& stage : stages)
+    {
+        size_t slash = stage.path.find_last_of("/\\");
+        size_t start = slash == std::string::npos ? 0 : slash + 1;
+        size_t dot   = stage.path.find_last_of('.');
+
+        path += stage.path.substr(start, dot == std::string::npos || dot < start ? std::string::npos : dot - start);
+        path += '.';
+    }
+
+    if (!defines.empty())
+    {
+        char key[17];
+        snprintf(key, sizeof(key), "%016llx", (unsigned long long)shader_defines_key(defines));
+
+        path += key;
+        path += '.';
+    }
+
+    return path + "program";
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool linked(GLuint program)
+{
+    GLint status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+
+    return status == GL_TRUE;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static GLuint compile(GLenum type, const std::string& path, const std::string& source)
+{
+    GLuint      shader     = glCreateShader(type);
+    const char* sources[2] = { SHADER_VERSION_DIRECTIVE, source.c_str() };
+
+    glShaderSource(shader, 2, sources, nullptr);
+    glCompileShader(shader);
+
+    GLint status = GL_FALSE;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+
+    if (status != GL_TRUE)
+    {
+        GLint length = 0;
+        glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+
+        std::string log(size_t(std::max(length, 1)), '\0');
+        glGetShaderInfoLog(shader, length, nullptr, &log[0]);
+
+        DW_LOG_ERROR("Failed to compile " + path + ":\n" + log);
+
+        glDeleteShader(shader);
+        return 0;
+    }
+
+    return shader;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+ShaderProgram::~ShaderProgram()
+{
+    if (m_id)
+        glDeleteProgram(m_id);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void ShaderProgram::use()
+{
+    glUseProgram(m_id);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+GLint ShaderProgram::location(const std::string& name)
+{
+    auto it = m_locations.find(name);
+
+    if (it != m_locations.end())
+        return it->second;
+
+    GLint location    = glGetUniformLocation(m_id, name.c_str());
+    m_locations[name] = location;
+
+    return location;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool ShaderProgram::set_uniform(const std::string& name, int value)
+{
+    GLint loc = location(name);
+
+    if (loc < 0)
+        return false;
+
+    glProgramUniform1i(m_id, loc, value);
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool ShaderProgram::set_uniform(const std::string& name, float value)
+{
+    GLint loc = location(name);
+
+    if (loc < 0)
+        return false;
+
+    glProgramUniform1f(m_id, loc, value);
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool ShaderProgram::set_uniform(const std::string& name, const glm::vec2& value)
+{
+    GLint loc = location(name);
+
+    if (loc < 0)
+        return false;
+
+    glProgramUniform2f(m_id, loc, value.x, value.y);
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool ShaderProgram::set_uniform(const std::string& name, const glm::vec3& value)
+{
+    GLint loc = location(name);
+
+    if (loc < 0)
+        return false;
+
+    glProgramUniform3f(m_id, loc, value.x, value.y, value.z);
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool ShaderProgram::set_uniform(const std::string& name, const glm::vec4& value)
+{
+    GLint loc = location(name);
+
+    if (loc < 0)
+        return false;
+
+    glProgramUniform4f(m_id, loc, value.x, value.y, value.z, value.w);
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool ShaderProgram::set_uniform(const std::string& name, const glm::mat4& value)
+{
+    GLint loc = location(name);
+
+    if (loc < 0)
+        return false;
+
+    glProgramUniformMatrix4fv(m_id, loc, 1, GL_FALSE, glm::value_ptr(value));
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void ShaderLibrary::create(bool use_cache)
+{
+    GLint num_formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats);
+
+    m_driver    = std::string((const char*)glGetString(GL_VENDOR)) + "\n" + (const char*)glGetString(GL_RENDERER) + "\n" + (const char*)glGetString(GL_VERSION);
+    m_use_cache = use_cache && num_formats > 0;
+    m_last_poll = std::chrono::high_resolution_clock::now();
+
+    if (use_cache && num_formats == 0)
+        DW_LOG_WARNING("The driver supports no program binary formats, shader programs are always compiled from source");
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+ShaderProgram::Ptr ShaderLibrary::load(const std::vector<ShaderStage>& stages, const ShaderDefines& defines)
+{
+    ShaderProgram::Ptr       program = std::make_shared<ShaderProgram>();
+    std::vector<std::string> files;
+
+    program->m_stages  = stages;
+    program->m_defines = defines;
+    program->m_id     = build(*program, files);
+
+    if (!program->m_id)
+        return nullptr;
+
+    m_include_graph.set_program(uint32_t(m_programs.size()), files, shader_file_time);
+    m_programs.push_back(program);
+
+    return program;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool ShaderLibrary::poll(std::vector<ShaderProgram*>& reloaded)
+{
+    auto now = std::chrono::high_resolution_clock::now();
+
+    reloaded.clear();
+
+    if (std::chrono::duration<double>(now - m_last_poll).count() < SHADER_POLL_INTERVAL)
+        return false;
+
+    m_last_poll = now;
+
+    std::vector<uint32_t> changed;
+    m_include_graph.poll(shader_file_time, changed);
+
+    for (uint32_t index : changed)
+    {
+        ShaderProgram&           program = *m_programs[index];
+        std::vector<std::string> files;
+        GLuint                   id = build(program, files);
+
+        if (!id)
+        {
+            DW_LOG_WARNING("Failed to reload " + cache_path(program.m_stages, program.m_defines) + ", keeping the previous program");
+            continue;
+        }
+
+        glDeleteProgram(program.m_id);
+
+        program.m_id = id;
+        program.m_locations.clear();
+
+        // The includes may have changed as well.
+        m_include_graph.set_program(index, files, shader_file_time);
+
+        DW_LOG_INFO("Reloaded " + cache_path(program.m_stages, program.m_defines));
+
+        reloaded.push_back(&program);
+    }
+
+    return !reloaded.empty();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+GLuint ShaderLibrary::build(const ShaderProgram& program, std::vector<std::string>& files)
+{
+    std::vector<std::string> sources;
+    std::string              defines = shader_defines_source(program.m_defines);
+
+    files.clear();
+
+    for (const auto& stage : program.m_stages)
+    {
+        std::string              source;
+        std::vector<std::string> stage_files;
+        std::string              error;
+
+        if (!shader_expand_includes(stage.path, shader_read_file, source, stage_files, error))
+        {
+            DW_LOG_ERROR(error);
+            return 0;
+        }
+
+        sources.push_back(defines + source);
+        files.insert(files.end(), stage_files.begin(), stage_files.end());
+    }
+
+    std::string path = cache_path(program.m_stages, program.m_defines);
+    uint64_t    key  = shader_program_key(sources, m_driver);
+    GLuint      id   = glCreateProgram();
+
+    if (m_use_cache)
+    {
+        NoiseCacheFile file;
+        uint32_t       binary_format = 0;
+        const uint8_t* binary        = nullptr;
+        size_t         binary_size   = 0;
+
+        // A driver update may still reject a binary it reports the same version for, which only costs the compile below.
+        if (file.open(path) && shader_cache_parse(file.data(), file.size(), key, binary_format, binary, binary_size))
+        {
+            glProgramBinary(id, binary_format, binary, GLsizei(binary_size));
+
+            if (linked(id))
+            {
+                m_cache_hits++;
+                return id;
+            }
+        }
+
+        glProgramParameteri(id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    m_cache_misses++;
+
+    std::vector<GLuint> shaders;
+
+    for (size_t i = 0; i < program.m_stages.size(); i++)
+    {
+        GLuint shader = compile(program.m_stages[i].type, program.m_stages[i].path, sources[i]);
+
+        if (shader)
+        {
+            glAttachShader(id, shader);
+            shaders.push_back(shader);
+        }
+    }
+
+    if (shaders.size() == program.m_stages.size())
+        glLinkProgram(id);
+
+    for (GLuint shader : shaders)
+    {
+        glDetachShader(id, shader);
+        glDeleteShader(shader);
+    }
+
+    if (shaders.size() != program.m_stages.size())
+    {
+        glDeleteProgram(id);
+        return 0;
+    }
+
+    if (!linked(id))
+    {
+        GLint length = 0;
+        glGetProgramiv(id, GL_INFO_LOG_LENGTH, &length);
+
+        std::string log(size_t(std::max(length, 1)), '\0');
+        glGetProgramInfoLog(id, length, nullptr, &log[0]);
+
+        DW_LOG_ERROR("Failed to link " + path + ":\n" + log);
+
+        glDeleteProgram(id);
+        return 0;
+    }
+
+    if (m_use_cache)
+    {
+        GLint length = 0;
+        glGetProgramiv(id, GL_PROGRAM_BINARY_LENGTH, &length);
+
+        std::vector<uint8_t> binary(size_t(std::max(length, 0)));
+        GLenum               binary_format = 0;
+
+        if (length > 0)
+            glGetProgramBinary(id, length, nullptr, &binary_format, binary.data());
+
+        if (binary.empty() || !shader_cache_write(path, key, binary_format, binary.data(), binary.size()))
+            DW_LOG_WARNING("Failed to write program cache: " + path);
+    }
+
+    return id;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void ShaderVariants::create(ShaderLibrary* library, const std::vector<ShaderStage>& stages)
+{
+    m_library = library;
+    m_stages  = stages;
+    m_variants.clear();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+ShaderProgram::Ptr ShaderVariants::get(const ShaderDefines& defines)
+{
+    uint64_t key = shader_defines_key(defines);
+    auto     it  = m_variants.find(key);
+
+    if (it != m_variants.end())
+        return it->second;
+
+    ShaderProgram::Ptr program = m_library->load(m_stages, defines);
+
+    if (!program)
+        DW_LOG_ERROR("Failed to build variant " + cache_path(m_stages, defines));
+
+    m_variants[key] = program;
+
+    return program;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
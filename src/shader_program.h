@@ -0,0 +1,112 @@
+#pragma once
+
+#include <ogl.h>
+#include <stdint.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "shader_source.h"
+
+// Shader programs built from include-expanded GLSL files, with their binaries cached on disk and hot reload. A program is looked up in
+// its cache file first, keyed by shader_program_key() over the expanded sources and the driver, and compiled and linked from source
+// only on a miss, after which its binary is written back. ShaderLibrary::poll() recompiles the programs whose files, includes
+// included, changed on disk. A program keeps its identity across reloads and keeps its previous binary if the new sources fail.
+// Variants of a program are built from the same stages with preprocessor defines injected, see shader_defines_source(), and are cached
+// and reloaded like any other program.
+
+// Every file a program depends on is checked at most this often.
+#define SHADER_POLL_INTERVAL 0.5
+
+struct ShaderStage
+{
+    GLenum      type;
+    std::string path;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+class ShaderProgram
+{
+public:
+    using Ptr = std::shared_ptr<ShaderProgram>;
+
+    ~ShaderProgram();
+
+    void use();
+
+    // Return false if the program has no active uniform 'name'.
+    bool set_uniform(const std::string& name, int value);
+    bool set_uniform(const std::string& name, float value);
+    bool set_uniform(const std::string& name, const glm::vec2& value);
+    bool set_uniform(const std::string& name, const glm::vec3& value);
+    bool set_uniform(const std::string& name, const glm::vec4& value);
+    bool set_uniform(const std::string& name, const glm::mat4& value);
+
+    inline GLuint id() const { return m_id; }
+
+private:
+    friend class ShaderLibrary;
+
+    GLint location(const std::string& name);
+
+    GLuint                                 m_id = 0;
+    std::vector<ShaderStage>               m_stages;
+    ShaderDefines                          m_defines;
+    std::unordered_map<std::string, GLint> m_locations;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+class ShaderLibrary
+{
+public:
+    // Must be called with the context current. Without 'use_cache', or if the driver has no program binary formats, every program
+    // is compiled from source.
+    void create(bool use_cache);
+
+    // Builds a program out of the given stages and defines, from the cache when possible. Returns null and logs the errors if it fails.
+    ShaderProgram::Ptr load(const std::vector<ShaderStage>& stages, const ShaderDefines& defines = ShaderDefines());
+
+    // Rebuilds the programs whose files changed since they were built and returns them in 'reloaded'. Returns false if nothing was
+    // reloaded.
+    bool poll(std::vector<ShaderProgram*>& reloaded);
+
+    inline uint32_t cache_hits() const { return m_cache_hits; }
+    inline uint32_t cache_misses() const { return m_cache_misses; }
+
+private:
+    // Builds a new GL program for the stages of 'program'. 'files' receives every file it was built from.
+    GLuint build(const ShaderProgram& program, std::vector<std::string>& files);
+
+    std::string                                    m_driver;
+    bool                                           m_use_cache    = false;
+    uint32_t                                       m_cache_hits   = 0;
+    uint32_t                                       m_cache_misses = 0;
+    std::vector<ShaderProgram::Ptr>                m_programs;
+    ShaderIncludeGraph                             m_include_graph;
+    std::chrono::high_resolution_clock::time_point m_last_poll;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Variants of one program, each built the first time it is asked for and kept by the key of its defines.
+class ShaderVariants
+{
+public:
+    void create(ShaderLibrary* library, const std::vector<ShaderStage>& stages);
+
+    // Returns the variant built with 'defines'. Returns null if it failed to build, which is only attempted once per set of defines.
+    ShaderProgram::Ptr get(const ShaderDefines& defines);
+
+    inline uint32_t size() const { return uint32_t(m_variants.size()); }
+
+private:
+    ShaderLibrary*                                   m_library = nullptr;
+    std::vector<ShaderStage>                         m_stages;
+    std::unordered_map<uint64_t, ShaderProgram::Ptr> m_variants;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,295 @@
+#include "shader_source.h"
+#include "noise_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static std::string directory_of(const std::string& path)
+{
+    size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? "" : path.substr(0, slash + 1);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Returns the file name of an '#include <name>' or '#include "name"' line, or an empty string for any other line.
+static std::string include_name(const std::string& line)
+{
+    size_t start = line.find_first_not_of(" \t");
+
+    if (start == std::string::npos || line.compare(start, 8, "#include") != 0)
+        return "";
+
+    size_t open = line.find_first_of("<\"", start + 8);
+
+    if (open == std::string::npos)
+        return "";
+
+    size_t close = line.find(line[open] == '<' ? '>' : '"', open + 1);
+
+    if (close == std::string::npos)
+        return "";
+
+    return line.substr(open + 1, close - open - 1);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool expand(const std::string& path, const ShaderFileReader& read_file, std::vector<std::string>& stack, std::string& source, std::vector<std::string>& files, std::string& error)
+{
+    if (std::find(stack.begin(), stack.end(), path) != stack.end())
+    {
+        error = "Include cycle: ";
+
+        for (const auto& file : stack)
+            error += file + " -> ";
+
+        error += path;
+        return false;
+    }
+
+    if (std::find(files.begin(), files.end(), path) != files.end())
+        return true;
+
+    std::string text;
+
+    if (!read_file(path, text))
+    {
+        error = stack.empty() ? "Failed to read " + path : "Failed to read " + path + ", included from " + stack.back();
+        return false;
+    }
+
+    files.push_back(path);
+    stack.push_back(path);
+
+    std::istringstream lines(text);
+    std::string        line;
+
+    while (std::getline(lines, line))
+    {
+        std::string name = include_name(line);
+
+        if (name.empty())
+        {
+            source += line;
+            source += '\n';
+        }
+        else if (!expand(directory_of(path) + name, read_file, stack, source, files, error))
+            return false;
+    }
+
+    stack.pop_back();
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool shader_expand_includes(const std::string& path, const ShaderFileReader& read_file, std::string& source, std::vector<std::string>& files, std::string& error)
+{
+    std::vector<std::string> stack;
+
+    source.clear();
+    files.clear();
+
+    return expand(path, read_file, stack, source, files, error);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint64_t shader_program_key(const std::vector<std::string>& sources, const std::string& driver)
+{
+    uint32_t version = SHADER_CACHE_VERSION;
+    uint64_t key     = noise_cache_hash(&version, sizeof(version));
+
+    for (const auto& source : sources)
+    {
+        uint64_t length = source.size();
+
+        key = noise_cache_hash(&length, sizeof(length), key);
+        key = noise_cache_hash(source.data(), source.size(), key);
+    }
+
+    return noise_cache_hash(driver.data(), driver.size(), key);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+std::string shader_defines_source(const ShaderDefines& defines)
+{
+    ShaderDefines sorted = defines;
+
+    std::sort(sorted.begin(), sorted.end(), [](const ShaderDefine& a, const ShaderDefine& b) { return a.name < b.name; });
+
+    std::string source;
+
+    for (const auto& define : sorted)
+        source += "#define " + define.name + " " + define.value + "\n";
+
+    return source;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint64_t shader_defines_key(const ShaderDefines& defines)
+{
+    if (defines.empty())
+        return 0;
+
+    std::string source = shader_defines_source(defines);
+    uint64_t    key    = noise_cache_hash(source.data(), source.size());
+
+    return key ? key : 1;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void shader_cache_serialize(uint64_t key, uint32_t binary_format, const void* binary, size_t binary_size, std::vector<uint8_t>& out)
+{
+    ShaderCacheHeader header;
+
+    header.magic         = SHADER_CACHE_MAGIC;
+    header.version       = SHADER_CACHE_VERSION;
+    header.key           = key;
+    header.binary_format = binary_format;
+    header.padding       = 0;
+    header.binary_size   = binary_size;
+
+    out.resize(sizeof(ShaderCacheHeader) + binary_size);
+
+    memcpy(out.data(), &header, sizeof(ShaderCacheHeader));
+
+    if (binary_size > 0)
+        memcpy(out.data() + sizeof(ShaderCacheHeader), binary, binary_size);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool shader_cache_parse(const uint8_t* data, size_t size, uint64_t expected_key, uint32_t& binary_format, const uint8_t*& binary, size_t& binary_size)
+{
+    if (!data || size < sizeof(ShaderCacheHeader))
+        return false;
+
+    ShaderCacheHeader header;
+    memcpy(&header, data, sizeof(ShaderCacheHeader));
+
+    if (header.magic != SHADER_CACHE_MAGIC || header.version != SHADER_CACHE_VERSION || header.key != expected_key)
+        return false;
+
+    if (header.binary_size == 0 || header.binary_size > size - sizeof(ShaderCacheHeader))
+        return false;
+
+    binary_format = header.binary_format;
+    binary        = data + sizeof(ShaderCacheHeader);
+    binary_size   = static_cast<size_t>(header.binary_size);
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool shader_cache_write(const std::string& path, uint64_t key, uint32_t binary_format, const void* binary, size_t binary_size)
+{
+    std::vector<uint8_t> data;
+    shader_cache_serialize(key, binary_format, binary, binary_size, data);
+
+    // Write to a temporary file first so that a partially written cache is never picked up.
+    std::string   temp_path = path + ".tmp";
+    std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+
+    if (!file.is_open())
+        return false;
+
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    file.close();
+
+    if (!file)
+        return false;
+
+    std::remove(path.c_str());
+
+    return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool shader_read_file(const std::string& path, std::string& text)
+{
+    std::ifstream file(path);
+
+    if (!file.is_open())
+        return false;
+
+    text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+int64_t shader_file_time(const std::string& path)
+{
+    struct stat file_stat;
+
+    if (stat(path.c_str(), &file_stat) != 0)
+        return 0;
+
+    return int64_t(file_stat.st_mtime);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void ShaderIncludeGraph::set_program(uint32_t program, const std::vector<std::string>& files, const ShaderFileTime& file_time)
+{
+    m_programs[program] = files;
+
+    for (const auto& file : files)
+    {
+        if (m_times.find(file) == m_times.end())
+            m_times[file] = file_time(file);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void ShaderIncludeGraph::poll(const ShaderFileTime& file_time, std::vector<uint32_t>& programs)
+{
+    std::vector<std::string> changed;
+
+    programs.clear();
+
+    for (auto& file : m_times)
+    {
+        int64_t time = file_time(file.first);
+
+        if (time != file.second)
+        {
+            file.second = time;
+            changed.push_back(file.first);
+        }
+    }
+
+    if (changed.empty())
+        return;
+
+    for (const auto& program : m_programs)
+    {
+        for (const auto& file : program.second)
+        {
+            if (std::find(changed.begin(), changed.end(), file) != changed.end())
+            {
+                programs.push_back(program.first);
+                break;
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
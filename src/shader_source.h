@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// Everything about the shader program cache that does not need a GL context: the expansion of the #include directives, the key a
+// program binary is stored under, the layout of the cache files and the include graph that decides which programs a file change
+// affects. The programs themselves are built by ShaderLibrary in shader_program.h.
+//
+// Cache file layout:
+//     ShaderCacheHeader
+//     program binary, as returned by glGetProgramBinary()
+
+#define SHADER_CACHE_MAGIC 0x48435053 // 'SPCH'
+#define SHADER_CACHE_VERSION 1
+
+struct ShaderCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t binary_format;
+    uint32_t padding;
+    uint64_t binary_size;
+};
+
+// Preprocessor definition a program variant is compiled with.
+struct ShaderDefine
+{
+    std::string name;
+    std::string value;
+};
+
+typedef std::vector<ShaderDefine> ShaderDefines;
+
+// Reads a whole text file, returns false if it does not exist.
+typedef std::function<bool(const std::string& path, std::string& text)> ShaderFileReader;
+
+// Modification time of a file, 0 if it does not exist.
+typedef std::function<int64_t(const std::string& path)> ShaderFileTime;
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Replaces every '#include <name>' (or "name") line of the shader at 'path' with the expanded contents of 'name', relative to the
+// directory of the file that includes it. A file is only expanded the first time it is included, an include cycle is an error.
+// 'files' receives 'path' followed by every file it includes, each once.
+bool shader_expand_includes(const std::string& path, const ShaderFileReader& read_file, std::string& source, std::vector<std::string>& files, std::string& error);
+
+// Key of a program built from the expanded sources of its stages, in order, by the driver described by 'driver' (vendor, renderer
+// and version strings). Program binaries are only valid for the driver that produced them.
+uint64_t shader_program_key(const std::vector<std::string>& sources, const std::string& driver);
+
+// "#define NAME VALUE" lines of 'defines' sorted by name, prepended to the expanded source of every stage of a variant. The same set of
+// defines always gives the same lines, whatever their order, so a variant is keyed and cached the same way every time.
+std::string shader_defines_source(const ShaderDefines& defines);
+
+// Key of a set of defines, the same for any order of them. 0 only for an empty set, the program without defines.
+uint64_t shader_defines_key(const ShaderDefines& defines);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void shader_cache_serialize(uint64_t key, uint32_t binary_format, const void* binary, size_t binary_size, std::vector<uint8_t>& out);
+
+// Parses a block produced by shader_cache_serialize(). Fails if the block is truncated, has the wrong magic or version, or if it was
+// built with a different key. 'binary' points into 'data'.
+bool shader_cache_parse(const uint8_t* data, size_t size, uint64_t expected_key, uint32_t& binary_format, const uint8_t*& binary, size_t& binary_size);
+
+bool shader_cache_write(const std::string& path, uint64_t key, uint32_t binary_format, const void* binary, size_t binary_size);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool    shader_read_file(const std::string& path, std::string& text);
+int64_t shader_file_time(const std::string& path);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Which programs were built from which files. Every file is checked once per poll, however many programs include it.
+class ShaderIncludeGraph
+{
+public:
+    // Replaces the files program 'program' was built from and records the current time of the ones not seen yet.
+    void set_program(uint32_t program, const std::vector<std::string>& files, const ShaderFileTime& file_time);
+
+    // Returns the programs built from a file whose time changed since the last poll, each once and in increasing order.
+    void poll(const ShaderFileTime& file_time, std::vector<uint32_t>& programs);
+
+private:
+    std::map<std::string, int64_t>               m_times;
+    std::map<uint32_t, std::vector<std::string>> m_programs;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
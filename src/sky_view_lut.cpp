@@ -0,0 +1,76 @@
+#include "sky_view_lut.h"
+#include "cloud_reference.h"
+#include "cpu_noise.h"
+
+#include <math.h>
+#include <algorithm>
+
+#define SKY_PI 3.14159265359f
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static float quantize_half(float value)
+{
+    return cpu_noise_half_to_float(cpu_noise_float_to_half(value));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec2 sky_view_lut_uv(const glm::vec3& direction)
+{
+    float azimuth   = atan2f(direction.z, direction.x);
+    float elevation = asinf(glm::clamp(direction.y, 0.0f, 1.0f));
+    float v         = sqrtf(elevation / (SKY_PI * 0.5f));
+
+    return glm::vec2(azimuth / (2.0f * SKY_PI) + 0.5f, (0.5f + v * float(SKY_VIEW_LUT_HEIGHT - 1)) / float(SKY_VIEW_LUT_HEIGHT));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec3 sky_view_lut_direction(uint32_t x, uint32_t y)
+{
+    float azimuth   = ((float(x) + 0.5f) / float(SKY_VIEW_LUT_WIDTH) - 0.5f) * 2.0f * SKY_PI;
+    float v         = float(y) / float(SKY_VIEW_LUT_HEIGHT - 1);
+    float elevation = v * v * SKY_PI * 0.5f;
+
+    return glm::vec3(cosf(elevation) * cosf(azimuth), sinf(elevation), cosf(elevation) * sinf(azimuth));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void sky_view_lut_build(const glm::vec3& sun_dir, float turbidity, std::vector<glm::vec3>& texels)
+{
+    texels.resize(SKY_VIEW_LUT_WIDTH * SKY_VIEW_LUT_HEIGHT);
+
+    for (uint32_t y = 0; y < SKY_VIEW_LUT_HEIGHT; y++)
+    {
+        for (uint32_t x = 0; x < SKY_VIEW_LUT_WIDTH; x++)
+        {
+            glm::vec3 sky = calculate_sky_luminance_rgb(sun_dir, sky_view_lut_direction(x, y), turbidity);
+
+            texels[y * SKY_VIEW_LUT_WIDTH + x] = glm::vec3(quantize_half(sky.x), quantize_half(sky.y), quantize_half(sky.z));
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::vec3 sky_view_lut_sample(const std::vector<glm::vec3>& texels, const glm::vec3& direction)
+{
+    glm::vec2 coord  = sky_view_lut_uv(direction) * glm::vec2(SKY_VIEW_LUT_WIDTH, SKY_VIEW_LUT_HEIGHT) - 0.5f;
+    glm::vec2 base   = glm::floor(coord);
+    glm::vec2 weight = coord - base;
+
+    int32_t x0 = int32_t(base.x), x1 = x0 + 1;
+    int32_t y0 = std::max(int32_t(base.y), 0), y1 = std::min(int32_t(base.y) + 1, SKY_VIEW_LUT_HEIGHT - 1);
+
+    x0 = (x0 % SKY_VIEW_LUT_WIDTH + SKY_VIEW_LUT_WIDTH) % SKY_VIEW_LUT_WIDTH;
+    x1 = (x1 % SKY_VIEW_LUT_WIDTH + SKY_VIEW_LUT_WIDTH) % SKY_VIEW_LUT_WIDTH;
+
+    glm::vec3 a = glm::mix(texels[y0 * SKY_VIEW_LUT_WIDTH + x0], texels[y0 * SKY_VIEW_LUT_WIDTH + x1], weight.x);
+    glm::vec3 b = glm::mix(texels[y1 * SKY_VIEW_LUT_WIDTH + x0], texels[y1 * SKY_VIEW_LUT_WIDTH + x1], weight.x);
+
+    return glm::mix(a, b, weight.y);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <vector>
+
+// Sky-view LUT: the Preetham sky (calculate_sky_luminance_rgb()) for the current sun direction, stored as a lat-long map of the view
+// direction so that the cloud pass reads it with one fetch instead of evaluating the Perez distribution per pixel. The sky below the
+// horizon equals the sky at the horizon, so only the upper hemisphere is stored. The elevation is mapped with a square root to spend
+// more texels near the horizon where the sky changes fastest. sky_view_lut_cs.glsl builds it on the GPU, CloudReference on the CPU.
+
+#define SKY_VIEW_LUT_WIDTH 256
+#define SKY_VIEW_LUT_HEIGHT 128
+
+// Turbidity of the sky, as passed to calculate_sky_luminance_rgb() by the cloud pass.
+#define SKY_TURBIDITY 2.0f
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Texture coordinates of 'direction', the first and last rows are centred on the horizon and the zenith. Keep in sync with
+// sky_view_lut_uv() in sky_view_lut.glsl.
+glm::vec2 sky_view_lut_uv(const glm::vec3& direction);
+
+// View direction at the centre of texel (x, y). Keep in sync with sky_view_lut_direction() in sky_view_lut.glsl.
+glm::vec3 sky_view_lut_direction(uint32_t x, uint32_t y);
+
+// Fills 'texels' (SKY_VIEW_LUT_WIDTH x SKY_VIEW_LUT_HEIGHT, rows from the horizon up) for 'sun_dir', quantized to half precision like
+// the GL_RGBA16F texture.
+void sky_view_lut_build(const glm::vec3& sun_dir, float turbidity, std::vector<glm::vec3>& texels);
+
+// Bilinear lookup with GL_REPEAT along the azimuth and GL_CLAMP_TO_EDGE along the elevation, as the cloud pass samples the texture.
+glm::vec3 sky_view_lut_sample(const std::vector<glm::vec3>& texels, const glm::vec3& direction);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
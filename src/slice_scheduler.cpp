@@ -0,0 +1,130 @@
+#include "slice_scheduler.h"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+struct SliceQueue
+{
+    std::mutex mutex;
+    uint32_t   begin = 0;
+    uint32_t   end   = 0;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool pop_front(SliceQueue& queue, uint32_t& slice)
+{
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.begin == queue.end)
+        return false;
+
+    slice = queue.begin++;
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool steal_back(std::vector<SliceQueue>& queues, uint32_t thief, uint32_t& slice)
+{
+    // Pick the victim with the most remaining work. The sizes are read without locking so this is only a hint, the actual steal is
+    // done under the victim's lock.
+    uint32_t victim    = thief;
+    uint32_t remaining = 0;
+
+    for (uint32_t i = 0; i < queues.size(); i++)
+    {
+        if (i == thief)
+            continue;
+
+        std::lock_guard<std::mutex> lock(queues[i].mutex);
+
+        uint32_t count = queues[i].end - queues[i].begin;
+
+        if (count > remaining)
+        {
+            remaining = count;
+            victim    = i;
+        }
+    }
+
+    if (victim == thief)
+        return false;
+
+    std::lock_guard<std::mutex> lock(queues[victim].mutex);
+
+    if (queues[victim].begin == queues[victim].end)
+        return true; // Lost the race, try again.
+
+    slice = --queues[victim].end;
+
+    return true;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+uint32_t SliceScheduler::hardware_threads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void SliceScheduler::run(uint32_t num_slices, uint32_t num_threads, const std::function<void(uint32_t slice, uint32_t thread)>& job)
+{
+    if (num_threads == 0)
+        num_threads = hardware_threads();
+
+    num_threads = std::max(1u, std::min(num_threads, num_slices));
+
+    if (num_threads <= 1)
+    {
+        for (uint32_t i = 0; i < num_slices; i++)
+            job(i, 0);
+
+        return;
+    }
+
+    std::vector<SliceQueue> queues(num_threads);
+
+    for (uint32_t i = 0; i < num_threads; i++)
+    {
+        queues[i].begin = uint64_t(num_slices) * i / num_threads;
+        queues[i].end   = uint64_t(num_slices) * (i + 1) / num_threads;
+    }
+
+    auto worker = [&](uint32_t thread) {
+        while (true)
+        {
+            uint32_t slice = UINT32_MAX;
+
+            if (!pop_front(queues[thread], slice))
+            {
+                if (!steal_back(queues, thread, slice))
+                    break;
+
+                if (slice == UINT32_MAX)
+                    continue;
+            }
+
+            job(slice, thread);
+        }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (uint32_t i = 1; i < num_threads; i++)
+        threads.emplace_back(worker, i);
+
+    worker(0);
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
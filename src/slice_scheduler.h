@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+
+// Runs a job over a range of independent slices (z-slices of a volume, image tiles, ...) on a set of worker threads. Each worker starts
+// with a contiguous share of the range and processes it front to back; once it runs out it steals slices from the back of the busiest
+// worker. This keeps neighbouring slices on the same thread while still balancing uneven per-slice costs.
+class SliceScheduler
+{
+public:
+    // 'num_threads' of 0 uses all hardware threads. The calling thread takes part in the work.
+    static void run(uint32_t num_slices, uint32_t num_threads, const std::function<void(uint32_t slice, uint32_t thread)>& job);
+
+    static uint32_t hardware_threads();
+};
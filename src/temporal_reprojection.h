@@ -0,0 +1,110 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <math.h>
+#include <stdint.h>
+
+// CPU mirror of the reprojection math in clouds_reconstruct_fs.glsl. Keep the two in sync.
+
+#define TEMPORAL_BLOCK_SIZE 4
+#define TEMPORAL_BLOCK_PIXELS (TEMPORAL_BLOCK_SIZE * TEMPORAL_BLOCK_SIZE)
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Returns the pixel within each 4x4 block that gets ray marched on the given frame. The order follows a 4x4 Bayer matrix so that
+// consecutive frames update pixels that are far apart and every pixel is refreshed exactly once every 16 frames.
+inline glm::ivec2 temporal_pixel_offset(uint32_t frame_index)
+{
+    static const glm::ivec2 kBayerOffsets[TEMPORAL_BLOCK_PIXELS] = {
+        glm::ivec2(0, 0), glm::ivec2(2, 2), glm::ivec2(2, 0), glm::ivec2(0, 2),
+        glm::ivec2(1, 1), glm::ivec2(3, 3), glm::ivec2(3, 1), glm::ivec2(1, 3),
+        glm::ivec2(1, 0), glm::ivec2(3, 2), glm::ivec2(3, 0), glm::ivec2(1, 2),
+        glm::ivec2(0, 1), glm::ivec2(2, 3), glm::ivec2(2, 1), glm::ivec2(0, 3)
+    };
+
+    return kBayerOffsets[frame_index % TEMPORAL_BLOCK_PIXELS];
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Size of the low resolution target that holds one marched pixel per 4x4 block.
+inline glm::ivec2 temporal_lowres_size(int width, int height)
+{
+    return glm::ivec2((width + TEMPORAL_BLOCK_SIZE - 1) / TEMPORAL_BLOCK_SIZE, (height + TEMPORAL_BLOCK_SIZE - 1) / TEMPORAL_BLOCK_SIZE);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// True if the full resolution pixel was ray marched this frame.
+inline bool temporal_is_marched_pixel(glm::ivec2 pixel, glm::ivec2 offset)
+{
+    return (pixel.x % TEMPORAL_BLOCK_SIZE) == offset.x && (pixel.y % TEMPORAL_BLOCK_SIZE) == offset.y;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Clouds are sampled at (position + wind * time), so a feature that is at 'position' this frame was at (position + wind * dt) on the
+// previous frame. Must match the wind term in sample_cloud_density().
+inline glm::vec3 temporal_cloud_advection(glm::vec3 wind_direction, float wind_speed, float delta_time)
+{
+    return (wind_direction + glm::vec3(0.0f, 0.1f, 0.0f)) * wind_speed * delta_time;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Texture coordinate of the low resolution target that a full resolution fragment upsamples from. Texel t holds the pixel
+// t * TEMPORAL_BLOCK_SIZE + offset, so that pixel lands on the texel centre and the ones between are interpolated.
+inline glm::vec2 temporal_upsample_uv(glm::vec2 frag_coord, glm::vec2 offset, glm::ivec2 lowres_size)
+{
+    return (frag_coord - 0.5f - offset + 0.5f * TEMPORAL_BLOCK_SIZE) / (float(TEMPORAL_BLOCK_SIZE) * glm::vec2(lowres_size));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Distance along the ray to the base of the cloud layer, used as the depth of the pixels that are reprojected. Takes the nearest
+// crossing in front of the origin and falls back to the thickness of the layer when the ray never reaches the base.
+inline float temporal_cloud_layer_distance(glm::vec3 origin, glm::vec3 direction, glm::vec3 planet_center, float planet_radius, float cloud_min_height, float cloud_max_height)
+{
+    glm::vec3 l = origin - planet_center;
+    float     b = glm::dot(direction, l);
+    float     c = glm::dot(l, l) - (planet_radius + cloud_min_height) * (planet_radius + cloud_min_height);
+    float     D = b * b - c;
+
+    if (D < 0.0f)
+        return cloud_max_height - cloud_min_height;
+
+    float s = sqrtf(D);
+    float t = (-b - s > 0.0f) ? -b - s : -b + s;
+
+    if (t < 0.0f)
+        return cloud_max_height - cloud_min_height;
+
+    return t;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Projects a world position using last frame's view projection matrix. Returns false if the point was behind the camera or outside the
+// previous frame, in which case the history has to be rejected.
+inline bool temporal_reproject(const glm::mat4& prev_view_proj, glm::vec3 world_pos, glm::vec2& uv)
+{
+    glm::vec4 clip_pos = prev_view_proj * glm::vec4(world_pos, 1.0f);
+
+    if (clip_pos.w <= 0.0f)
+        return false;
+
+    uv = glm::vec2(clip_pos.x, clip_pos.y) / clip_pos.w * 0.5f + 0.5f;
+
+    return uv.x >= 0.0f && uv.x <= 1.0f && uv.y >= 0.0f && uv.y <= 1.0f;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Clamps the reprojected history color to the range of the freshly marched neighbourhood to reject stale history caused by camera motion
+// and cloud advection that the reprojection does not account for.
+inline glm::vec3 temporal_clamp_history(glm::vec3 history, glm::vec3 neighbourhood_min, glm::vec3 neighbourhood_max)
+{
+    return glm::clamp(history, neighbourhood_min, neighbourhood_max);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,63 @@
+#include "test.h"
+#include "cloud_reference.h"
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(adaptive_march_backup_is_conservative)
+{
+    // The reference evaluates every fine sample the adaptive march steps over when it backs up from a coarse hit and counts the
+    // non-zero ones.
+    CloudParameters params;
+    CloudCamera     camera;
+    CloudReference  reference;
+
+    params.light_volume   = false;
+    params.adaptive_march = true;
+
+    bool initialized = reference.initialize(VOLUMETRIC_CLOUDS_TEXTURE_DIR, params, 64, 32);
+
+    CHECK(initialized);
+
+    if (!initialized)
+        return;
+
+    reference.set_verify_adaptive_march(true);
+
+    const uint32_t      width         = 96;
+    const uint32_t      height        = 54;
+    const float         coverages[]   = { 0.5f, 0.7f };
+    const float         step_scales[] = { 4.0f, 8.0f };
+    const glm::vec3     directions[]  = { glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.6f, 0.3f) };
+    CloudReferenceStats stats;
+
+    // With and without the empty space grid, which moves the coarse samples off the step grid.
+    for (int32_t skipping = 0; skipping < 2; skipping++)
+    {
+        for (float coverage : coverages)
+        {
+            for (float step_scale : step_scales)
+            {
+                for (const glm::vec3& direction : directions)
+                {
+                    params.empty_space_skipping = skipping == 1;
+                    params.cloud_coverage       = coverage;
+                    params.coarse_step_scale    = step_scale;
+                    camera.forward              = glm::normalize(direction);
+
+                    reference.set_parameters(params, camera, width, height);
+
+                    for (uint32_t y = 0; y < height; y++)
+                    {
+                        for (uint32_t x = 0; x < width; x++)
+                            reference.shade_pixel(x, y, stats);
+                    }
+                }
+            }
+        }
+    }
+
+    CHECK(stats.detail_samples > 0);
+    CHECK(stats.backup_violations == 0);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,217 @@
+#include "test.h"
+#include "auto_exposure.h"
+#include "shader_source.h"
+
+#include <math.h>
+#include <string>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(auto_exposure_bin_range)
+{
+    AutoExposureSettings settings;
+
+    // Black, negative and NaN luminance and anything below the range go to the ignored bin.
+    CHECK(auto_exposure_bin(0.0f, settings) == 0);
+    CHECK(auto_exposure_bin(-1.0f, settings) == 0);
+    CHECK(auto_exposure_bin(nanf(""), settings) == 0);
+    CHECK(auto_exposure_bin(exp2f(settings.min_log2_luminance) * 0.99f, settings) == 0);
+
+    // The bottom of the range is the first counted bin, the top and anything brighter the last one.
+    CHECK(auto_exposure_bin(exp2f(settings.min_log2_luminance), settings) == 1);
+    CHECK(auto_exposure_bin(exp2f(settings.max_log2_luminance), settings) == AUTO_EXPOSURE_HISTOGRAM_BINS - 1);
+    CHECK(auto_exposure_bin(1.0e9f, settings) == AUTO_EXPOSURE_HISTOGRAM_BINS - 1);
+    CHECK(auto_exposure_bin(INFINITY, settings) == AUTO_EXPOSURE_HISTOGRAM_BINS - 1);
+
+    uint32_t previous = 0;
+
+    for (float log2_luminance = settings.min_log2_luminance - 1.0f; log2_luminance <= settings.max_log2_luminance + 1.0f; log2_luminance += 0.01f)
+    {
+        uint32_t bin = auto_exposure_bin(exp2f(log2_luminance), settings);
+
+        CHECK(bin >= previous && bin < AUTO_EXPOSURE_HISTOGRAM_BINS);
+        previous = bin;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(auto_exposure_bin_centers)
+{
+    AutoExposureSettings settings;
+
+    settings.min_log2_luminance = -8.0f;
+    settings.max_log2_luminance = 4.0f;
+
+    // The center of every bin falls back into it, and the centers are evenly spaced over the range.
+    float spacing = (settings.max_log2_luminance - settings.min_log2_luminance) / float(AUTO_EXPOSURE_HISTOGRAM_BINS - 1);
+
+    for (uint32_t bin = 1; bin < AUTO_EXPOSURE_HISTOGRAM_BINS; bin++)
+    {
+        float center = auto_exposure_bin_log2_luminance(bin, settings);
+
+        CHECK(auto_exposure_bin(exp2f(center), settings) == bin);
+        CHECK_NEAR(center, settings.min_log2_luminance + (float(bin) - 0.5f) * spacing, 1.0e-5f);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(auto_exposure_histogram_stride)
+{
+    AutoExposureSettings settings;
+
+    // RGBA pixels, the alpha must not be read as the red of the next pixel.
+    const float pixels[] = { 0.0f, 0.0f, 0.0f, 100.0f, 1.0f, 1.0f, 1.0f, 100.0f, 1.0f, 1.0f, 1.0f, 100.0f };
+    uint32_t    histogram[AUTO_EXPOSURE_HISTOGRAM_BINS] = {};
+
+    auto_exposure_histogram(pixels, 3, 4, settings, histogram);
+
+    CHECK(histogram[0] == 1);
+    CHECK(histogram[auto_exposure_bin(1.0f, settings)] == 2);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(auto_exposure_average_empty)
+{
+    AutoExposureSettings settings;
+    uint32_t             histogram[AUTO_EXPOSURE_HISTOGRAM_BINS] = {};
+    float                average = 42.0f;
+
+    CHECK(!auto_exposure_average_log2_luminance(histogram, settings, average));
+
+    // Pixels below the range do not count.
+    histogram[0] = 1000;
+
+    CHECK(!auto_exposure_average_log2_luminance(histogram, settings, average));
+    CHECK(average == 42.0f);
+
+    // Nor does the state change.
+    AutoExposureState state = { 1.5f, 2.0f, -3.0f, 0.0f };
+
+    auto_exposure_update(histogram, 1.0f, settings, state);
+
+    CHECK(state.exposure == 1.5f && state.target_exposure == 2.0f && state.average_log2_luminance == -3.0f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(auto_exposure_average_percentiles)
+{
+    AutoExposureSettings settings;
+    uint32_t             histogram[AUTO_EXPOSURE_HISTOGRAM_BINS] = {};
+    float                average = 0.0f;
+
+    // A single bin averages to its center whatever the percentiles, the ignored bin does not move it.
+    histogram[0]  = 500;
+    histogram[20] = 10;
+
+    CHECK(auto_exposure_average_log2_luminance(histogram, settings, average));
+    CHECK_NEAR(average, auto_exposure_bin_log2_luminance(20, settings), 1.0e-5f);
+
+    // The darkest and brightest pixels outside the percentiles are left out entirely.
+    histogram[5]  = 10;
+    histogram[20] = 80;
+    histogram[60] = 10;
+
+    settings.low_percentile  = 0.1f;
+    settings.high_percentile = 0.9f;
+
+    CHECK(auto_exposure_average_log2_luminance(histogram, settings, average));
+    CHECK_NEAR(average, auto_exposure_bin_log2_luminance(20, settings), 1.0e-4f);
+
+    // A bin that straddles a percentile is weighted by the fraction inside it: of 4 + 4 pixels the low percentile of 0.25 keeps 2 of
+    // the darker bin.
+    histogram[5]  = 0;
+    histogram[10] = 4;
+    histogram[20] = 4;
+    histogram[60] = 0;
+
+    settings.low_percentile  = 0.25f;
+    settings.high_percentile = 1.0f;
+
+    float expected = (2.0f * auto_exposure_bin_log2_luminance(10, settings) + 4.0f * auto_exposure_bin_log2_luminance(20, settings)) / 6.0f;
+
+    CHECK(auto_exposure_average_log2_luminance(histogram, settings, average));
+    CHECK_NEAR(average, expected, 1.0e-5f);
+
+    // Equal percentiles keep nothing.
+    settings.low_percentile  = 0.5f;
+    settings.high_percentile = 0.5f;
+
+    CHECK(!auto_exposure_average_log2_luminance(histogram, settings, average));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(auto_exposure_target_key)
+{
+    AutoExposureSettings settings;
+
+    // The average is mapped to the key, then shifted by the compensation in stops and clamped.
+    CHECK_NEAR(auto_exposure_target(-2.0f, settings) * exp2f(-2.0f), settings.key, 1.0e-6f);
+
+    settings.compensation = 1.0f;
+
+    CHECK_NEAR(auto_exposure_target(-2.0f, settings) * exp2f(-2.0f), settings.key * 2.0f, 1.0e-6f);
+    CHECK(auto_exposure_target(-30.0f, settings) == settings.max_exposure);
+    CHECK(auto_exposure_target(30.0f, settings) == settings.min_exposure);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(auto_exposure_adapt_rates)
+{
+    AutoExposureSettings settings;
+
+    // No time, no change. An exposure that has not been set yet jumps to the target.
+    CHECK(auto_exposure_adapt(1.0f, 4.0f, 0.0f, settings) == 1.0f);
+    CHECK(auto_exposure_adapt(0.0f, 4.0f, 0.1f, settings) == 4.0f);
+    CHECK(auto_exposure_adapt(1.0f, 1.0f, 0.1f, settings) == 1.0f);
+
+    // Moves towards the target without overshooting, in either direction, and converges.
+    float rising  = 1.0f;
+    float falling = 1.0f;
+
+    for (int i = 0; i < 600; i++)
+    {
+        float next_rising  = auto_exposure_adapt(rising, 4.0f, 1.0f / 60.0f, settings);
+        float next_falling = auto_exposure_adapt(falling, 0.25f, 1.0f / 60.0f, settings);
+
+        CHECK(next_rising >= rising && next_rising <= 4.0f);
+        CHECK(next_falling <= falling && next_falling >= 0.25f);
+
+        rising  = next_rising;
+        falling = next_falling;
+    }
+
+    CHECK_NEAR(rising, 4.0f, 1.0e-3f);
+    CHECK_NEAR(falling, 0.25f, 1.0e-3f);
+
+    // The same distance in stops is covered faster going down than up.
+    float up   = log2f(auto_exposure_adapt(1.0f, 4.0f, 0.1f, settings));
+    float down = -log2f(auto_exposure_adapt(1.0f, 0.25f, 0.1f, settings));
+
+    CHECK(down > up);
+    CHECK_NEAR(up, 2.0f * (1.0f - expf(-0.1f * settings.speed_up)), 1.0e-5f);
+    CHECK_NEAR(down, 2.0f * (1.0f - expf(-0.1f * settings.speed_down)), 1.0e-5f);
+
+    // Independent of the frame rate: two half steps land where one full step does.
+    float half = auto_exposure_adapt(auto_exposure_adapt(1.0f, 8.0f, 0.05f, settings), 8.0f, 0.05f, settings);
+
+    CHECK_NEAR(half, auto_exposure_adapt(1.0f, 8.0f, 0.1f, settings), 1.0e-4f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(auto_exposure_glsl_sync)
+{
+    // The bin count is duplicated in the shader and the histogram buffer is sized from the C++ side.
+    std::string source;
+
+    CHECK(shader_read_file(VOLUMETRIC_CLOUDS_SHADER_DIR "/auto_exposure.glsl", source));
+    CHECK(source.find("#define AUTO_EXPOSURE_HISTOGRAM_BINS " + std::to_string(AUTO_EXPOSURE_HISTOGRAM_BINS) + "\n") != std::string::npos);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,164 @@
+#include "test.h"
+#include "benchmark_script.h"
+#include "profiler_stats.h"
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static const char* kScript = "timestep 0.05   # 20 fps\n"
+                             "warmup 3\n"
+                             "frames 10\n"
+                             "\n"
+                             "keyframe 0\n"
+                             "position 0 5 0\n"
+                             "direction -2 0 0\n"
+                             "coverage 0.5\n"
+                             "keyframe 2\n"
+                             "position -200 25 0\n"
+                             "sun_angle -90\n"
+                             "keyframe 4\n"
+                             "coverage 0.9\n";
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(benchmark_script_parse)
+{
+    BenchmarkScript script;
+    std::string     error;
+
+    CHECK(parse_benchmark_script(kScript, script, error));
+    CHECK_NEAR(script.timestep, 0.05f, 1e-7f);
+    CHECK(script.warmup == 3 && script.frames == 10);
+    CHECK(script.keyframes.size() == 3);
+
+    if (script.keyframes.size() != 3)
+        return;
+
+    // Every keyframe carries every value set anywhere in the script, directions are normalized and angles in radians.
+    const uint32_t mask = BENCHMARK_POSITION | BENCHMARK_DIRECTION | BENCHMARK_SUN_ANGLE | BENCHMARK_COVERAGE;
+
+    for (const BenchmarkKeyframe& keyframe : script.keyframes)
+        CHECK(keyframe.mask == mask);
+
+    CHECK(script.keyframes[0].direction == glm::vec3(-1.0f, 0.0f, 0.0f));
+    CHECK(script.keyframes[2].direction == glm::vec3(-1.0f, 0.0f, 0.0f));
+    CHECK_NEAR(script.keyframes[0].sun_angle, -1.5707963f, 1e-5f); // Filled backwards from keyframe 1.
+    CHECK(script.keyframes[2].position == glm::vec3(-200.0f, 25.0f, 0.0f)); // Filled forwards.
+    CHECK(script.keyframes[1].coverage == 0.5f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(benchmark_script_interpolation)
+{
+    BenchmarkScript script;
+    std::string     error;
+
+    CHECK(parse_benchmark_script(kScript, script, error));
+
+    if (script.keyframes.size() != 3)
+        return;
+
+    BenchmarkKeyframe state = sample_benchmark_script(script, 1.0f);
+
+    CHECK_NEAR(state.position.x, -100.0f, 1e-4f);
+    CHECK_NEAR(state.position.y, 15.0f, 1e-4f);
+    CHECK_NEAR(state.coverage, 0.5f, 1e-6f);
+    CHECK_NEAR(state.time, 1.0f, 1e-6f);
+
+    state = sample_benchmark_script(script, 3.0f);
+
+    CHECK_NEAR(state.coverage, 0.7f, 1e-6f);
+    CHECK(state.position == glm::vec3(-200.0f, 25.0f, 0.0f));
+
+    // Clamped outside of the keyframes.
+    CHECK(sample_benchmark_script(script, -1.0f).position == glm::vec3(0.0f, 5.0f, 0.0f));
+    CHECK_NEAR(sample_benchmark_script(script, 100.0f).coverage, 0.9f, 1e-6f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(benchmark_script_opposite_directions)
+{
+    BenchmarkScript script;
+    std::string     error;
+
+    CHECK(parse_benchmark_script("keyframe 0\ndirection 1 0 0\nkeyframe 1\ndirection -1 0 0\n", script, error));
+
+    // Half way the interpolated direction vanishes, the sample must still be a unit vector.
+    glm::vec3 direction = sample_benchmark_script(script, 0.5f).direction;
+
+    CHECK_NEAR(glm::length(direction), 1.0f, 1e-5f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(benchmark_script_rejects_malformed_scripts)
+{
+    struct Case
+    {
+        const char* text;
+        const char* error;
+    };
+
+    const Case cases[] = {
+        { "", "line 0: the script has no keyframes" },
+        { "# only a comment\ntimestep 0.1\n", "line 2: the script has no keyframes" },
+        { "position 0 0 0\n", "line 1: 'position' must follow a keyframe" },
+        { "keyframe\n", "line 1: expected a time after 'keyframe'" },
+        { "keyframe 1\nkeyframe 1\n", "line 2: keyframe times must be increasing" },
+        { "keyframe 0\nposition 0 0\n", "line 2: invalid value for 'position'" },
+        { "keyframe 0\ndirection 0 0 0\n", "line 2: invalid value for 'direction'" },
+        { "keyframe 0\ncoverage 0.5 0.6\n", "line 2: unexpected '0.6'" },
+        { "keyframe 0\nfov 90\n", "line 2: unknown command 'fov'" },
+        { "timestep 0\nkeyframe 0\n", "line 1: invalid value for 'timestep'" },
+        { "frames 0\nkeyframe 0\n", "line 1: invalid value for 'frames'" },
+    };
+
+    for (const Case& c : cases)
+    {
+        BenchmarkScript script;
+        std::string     error;
+
+        CHECK(!parse_benchmark_script(c.text, script, error));
+
+        if (error != c.error)
+        {
+            printf("    '%s' != '%s'\n", error.c_str(), c.error);
+            CHECK(error == c.error);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(benchmark_script_shipped_scripts_load)
+{
+    BenchmarkScript script;
+    std::string     error;
+
+    CHECK(load_benchmark_script(VOLUMETRIC_CLOUDS_BENCHMARK_DIR "/flythrough.txt", script, error));
+    CHECK(!load_benchmark_script(VOLUMETRIC_CLOUDS_BENCHMARK_DIR "/missing.txt", script, error));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(benchmark_frame_time_summary)
+{
+    // The summary printed at the end of a run: 10 frames of 10 to 19 ms, with one 100 ms hitch.
+    std::vector<float> frame_times;
+
+    for (uint32_t i = 0; i < 10; i++)
+        frame_times.push_back(float(10 + i));
+
+    frame_times[4] = 100.0f;
+
+    TimingSummary summary = summarize_timings(frame_times.data(), uint32_t(frame_times.size()));
+
+    CHECK(summary.min == 10.0f);
+    CHECK(summary.max == 100.0f);
+    CHECK(summary.p50 == 15.0f);
+    CHECK(summary.p95 == 100.0f);
+    CHECK_NEAR(summary.avg, (145.0f - 14.0f + 100.0f) / 10.0f, 1e-4f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
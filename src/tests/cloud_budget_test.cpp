@@ -0,0 +1,203 @@
+#include "test.h"
+#include "cloud_budget.h"
+
+#include <stdio.h>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool same_level(const CloudBudgetLevel& a, const CloudBudgetLevel& b)
+{
+    return a.scale == b.scale && a.step_fraction == b.step_fraction;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static uint32_t count_changes(const std::vector<CloudBudgetLevel>& levels, size_t first, size_t last)
+{
+    uint32_t changes = 0;
+
+    for (size_t i = first + 1; i < last; i++)
+    {
+        if (!same_level(levels[i], levels[i - 1]))
+            changes++;
+    }
+
+    return changes;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_budget_levels)
+{
+    CloudBudgetSettings settings;
+
+    CHECK(same_level(cloud_budget_level(1.0f, settings), { 1.0f, 1.0f }));
+    CHECK(same_level(cloud_budget_level(2.0f, settings), { 1.0f, 1.0f }));
+    CHECK(same_level(cloud_budget_level(0.75f, settings), { 1.0f, 0.75f }));
+
+    // Steps first, down to min_step_fraction, then the resolution, rounded down to the quantum.
+    CHECK(same_level(cloud_budget_level(0.25f, settings), { 0.6875f, 0.5f }));
+    CHECK(same_level(cloud_budget_level(0.0f, settings), { settings.min_scale, 0.5f }));
+
+    // The temporal path keeps the full resolution.
+    settings.min_scale = 1.0f;
+
+    CHECK(same_level(cloud_budget_level(0.25f, settings), { 1.0f, 0.5f }));
+
+    // Every level fits the requested cost unless it is already the cheapest one.
+    settings = CloudBudgetSettings();
+
+    for (int i = 1; i <= 100; i++)
+    {
+        float            cost  = float(i) / 100.0f;
+        CloudBudgetLevel level = cloud_budget_level(cost, settings);
+
+        CHECK(cloud_budget_cost(level) <= cost + 1e-6f || same_level(level, { settings.min_scale, settings.min_step_fraction }));
+        CHECK(cloud_budget_cost(level) > cost * 0.5f || level.scale == settings.min_scale);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_budget_converges_on_a_constant_trace)
+{
+    CloudBudgetSettings settings;
+    settings.settle_frames = 4;
+
+    const float full_quality[] = { 2.0f, 6.0f, 12.0f, 40.0f };
+
+    for (float ms : full_quality)
+    {
+        std::vector<float>            trace(200, ms);
+        std::vector<CloudBudgetLevel> levels;
+        std::vector<float>            times;
+
+        cloud_budget_simulate(settings, trace, 3, levels, times);
+
+        // Settled after the first quarter and then never moves again.
+        CHECK(count_changes(levels, 50, trace.size()) == 0);
+
+        float final_ms = times.back();
+
+        if (ms <= settings.target_ms)
+            CHECK(same_level(levels.back(), { 1.0f, 1.0f }));
+        else if (same_level(levels.back(), { settings.min_scale, settings.min_step_fraction }))
+            CHECK(final_ms > settings.target_ms);
+        else
+        {
+            CHECK(final_ms <= settings.target_ms * (1.0f + settings.hysteresis));
+            CHECK(final_ms >= settings.target_ms * 0.5f);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_budget_follows_load_changes)
+{
+    CloudBudgetSettings settings;
+
+    std::vector<float> trace;
+
+    trace.insert(trace.end(), 100, 2.0f);
+    trace.insert(trace.end(), 100, 10.0f);
+    trace.insert(trace.end(), 100, 3.0f);
+
+    std::vector<CloudBudgetLevel> levels;
+    std::vector<float>            times;
+
+    cloud_budget_simulate(settings, trace, 3, levels, times);
+
+    CHECK(same_level(levels[99], { 1.0f, 1.0f }));
+    CHECK(times[199] <= settings.target_ms * (1.0f + settings.hysteresis));
+    CHECK(levels[199].scale < 1.0f);
+    CHECK(same_level(levels[299], { 1.0f, 1.0f }));
+
+    // One change at most per settle period plus the latency, and each within CLOUD_BUDGET_MAX_CHANGE of the previous cost.
+    size_t last_change = 0;
+
+    for (size_t i = 1; i < trace.size(); i++)
+    {
+        if (same_level(levels[i], levels[i - 1]))
+            continue;
+
+        float ratio = cloud_budget_cost(levels[i]) / cloud_budget_cost(levels[i - 1]);
+
+        CHECK(ratio <= CLOUD_BUDGET_MAX_CHANGE + 1e-4f && ratio >= 1.0f / CLOUD_BUDGET_MAX_CHANGE - 1e-4f);
+        CHECK(last_change == 0 || i - last_change > settings.settle_frames);
+
+        last_change = i;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_budget_ignores_noise)
+{
+    CloudBudgetSettings settings;
+    settings.settle_frames = 4;
+
+    // +-5% of noise around a time that fits the budget at half the steps.
+    std::vector<float> trace(400);
+    uint32_t           state = 1;
+
+    for (float& ms : trace)
+    {
+        state = state * 1664525u + 1013904223u;
+        ms    = 7.6f * (0.95f + 0.1f * float(state >> 8) / float(1u << 24));
+    }
+
+    std::vector<CloudBudgetLevel> levels;
+    std::vector<float>            times;
+
+    cloud_budget_simulate(settings, trace, 3, levels, times);
+
+    CHECK(count_changes(levels, 0, trace.size()) <= 3);
+    CHECK(count_changes(levels, 100, trace.size()) == 0);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_budget_read_trace)
+{
+    const char* csv_path  = "cloud_budget_test.csv";
+    const char* json_path = "cloud_budget_test.json";
+
+    FILE* file = fopen(csv_path, "w");
+    CHECK(file != nullptr);
+
+    if (file)
+    {
+        fprintf(file, "frame,pass,cpu_ms,gpu_ms\n0,Clouds,0.1,1.5\n0,Tonemap,0.1,0.2\n1,Clouds,0.1,\n2,Clouds,0.1,2.25\n");
+        fclose(file);
+    }
+
+    file = fopen(json_path, "w");
+    CHECK(file != nullptr);
+
+    if (file)
+    {
+        fprintf(file, "{\"frame\":0,\"passes\":[{\"name\":\"Scene\",\"cpu_ms\":0.1,\"gpu_ms\":9.0},{\"name\":\"Clouds\",\"cpu_ms\":0.1,\"gpu_ms\":3.5}]}\n");
+        fprintf(file, "{\"frame\":1,\"passes\":[{\"name\":\"Clouds\",\"cpu_ms\":0.1,\"gpu_ms\":null}]}\n");
+        fprintf(file, "{\"frame\":2,\"passes\":[{\"name\":\"Clouds\",\"cpu_ms\":0.1,\"gpu_ms\":0.75}]}\n");
+        fclose(file);
+    }
+
+    std::vector<float> trace;
+
+    CHECK(cloud_budget_read_trace(csv_path, "Clouds", trace));
+    CHECK(trace == std::vector<float>({ 1.5f, 2.25f }));
+
+    CHECK(cloud_budget_read_trace(json_path, "Clouds", trace));
+    CHECK(trace == std::vector<float>({ 3.5f, 0.75f }));
+
+    CHECK(cloud_budget_read_trace(json_path, "Tonemap", trace));
+    CHECK(trace.empty());
+
+    CHECK(!cloud_budget_read_trace("missing_cloud_budget_trace.csv", "Clouds", trace));
+
+    remove(csv_path);
+    remove(json_path);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
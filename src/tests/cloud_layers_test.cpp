@@ -0,0 +1,246 @@
+#include "test.h"
+#include "cloud_layers.h"
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static std::vector<CloudLayer> default_stack()
+{
+    std::vector<CloudLayer> layers(2);
+
+    layers[0].type       = CLOUD_LAYER_VOLUMETRIC;
+    layers[0].min_height = 1500.0f;
+    layers[0].max_height = 4000.0f;
+    layers[1].min_height = 8000.0f;
+    layers[1].max_height = 8000.0f;
+
+    return layers;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static bool validate(const std::vector<CloudLayer>& layers)
+{
+    std::string error;
+    bool        valid = cloud_layers_validate(layers.data(), uint32_t(layers.size()), error);
+
+    // Every rejection says why.
+    CHECK(valid == error.empty());
+
+    return valid;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_layers_validate_stack)
+{
+    std::vector<CloudLayer> layers = default_stack();
+
+    CHECK(validate(layers));
+
+    // The shell alone is valid, a cirrus layer touching its top is too.
+    CHECK(validate(std::vector<CloudLayer>(layers.begin(), layers.begin() + 1)));
+
+    layers[1].min_height = layers[0].max_height;
+    layers[1].max_height = layers[0].max_height;
+
+    CHECK(validate(layers));
+
+    // Up to CLOUD_MAX_LAYERS.
+    layers = default_stack();
+
+    for (uint32_t i = 2; i < CLOUD_MAX_LAYERS; i++)
+    {
+        layers.push_back(layers.back());
+        layers.back().min_height = layers.back().max_height = 8000.0f + 2000.0f * float(i);
+    }
+
+    CHECK(layers.size() == CLOUD_MAX_LAYERS);
+    CHECK(validate(layers));
+
+    layers.push_back(layers.back());
+    layers.back().min_height = layers.back().max_height += 2000.0f;
+
+    CHECK(!validate(layers));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_layers_validate_rejects)
+{
+    // No volumetric layer, or two of them.
+    std::vector<CloudLayer> layers = default_stack();
+
+    CHECK(!validate(std::vector<CloudLayer>(layers.begin() + 1, layers.end())));
+
+    layers[1].type       = CLOUD_LAYER_VOLUMETRIC;
+    layers[1].max_height = 9000.0f;
+
+    CHECK(!validate(layers));
+
+    // A cirrus layer inside the shell, or at the height of another cirrus layer.
+    layers               = default_stack();
+    layers[1].min_height = layers[1].max_height = 2000.0f;
+
+    CHECK(!validate(layers));
+
+    layers = default_stack();
+    layers.push_back(layers[1]);
+
+    CHECK(!validate(layers));
+
+    // Layers out of order, a cirrus layer below the shell or below the cirrus layer listed before it.
+    layers               = default_stack();
+    layers[1].min_height = layers[1].max_height = 500.0f;
+
+    CHECK(!validate(layers));
+
+    layers = default_stack();
+    layers.push_back(layers[1]);
+    layers[2].min_height = layers[2].max_height = 6000.0f;
+
+    CHECK(!validate(layers));
+
+    std::swap(layers[1], layers[2]);
+
+    CHECK(validate(layers));
+
+    // A cirrus layer with a thickness or without a positive scale, and a negative or inverted height range.
+    layers               = default_stack();
+    layers[1].max_height = 8500.0f;
+
+    CHECK(!validate(layers));
+
+    layers          = default_stack();
+    layers[1].scale = 0.0f;
+
+    CHECK(!validate(layers));
+
+    layers               = default_stack();
+    layers[1].min_height = layers[1].max_height = -100.0f;
+
+    CHECK(!validate(layers));
+
+    layers               = default_stack();
+    layers[0].max_height = 1000.0f;
+
+    CHECK(!validate(layers));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_layer_distance_crossings)
+{
+    glm::vec3 center(0.0f, -6000.0f, 0.0f);
+
+    // From inside the sphere the ray leaves through it, up and sideways.
+    CHECK_NEAR(cloud_layer_distance(glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f), center, 8000.0f), 2000.0f, 1.0e-2f);
+    CHECK(cloud_layer_distance(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), center, 8000.0f) > 0.0f);
+
+    // From outside it is crossed on the near side, not at all when the ray points away or misses.
+    glm::vec3 above(0.0f, 4000.0f, 0.0f);
+
+    CHECK_NEAR(cloud_layer_distance(above, glm::vec3(0.0f, -1.0f, 0.0f), center, 8000.0f), 2000.0f, 1.0e-2f);
+    CHECK(cloud_layer_distance(above, glm::vec3(0.0f, 1.0f, 0.0f), center, 8000.0f) < 0.0f);
+    CHECK(cloud_layer_distance(glm::vec3(0.0f, 20000.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), center, 8000.0f) < 0.0f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_cirrus_texture_mips)
+{
+    std::vector<std::vector<float>> mips;
+
+    cloud_cirrus_texture_generate(64, 4, mips);
+
+    // Full chain down to 1x1, each mip the box filter of the one above.
+    CHECK(mips.size() == 7);
+
+    for (size_t i = 0; i < mips.size(); i++)
+        CHECK(mips[i].size() == size_t(64 >> i) * (64 >> i));
+
+    for (size_t i = 1; i < mips.size(); i++)
+    {
+        uint32_t size = 64 >> i;
+
+        for (uint32_t y = 0; y < size; y++)
+        {
+            for (uint32_t x = 0; x < size; x++)
+            {
+                const std::vector<float>& src = mips[i - 1];
+
+                float sum = src[(y * 2) * size * 2 + x * 2] + src[(y * 2) * size * 2 + x * 2 + 1] + src[(y * 2 + 1) * size * 2 + x * 2] + src[(y * 2 + 1) * size * 2 + x * 2 + 1];
+
+                CHECK_NEAR(mips[i][y * size + x], sum * 0.25f, 1.0e-6f);
+            }
+        }
+    }
+
+    // Equalized, so the whole texture averages to one half.
+    CHECK_NEAR(mips.back()[0], 0.5f, 1.0e-4f);
+
+    // Deterministic.
+    std::vector<std::vector<float>> again;
+
+    cloud_cirrus_texture_generate(64, 4, again);
+
+    CHECK(again == mips);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_cirrus_texture_coverage)
+{
+    std::vector<std::vector<float>> mips;
+
+    cloud_cirrus_texture_generate(CLOUD_CIRRUS_TEXTURE_SIZE, CLOUD_CIRRUS_TEXTURE_FREQUENCY, mips);
+
+    const std::vector<float>& texels = mips[0];
+
+    CHECK(*std::min_element(texels.begin(), texels.end()) > 0.0f);
+    CHECK(*std::max_element(texels.begin(), texels.end()) < 1.0f);
+
+    // shade_cirrus_layer() keeps the texels above 1 - coverage, a fraction 'coverage' of them.
+    for (float coverage : { 0.1f, 0.3f, 0.5f, 0.9f })
+    {
+        size_t kept = std::count_if(texels.begin(), texels.end(), [&](float value) { return value > 1.0f - coverage; });
+
+        CHECK_NEAR(float(kept) / float(texels.size()), coverage, 1.0e-3f);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_cirrus_texture_tiles)
+{
+    std::vector<std::vector<float>> mips;
+
+    cloud_cirrus_texture_generate(CLOUD_CIRRUS_TEXTURE_SIZE, CLOUD_CIRRUS_TEXTURE_FREQUENCY, mips);
+
+    const std::vector<float>& texels = mips[0];
+    const uint32_t            size   = CLOUD_CIRRUS_TEXTURE_SIZE;
+
+    // Sampled with GL_REPEAT, so the step across an edge is no larger than between any two neighbours inside the texture.
+    float inside = 0.0f;
+    float edge   = 0.0f;
+
+    for (uint32_t i = 0; i < size; i++)
+    {
+        for (uint32_t j = 0; j + 1 < size; j++)
+        {
+            inside = std::max(inside, fabsf(texels[i * size + j] - texels[i * size + j + 1]));
+            inside = std::max(inside, fabsf(texels[j * size + i] - texels[(j + 1) * size + i]));
+        }
+
+        edge = std::max(edge, fabsf(texels[i * size] - texels[i * size + size - 1]));
+        edge = std::max(edge, fabsf(texels[i] - texels[(size - 1) * size + i]));
+    }
+
+    CHECK(edge > 0.0f);
+    CHECK(edge <= inside);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
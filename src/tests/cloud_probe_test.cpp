@@ -0,0 +1,146 @@
+#include "test.h"
+#include "cloud_probe.h"
+
+#include <math.h>
+#include <random>
+#include <vector>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_probe_scheduler_covers_every_face)
+{
+    // Sizes that are and are not multiples of the tiles, including more tiles than half the size.
+    const uint32_t configurations[][2] = { { 64, 1 }, { 64, 2 }, { 64, 3 }, { 64, 12 }, { 10, 6 }, { 7, 7 } };
+
+    for (const uint32_t* configuration : configurations)
+    {
+        uint32_t size           = configuration[0];
+        uint32_t tiles_per_axis = configuration[1];
+
+        CloudProbeScheduler scheduler;
+
+        scheduler.reset(size, tiles_per_axis);
+
+        CHECK(scheduler.size() == size);
+        CHECK(scheduler.frames_per_cycle() == CLOUD_PROBE_FACES * tiles_per_axis * tiles_per_axis);
+
+        for (uint32_t cycle = 0; cycle < 2; cycle++)
+        {
+            std::vector<uint32_t> covered(size_t(CLOUD_PROBE_FACES) * size * size, 0);
+
+            for (uint32_t frame = 0; frame < scheduler.frames_per_cycle(); frame++)
+            {
+                CHECK(scheduler.complete() == (cycle > 0));
+
+                CloudProbeTile tile = scheduler.next();
+
+                // Faces in order, each face complete before the next starts.
+                CHECK(tile.face == frame / (tiles_per_axis * tiles_per_axis));
+                CHECK(tile.first_of_cycle == (frame == 0));
+                CHECK(tile.last_of_face == ((frame + 1) % (tiles_per_axis * tiles_per_axis) == 0));
+
+                // Never empty, never past the edge and never more than a texel apart in size.
+                CHECK(tile.width > 0 && tile.height > 0);
+                CHECK(tile.x + tile.width <= size && tile.y + tile.height <= size);
+                CHECK(tile.width >= size / tiles_per_axis && tile.width <= (size + tiles_per_axis - 1) / tiles_per_axis);
+
+                if (tile.face >= CLOUD_PROBE_FACES || tile.x + tile.width > size || tile.y + tile.height > size)
+                    continue;
+
+                for (uint32_t y = tile.y; y < tile.y + tile.height; y++)
+                {
+                    for (uint32_t x = tile.x; x < tile.x + tile.width; x++)
+                        covered[(size_t(tile.face) * size + y) * size + x]++;
+                }
+            }
+
+            CHECK(scheduler.complete());
+
+            for (uint32_t count : covered)
+                CHECK(count == 1);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_probe_scheduler_reset)
+{
+    CloudProbeScheduler scheduler;
+
+    // The tiles per axis are clamped to [1, size].
+    scheduler.reset(64, 0);
+    CHECK(scheduler.frames_per_cycle() == CLOUD_PROBE_FACES);
+
+    scheduler.reset(4, 9);
+    CHECK(scheduler.frames_per_cycle() == CLOUD_PROBE_FACES * 16);
+
+    // Starts over from the first tile of face 0 and is incomplete again.
+    scheduler.reset(64, 2);
+
+    for (uint32_t frame = 0; frame < scheduler.frames_per_cycle() + 3; frame++)
+        scheduler.next();
+
+    CHECK(scheduler.complete());
+
+    scheduler.reset(64, 2);
+
+    CloudProbeTile tile = scheduler.next();
+
+    CHECK(!scheduler.complete());
+    CHECK(tile.face == 0 && tile.x == 0 && tile.y == 0 && tile.first_of_cycle);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_probe_face_view_proj_matches_cubemap_lookup)
+{
+    // A direction projects to the texel the GL cubemap lookup reads for it (major axis table of the specification), with t along +y
+    // of the framebuffer.
+    std::mt19937                          rng(11);
+    std::uniform_real_distribution<float> coordinate(-1.0f, 1.0f);
+
+    const glm::vec3 position(100.0f, 2000.0f, -50.0f);
+
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        glm::vec3 r = glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng));
+        glm::vec3 a = glm::abs(r);
+
+        if (glm::length(r) < 0.1f)
+            continue;
+
+        uint32_t face;
+        float    sc, tc, ma;
+
+        if (a.x >= a.y && a.x >= a.z)
+        {
+            face = r.x > 0.0f ? 0 : 1;
+            sc   = r.x > 0.0f ? -r.z : r.z;
+            tc   = -r.y;
+            ma   = a.x;
+        }
+        else if (a.y >= a.z)
+        {
+            face = r.y > 0.0f ? 2 : 3;
+            sc   = r.x;
+            tc   = r.y > 0.0f ? r.z : -r.z;
+            ma   = a.y;
+        }
+        else
+        {
+            face = r.z > 0.0f ? 4 : 5;
+            sc   = r.z > 0.0f ? r.x : -r.x;
+            tc   = -r.y;
+            ma   = a.z;
+        }
+
+        glm::vec4 clip = cloud_probe_face_view_proj(face, position, 1.0f, 100000.0f) * glm::vec4(position + r * 10.0f, 1.0f);
+
+        CHECK(clip.w > 0.0f);
+        CHECK_NEAR(clip.x / clip.w, sc / ma, 1e-4f);
+        CHECK_NEAR(clip.y / clip.w, tc / ma, 1e-4f);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
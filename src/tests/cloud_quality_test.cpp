@@ -0,0 +1,156 @@
+#include "test.h"
+#include "cloud_quality.h"
+
+#include <set>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static std::string define_value(const ShaderDefines& defines, const char* name)
+{
+    for (const ShaderDefine& define : defines)
+    {
+        if (define.name == name)
+            return define.value;
+    }
+
+    return "";
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_quality_names)
+{
+    for (int i = 0; i < CLOUD_QUALITY_COUNT; i++)
+    {
+        CloudQualityTier tier = CLOUD_QUALITY_COUNT;
+
+        CHECK(cloud_quality_parse(cloud_quality_name(CloudQualityTier(i)), tier));
+        CHECK(tier == CloudQualityTier(i));
+    }
+
+    CloudQualityTier tier = CLOUD_QUALITY_HIGH;
+
+    CHECK(!cloud_quality_parse("ultra", tier));
+    CHECK(!cloud_quality_parse("", tier));
+    CHECK(tier == CLOUD_QUALITY_HIGH);
+
+    // Custom holds the defaults of the sample, the same as a default permutation.
+    CloudPermutation          defaults;
+    const CloudQualityPreset& custom = cloud_quality_preset(CLOUD_QUALITY_CUSTOM);
+
+    CHECK(custom.max_num_steps == defaults.max_num_steps && custom.cone_samples == defaults.cone_samples);
+    CHECK(custom.detail_noise == defaults.detail_noise && custom.light_volume == defaults.light_volume && custom.sky_view_lut == defaults.sky_view_lut);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_permutation_defines)
+{
+    ShaderDefines defines = { { "STALE", "1" } };
+
+    // Custom reads everything from its uniforms.
+    cloud_permutation_defines(cloud_quality_permutation(CLOUD_QUALITY_CUSTOM, true, true), defines);
+
+    CHECK(defines.empty());
+    CHECK(shader_defines_key(defines) == 0);
+
+    // The preset steps, cones and detail noise with the light march and sky model in use.
+    CloudPermutation low = cloud_quality_permutation(CLOUD_QUALITY_LOW, false, true);
+
+    cloud_permutation_defines(low, defines);
+
+    const CloudQualityPreset& preset = cloud_quality_preset(CLOUD_QUALITY_LOW);
+
+    CHECK(defines.size() == 5);
+    CHECK(define_value(defines, "CLOUD_MAX_NUM_STEPS") == std::to_string(preset.max_num_steps));
+    CHECK(define_value(defines, "CLOUD_CONE_SAMPLES") == std::to_string(preset.cone_samples));
+    CHECK(define_value(defines, "CLOUD_DETAIL_NOISE") == (preset.detail_noise ? "1" : "0"));
+    CHECK(define_value(defines, "CLOUD_LIGHT_VOLUME") == "0");
+    CHECK(define_value(defines, "CLOUD_SKY_VIEW_LUT") == "1");
+
+    // Out of range settings are clamped to what the shaders support.
+    low.max_num_steps = 0;
+    low.cone_samples  = CLOUD_MAX_CONE_SAMPLES + 3;
+
+    cloud_permutation_defines(low, defines);
+
+    CHECK(define_value(defines, "CLOUD_MAX_NUM_STEPS") == "1");
+    CHECK(define_value(defines, "CLOUD_CONE_SAMPLES") == std::to_string(CLOUD_MAX_CONE_SAMPLES));
+
+    low.cone_samples = 0;
+
+    cloud_permutation_defines(low, defines);
+
+    CHECK(define_value(defines, "CLOUD_CONE_SAMPLES") == "1");
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_permutation_variant_keys)
+{
+    // Every tier and light/sky combination is its own variant, and the same permutation is always the same one.
+    std::set<uint64_t> keys;
+    std::set<uint64_t> tier_keys;
+
+    for (int tier = CLOUD_QUALITY_LOW; tier < CLOUD_QUALITY_COUNT; tier++)
+    {
+        for (int combination = 0; combination < 4; combination++)
+        {
+            ShaderDefines defines;
+            ShaderDefines again;
+
+            cloud_permutation_defines(cloud_quality_permutation(CloudQualityTier(tier), combination & 1, combination & 2), defines);
+            cloud_permutation_defines(cloud_quality_permutation(CloudQualityTier(tier), combination & 1, combination & 2), again);
+
+            uint64_t key = shader_defines_key(defines);
+
+            CHECK(key != 0);
+            CHECK(key == shader_defines_key(again));
+
+            keys.insert(key);
+
+            // The tiers also differ from each other with the same light march and sky model.
+            if (combination == 3)
+                tier_keys.insert(key);
+        }
+    }
+
+    CHECK(keys.size() == 16);
+    CHECK(tier_keys.size() == 4);
+
+    // The order of the defines does not change the source or the key.
+    ShaderDefines defines;
+
+    cloud_permutation_defines(cloud_quality_permutation(CLOUD_QUALITY_MEDIUM, true, false), defines);
+
+    ShaderDefines reversed(defines.rbegin(), defines.rend());
+
+    CHECK(shader_defines_source(defines) == shader_defines_source(reversed));
+    CHECK(shader_defines_key(defines) == shader_defines_key(reversed));
+    CHECK(shader_defines_source(defines) == "#define CLOUD_CONE_SAMPLES 4\n#define CLOUD_DETAIL_NOISE 1\n#define CLOUD_LIGHT_VOLUME 1\n#define CLOUD_MAX_NUM_STEPS 96\n#define CLOUD_SKY_VIEW_LUT 0\n");
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_permutation_defines_are_used)
+{
+    // Every define is tested by the shaders, a renamed define would silently compile the uniform path.
+    std::string density;
+    std::string march;
+
+    CHECK(shader_read_file(VOLUMETRIC_CLOUDS_SHADER_DIR "/cloud_density.glsl", density));
+    CHECK(shader_read_file(VOLUMETRIC_CLOUDS_SHADER_DIR "/cloud_march.glsl", march));
+
+    ShaderDefines defines;
+
+    cloud_permutation_defines(cloud_quality_permutation(CLOUD_QUALITY_HIGH, true, true), defines);
+
+    for (const ShaderDefine& define : defines)
+    {
+        bool used = density.find("def " + define.name + "\n") != std::string::npos || march.find("def " + define.name + "\n") != std::string::npos;
+
+        CHECK(used);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
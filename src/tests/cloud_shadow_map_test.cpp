@@ -0,0 +1,105 @@
+#include "test.h"
+#include "cloud_shadow_map.h"
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_shadow_map_origin_is_snapped)
+{
+    const float extent = CLOUD_SHADOW_MAP_EXTENT;
+    const float texel  = extent / float(CLOUD_SHADOW_MAP_SIZE);
+
+    const glm::vec3 cameras[] = { glm::vec3(0.0f), glm::vec3(17.3f, 250.0f, -4.1f), glm::vec3(-12345.6f, 10.0f, 9876.5f), glm::vec3(texel * 0.49f, 0.0f, -texel * 0.51f) };
+
+    for (const glm::vec3& camera : cameras)
+    {
+        CloudShadowMapProjection projection = cloud_shadow_map_projection(camera, extent, CLOUD_SHADOW_MAP_SIZE, 100.0f);
+
+        CHECK_NEAR(projection.texel_size, texel, 1e-6f);
+        CHECK_NEAR(projection.plane_height, 100.0f, 0.0f);
+
+        // The origin is a multiple of the texel size and the closest one to the camera.
+        glm::vec2 cells = projection.origin / texel;
+
+        CHECK_NEAR(cells.x, roundf(cells.x), 1e-3f);
+        CHECK_NEAR(cells.y, roundf(cells.y), 1e-3f);
+        CHECK(fabsf(projection.origin.x - camera.x) <= texel * 0.5f + 1e-3f);
+        CHECK(fabsf(projection.origin.y - camera.z) <= texel * 0.5f + 1e-3f);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_shadow_map_texels_stay_put_as_the_camera_moves)
+{
+    const float extent = CLOUD_SHADOW_MAP_EXTENT;
+    const float texel  = extent / float(CLOUD_SHADOW_MAP_SIZE);
+
+    CloudShadowMapProjection a = cloud_shadow_map_projection(glm::vec3(texel * 0.1f, 0.0f, -texel * 0.2f), extent, CLOUD_SHADOW_MAP_SIZE, 0.0f);
+
+    // Move by a few texels plus a fraction, the map shifts by a whole number of texels and every texel centre lands on a centre of the
+    // previous map.
+    CloudShadowMapProjection b = cloud_shadow_map_projection(glm::vec3(texel * 3.4f, 0.0f, -texel * 7.9f), extent, CLOUD_SHADOW_MAP_SIZE, 0.0f);
+
+    glm::vec2 shift = (b.origin - a.origin) / texel;
+
+    CHECK_NEAR(shift.x, 3.0f, 1e-3f);
+    CHECK_NEAR(shift.y, -8.0f, 1e-3f);
+
+    const glm::ivec2 texels[] = { glm::ivec2(0, 0), glm::ivec2(100, 300), glm::ivec2(CLOUD_SHADOW_MAP_SIZE - 9, CLOUD_SHADOW_MAP_SIZE - 1) };
+
+    for (const glm::ivec2& texel_b : texels)
+    {
+        glm::vec3 pb = cloud_shadow_map_texel_position(b, texel_b, CLOUD_SHADOW_MAP_SIZE);
+        glm::vec3 pa = cloud_shadow_map_texel_position(a, texel_b + glm::ivec2(3, -8), CLOUD_SHADOW_MAP_SIZE);
+
+        CHECK_NEAR(pa.x, pb.x, 1e-2f);
+        CHECK_NEAR(pa.z, pb.z, 1e-2f);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_shadow_map_uv_round_trip)
+{
+    CloudShadowMapProjection projection = cloud_shadow_map_projection(glm::vec3(1234.0f, 50.0f, -567.0f), 8000.0f, 256, 20.0f);
+
+    // A texel centre on the plane maps back to the centre of that texel whatever the sun direction.
+    const glm::vec3 sun_dirs[] = { glm::vec3(0.0f, 1.0f, 0.0f), glm::normalize(glm::vec3(0.6f, 0.3f, -0.2f)) };
+
+    for (const glm::vec3& sun_dir : sun_dirs)
+    {
+        for (int y = 0; y < 256; y += 51)
+        {
+            for (int x = 0; x < 256; x += 37)
+            {
+                glm::vec3 position = cloud_shadow_map_texel_position(projection, glm::ivec2(x, y), 256);
+                glm::vec2 uv       = cloud_shadow_map_uv(projection, position, sun_dir);
+
+                CHECK_NEAR(uv.x, (float(x) + 0.5f) / 256.0f, 1e-4f);
+                CHECK_NEAR(uv.y, (float(y) + 0.5f) / 256.0f, 1e-4f);
+            }
+        }
+    }
+
+    // A point above the plane is slid along the sun direction down to it.
+    glm::vec3 sun_dir  = glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f));
+    glm::vec2 above    = cloud_shadow_map_uv(projection, glm::vec3(1234.0f, 1020.0f, -567.0f), sun_dir);
+    glm::vec2 expected = glm::vec2(-1000.0f + 1234.0f - projection.origin.x, -567.0f - projection.origin.y) / 8000.0f + 0.5f;
+
+    CHECK_NEAR(above.x, expected.x, 1e-4f);
+    CHECK_NEAR(above.y, expected.y, 1e-4f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_shadow_map_recenter)
+{
+    CloudShadowMapProjection projection = cloud_shadow_map_projection(glm::vec3(0.0f), 8000.0f, 256, 0.0f);
+
+    CHECK(!cloud_shadow_map_needs_recenter(projection, glm::vec3(0.0f, 5000.0f, 0.0f)));
+    CHECK(!cloud_shadow_map_needs_recenter(projection, glm::vec3(1900.0f, 0.0f, 0.0f)));
+    CHECK(cloud_shadow_map_needs_recenter(projection, glm::vec3(1500.0f, 0.0f, 1500.0f)));
+    CHECK(cloud_shadow_map_needs_recenter(projection, glm::vec3(0.0f, 0.0f, -2100.0f)));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
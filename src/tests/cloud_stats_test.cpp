@@ -0,0 +1,111 @@
+#include "test.h"
+#include "cloud_stats.h"
+#include "shader_source.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static CloudStatsTotals test_totals()
+{
+    CloudStatsTotals totals;
+
+    memset(&totals, 0, sizeof(totals));
+
+    totals.counters[CLOUD_STATS_STEPS]           = 5000;
+    totals.counters[CLOUD_STATS_DENSITY_FETCHES] = 4200;
+    totals.counters[CLOUD_STATS_DETAIL_FETCHES]  = 1300;
+    totals.counters[CLOUD_STATS_LIGHT_SAMPLES]   = 4294967295u;
+    totals.occupied_steps                        = 900;
+    totals.marched_pixels                        = 64;
+
+    return totals;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_stats_log_csv)
+{
+    const char* path = "cloud_stats_log_test.csv";
+
+    {
+        CloudStatsLog log;
+
+        CHECK(log.open(path));
+        CHECK(log.is_open());
+
+        log.write_frame(3, test_totals());
+        log.write_frame(4, CloudStatsTotals());
+        log.close();
+
+        CHECK(!log.is_open());
+    }
+
+    // The counters are unsigned, the largest one is not printed negative.
+    CHECK(test_read_file(path) == "frame,steps,density_fetches,detail_fetches,light_samples,occupied_steps,marched_pixels\n"
+                                  "3,5000,4200,1300,4294967295,900,64\n"
+                                  "4,0,0,0,0,0,0\n");
+
+    remove(path);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_stats_log_json_lines)
+{
+    const char* path = "cloud_stats_log_test.json";
+
+    {
+        CloudStatsLog log;
+
+        CHECK(log.open(path));
+
+        log.write_frame(12345678901ull, test_totals());
+    }
+
+    CHECK(test_read_file(path) == "{\"frame\":12345678901,\"steps\":5000,\"density_fetches\":4200,\"detail_fetches\":1300,"
+                                  "\"light_samples\":4294967295,\"occupied_steps\":900,\"marched_pixels\":64}\n");
+
+    remove(path);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_stats_log_closed)
+{
+    CloudStatsLog log;
+
+    // Writing without a file is a no-op, and a path that cannot be created fails to open.
+    log.write_frame(1, test_totals());
+
+    CHECK(!log.is_open());
+    CHECK(!log.open("missing_directory/cloud_stats.csv"));
+    CHECK(!log.is_open());
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_stats_glsl_sync)
+{
+    // The counter indices and the CloudStats block are duplicated in the shader, the layout itself is checked by the static asserts
+    // in cloud_stats.h.
+    std::string source;
+
+    CHECK(shader_read_file(VOLUMETRIC_CLOUDS_SHADER_DIR "/cloud_stats.glsl", source));
+
+    const char* defines[CLOUD_STATS_COUNTER_COUNT] = { "CLOUD_STATS_STEPS", "CLOUD_STATS_DENSITY_FETCHES", "CLOUD_STATS_DETAIL_FETCHES", "CLOUD_STATS_LIGHT_SAMPLES" };
+
+    for (uint32_t i = 0; i < CLOUD_STATS_COUNTER_COUNT; i++)
+        CHECK(source.find(std::string("#define ") + defines[i] + " " + std::to_string(i) + "\n") != std::string::npos);
+
+    CHECK(source.find("layout(std430, binding = 1) buffer CloudStats\n"
+                      "{\n"
+                      "    uint stats_counters[" + std::to_string(CLOUD_STATS_COUNTER_COUNT) + "];\n"
+                      "    uint stats_occupied_steps;\n"
+                      "    uint stats_marched_pixels;\n"
+                      "    uint stats_padding[2];\n"
+                      "};\n") != std::string::npos);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,165 @@
+#include "test.h"
+#include "cloud_reference.h"
+#include "cloud_tiles.h"
+
+#include <algorithm>
+#include <atomic>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_tile_pack_round_trip)
+{
+    CHECK(cloud_tile_count(0) == 0);
+    CHECK(cloud_tile_count(1) == 1);
+    CHECK(cloud_tile_count(CLOUD_TILE_SIZE) == 1);
+    CHECK(cloud_tile_count(CLOUD_TILE_SIZE + 1) == 2);
+    CHECK(cloud_tile_count(1920) == 120);
+
+    const uint32_t coordinates[][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 119, 67 }, { 0xffff, 0xffff } };
+
+    for (const uint32_t* c : coordinates)
+    {
+        uint32_t x = 0, y = 0;
+
+        cloud_tile_unpack(cloud_tile_pack(c[0], c[1]), x, y);
+
+        CHECK(x == c[0] && y == c[1]);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_tiles_classify_compacts_every_tile_once)
+{
+    // Not a multiple of the tile size, so that the last row and column of tiles are partial.
+    const uint32_t width   = 5 * CLOUD_TILE_SIZE + 7;
+    const uint32_t height  = 3 * CLOUD_TILE_SIZE + 1;
+    const uint32_t tiles_x = cloud_tile_count(width);
+    const uint32_t tiles_y = cloud_tile_count(height);
+
+    // A disk, a lone pixel in the corner of a partial tile and the last pixel of the target need a march.
+    auto needs_march = [&](uint32_t x, uint32_t y) {
+        int32_t dx = int32_t(x) - 30;
+        int32_t dy = int32_t(y) - 20;
+
+        return dx * dx + dy * dy < 100 || (x == 5 * CLOUD_TILE_SIZE && y == 2 * CLOUD_TILE_SIZE + 3) || (x == width - 1 && y == height - 1);
+    };
+
+    std::vector<bool> expected(tiles_x * tiles_y, false);
+
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            if (needs_march(x, y))
+                expected[(y / CLOUD_TILE_SIZE) * tiles_x + x / CLOUD_TILE_SIZE] = true;
+        }
+    }
+
+    for (uint32_t num_threads : { 1u, 4u })
+    {
+        std::vector<std::atomic<uint32_t>> shaded(width * height);
+        std::vector<uint32_t>              tiles;
+        std::atomic<bool>                  bad_thread(false);
+
+        for (std::atomic<uint32_t>& count : shaded)
+            count = 0;
+
+        cloud_tiles_classify(width, height, num_threads, needs_march, [&](uint32_t x, uint32_t y, uint32_t thread) {
+            shaded[y * width + x]++;
+
+            if (thread >= num_threads)
+                bad_thread = true;
+        }, tiles);
+
+        CHECK(!bad_thread);
+
+        // The marched tiles are exactly the ones with a pixel that needs it, each appended once.
+        std::vector<uint32_t> marched(tiles_x * tiles_y, 0);
+
+        for (uint32_t tile : tiles)
+        {
+            uint32_t x = 0, y = 0;
+
+            cloud_tile_unpack(tile, x, y);
+
+            CHECK(x < tiles_x && y < tiles_y);
+
+            if (x < tiles_x && y < tiles_y)
+                marched[y * tiles_x + x]++;
+        }
+
+        for (uint32_t i = 0; i < tiles_x * tiles_y; i++)
+            CHECK(marched[i] == (expected[i] ? 1u : 0u));
+
+        // Every pixel of the other tiles is shaded once by the classification, including those of the partial tiles.
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+                CHECK(shaded[y * width + x] == (expected[(y / CLOUD_TILE_SIZE) * tiles_x + x / CLOUD_TILE_SIZE] ? 0u : 1u));
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(cloud_tiles_skip_only_empty_pixels)
+{
+    // Wherever the classification says a pixel needs no march, the shortcut matches the full march.
+    CloudParameters params;
+    CloudCamera     camera;
+    CloudReference  reference;
+
+    params.light_volume = false;
+
+    bool initialized = reference.initialize(VOLUMETRIC_CLOUDS_TEXTURE_DIR, params, 64, 32);
+
+    CHECK(initialized);
+
+    if (!initialized)
+        return;
+
+    const uint32_t width  = 48;
+    const uint32_t height = 27;
+
+    // Looking down at the ground, which hides the cloud layer in the lower half, then a coverage with no clouds at all.
+    const float coverages[] = { 0.5f, 1.0f };
+    uint32_t    skipped     = 0;
+    uint32_t    marched     = 0;
+
+    camera.forward = glm::normalize(glm::vec3(-1.0f, -0.2f, 0.3f));
+
+    for (float coverage : coverages)
+    {
+        params.cloud_coverage = coverage;
+
+        reference.set_parameters(params, camera, width, height);
+
+        for (uint32_t y = 0; y < height; y++)
+        {
+            for (uint32_t x = 0; x < width; x++)
+            {
+                CloudReferenceStats stats;
+
+                if (reference.pixel_needs_march(x, y))
+                {
+                    marched++;
+                    continue;
+                }
+
+                glm::vec3 empty = reference.shade_empty_pixel(x, y, stats);
+                glm::vec3 full  = reference.shade_pixel(x, y, stats);
+                glm::vec3 error = glm::abs(empty - full);
+
+                CHECK(std::max(error.x, std::max(error.y, error.z)) <= 1e-5f);
+
+                skipped++;
+            }
+        }
+    }
+
+    CHECK(skipped > 0);
+    CHECK(marched > 0);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,162 @@
+#include "test.h"
+#include "cloud_reference.h"
+#include "cpu_noise.h"
+#include "empty_space_grid.h"
+
+#include <algorithm>
+#include <random>
+
+#define TEST_SHAPE_SIZE 32
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Shape noise quantized as the sample uploads it with 'format', along with the grid built from it.
+static void build_test_grid(NoiseFormat format, std::vector<float>& texels, ReferenceVolume& volume, std::vector<float>& grid)
+{
+    std::vector<float> shape(size_t(TEST_SHAPE_SIZE) * TEST_SHAPE_SIZE * TEST_SHAPE_SIZE * 4);
+
+    cpu_noise_generate(CPU_NOISE_VOLUME_SHAPE, TEST_SHAPE_SIZE, 4.0f, CPU_NOISE_BACKEND_SCALAR, 1, shape.data());
+    noise_format_pack(format, CPU_NOISE_VOLUME_SHAPE, shape.data(), shape.size() / 4, texels);
+
+    uint32_t channels = noise_format_channels(format, CPU_NOISE_VOLUME_SHAPE);
+
+    volume.create(texels.data(), TEST_SHAPE_SIZE, channels, format);
+
+    for (float& value : texels)
+        value = noise_format_quantize(format, value);
+
+    empty_space_build_grid(texels.data(), TEST_SHAPE_SIZE, EMPTY_SPACE_CELL_SIZE, channels, grid);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(empty_space_grid_bounds_every_sample)
+{
+    // Any trilinear sample of the mips the march uses while skipping, inside a cell or up to one texel outside it, must be at or below
+    // the bound of the cell. Otherwise a coverage between the two would skip a sample with a non-zero density.
+    const NoiseFormat formats[] = { NOISE_FORMAT_RGBA16F, NOISE_FORMAT_UNORM8, NOISE_FORMAT_FOLDED };
+    const int32_t     cells     = TEST_SHAPE_SIZE / EMPTY_SPACE_CELL_SIZE;
+
+    std::mt19937                          rng(7);
+    std::uniform_real_distribution<float> offset(-1.0f, float(EMPTY_SPACE_CELL_SIZE) + 1.0f);
+    std::uniform_real_distribution<float> lod(0.0f, EMPTY_SPACE_MAX_SHAPE_LOD);
+
+    for (NoiseFormat format : formats)
+    {
+        std::vector<float> texels;
+        std::vector<float> grid;
+        ReferenceVolume    volume;
+
+        build_test_grid(format, texels, volume, grid);
+
+        CHECK(grid.size() == size_t(cells) * cells * cells);
+
+        uint32_t violations = 0;
+
+        for (int32_t cell = 0; cell < cells * cells * cells; cell++)
+        {
+            glm::ivec3 c = glm::ivec3(cell % cells, (cell / cells) % cells, cell / (cells * cells));
+
+            for (uint32_t i = 0; i < 64; i++)
+            {
+                glm::vec3 texel  = glm::vec3(c * EMPTY_SPACE_CELL_SIZE) + glm::vec3(offset(rng), offset(rng), offset(rng));
+                glm::vec4 sample = volume.sample_lod(texel / float(TEST_SHAPE_SIZE), lod(rng));
+                float     base   = noise_format_folded(format) ? sample.x : empty_space_base_cloud(&sample.x);
+
+                if (base > grid[cell])
+                    violations++;
+            }
+        }
+
+        CHECK(violations == 0);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(empty_space_grid_bounds_coarse_mips)
+{
+    // Full density everywhere except in the texels the grid reads for the cells at x = 0, [-2, EMPTY_SPACE_CELL_SIZE + 1].
+    std::vector<float> texels(size_t(TEST_SHAPE_SIZE) * TEST_SHAPE_SIZE * TEST_SHAPE_SIZE);
+    std::vector<float> grid;
+    ReferenceVolume    volume;
+
+    for (size_t i = 0; i < texels.size(); i++)
+    {
+        int32_t x = int32_t(i % TEST_SHAPE_SIZE);
+
+        texels[i] = x > EMPTY_SPACE_CELL_SIZE + 1 && x < TEST_SHAPE_SIZE - 2 ? 1.0f : 0.0f;
+    }
+
+    volume.create(texels.data(), TEST_SHAPE_SIZE, 1, NOISE_FORMAT_FOLDED);
+    empty_space_build_grid(texels.data(), TEST_SHAPE_SIZE, EMPTY_SPACE_CELL_SIZE, 1, grid);
+
+    CHECK(grid[0] == EMPTY_SPACE_MARGIN);
+
+    // Largest sample of the cells at x = 0, up to one texel outside of them.
+    auto max_sample = [&](float lod) {
+        float result = 0.0f;
+
+        for (float x = -1.0f; x <= float(EMPTY_SPACE_CELL_SIZE) + 1.0f; x += 0.125f)
+            result = std::max(result, volume.sample_lod(glm::vec3(x, 8.0f, 8.0f) / float(TEST_SHAPE_SIZE), lod).x);
+
+        return result;
+    };
+
+    CHECK(max_sample(0.0f) <= grid[0]);
+    CHECK(max_sample(EMPTY_SPACE_MAX_SHAPE_LOD * 0.5f) <= grid[0]);
+    CHECK(max_sample(EMPTY_SPACE_MAX_SHAPE_LOD) <= grid[0]);
+
+    // One mip further the slab bleeds into the cells, the reason the march clamps the shape lod.
+    CHECK(max_sample(EMPTY_SPACE_MAX_SHAPE_LOD + 1.0f) > grid[0]);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(empty_space_skipping_is_conservative)
+{
+    // The reference march evaluates every sample the grid lets it skip and counts the non-zero ones.
+    CloudParameters params;
+    CloudCamera     camera;
+    CloudReference  reference;
+
+    // The light volume does not change what is skipped and would be rebuilt for every view.
+    params.light_volume = false;
+
+    bool initialized = reference.initialize(VOLUMETRIC_CLOUDS_TEXTURE_DIR, params, 64, 32);
+
+    CHECK(initialized);
+
+    if (!initialized)
+        return;
+
+    reference.set_verify_empty_space(true);
+
+    const uint32_t      width        = 96;
+    const uint32_t      height       = 54;
+    const float         coverages[]  = { 0.5f, 0.7f };
+    const glm::vec3     directions[] = { glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(-1.0f, 0.6f, 0.3f) };
+    CloudReferenceStats stats;
+
+    for (float coverage : coverages)
+    {
+        for (const glm::vec3& direction : directions)
+        {
+            params.cloud_coverage = coverage;
+            camera.forward        = glm::normalize(direction);
+
+            reference.set_parameters(params, camera, width, height);
+
+            for (uint32_t y = 0; y < height; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                    reference.shade_pixel(x, y, stats);
+            }
+        }
+    }
+
+    CHECK(stats.skipped_samples > 0);
+    CHECK(stats.skip_violations == 0);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
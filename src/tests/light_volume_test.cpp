@@ -0,0 +1,87 @@
+#include "test.h"
+#include "light_volume.h"
+
+#include <math.h>
+
+// The planet and shell of the sample.
+#define TEST_PLANET_RADIUS 35000.0f
+#define TEST_CLOUD_MIN_HEIGHT 1500.0f
+#define TEST_CLOUD_MAX_HEIGHT 4000.0f
+
+static const glm::vec3 kPlanetCenter = glm::vec3(0.0f, -TEST_PLANET_RADIUS, 0.0f);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(light_volume_extent_covers_horizon)
+{
+    const float outer_radius = TEST_PLANET_RADIUS + TEST_CLOUD_MAX_HEIGHT;
+
+    glm::vec3 camera_pos = glm::vec3(0.0f, 5.0f, 0.0f);
+    float     extent     = light_volume_extent(camera_pos, kPlanetCenter, TEST_PLANET_RADIUS, TEST_CLOUD_MAX_HEIGHT);
+
+    // The outer shell meets the horizon plane of the camera at this distance, the volume reaches LIGHT_VOLUME_MARGIN past it.
+    float distance = glm::length(camera_pos - kPlanetCenter);
+    float horizon  = sqrtf(outer_radius * outer_radius - distance * distance);
+
+    CHECK_NEAR(extent * 0.5f, horizon * LIGHT_VOLUME_MARGIN, 1.0f);
+
+    // Higher up less of the shell is in front of the horizon.
+    CHECK(light_volume_extent(glm::vec3(0.0f, 3000.0f, 0.0f), kPlanetCenter, TEST_PLANET_RADIUS, TEST_CLOUD_MAX_HEIGHT) < extent);
+
+    // Above the shell it falls back to the size of the shell.
+    CHECK_NEAR(light_volume_extent(glm::vec3(0.0f, 10000.0f, 0.0f), kPlanetCenter, TEST_PLANET_RADIUS, TEST_CLOUD_MAX_HEIGHT), 2.0f * outer_radius * LIGHT_VOLUME_MARGIN, 1.0f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(light_volume_out_of_range)
+{
+    glm::vec3 origin = glm::vec3(100.0f, 5.0f, -200.0f);
+    float     extent = light_volume_extent(origin, kPlanetCenter, TEST_PLANET_RADIUS, TEST_CLOUD_MAX_HEIGHT);
+
+    // The margin past the horizon is how far the camera may move before the volume has to be rebuilt.
+    float reach = extent * 0.5f / LIGHT_VOLUME_MARGIN * (LIGHT_VOLUME_MARGIN - 1.0f);
+
+    CHECK(!light_volume_out_of_range(origin, extent, origin));
+    CHECK(!light_volume_out_of_range(origin, extent, origin + glm::vec3(reach * 0.99f, 0.0f, 0.0f)));
+    CHECK(!light_volume_out_of_range(origin, extent, origin + glm::vec3(0.0f, 0.0f, -reach * 0.99f)));
+    CHECK(light_volume_out_of_range(origin, extent, origin + glm::vec3(reach * 1.01f, 0.0f, 0.0f)));
+    CHECK(light_volume_out_of_range(origin, extent, origin + glm::vec3(reach * 0.8f, 0.0f, reach * 0.8f)));
+
+    // Only the horizontal distance counts, the volume covers the whole height of the shell.
+    CHECK(!light_volume_out_of_range(origin, extent, origin + glm::vec3(0.0f, 3000.0f, 0.0f)));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(light_volume_texel_positions)
+{
+    glm::vec3 origin = glm::vec3(100.0f, 5.0f, -200.0f);
+    float     extent = light_volume_extent(origin, kPlanetCenter, TEST_PLANET_RADIUS, TEST_CLOUD_MAX_HEIGHT);
+
+    const glm::ivec3 texels[] = { glm::ivec3(0, 0, 0), glm::ivec3(LIGHT_VOLUME_SIZE / 2, LIGHT_VOLUME_SIZE / 2, LIGHT_VOLUME_HEIGHT / 2), glm::ivec3(LIGHT_VOLUME_SIZE - 1, 17, LIGHT_VOLUME_HEIGHT - 1), glm::ivec3(3, LIGHT_VOLUME_SIZE - 1, 5) };
+
+    for (const glm::ivec3& texel : texels)
+    {
+        glm::vec3 position = light_volume_texel_position(texel, origin, extent, kPlanetCenter, TEST_PLANET_RADIUS, TEST_CLOUD_MIN_HEIGHT, TEST_CLOUD_MAX_HEIGHT);
+
+        // The lookup of sample_light_volume() in cloud_march.glsl lands on the centre of the texel that was built for the position.
+        glm::vec2 uv              = (glm::vec2(position.x, position.z) - glm::vec2(origin.x, origin.z)) / extent + 0.5f;
+        float     height_fraction = (glm::length(position - kPlanetCenter) - (TEST_PLANET_RADIUS + TEST_CLOUD_MIN_HEIGHT)) / (TEST_CLOUD_MAX_HEIGHT - TEST_CLOUD_MIN_HEIGHT);
+
+        CHECK_NEAR(uv.x * LIGHT_VOLUME_SIZE - 0.5f, float(texel.x), 1e-2f);
+        CHECK_NEAR(uv.y * LIGHT_VOLUME_SIZE - 0.5f, float(texel.y), 1e-2f);
+        CHECK_NEAR(height_fraction * LIGHT_VOLUME_HEIGHT - 0.5f, float(texel.z), 1e-2f);
+
+        // Texels are placed on the upper side of the shell.
+        CHECK(position.y > kPlanetCenter.y);
+    }
+
+    // The corner texel is half a texel inside the square of the volume.
+    glm::vec3 corner = light_volume_texel_position(glm::ivec3(0), origin, extent, kPlanetCenter, TEST_PLANET_RADIUS, TEST_CLOUD_MIN_HEIGHT, TEST_CLOUD_MAX_HEIGHT);
+
+    CHECK_NEAR(corner.x, origin.x - extent * 0.5f * (1.0f - 1.0f / LIGHT_VOLUME_SIZE), 1e-1f);
+    CHECK_NEAR(corner.z, origin.z - extent * 0.5f * (1.0f - 1.0f / LIGHT_VOLUME_SIZE), 1e-1f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
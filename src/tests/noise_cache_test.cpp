@@ -0,0 +1,127 @@
+#include "test.h"
+#include "noise_cache.h"
+#include "noise_format.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_cache_key_changes_with_every_input)
+{
+    std::vector<std::string> sources = { "shape", "noise" };
+
+    uint64_t key = noise_cache_key(sources, 128, { 4.0f }, NOISE_FORMAT_RGBA16F);
+
+    CHECK(noise_cache_key(sources, 128, { 4.0f }, NOISE_FORMAT_RGBA16F) == key);
+    CHECK(noise_cache_key({ "shape ", "noise" }, 128, { 4.0f }, NOISE_FORMAT_RGBA16F) != key);
+    CHECK(noise_cache_key(sources, 64, { 4.0f }, NOISE_FORMAT_RGBA16F) != key);
+    CHECK(noise_cache_key(sources, 128, { 4.5f }, NOISE_FORMAT_RGBA16F) != key);
+    CHECK(noise_cache_key(sources, 128, { 4.0f }, NOISE_FORMAT_UNORM8) != key);
+    CHECK(noise_cache_key(sources, 128, { 4.0f }, NOISE_FORMAT_FOLDED) != key);
+
+    // Sources are length prefixed, moving text from one to the other is a different key.
+    CHECK(noise_cache_key({ "shap", "enoise" }, 128, { 4.0f }, NOISE_FORMAT_RGBA16F) != key);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static NoiseVolume test_volume(std::vector<uint8_t>& mip0, std::vector<uint8_t>& mip1)
+{
+    mip0.resize(4 * 4 * 4 * 2);
+    mip1.resize(2 * 2 * 2 * 2);
+
+    for (size_t i = 0; i < mip0.size(); i++)
+        mip0[i] = uint8_t(i * 7);
+
+    for (size_t i = 0; i < mip1.size(); i++)
+        mip1[i] = uint8_t(255 - i);
+
+    NoiseVolume volume;
+
+    volume.key             = 0x1234567890abcdefull;
+    volume.internal_format = 1;
+    volume.format          = 2;
+    volume.type            = 3;
+    volume.mips            = { { 4, 4, 4, 0, 0, mip0.size() }, { 2, 2, 2, 0, 0, mip1.size() } };
+    volume.mip_data        = { mip0.data(), mip1.data() };
+
+    return volume;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_cache_serialize_round_trip)
+{
+    std::vector<uint8_t> mip0, mip1, data;
+    NoiseVolume          volume = test_volume(mip0, mip1);
+
+    noise_cache_serialize(volume, data);
+
+    NoiseVolume parsed;
+
+    CHECK(noise_cache_parse(data.data(), data.size(), volume.key, parsed));
+    CHECK(parsed.internal_format == 1 && parsed.format == 2 && parsed.type == 3);
+    CHECK(parsed.mips.size() == 2);
+
+    if (parsed.mips.size() != 2)
+        return;
+
+    for (size_t i = 0; i < 2; i++)
+    {
+        CHECK(parsed.mips[i].offset % NOISE_CACHE_ALIGNMENT == 0);
+        CHECK(parsed.mips[i].size == volume.mips[i].size);
+        CHECK(memcmp(parsed.mip_data[i], volume.mip_data[i], volume.mips[i].size) == 0);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_cache_rejects_stale_and_corrupt_files)
+{
+    std::vector<uint8_t> mip0, mip1, data;
+    NoiseVolume          volume = test_volume(mip0, mip1);
+    NoiseVolume          parsed;
+
+    noise_cache_serialize(volume, data);
+
+    CHECK(!noise_cache_parse(data.data(), data.size(), volume.key + 1, parsed));
+    CHECK(!noise_cache_parse(data.data(), data.size() - 1, volume.key, parsed));
+    CHECK(!noise_cache_parse(data.data(), sizeof(NoiseCacheHeader) - 1, volume.key, parsed));
+    CHECK(!noise_cache_parse(nullptr, 0, volume.key, parsed));
+
+    std::vector<uint8_t> bad_version = data;
+
+    bad_version[offsetof(NoiseCacheHeader, version)]++;
+
+    CHECK(!noise_cache_parse(bad_version.data(), bad_version.size(), volume.key, parsed));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_cache_file_round_trip)
+{
+    std::vector<uint8_t> mip0, mip1;
+    NoiseVolume          volume = test_volume(mip0, mip1);
+    const char*          path   = "noise_cache_test.bin";
+
+    CHECK(noise_cache_write(path, volume));
+
+    {
+        NoiseCacheFile file;
+        NoiseVolume    parsed;
+
+        CHECK(file.open(path));
+        CHECK(noise_cache_parse(file.data(), file.size(), volume.key, parsed));
+        CHECK(parsed.mips.size() == 2 && memcmp(parsed.mip_data[1], mip1.data(), mip1.size()) == 0);
+    }
+
+    remove(path);
+
+    NoiseCacheFile missing;
+
+    CHECK(!missing.open(path));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
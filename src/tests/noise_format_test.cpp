@@ -0,0 +1,130 @@
+#include "test.h"
+#include "noise_format.h"
+#include "empty_space_grid.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#define TEST_NOISE_SIZE 16
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_format_cache_paths)
+{
+    CHECK(noise_format_cache_path(NOISE_FORMAT_RGBA16F, CPU_NOISE_VOLUME_SHAPE) == "shape_noise_rgba16f.cache");
+    CHECK(noise_format_cache_path(NOISE_FORMAT_UNORM8, CPU_NOISE_VOLUME_DETAIL) == "detail_noise_unorm8.cache");
+
+    // Every format and volume has a file of its own.
+    std::vector<std::string> paths;
+
+    for (int f = 0; f < NOISE_FORMAT_COUNT; f++)
+    {
+        paths.push_back(noise_format_cache_path(NoiseFormat(f), CPU_NOISE_VOLUME_SHAPE));
+        paths.push_back(noise_format_cache_path(NoiseFormat(f), CPU_NOISE_VOLUME_DETAIL));
+    }
+
+    std::sort(paths.begin(), paths.end());
+
+    CHECK(std::unique(paths.begin(), paths.end()) == paths.end());
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_format_texel_sizes)
+{
+    // The table in noise_format.h.
+    CHECK(noise_format_texel_size(NOISE_FORMAT_RGBA16F, CPU_NOISE_VOLUME_SHAPE) == 8);
+    CHECK(noise_format_texel_size(NOISE_FORMAT_RGBA16F, CPU_NOISE_VOLUME_DETAIL) == 8);
+    CHECK(noise_format_texel_size(NOISE_FORMAT_UNORM8, CPU_NOISE_VOLUME_SHAPE) == 4);
+    CHECK(noise_format_texel_size(NOISE_FORMAT_UNORM8, CPU_NOISE_VOLUME_DETAIL) == 3);
+    CHECK(noise_format_texel_size(NOISE_FORMAT_FOLDED, CPU_NOISE_VOLUME_SHAPE) == 1);
+    CHECK(noise_format_texel_size(NOISE_FORMAT_FOLDED, CPU_NOISE_VOLUME_DETAIL) == 1);
+
+    // Encoding writes exactly the bytes of the texels.
+    std::vector<float>   channels(5 * 4, 0.5f);
+    std::vector<uint8_t> bytes;
+
+    for (int f = 0; f < NOISE_FORMAT_COUNT; f++)
+    {
+        NoiseFormat format = NoiseFormat(f);
+        uint32_t    count  = 5 * noise_format_channels(format, CPU_NOISE_VOLUME_DETAIL);
+
+        noise_format_encode(format, channels.data(), count, bytes);
+
+        CHECK(bytes.size() == 5 * noise_format_texel_size(format, CPU_NOISE_VOLUME_DETAIL));
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_format_pack_and_quantize)
+{
+    const float        texel[4] = { 0.8f, 0.3f, 0.6f, 0.9f };
+    std::vector<float> packed;
+
+    // Unfolded formats keep the channels they store.
+    noise_format_pack(NOISE_FORMAT_UNORM8, CPU_NOISE_VOLUME_DETAIL, texel, 1, packed);
+
+    CHECK(packed.size() == 3);
+    CHECK(memcmp(packed.data(), texel, sizeof(float) * 3) == 0);
+
+    // Folded volumes hold what sample_cloud_density() derives from the texel.
+    noise_format_pack(NOISE_FORMAT_FOLDED, CPU_NOISE_VOLUME_DETAIL, texel, 1, packed);
+
+    CHECK(packed.size() == 1);
+    CHECK_NEAR(packed[0], noise_detail_fbm(texel), 1e-6f);
+
+    noise_format_pack(NOISE_FORMAT_FOLDED, CPU_NOISE_VOLUME_SHAPE, texel, 1, packed);
+
+    CHECK_NEAR(packed[0], std::min(std::max(empty_space_base_cloud(texel), 0.0f), 1.0f), 1e-6f);
+
+    // UNORM8 clamps to [0, 1] and rounds to the nearest of 256 levels, and quantizing twice changes nothing.
+    CHECK(noise_format_quantize(NOISE_FORMAT_UNORM8, -0.5f) == 0.0f);
+    CHECK(noise_format_quantize(NOISE_FORMAT_UNORM8, 1.5f) == 1.0f);
+    CHECK_NEAR(noise_format_quantize(NOISE_FORMAT_UNORM8, 0.5f), 128.0f / 255.0f, 1e-6f);
+
+    for (float value = 0.0f; value <= 1.0f; value += 0.0137f)
+    {
+        for (int f = 0; f < NOISE_FORMAT_COUNT; f++)
+        {
+            float quantized = noise_format_quantize(NoiseFormat(f), value);
+
+            CHECK(noise_format_quantize(NoiseFormat(f), quantized) == quantized);
+            CHECK(fabsf(quantized - value) <= (f == NOISE_FORMAT_RGBA16F ? 1e-3f : 0.5f / 255.0f + 1e-6f));
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_format_error_against_rgba16f)
+{
+    std::vector<float> texels(size_t(TEST_NOISE_SIZE) * TEST_NOISE_SIZE * TEST_NOISE_SIZE * 4);
+
+    cpu_noise_generate(CPU_NOISE_VOLUME_DETAIL, TEST_NOISE_SIZE, 8.0f, CPU_NOISE_BACKEND_SCALAR, 1, texels.data());
+
+    NoiseFormatError at_texels;
+    NoiseFormatError between_texels;
+
+    // RGBA16F is the reference.
+    noise_format_error(NOISE_FORMAT_RGBA16F, CPU_NOISE_VOLUME_DETAIL, texels.data(), TEST_NOISE_SIZE, at_texels, between_texels);
+
+    CHECK(at_texels.max_error == 0.0f);
+    CHECK(between_texels.max_error == 0.0f);
+
+    // The Worley FBM weights sum to one, so UNORM8 stays within half a level of it plus the half precision of the reference.
+    noise_format_error(NOISE_FORMAT_UNORM8, CPU_NOISE_VOLUME_DETAIL, texels.data(), TEST_NOISE_SIZE, at_texels, between_texels);
+
+    CHECK(at_texels.max_error > 0.0f);
+    CHECK(at_texels.max_error <= 0.5f / 255.0f + 1e-3f);
+    CHECK(at_texels.rms_error <= at_texels.max_error);
+
+    // The FBM is linear, so folding it commutes with filtering and the error between texels stays as small.
+    noise_format_error(NOISE_FORMAT_FOLDED, CPU_NOISE_VOLUME_DETAIL, texels.data(), TEST_NOISE_SIZE, at_texels, between_texels);
+
+    CHECK(at_texels.max_error <= 0.5f / 255.0f + 1e-3f);
+    CHECK(between_texels.max_error <= 0.5f / 255.0f + 1e-3f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,189 @@
+#include "test.h"
+#include "cpu_noise.h"
+#include "noise_regenerator.h"
+
+#include <algorithm>
+#include <random>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_slab_budget)
+{
+    NoiseSlabBudget budget;
+
+    // The guess until the first measurement, which replaces it.
+    budget.reset(2.0f);
+
+    CHECK(budget.texels(4.0f) == 2000000);
+    CHECK(budget.texels(0.0f) == 0);
+    CHECK(budget.texels(-1.0f) == 0);
+
+    budget.report(0, 1.0f);
+    budget.report(1000000, -1.0f);
+
+    CHECK(budget.ms_per_mtexel() == 2.0f);
+
+    budget.report(500000, 4.0f);
+
+    CHECK_NEAR(budget.ms_per_mtexel(), 8.0f, 1e-5f);
+    CHECK(budget.texels(2.0f) == 250000);
+
+    // Later measurements are smoothed.
+    budget.report(1000000, 16.0f);
+
+    CHECK_NEAR(budget.ms_per_mtexel(), 8.0f + (16.0f - 8.0f) * NOISE_BUDGET_SMOOTHING, 1e-5f);
+
+    // reset() forgets the measurements.
+    budget.reset(1.0f);
+    budget.report(1000000, 3.0f);
+
+    CHECK_NEAR(budget.ms_per_mtexel(), 3.0f, 1e-5f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_slab_scheduler_order)
+{
+    const uint32_t size       = 32;
+    const uint32_t slab_depth = 4;
+    const uint64_t slab       = uint64_t(size) * size * slab_depth;
+    const uint64_t budgets[]  = { 0, slab - 1, slab, slab * 3 + 7, slab * 100 };
+
+    for (uint64_t budget : budgets)
+    {
+        NoiseSlabScheduler scheduler;
+
+        CHECK(!scheduler.active());
+        CHECK(scheduler.progress() == 1.0f);
+
+        scheduler.begin(size, slab_depth);
+
+        CHECK(scheduler.active());
+        CHECK(scheduler.progress() == 0.0f);
+
+        // Slices built so far per mip, the scheduler must hand them out in order and only once their sources are.
+        std::vector<uint32_t>        built(6, 0);
+        std::vector<NoiseSliceRange> ranges;
+        uint32_t                     frames = 0;
+        float                        last   = 0.0f;
+
+        while (scheduler.active() && frames < 1000)
+        {
+            uint64_t texels = scheduler.advance(budget, ranges);
+            uint64_t mip0   = 0;
+
+            frames++;
+
+            CHECK(!ranges.empty());
+
+            for (const NoiseSliceRange& range : ranges)
+            {
+                CHECK(range.mip < built.size() && range.count > 0);
+                CHECK(range.first == built[range.mip]);
+
+                built[range.mip] += range.count;
+
+                if (range.mip == 0)
+                    mip0 += uint64_t(range.count) * size * size;
+                else
+                    CHECK(built[range.mip] * 2 <= built[range.mip - 1]);
+            }
+
+            // At least one slab, whole slabs only and no more than the budget beyond that.
+            CHECK(texels == mip0);
+            CHECK(mip0 == 0 || (mip0 % slab == 0 && (mip0 <= budget || mip0 == slab)));
+            CHECK(scheduler.progress() >= last);
+
+            last = scheduler.progress();
+        }
+
+        CHECK(!scheduler.active());
+        CHECK(scheduler.progress() == 1.0f);
+
+        for (uint32_t mip = 0; mip < built.size(); mip++)
+            CHECK(built[mip] == size >> mip);
+
+        uint64_t slabs_per_frame = std::max(budget / slab, uint64_t(1));
+
+        CHECK(frames == (size / slab_depth + slabs_per_frame - 1) / slabs_per_frame);
+
+        // Nothing more once done.
+        CHECK(scheduler.advance(budget, ranges) == 0 && ranges.empty());
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_slab_scheduler_cancel)
+{
+    NoiseSlabScheduler           scheduler;
+    std::vector<NoiseSliceRange> ranges;
+
+    scheduler.begin(16, 8);
+    scheduler.advance(0, ranges);
+
+    CHECK(scheduler.progress() == 0.5f);
+
+    scheduler.cancel();
+
+    CHECK(!scheduler.active());
+    CHECK(scheduler.advance(0, ranges) == 0 && ranges.empty());
+
+    // A new rebuild starts from the first slice.
+    scheduler.begin(16, 8);
+    scheduler.advance(0, ranges);
+
+    CHECK(!ranges.empty() && ranges[0].mip == 0 && ranges[0].first == 0 && ranges[0].count == 8);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(noise_slab_rebuild_matches_full_mips)
+{
+    // Building the slices as they are handed out gives the same mip chain as generating it at once.
+    const uint32_t size     = 16;
+    const uint32_t channels = 4;
+
+    std::vector<float> volume(size_t(size) * size * size * channels);
+    std::mt19937       rng(3);
+
+    std::uniform_real_distribution<float> value(0.0f, 1.0f);
+
+    for (float& v : volume)
+        v = value(rng);
+
+    std::vector<std::vector<float>> expected;
+
+    cpu_noise_generate_mips(volume.data(), size, channels, expected);
+
+    std::vector<std::vector<float>> mips(expected.size());
+
+    for (size_t mip = 0; mip < mips.size(); mip++)
+        mips[mip].assign(expected[mip].size(), -1.0f);
+
+    NoiseSlabScheduler           scheduler;
+    std::vector<NoiseSliceRange> ranges;
+
+    scheduler.begin(size, 2);
+
+    while (scheduler.active())
+    {
+        scheduler.advance(uint64_t(size) * size * 3, ranges);
+
+        for (const NoiseSliceRange& range : ranges)
+        {
+            if (range.mip == 0)
+            {
+                size_t slice = size_t(size) * size * channels;
+
+                std::copy(volume.begin() + range.first * slice, volume.begin() + (range.first + range.count) * slice, mips[0].begin() + range.first * slice);
+            }
+            else
+                noise_downsample_slices(mips[range.mip - 1].data(), size >> (range.mip - 1), channels, range.first, range.count, mips[range.mip].data());
+        }
+    }
+
+    CHECK(mips == expected);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
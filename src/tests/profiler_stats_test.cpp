@@ -0,0 +1,117 @@
+#include "test.h"
+#include "profiler_stats.h"
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(profiler_nearest_rank_percentiles)
+{
+    // 1..100 in reverse, the nearest rank of p is ceil(p / 100 * n).
+    float samples[100];
+
+    for (uint32_t i = 0; i < 100; i++)
+        samples[i] = float(100 - i);
+
+    TimingSummary summary = summarize_timings(samples, 100);
+
+    CHECK(summary.min == 1.0f && summary.max == 100.0f);
+    CHECK_NEAR(summary.avg, 50.5f, 1e-5f);
+    CHECK(summary.p50 == 50.0f);
+    CHECK(summary.p95 == 95.0f);
+    CHECK(summary.p99 == 99.0f);
+
+    // Small counts round the rank up and never go below the first sample.
+    const float few[] = { 4.0f, 1.0f, 3.0f };
+
+    summary = summarize_timings(few, 3);
+
+    CHECK(summary.p50 == 3.0f);
+    CHECK(summary.p95 == 4.0f);
+    CHECK(summarize_timings(few, 1).p50 == 4.0f);
+    CHECK(summarize_timings(few, 0).max == 0.0f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(profiler_history_wraps_around)
+{
+    TimingHistory history;
+
+    CHECK(history.count() == 0);
+
+    for (uint32_t i = 0; i < PROFILER_HISTORY_SIZE; i++)
+        history.add(1000.0f);
+
+    CHECK(history.count() == PROFILER_HISTORY_SIZE);
+
+    // Once full, every new sample replaces the oldest one.
+    for (uint32_t i = 0; i < PROFILER_HISTORY_SIZE - 1; i++)
+        history.add(float(i + 1));
+
+    CHECK(history.count() == PROFILER_HISTORY_SIZE);
+    CHECK(history.summary().max == 1000.0f);
+
+    history.add(float(PROFILER_HISTORY_SIZE));
+
+    TimingSummary summary = history.summary();
+
+    CHECK(summary.min == 1.0f);
+    CHECK(summary.max == float(PROFILER_HISTORY_SIZE));
+    CHECK_NEAR(summary.avg, (PROFILER_HISTORY_SIZE + 1) * 0.5f, 1e-4f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static std::vector<PassSample> test_samples()
+{
+    return { { "Clouds", 0.25f, 1.5f }, { "Tonemap", 0.125f, -1.0f } };
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(profiler_log_csv)
+{
+    const char* path = "profiler_log_test.csv";
+
+    {
+        ProfilerLog log;
+
+        CHECK(log.open(path));
+        CHECK(log.is_open());
+
+        log.write_frame(7, test_samples());
+        log.close();
+
+        CHECK(!log.is_open());
+    }
+
+    // Dropped GPU samples leave the column empty.
+    CHECK(test_read_file(path) == "frame,pass,cpu_ms,gpu_ms\n"
+                                  "7,Clouds,0.2500,1.5000\n"
+                                  "7,Tonemap,0.1250,\n");
+
+    remove(path);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(profiler_log_json_lines)
+{
+    const char* path = "profiler_log_test.json";
+
+    {
+        ProfilerLog log;
+
+        CHECK(log.open(path));
+
+        log.write_frame(1, test_samples());
+        log.write_frame(2, {});
+    }
+
+    CHECK(test_read_file(path) == "{\"frame\":1,\"passes\":[{\"name\":\"Clouds\",\"cpu_ms\":0.2500,\"gpu_ms\":1.5000},"
+                                  "{\"name\":\"Tonemap\",\"cpu_ms\":0.1250,\"gpu_ms\":null}]}\n"
+                                  "{\"frame\":2,\"passes\":[]}\n");
+
+    remove(path);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
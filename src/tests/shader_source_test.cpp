@@ -0,0 +1,220 @@
+#include "test.h"
+#include "shader_source.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <algorithm>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// In-memory files for shader_expand_includes().
+static ShaderFileReader test_reader(const std::map<std::string, std::string>& files)
+{
+    return [files](const std::string& path, std::string& text) {
+        auto it = files.find(path);
+
+        if (it == files.end())
+            return false;
+
+        text = it->second;
+        return true;
+    };
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(shader_expand_includes)
+{
+    std::map<std::string, std::string> files;
+
+    files["shader/main.glsl"]       = "#include <common.glsl>\n  #include \"lib/light.glsl\"\n#include <common.glsl>\nvoid main() {}\n";
+    files["shader/common.glsl"]     = "float common;\n";
+    files["shader/lib/light.glsl"]  = "#include <shadow.glsl>\nfloat light;\n";
+    files["shader/lib/shadow.glsl"] = "float shadow;\n";
+
+    std::string              source;
+    std::vector<std::string> included;
+    std::string              error;
+
+    // Relative to the including file, and common.glsl only once although it is included twice.
+    CHECK(shader_expand_includes("shader/main.glsl", test_reader(files), source, included, error));
+    CHECK(source == "float common;\nfloat shadow;\nfloat light;\nvoid main() {}\n");
+    CHECK(included == std::vector<std::string>({ "shader/main.glsl", "shader/common.glsl", "shader/lib/light.glsl", "shader/lib/shadow.glsl" }));
+    CHECK(error.empty());
+
+    // Lines that only look like includes are kept.
+    files["shader/other.glsl"] = "// #include <common.glsl>\n#include\n#include <unterminated\n";
+
+    CHECK(shader_expand_includes("shader/other.glsl", test_reader(files), source, included, error));
+    CHECK(source == files["shader/other.glsl"]);
+    CHECK(included == std::vector<std::string>({ "shader/other.glsl" }));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(shader_expand_includes_errors)
+{
+    std::map<std::string, std::string> files;
+
+    files["a.glsl"] = "#include <b.glsl>\n";
+    files["b.glsl"] = "#include <c.glsl>\n";
+    files["c.glsl"] = "#include <a.glsl>\n";
+    files["d.glsl"] = "#include <missing.glsl>\n";
+
+    std::string              source;
+    std::vector<std::string> included;
+    std::string              error;
+
+    CHECK(!shader_expand_includes("a.glsl", test_reader(files), source, included, error));
+    CHECK(error == "Include cycle: a.glsl -> b.glsl -> c.glsl -> a.glsl");
+
+    CHECK(!shader_expand_includes("d.glsl", test_reader(files), source, included, error));
+    CHECK(error == "Failed to read missing.glsl, included from d.glsl");
+
+    CHECK(!shader_expand_includes("missing.glsl", test_reader(files), source, included, error));
+    CHECK(error == "Failed to read missing.glsl");
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(shader_expand_shipped_shaders)
+{
+    // Every include of the cloud compute pass resolves on disk.
+    std::string              source;
+    std::vector<std::string> included;
+    std::string              error;
+
+    CHECK(shader_expand_includes(VOLUMETRIC_CLOUDS_SHADER_DIR "/clouds_cs.glsl", shader_read_file, source, included, error));
+    CHECK(error.empty());
+    CHECK(source.find("#include") == std::string::npos);
+
+    const char* expected[] = { "cloud_march.glsl", "cloud_density.glsl", "weather_map.glsl", "cloud_tiles.glsl" };
+
+    for (const char* name : expected)
+        CHECK(std::find(included.begin(), included.end(), std::string(VOLUMETRIC_CLOUDS_SHADER_DIR "/") + name) != included.end());
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(shader_program_key)
+{
+    const std::vector<std::string> sources = { "void main() {}\n", "out vec4 color;\n" };
+    const uint64_t                 key     = shader_program_key(sources, "vendor renderer 4.5");
+
+    CHECK(key == shader_program_key(sources, "vendor renderer 4.5"));
+
+    // Any change of a stage, of the order of the stages or of the driver changes the key.
+    CHECK(key != shader_program_key({ "void main() {}\n", "out vec4 colour;\n" }, "vendor renderer 4.5"));
+    CHECK(key != shader_program_key({ sources[1], sources[0] }, "vendor renderer 4.5"));
+    CHECK(key != shader_program_key(sources, "vendor renderer 4.6"));
+
+    // Moving text across the boundary of two stages changes it too.
+    CHECK(shader_program_key({ "ab", "c" }, "") != shader_program_key({ "a", "bc" }, ""));
+    CHECK(shader_program_key({ "a" }, "") != shader_program_key({ "a", "" }, ""));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(shader_cache_round_trip)
+{
+    const uint8_t binary[] = { 1, 2, 3, 4, 5, 6, 7 };
+
+    std::vector<uint8_t> data;
+
+    shader_cache_serialize(0x1234, 42, binary, sizeof(binary), data);
+
+    CHECK(data.size() == sizeof(ShaderCacheHeader) + sizeof(binary));
+
+    uint32_t       format = 0;
+    const uint8_t* parsed = nullptr;
+    size_t         size   = 0;
+
+    CHECK(shader_cache_parse(data.data(), data.size(), 0x1234, format, parsed, size));
+    CHECK(format == 42 && size == sizeof(binary) && parsed == data.data() + sizeof(ShaderCacheHeader));
+    CHECK(std::equal(binary, binary + sizeof(binary), parsed));
+
+    // Wrong key, truncated, empty, bad magic or version.
+    CHECK(!shader_cache_parse(data.data(), data.size(), 0x1235, format, parsed, size));
+    CHECK(!shader_cache_parse(data.data(), data.size() - 1, 0x1234, format, parsed, size));
+    CHECK(!shader_cache_parse(data.data(), sizeof(ShaderCacheHeader) - 1, 0x1234, format, parsed, size));
+    CHECK(!shader_cache_parse(nullptr, 0, 0x1234, format, parsed, size));
+
+    std::vector<uint8_t> empty;
+
+    shader_cache_serialize(0x1234, 42, nullptr, 0, empty);
+
+    CHECK(!shader_cache_parse(empty.data(), empty.size(), 0x1234, format, parsed, size));
+
+    std::vector<uint8_t> corrupt = data;
+
+    corrupt[0] ^= 0xff;
+    CHECK(!shader_cache_parse(corrupt.data(), corrupt.size(), 0x1234, format, parsed, size));
+
+    corrupt = data;
+    corrupt[offsetof(ShaderCacheHeader, version)]++;
+    CHECK(!shader_cache_parse(corrupt.data(), corrupt.size(), 0x1234, format, parsed, size));
+
+    // Through a file.
+    const char* path = "shader_cache_test.bin";
+    std::string text;
+
+    CHECK(shader_cache_write(path, 0x1234, 42, binary, sizeof(binary)));
+    CHECK(shader_read_file(path, text));
+    CHECK(text.size() == data.size() && std::equal(text.begin(), text.end(), reinterpret_cast<const char*>(data.data())));
+    CHECK(shader_file_time(path) != 0);
+    CHECK(shader_file_time("missing_shader_cache_test.bin") == 0);
+
+    remove(path);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(shader_include_graph)
+{
+    std::map<std::string, int64_t> times = { { "a.glsl", 1 }, { "common.glsl", 1 }, { "b.glsl", 1 } };
+    std::map<std::string, int>     calls;
+
+    ShaderFileTime file_time = [&](const std::string& path) {
+        calls[path]++;
+        return times[path];
+    };
+
+    ShaderIncludeGraph    graph;
+    std::vector<uint32_t> programs;
+
+    graph.set_program(7, { "a.glsl", "common.glsl" }, file_time);
+    graph.set_program(3, { "b.glsl", "common.glsl" }, file_time);
+
+    graph.poll(file_time, programs);
+
+    CHECK(programs.empty());
+
+    // A shared include reloads every program built from it, in increasing order, and each file is checked once per poll.
+    calls.clear();
+    times["common.glsl"] = 2;
+
+    graph.poll(file_time, programs);
+
+    CHECK(programs == std::vector<uint32_t>({ 3, 7 }));
+    CHECK(calls["common.glsl"] == 1 && calls["a.glsl"] == 1 && calls["b.glsl"] == 1);
+
+    graph.poll(file_time, programs);
+
+    CHECK(programs.empty());
+
+    times["a.glsl"] = 5;
+
+    graph.poll(file_time, programs);
+
+    CHECK(programs == std::vector<uint32_t>({ 7 }));
+
+    // After a reload the program only depends on its new files.
+    graph.set_program(7, { "a.glsl" }, file_time);
+    times["common.glsl"] = 3;
+
+    graph.poll(file_time, programs);
+
+    CHECK(programs == std::vector<uint32_t>({ 3 }));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
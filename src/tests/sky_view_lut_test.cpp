@@ -0,0 +1,98 @@
+#include "test.h"
+#include "sky_view_lut.h"
+
+#include <math.h>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(sky_view_lut_texel_round_trip)
+{
+    // The direction of every texel centre maps back to that centre.
+    for (uint32_t y = 0; y < SKY_VIEW_LUT_HEIGHT; y++)
+    {
+        for (uint32_t x = 0; x < SKY_VIEW_LUT_WIDTH; x++)
+        {
+            glm::vec3 direction = sky_view_lut_direction(x, y);
+            glm::vec2 texel     = sky_view_lut_uv(direction) * glm::vec2(SKY_VIEW_LUT_WIDTH, SKY_VIEW_LUT_HEIGHT) - 0.5f;
+
+            CHECK_NEAR(glm::length(direction), 1.0f, 1e-5f);
+            CHECK(direction.y >= 0.0f);
+
+            // At the zenith the azimuth is undefined.
+            if (y < SKY_VIEW_LUT_HEIGHT - 1)
+                CHECK_NEAR(texel.x, float(x), 2e-3f);
+
+            CHECK_NEAR(texel.y, float(y), 2e-3f);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(sky_view_lut_direction_round_trip)
+{
+    // Any direction of the upper hemisphere keeps its azimuth and elevation through the uv.
+    for (float elevation = 0.0f; elevation < 1.5f; elevation += 0.05f)
+    {
+        for (float azimuth = -3.1f; azimuth < 3.1f; azimuth += 0.1f)
+        {
+            glm::vec3 direction = glm::vec3(cosf(elevation) * cosf(azimuth), sinf(elevation), cosf(elevation) * sinf(azimuth));
+            glm::vec2 uv        = sky_view_lut_uv(direction);
+
+            // Inverse of the mapping, sky_view_lut_direction() evaluated between texel centres.
+            float u = (uv.x - 0.5f) * 2.0f * 3.14159265f;
+            float v = (uv.y * float(SKY_VIEW_LUT_HEIGHT) - 0.5f) / float(SKY_VIEW_LUT_HEIGHT - 1);
+
+            CHECK_NEAR(u, azimuth, 1e-4f);
+            CHECK_NEAR(v * v * 3.14159265f * 0.5f, elevation, 1e-4f);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(sky_view_lut_horizon_and_zenith)
+{
+    const float row_size = 1.0f / float(SKY_VIEW_LUT_HEIGHT);
+
+    // The horizon is the centre of the first row, the zenith the centre of the last one.
+    CHECK_NEAR(sky_view_lut_uv(glm::vec3(1.0f, 0.0f, 0.0f)).y, 0.5f * row_size, 1e-6f);
+    CHECK_NEAR(sky_view_lut_uv(glm::vec3(0.0f, 1.0f, 0.0f)).y, 1.0f - 0.5f * row_size, 1e-6f);
+
+    // Below the horizon the sky is that of the horizon.
+    CHECK_NEAR(sky_view_lut_uv(glm::normalize(glm::vec3(1.0f, -0.5f, 0.0f))).y, 0.5f * row_size, 1e-6f);
+
+    // The square root spends more rows near the horizon: the lowest tenth of the elevation takes about a third of them.
+    CHECK(sky_view_lut_uv(glm::vec3(cosf(0.157f), sinf(0.157f), 0.0f)).y > 0.3f);
+
+    // The azimuth wraps around behind -x, where GL_REPEAT blends the first and last columns.
+    CHECK_NEAR(sky_view_lut_uv(glm::normalize(glm::vec3(-1.0f, 0.0f, 1e-4f))).x, 1.0f, 1e-4f);
+    CHECK_NEAR(sky_view_lut_uv(glm::normalize(glm::vec3(-1.0f, 0.0f, -1e-4f))).x, 0.0f, 1e-4f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(sky_view_lut_sample_texel_centres)
+{
+    std::vector<glm::vec3> texels(SKY_VIEW_LUT_WIDTH * SKY_VIEW_LUT_HEIGHT);
+
+    for (size_t i = 0; i < texels.size(); i++)
+        texels[i] = glm::vec3(float(i % SKY_VIEW_LUT_WIDTH), float(i / SKY_VIEW_LUT_WIDTH), 1.0f);
+
+    // A lookup at a texel centre returns that texel without blending in its neighbours.
+    const uint32_t xs[] = { 0, 1, 100, SKY_VIEW_LUT_WIDTH - 1 };
+    const uint32_t ys[] = { 0, 1, 64, SKY_VIEW_LUT_HEIGHT - 2 };
+
+    for (uint32_t x : xs)
+    {
+        for (uint32_t y : ys)
+        {
+            glm::vec3 value = sky_view_lut_sample(texels, sky_view_lut_direction(x, y));
+
+            CHECK_NEAR(value.x, float(x), 5e-3f);
+            CHECK_NEAR(value.y, float(y), 5e-3f);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
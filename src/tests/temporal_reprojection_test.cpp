@@ -0,0 +1,171 @@
+#include "test.h"
+#include "temporal_reprojection.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(temporal_offsets_cover_every_block_pixel)
+{
+    bool visited[TEMPORAL_BLOCK_PIXELS] = {};
+
+    for (uint32_t frame = 0; frame < TEMPORAL_BLOCK_PIXELS; frame++)
+    {
+        glm::ivec2 offset = temporal_pixel_offset(frame);
+
+        CHECK(offset.x >= 0 && offset.x < TEMPORAL_BLOCK_SIZE && offset.y >= 0 && offset.y < TEMPORAL_BLOCK_SIZE);
+
+        visited[offset.y * TEMPORAL_BLOCK_SIZE + offset.x] = true;
+
+        // The sequence repeats every block.
+        CHECK(temporal_pixel_offset(frame + TEMPORAL_BLOCK_PIXELS) == offset);
+    }
+
+    for (uint32_t i = 0; i < TEMPORAL_BLOCK_PIXELS; i++)
+        CHECK(visited[i]);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(temporal_offsets_are_spread_out)
+{
+    // Consecutive frames never update neighbouring pixels along an axis.
+    for (uint32_t frame = 0; frame < TEMPORAL_BLOCK_PIXELS; frame++)
+    {
+        glm::ivec2 d = temporal_pixel_offset(frame + 1) - temporal_pixel_offset(frame);
+
+        CHECK(d.x * d.x + d.y * d.y >= 2);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(temporal_marched_pixels)
+{
+    CHECK(temporal_lowres_size(1920, 1080) == glm::ivec2(480, 270));
+    CHECK(temporal_lowres_size(1921, 1083) == glm::ivec2(481, 271));
+
+    // Every full resolution pixel is marched exactly once per cycle.
+    for (int y = 0; y < 8; y++)
+    {
+        for (int x = 0; x < 8; x++)
+        {
+            uint32_t count = 0;
+
+            for (uint32_t frame = 0; frame < TEMPORAL_BLOCK_PIXELS; frame++)
+                count += temporal_is_marched_pixel(glm::ivec2(x, y), temporal_pixel_offset(frame)) ? 1 : 0;
+
+            CHECK(count == 1);
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(temporal_advection_matches_density_wind)
+{
+    // sample_cloud_density() reads the noise at position + wind * time. The feature at 'position' now must be read at the same noise
+    // coordinate from position + advection one frame earlier.
+    glm::vec3 wind_direction = glm::vec3(0.6f, 0.0f, 0.8f);
+    float     wind_speed     = 50.0f;
+    float     time           = 12.5f;
+    float     delta_time     = 1.0f / 60.0f;
+    glm::vec3 position       = glm::vec3(100.0f, 2000.0f, -300.0f);
+    glm::vec3 wind           = (wind_direction + glm::vec3(0.0f, 0.1f, 0.0f)) * wind_speed;
+
+    glm::vec3 now      = position + wind * time;
+    glm::vec3 previous = position + temporal_cloud_advection(wind_direction, wind_speed, delta_time) + wind * (time - delta_time);
+
+    CHECK_NEAR(now.x, previous.x, 1e-3f);
+    CHECK_NEAR(now.y, previous.y, 1e-3f);
+    CHECK_NEAR(now.z, previous.z, 1e-3f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(temporal_upsample_lands_on_marched_pixels)
+{
+    glm::ivec2 lowres_size = temporal_lowres_size(64, 32);
+
+    for (uint32_t frame = 0; frame < TEMPORAL_BLOCK_PIXELS; frame++)
+    {
+        glm::ivec2 offset = temporal_pixel_offset(frame);
+
+        for (int y = 0; y < 32; y++)
+        {
+            for (int x = 0; x < 64; x++)
+            {
+                glm::ivec2 pixel = glm::ivec2(x, y);
+                glm::vec2  texel = temporal_upsample_uv(glm::vec2(pixel) + 0.5f, glm::vec2(offset), lowres_size) * glm::vec2(lowres_size);
+
+                // A marched pixel reads the centre of the texel it was written to, any other pixel sits at its distance from it.
+                glm::vec2 expected = glm::vec2(pixel - offset) / float(TEMPORAL_BLOCK_SIZE) + 0.5f;
+
+                CHECK_NEAR(texel.x, expected.x, 1e-4f);
+                CHECK_NEAR(texel.y, expected.y, 1e-4f);
+
+                if (temporal_is_marched_pixel(pixel, offset))
+                {
+                    CHECK_NEAR(texel.x, float(x / TEMPORAL_BLOCK_SIZE) + 0.5f, 1e-4f);
+                    CHECK_NEAR(texel.y, float(y / TEMPORAL_BLOCK_SIZE) + 0.5f, 1e-4f);
+                }
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(temporal_cloud_layer_distance)
+{
+    // The sample's planet, a 1500 to 4000 m layer.
+    float     radius = 35000.0f;
+    glm::vec3 center = glm::vec3(0.0f, -radius, 0.0f);
+    glm::vec3 up     = glm::vec3(0.0f, 1.0f, 0.0f);
+    glm::vec3 down   = glm::vec3(0.0f, -1.0f, 0.0f);
+
+    // Below the base the ray leaves through it, straight up at the height difference.
+    CHECK_NEAR(temporal_cloud_layer_distance(glm::vec3(0.0f, 500.0f, 0.0f), up, center, radius, 1500.0f, 4000.0f), 1000.0f, 0.1f);
+    CHECK(temporal_cloud_layer_distance(glm::vec3(0.0f, 500.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), center, radius, 1500.0f, 4000.0f) > 1000.0f);
+
+    // Above the base looking down the near side is hit, not the far side of the planet.
+    CHECK_NEAR(temporal_cloud_layer_distance(glm::vec3(0.0f, 3000.0f, 0.0f), down, center, radius, 1500.0f, 4000.0f), 1500.0f, 0.1f);
+
+    // Above the base looking up or past the sphere, the layer thickness.
+    CHECK_NEAR(temporal_cloud_layer_distance(glm::vec3(0.0f, 3000.0f, 0.0f), up, center, radius, 1500.0f, 4000.0f), 2500.0f, 1e-3f);
+    CHECK_NEAR(temporal_cloud_layer_distance(glm::vec3(0.0f, 3000.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), center, radius, 1500.0f, 4000.0f), 2500.0f, 1e-3f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(temporal_reprojection)
+{
+    glm::vec3 eye       = glm::vec3(0.0f, 5.0f, 0.0f);
+    glm::mat4 view      = glm::lookAt(eye, eye + glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 view_proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 1.0f, 1000.0f) * view;
+    glm::vec2 uv;
+
+    // Straight ahead lands in the middle of the previous frame.
+    CHECK(temporal_reproject(view_proj, eye + glm::vec3(-500.0f, 0.0f, 0.0f), uv));
+    CHECK_NEAR(uv.x, 0.5f, 1e-4f);
+    CHECK_NEAR(uv.y, 0.5f, 1e-4f);
+
+    // Up is up in uv space.
+    CHECK(temporal_reproject(view_proj, eye + glm::vec3(-500.0f, 100.0f, 0.0f), uv));
+    CHECK(uv.y > 0.5f);
+
+    // Behind the camera and outside the frustum are rejected.
+    CHECK(!temporal_reproject(view_proj, eye + glm::vec3(500.0f, 0.0f, 0.0f), uv));
+    CHECK(!temporal_reproject(view_proj, eye + glm::vec3(-10.0f, 0.0f, 100.0f), uv));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(temporal_history_clamp)
+{
+    glm::vec3 clamped = temporal_clamp_history(glm::vec3(2.0f, 0.5f, -1.0f), glm::vec3(0.0f), glm::vec3(1.0f));
+
+    CHECK(clamped == glm::vec3(1.0f, 0.5f, 0.0f));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <math.h>
+#include <stdio.h>
+#include <string>
+
+// Minimal test harness of volumetric-clouds-tests. TEST() registers a case that test_main.cpp runs in name order, CHECK() records a
+// failure and carries on so that one run reports every broken expectation. Only GL-free code is tested.
+
+typedef void (*TestFunction)();
+
+struct TestCase
+{
+    const char*  name;
+    TestFunction function;
+};
+
+int  test_register(const char* name, TestFunction function);
+void test_fail(const char* file, int line, const char* expression);
+
+// Contents of the file at 'path', empty if it cannot be read.
+std::string test_read_file(const char* path);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+#define TEST(name)                                                      \
+    static void name();                                                 \
+    static const int name##_registered = test_register(#name, name);    \
+    static void name()
+
+#define CHECK(expression)                                       \
+    do                                                          \
+    {                                                           \
+        if (!(expression))                                      \
+            test_fail(__FILE__, __LINE__, #expression);         \
+    } while (0)
+
+#define CHECK_NEAR(a, b, epsilon) CHECK(fabs(double(a) - double(b)) <= double(epsilon))
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,96 @@
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+// Runs every registered test, or those whose name contains the first argument. Tests that write files do so in the working directory,
+// the build directory when run by CTest.
+//
+// Usage:
+//     volumetric-clouds-tests [filter]
+
+static std::vector<TestCase>& test_cases()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+static int g_failures = 0;
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+int test_register(const char* name, TestFunction function)
+{
+    test_cases().push_back({ name, function });
+    return int(test_cases().size());
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void test_fail(const char* file, int line, const char* expression)
+{
+    printf("    %s:%d: CHECK(%s) failed\n", file, line, expression);
+    g_failures++;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+std::string test_read_file(const char* path)
+{
+    std::string contents;
+    FILE*       file = fopen(path, "rb");
+
+    if (!file)
+        return contents;
+
+    char   buffer[4096];
+    size_t read;
+
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        contents.append(buffer, read);
+
+    fclose(file);
+
+    return contents;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, const char* argv[])
+{
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+
+    std::vector<TestCase> tests = test_cases();
+
+    std::sort(tests.begin(), tests.end(), [](const TestCase& a, const TestCase& b) { return strcmp(a.name, b.name) < 0; });
+
+    uint32_t run    = 0;
+    uint32_t failed = 0;
+
+    for (const TestCase& test : tests)
+    {
+        if (filter && !strstr(test.name, filter))
+            continue;
+
+        int failures = g_failures;
+
+        test.function();
+        run++;
+
+        if (g_failures != failures)
+        {
+            printf("FAILED %s\n", test.name);
+            failed++;
+        }
+        else
+            printf("passed %s\n", test.name);
+    }
+
+    printf("\n%u of %u tests passed\n", run - failed, run);
+
+    return failed == 0 && run > 0 ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,351 @@
+#include "test.h"
+#include "weather_map.h"
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static const uint8_t* test_tile(const WeatherMapHeader& header, const std::vector<uint8_t>& tiles, const glm::ivec2& tile)
+{
+    return &tiles[(size_t(tile.y) * header.tiles_x + tile.x) * WEATHER_TILE_BYTES];
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(weather_map_file_round_trip)
+{
+    const char* path = "weather_map_test.map";
+
+    WeatherMapHeader     header;
+    std::vector<uint8_t> tiles;
+
+    weather_map_generate(5, 3, 100.0f, 0, header, tiles);
+
+    CHECK(tiles.size() == size_t(5) * 3 * WEATHER_TILE_BYTES);
+    CHECK(weather_map_write(path, header, tiles));
+
+    // Centred on the origin.
+    CHECK(weather_map_tile(header, 0.0f, 0.0f) == glm::ivec2(2, 1));
+    CHECK(weather_map_tile(header, header.origin_x - 1.0f, header.origin_z) == glm::ivec2(-1, 0));
+
+    WeatherMapFile file;
+
+    CHECK(file.open(path));
+    CHECK(file.header().tiles_x == 5 && file.header().tiles_y == 3 && file.header().texel_size == 100.0f);
+
+    std::vector<uint8_t> texels(WEATHER_TILE_BYTES);
+
+    // Read out of order, every tile comes back as written.
+    const glm::ivec2 order[] = { glm::ivec2(4, 2), glm::ivec2(0, 0), glm::ivec2(3, 1), glm::ivec2(0, 2) };
+
+    for (const glm::ivec2& tile : order)
+    {
+        CHECK(file.read_tile(tile, texels.data()));
+        CHECK(std::equal(texels.begin(), texels.end(), test_tile(header, tiles, tile)));
+    }
+
+    CHECK(!file.read_tile(glm::ivec2(5, 0), texels.data()));
+    CHECK(!file.read_tile(glm::ivec2(0, -1), texels.data()));
+
+    remove(path);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(weather_map_file_rejects_invalid_maps)
+{
+    const char* path = "weather_map_test_invalid.map";
+
+    WeatherMapHeader     valid;
+    std::vector<uint8_t> tiles;
+
+    weather_map_generate(2, 2, 100.0f, 0, valid, tiles);
+
+    WeatherMapHeader headers[5] = { valid, valid, valid, valid, valid };
+
+    headers[0].magic      = 0;
+    headers[1].version    = WEATHER_MAP_VERSION + 1;
+    headers[2].tile_size  = WEATHER_TILE_SIZE * 2;
+    headers[3].texel_size = 0.0f;
+    headers[4].tiles_x    = 0;
+
+    for (const WeatherMapHeader& header : headers)
+    {
+        WeatherMapFile file;
+
+        CHECK(weather_map_write(path, header, tiles));
+        CHECK(!file.open(path));
+    }
+
+    // One byte short of the tiles the header declares.
+    tiles.pop_back();
+
+    WeatherMapFile truncated;
+
+    CHECK(weather_map_write(path, valid, tiles));
+    CHECK(!truncated.open(path));
+
+    WeatherMapFile missing;
+
+    CHECK(!missing.open("missing_weather_map_test.map"));
+
+    remove(path);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(weather_map_tile_sampling)
+{
+    std::vector<uint8_t> tile(WEATHER_TILE_BYTES, 0);
+
+    for (uint32_t y = 0; y < WEATHER_TILE_SIZE; y++)
+    {
+        for (uint32_t x = 0; x < WEATHER_TILE_SIZE; x++)
+        {
+            uint8_t* texel = &tile[(y * WEATHER_TILE_SIZE + x) * 4];
+
+            texel[0] = uint8_t(x * 8);
+            texel[1] = uint8_t(y * 8);
+            texel[2] = uint8_t(100 + x);
+        }
+    }
+
+    // Texel centres, a bilinear midpoint and the clamp half a texel inside the tile.
+    Weather centre = weather_map_sample_tile(tile.data(), glm::vec2(3.5f, 7.5f));
+    Weather middle = weather_map_sample_tile(tile.data(), glm::vec2(4.0f, 8.0f));
+    Weather edge   = weather_map_sample_tile(tile.data(), glm::vec2(-3.0f, float(WEATHER_TILE_SIZE) + 2.0f));
+
+    CHECK_NEAR(centre.coverage, 24.0f / 255.0f, 1e-6f);
+    CHECK_NEAR(centre.cloud_type, 56.0f / 255.0f, 1e-6f);
+    CHECK_NEAR(centre.precipitation, 103.0f / 255.0f, 1e-6f);
+    CHECK_NEAR(middle.coverage, 28.0f / 255.0f, 1e-6f);
+    CHECK_NEAR(middle.cloud_type, 60.0f / 255.0f, 1e-6f);
+    CHECK_NEAR(edge.coverage, 0.0f, 1e-6f);
+    CHECK_NEAR(edge.cloud_type, float((WEATHER_TILE_SIZE - 1) * 8) / 255.0f, 1e-6f);
+
+    tile[(5 * WEATHER_TILE_SIZE + 9) * 4] = 0;
+    tile[0]                               = 3;
+
+    CHECK_NEAR(weather_map_min_coverage(tile.data()), 0.0f, 0.0f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(weather_map_window_fade)
+{
+    const float tile   = float(WEATHER_TILE_SIZE);
+    const float window = float(WEATHER_WINDOW_TILES) * tile;
+
+    // Zero at the edge of the window, linear over the outer tile and one everywhere inside it.
+    CHECK_NEAR(weather_map_window_fade(glm::vec2(0.0f, window * 0.5f)), 0.0f, 1e-6f);
+    CHECK_NEAR(weather_map_window_fade(glm::vec2(window * 0.5f, window)), 0.0f, 1e-6f);
+    CHECK_NEAR(weather_map_window_fade(glm::vec2(tile * 0.25f, window * 0.5f)), 0.25f, 1e-6f);
+    CHECK_NEAR(weather_map_window_fade(glm::vec2(window * 0.5f, window - tile * 0.5f)), 0.5f, 1e-6f);
+    CHECK_NEAR(weather_map_window_fade(glm::vec2(tile, tile)), 1.0f, 1e-6f);
+    CHECK_NEAR(weather_map_window_fade(glm::vec2(window * 0.5f)), 1.0f, 1e-6f);
+
+    // The nearest edge wins in corners, nothing is sampled outside.
+    CHECK_NEAR(weather_map_window_fade(glm::vec2(tile * 0.5f, tile * 0.25f)), 0.25f, 1e-6f);
+    CHECK_NEAR(weather_map_window_fade(glm::vec2(-tile, window * 0.5f)), 0.0f, 1e-6f);
+    CHECK_NEAR(weather_map_window_fade(glm::vec2(window * 0.5f, window + tile)), 0.0f, 1e-6f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Checks the indirection and the coverage bound against the tiles 'residency' reports resident.
+static void check_window(const WeatherResidency& residency, const WeatherMapHeader& header, const std::vector<uint8_t>& tiles, const glm::ivec2& camera_tile)
+{
+    CHECK(residency.window_origin() == camera_tile - glm::ivec2(WEATHER_WINDOW_TILES / 2));
+
+    float    min_coverage = 1.0f;
+    uint32_t resident     = 0;
+
+    for (int32_t y = 0; y < WEATHER_WINDOW_TILES; y++)
+    {
+        for (int32_t x = 0; x < WEATHER_WINDOW_TILES; x++)
+        {
+            glm::ivec2     tile  = residency.window_origin() + glm::ivec2(x, y);
+            int32_t        slot  = residency.slot(tile);
+            const uint8_t* texel = &residency.indirection()[(y * WEATHER_WINDOW_TILES + x) * 4];
+
+            if (slot < 0)
+            {
+                CHECK(texel[2] == 0);
+                continue;
+            }
+
+            CHECK(slot < WEATHER_ATLAS_TILES * WEATHER_ATLAS_TILES);
+            CHECK(texel[0] == slot % WEATHER_ATLAS_TILES && texel[1] == slot / WEATHER_ATLAS_TILES && texel[2] == 255);
+
+            min_coverage = std::min(min_coverage, weather_map_min_coverage(test_tile(header, tiles, tile)));
+            resident++;
+        }
+    }
+
+    CHECK(residency.resident_tiles() == resident);
+    CHECK(residency.min_coverage() == min_coverage);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(weather_residency_streams_the_window)
+{
+    WeatherMapHeader     header;
+    std::vector<uint8_t> tiles;
+
+    weather_map_generate(16, 16, 100.0f, 0, header, tiles);
+
+    std::vector<glm::ivec2> loaded;
+
+    WeatherResidency residency;
+
+    residency.initialize(glm::ivec2(16, 16), [&](const glm::ivec2& tile, uint8_t* texels) {
+        loaded.push_back(tile);
+        std::copy(test_tile(header, tiles, tile), test_tile(header, tiles, tile) + WEATHER_TILE_BYTES, texels);
+        return true;
+    }, false);
+
+    std::vector<WeatherTileUpload> uploads;
+    glm::ivec2                     camera_tile(8, 8);
+
+    // The tile of the camera first, then nearest first, WEATHER_UPLOADS_PER_FRAME per frame.
+    residency.update(camera_tile, uploads);
+
+    CHECK(uploads.size() == WEATHER_UPLOADS_PER_FRAME);
+    CHECK(!loaded.empty() && loaded[0] == camera_tile);
+
+    for (size_t i = 1; i < loaded.size(); i++)
+    {
+        glm::ivec2 d = loaded[i] - camera_tile;
+
+        CHECK(d.x * d.x + d.y * d.y == 1);
+    }
+
+    for (const WeatherTileUpload& upload : uploads)
+        CHECK(upload.texels.size() == WEATHER_TILE_BYTES);
+
+    const uint32_t window_tiles = WEATHER_WINDOW_TILES * WEATHER_WINDOW_TILES;
+    const uint32_t frames       = (window_tiles + WEATHER_UPLOADS_PER_FRAME - 1) / WEATHER_UPLOADS_PER_FRAME;
+
+    for (uint32_t frame = 1; frame < frames; frame++)
+        residency.update(camera_tile, uploads);
+
+    CHECK(residency.resident_tiles() == window_tiles);
+    CHECK(loaded.size() == window_tiles);
+    check_window(residency, header, tiles, camera_tile);
+
+    // Nothing left to load.
+    residency.update(camera_tile, uploads);
+
+    CHECK(uploads.empty());
+    CHECK(loaded.size() == window_tiles);
+
+    // One tile to the right: a new column comes in, the free slots are used before anything is evicted.
+    camera_tile.x++;
+    loaded.clear();
+
+    for (uint32_t frame = 0; frame < 2; frame++)
+        residency.update(camera_tile, uploads);
+
+    CHECK(loaded.size() == WEATHER_WINDOW_TILES);
+    CHECK(residency.resident_tiles() == window_tiles);
+    check_window(residency, header, tiles, camera_tile);
+
+    // The column that left the window stays cached, so coming back loads nothing.
+    camera_tile.x--;
+    loaded.clear();
+
+    residency.update(camera_tile, uploads);
+
+    CHECK(loaded.empty() && uploads.empty());
+    CHECK(residency.resident_tiles() == window_tiles);
+
+    // Far away every slot is reused, the least recently used first, and the window is never evicted.
+    for (int32_t step = 0; step < 8; step++)
+    {
+        camera_tile = glm::ivec2(8 + (step % 2) * 4, 8 - step / 2);
+
+        for (uint32_t frame = 0; frame < frames; frame++)
+            residency.update(camera_tile, uploads);
+
+        CHECK(residency.resident_tiles() == window_tiles);
+        check_window(residency, header, tiles, camera_tile);
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(weather_residency_map_edges)
+{
+    WeatherMapHeader     header;
+    std::vector<uint8_t> tiles;
+
+    weather_map_generate(4, 4, 100.0f, 0, header, tiles);
+
+    WeatherResidency residency;
+    uint32_t         failures = 0;
+
+    // Tiles outside the map are never requested, a failed load is retried and never made resident.
+    residency.initialize(glm::ivec2(4, 4), [&](const glm::ivec2& tile, uint8_t* texels) {
+        CHECK(tile.x >= 0 && tile.y >= 0 && tile.x < 4 && tile.y < 4);
+
+        if (tile == glm::ivec2(1, 1))
+        {
+            failures++;
+            return false;
+        }
+
+        std::copy(test_tile(header, tiles, tile), test_tile(header, tiles, tile) + WEATHER_TILE_BYTES, texels);
+        return true;
+    }, false);
+
+    std::vector<WeatherTileUpload> uploads;
+
+    for (uint32_t frame = 0; frame < 8; frame++)
+        residency.update(glm::ivec2(0, 0), uploads);
+
+    CHECK(residency.resident_tiles() == 15);
+    CHECK(residency.slot(glm::ivec2(1, 1)) < 0);
+    CHECK(failures > 1);
+    check_window(residency, header, tiles, glm::ivec2(0, 0));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+TEST(weather_residency_async)
+{
+    WeatherMapHeader     header;
+    std::vector<uint8_t> tiles;
+
+    weather_map_generate(16, 16, 100.0f, 0, header, tiles);
+
+    WeatherResidency residency;
+
+    residency.initialize(glm::ivec2(16, 16), [&](const glm::ivec2& tile, uint8_t* texels) {
+        std::copy(test_tile(header, tiles, tile), test_tile(header, tiles, tile) + WEATHER_TILE_BYTES, texels);
+        return true;
+    }, true);
+
+    std::vector<WeatherTileUpload> uploads;
+    const uint32_t                 window_tiles = WEATHER_WINDOW_TILES * WEATHER_WINDOW_TILES;
+
+    // Bounded so that a lost request fails the test instead of hanging it.
+    for (uint32_t frame = 0; frame < 2000 && residency.resident_tiles() < window_tiles; frame++)
+    {
+        residency.update(glm::ivec2(3, 12), uploads);
+
+        CHECK(uploads.size() <= WEATHER_UPLOADS_PER_FRAME);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    CHECK(residency.resident_tiles() == window_tiles);
+    check_window(residency, header, tiles, glm::ivec2(3, 12));
+
+    residency.shutdown();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <ogl.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+// Uniform buffer split into UNIFORM_RING_SIZE slots of a persistently mapped buffer. Each upload goes to the next slot after waiting on
+// the fence of the frame that last read it, so the CPU never writes memory the GPU may still be reading and never maps or unmaps the
+// buffer. Uploads whose contents match the previous one are skipped and keep using the current slot.
+
+#define UNIFORM_RING_SIZE 3
+
+class UniformRing
+{
+public:
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    bool create(size_t size)
+    {
+        GLint alignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+
+        m_size   = size;
+        m_stride = (size + size_t(alignment) - 1) / size_t(alignment) * size_t(alignment);
+
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glCreateBuffers(1, &m_buffer);
+        glNamedBufferStorage(m_buffer, m_stride * UNIFORM_RING_SIZE, nullptr, flags);
+
+        m_ptr = (uint8_t*)glMapNamedBufferRange(m_buffer, 0, m_stride * UNIFORM_RING_SIZE, flags);
+
+        if (!m_ptr)
+        {
+            DW_LOG_FATAL("Failed to persistently map uniform buffer");
+            return false;
+        }
+
+        m_last.resize(size);
+
+        return true;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Must be called while the context is still current.
+    void destroy()
+    {
+        for (uint32_t i = 0; i < UNIFORM_RING_SIZE; i++)
+        {
+            if (m_fences[i])
+                glDeleteSync(m_fences[i]);
+
+            m_fences[i] = nullptr;
+        }
+
+        if (m_buffer)
+        {
+            glUnmapNamedBuffer(m_buffer);
+            glDeleteBuffers(1, &m_buffer);
+        }
+
+        m_buffer = 0;
+        m_ptr    = nullptr;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Writes 'data' (of the size given to create()) into the next slot, unless it is identical to the last upload.
+    void update(const void* data)
+    {
+        if (m_valid && memcmp(data, m_last.data(), m_size) == 0)
+        {
+            m_skipped_uploads++;
+            return;
+        }
+
+        m_slot = (m_slot + 1) % UNIFORM_RING_SIZE;
+
+        if (m_fences[m_slot])
+        {
+            // Only blocks when the GPU is more than UNIFORM_RING_SIZE - 1 frames behind.
+            while (glClientWaitSync(m_fences[m_slot], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+                ;
+
+            glDeleteSync(m_fences[m_slot]);
+            m_fences[m_slot] = nullptr;
+        }
+
+        memcpy(m_ptr + m_slot * m_stride, data, m_size);
+        memcpy(m_last.data(), data, m_size);
+
+        m_valid = true;
+        m_uploads++;
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    void bind(uint32_t binding)
+    {
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_buffer, m_slot * m_stride, m_size);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    // Fences the current slot after the last draw of the frame that reads it. A slot that is kept across frames because nothing
+    // changed gets a new fence every frame, so it is never rewritten while an older frame may still read it.
+    void end_frame()
+    {
+        if (m_fences[m_slot])
+            glDeleteSync(m_fences[m_slot]);
+
+        m_fences[m_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+    inline uint64_t uploads() const { return m_uploads; }
+    inline uint64_t skipped_uploads() const { return m_skipped_uploads; }
+
+    // -----------------------------------------------------------------------------------------------------------------------------------
+
+private:
+    GLuint               m_buffer = 0;
+    uint8_t*             m_ptr    = nullptr;
+    size_t               m_size   = 0;
+    size_t               m_stride = 0;
+    uint32_t             m_slot   = 0;
+    bool                 m_valid  = false;
+    GLsync               m_fences[UNIFORM_RING_SIZE] = {};
+    std::vector<uint8_t> m_last;
+    uint64_t             m_uploads         = 0;
+    uint64_t             m_skipped_uploads = 0;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
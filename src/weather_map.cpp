@@ -0,0 +1,483 @@
+#include "weather_map.h"
+
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static float hash(int32_t x, int32_t y, uint32_t seed)
+{
+    uint32_t h = uint32_t(x) * 374761393u + uint32_t(y) * 668265263u + seed * 2246822519u;
+
+    h = (h ^ (h >> 13)) * 1274126177u;
+    h ^= h >> 16;
+
+    return float(h & 0xffffff) / float(0xffffff);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static float value_noise(float x, float y, uint32_t seed)
+{
+    float   fx = floorf(x);
+    float   fy = floorf(y);
+    int32_t ix = int32_t(fx);
+    int32_t iy = int32_t(fy);
+    float   tx = x - fx;
+    float   ty = y - fy;
+
+    tx = tx * tx * (3.0f - 2.0f * tx);
+    ty = ty * ty * (3.0f - 2.0f * ty);
+
+    float a = hash(ix, iy, seed) + (hash(ix + 1, iy, seed) - hash(ix, iy, seed)) * tx;
+    float b = hash(ix, iy + 1, seed) + (hash(ix + 1, iy + 1, seed) - hash(ix, iy + 1, seed)) * tx;
+
+    return a + (b - a) * ty;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static float fbm(float x, float y, uint32_t seed)
+{
+    float sum       = 0.0f;
+    float amplitude = 0.5f;
+
+    for (uint32_t octave = 0; octave < 4; octave++)
+    {
+        sum += value_noise(x, y, seed + octave) * amplitude;
+        x *= 2.0f;
+        y *= 2.0f;
+        amplitude *= 0.5f;
+    }
+
+    return sum / 0.9375f;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static uint8_t to_unorm8(float value)
+{
+    return uint8_t(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+static float smoothstep(float edge0, float edge1, float x)
+{
+    float t = std::min(std::max((x - edge0) / (edge1 - edge0), 0.0f), 1.0f);
+
+    return t * t * (3.0f - 2.0f * t);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void weather_map_generate(uint32_t tiles_x, uint32_t tiles_y, float texel_size, uint32_t seed, WeatherMapHeader& header, std::vector<uint8_t>& tiles)
+{
+    header.magic      = WEATHER_MAP_MAGIC;
+    header.version    = WEATHER_MAP_VERSION;
+    header.tile_size  = WEATHER_TILE_SIZE;
+    header.tiles_x    = tiles_x;
+    header.tiles_y    = tiles_y;
+    header.origin_x   = -0.5f * float(tiles_x * WEATHER_TILE_SIZE) * texel_size;
+    header.origin_z   = -0.5f * float(tiles_y * WEATHER_TILE_SIZE) * texel_size;
+    header.texel_size = texel_size;
+
+    tiles.resize(size_t(tiles_x) * tiles_y * WEATHER_TILE_BYTES);
+
+    // Weather systems a few tens of kilometres across, the scale does not depend on the texel size.
+    const float FEATURE_SIZE = 40000.0f;
+
+    for (uint32_t ty = 0; ty < tiles_y; ty++)
+    {
+        for (uint32_t tx = 0; tx < tiles_x; tx++)
+        {
+            uint8_t* tile = &tiles[(size_t(ty) * tiles_x + tx) * WEATHER_TILE_BYTES];
+
+            for (uint32_t y = 0; y < WEATHER_TILE_SIZE; y++)
+            {
+                for (uint32_t x = 0; x < WEATHER_TILE_SIZE; x++)
+                {
+                    float wx = (float(tx * WEATHER_TILE_SIZE + x) + 0.5f) * texel_size / FEATURE_SIZE;
+                    float wz = (float(ty * WEATHER_TILE_SIZE + y) + 0.5f) * texel_size / FEATURE_SIZE;
+
+                    float coverage      = 0.5f + 0.4f * fbm(wx, wz, seed);
+                    float cloud_type    = fbm(wx * 0.7f + 17.0f, wz * 0.7f - 31.0f, seed + 8);
+                    float precipitation = smoothstep(0.6f, 0.9f, cloud_type) * smoothstep(0.75f, 0.6f, coverage);
+
+                    uint8_t* texel = &tile[(y * WEATHER_TILE_SIZE + x) * 4];
+
+                    texel[0] = to_unorm8(coverage);
+                    texel[1] = to_unorm8(cloud_type);
+                    texel[2] = to_unorm8(precipitation);
+                    texel[3] = 0;
+                }
+            }
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool weather_map_write(const std::string& path, const WeatherMapHeader& header, const std::vector<uint8_t>& tiles)
+{
+    std::ofstream file(path, std::ios::binary);
+
+    if (!file)
+        return false;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(tiles.data()), tiles.size());
+
+    return file.good();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+glm::ivec2 weather_map_tile(const WeatherMapHeader& header, float x, float z)
+{
+    float tile_extent = float(WEATHER_TILE_SIZE) * header.texel_size;
+
+    return glm::ivec2(int32_t(floorf((x - header.origin_x) / tile_extent)), int32_t(floorf((z - header.origin_z) / tile_extent)));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+Weather weather_map_sample_tile(const uint8_t* tile, const glm::vec2& texel)
+{
+    glm::vec2  position = glm::clamp(texel, glm::vec2(0.5f), glm::vec2(WEATHER_TILE_SIZE - 0.5f)) - 0.5f;
+    glm::ivec2 p0       = glm::min(glm::ivec2(glm::floor(position)), glm::ivec2(WEATHER_TILE_SIZE - 2));
+    glm::vec2  t        = position - glm::vec2(p0);
+
+    float values[3];
+
+    for (int c = 0; c < 3; c++)
+    {
+        float v00 = tile[(p0.y * WEATHER_TILE_SIZE + p0.x) * 4 + c];
+        float v10 = tile[(p0.y * WEATHER_TILE_SIZE + p0.x + 1) * 4 + c];
+        float v01 = tile[((p0.y + 1) * WEATHER_TILE_SIZE + p0.x) * 4 + c];
+        float v11 = tile[((p0.y + 1) * WEATHER_TILE_SIZE + p0.x + 1) * 4 + c];
+
+        float a = v00 + (v10 - v00) * t.x;
+        float b = v01 + (v11 - v01) * t.x;
+
+        values[c] = (a + (b - a) * t.y) / 255.0f;
+    }
+
+    return { values[0], values[1], values[2] };
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float weather_map_min_coverage(const uint8_t* tile)
+{
+    uint8_t coverage = 255;
+
+    for (uint32_t i = 0; i < WEATHER_TILE_SIZE * WEATHER_TILE_SIZE; i++)
+        coverage = std::min(coverage, tile[i * 4]);
+
+    return float(coverage) / 255.0f;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+float weather_map_window_fade(const glm::vec2& texel)
+{
+    // Distance to the nearest edge of the window, in tiles.
+    glm::vec2 edge = glm::min(texel, glm::vec2(float(WEATHER_WINDOW_TILES * WEATHER_TILE_SIZE)) - texel) / float(WEATHER_TILE_SIZE);
+
+    return std::min(std::max(std::min(edge.x, edge.y), 0.0f), 1.0f);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool WeatherMapFile::open(const std::string& path)
+{
+    m_file.open(path, std::ios::binary);
+
+    if (!m_file)
+        return false;
+
+    m_file.seekg(0, std::ios::end);
+    uint64_t size = uint64_t(m_file.tellg());
+    m_file.seekg(0, std::ios::beg);
+
+    if (size < sizeof(WeatherMapHeader) || !m_file.read(reinterpret_cast<char*>(&m_header), sizeof(m_header)))
+        return false;
+
+    if (m_header.magic != WEATHER_MAP_MAGIC || m_header.version != WEATHER_MAP_VERSION || m_header.tile_size != WEATHER_TILE_SIZE || m_header.texel_size <= 0.0f)
+        return false;
+
+    if (m_header.tiles_x == 0 || m_header.tiles_y == 0)
+        return false;
+
+    return size >= sizeof(WeatherMapHeader) + uint64_t(m_header.tiles_x) * m_header.tiles_y * WEATHER_TILE_BYTES;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool WeatherMapFile::read_tile(const glm::ivec2& tile, uint8_t* texels)
+{
+    if (tile.x < 0 || tile.y < 0 || uint32_t(tile.x) >= m_header.tiles_x || uint32_t(tile.y) >= m_header.tiles_y)
+        return false;
+
+    uint64_t offset = sizeof(WeatherMapHeader) + (uint64_t(tile.y) * m_header.tiles_x + uint64_t(tile.x)) * WEATHER_TILE_BYTES;
+
+    m_file.seekg(std::streamoff(offset), std::ios::beg);
+
+    return bool(m_file.read(reinterpret_cast<char*>(texels), WEATHER_TILE_BYTES));
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+WeatherResidency::~WeatherResidency()
+{
+    shutdown();
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void WeatherResidency::initialize(const glm::ivec2& num_tiles, const WeatherTileLoader& loader, bool async)
+{
+    shutdown();
+
+    m_num_tiles     = num_tiles;
+    m_loader        = loader;
+    m_async         = async;
+    m_frame         = 0;
+    m_window_origin = glm::ivec2(0);
+    m_min_coverage  = 1.0f;
+    m_stop          = false;
+
+    m_slots.assign(WEATHER_ATLAS_TILES * WEATHER_ATLAS_TILES, Slot());
+    m_indirection.assign(WEATHER_WINDOW_TILES * WEATHER_WINDOW_TILES * 4, 0);
+
+    if (m_async)
+        m_thread = std::thread(&WeatherResidency::worker, this);
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void WeatherResidency::shutdown()
+{
+    if (m_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+
+        m_condition.notify_all();
+        m_thread.join();
+    }
+
+    m_requests.clear();
+    m_completed.clear();
+    m_is_loading     = false;
+    m_resident_tiles = 0;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void WeatherResidency::update(const glm::ivec2& camera_tile, std::vector<WeatherTileUpload>& uploads)
+{
+    uploads.clear();
+
+    m_frame++;
+    m_window_origin = camera_tile - glm::ivec2(WEATHER_WINDOW_TILES / 2);
+
+    // Tiles of the window are in use this frame and cannot be evicted.
+    for (Slot& slot : m_slots)
+    {
+        if (slot.used && in_window(slot.tile))
+            slot.last_used = m_frame;
+    }
+
+    std::vector<glm::ivec2> missing;
+    std::vector<Load>       completed;
+
+    missing_tiles(camera_tile, missing);
+
+    if (!m_async)
+    {
+        for (size_t i = 0; i < missing.size() && completed.size() < WEATHER_UPLOADS_PER_FRAME; i++)
+        {
+            Load load = { missing[i], std::vector<uint8_t>(WEATHER_TILE_BYTES), false };
+
+            load.success = m_loader(load.tile, load.texels.data());
+            completed.push_back(std::move(load));
+        }
+    }
+    else
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        size_t count = std::min(m_completed.size(), size_t(WEATHER_UPLOADS_PER_FRAME));
+
+        completed.assign(std::make_move_iterator(m_completed.begin()), std::make_move_iterator(m_completed.begin() + count));
+        m_completed.erase(m_completed.begin(), m_completed.begin() + count);
+    }
+
+    for (Load& load : completed)
+    {
+        // Tiles that left the window while they were loading are dropped, they are requested again if the camera comes back.
+        if (!load.success || !in_window(load.tile) || slot(load.tile) >= 0)
+            continue;
+
+        // Free slots have never been used and come first, the window tiles are never evicted.
+        uint32_t victim = UINT32_MAX;
+
+        for (uint32_t i = 0; i < m_slots.size(); i++)
+        {
+            if (m_slots[i].last_used < m_frame && (victim == UINT32_MAX || m_slots[i].last_used < m_slots[victim].last_used))
+                victim = i;
+        }
+
+        if (victim == UINT32_MAX)
+            break;
+
+        m_slots[victim].tile         = load.tile;
+        m_slots[victim].last_used    = m_frame;
+        m_slots[victim].min_coverage = weather_map_min_coverage(load.texels.data());
+        m_slots[victim].used         = true;
+
+        uploads.push_back({ victim, std::move(load.texels) });
+    }
+
+    if (m_async)
+    {
+        missing_tiles(camera_tile, missing);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            // Replaces the previous requests, so tiles that left the window are never loaded.
+            m_requests.clear();
+
+            for (const glm::ivec2& tile : missing)
+            {
+                bool pending = m_is_loading && m_loading == tile;
+
+                for (const Load& load : m_completed)
+                    pending = pending || load.tile == tile;
+
+                if (!pending)
+                    m_requests.push_back(tile);
+            }
+        }
+
+        m_condition.notify_one();
+    }
+
+    // Indirection and coverage bound of the window.
+    std::fill(m_indirection.begin(), m_indirection.end(), 0);
+
+    m_min_coverage   = 1.0f;
+    m_resident_tiles = 0;
+
+    for (uint32_t i = 0; i < m_slots.size(); i++)
+    {
+        const Slot& s = m_slots[i];
+
+        if (!s.used || !in_window(s.tile))
+            continue;
+
+        glm::ivec2 cell  = s.tile - m_window_origin;
+        uint8_t*   texel = &m_indirection[(cell.y * WEATHER_WINDOW_TILES + cell.x) * 4];
+
+        texel[0] = uint8_t(i % WEATHER_ATLAS_TILES);
+        texel[1] = uint8_t(i / WEATHER_ATLAS_TILES);
+        texel[2] = 255;
+
+        m_min_coverage = std::min(m_min_coverage, s.min_coverage);
+        m_resident_tiles++;
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+int32_t WeatherResidency::slot(const glm::ivec2& tile) const
+{
+    for (uint32_t i = 0; i < m_slots.size(); i++)
+    {
+        if (m_slots[i].used && m_slots[i].tile == tile)
+            return int32_t(i);
+    }
+
+    return -1;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+bool WeatherResidency::in_window(const glm::ivec2& tile) const
+{
+    glm::ivec2 cell = tile - m_window_origin;
+
+    return cell.x >= 0 && cell.y >= 0 && cell.x < WEATHER_WINDOW_TILES && cell.y < WEATHER_WINDOW_TILES;
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void WeatherResidency::missing_tiles(const glm::ivec2& camera_tile, std::vector<glm::ivec2>& tiles) const
+{
+    tiles.clear();
+
+    for (int32_t y = 0; y < WEATHER_WINDOW_TILES; y++)
+    {
+        for (int32_t x = 0; x < WEATHER_WINDOW_TILES; x++)
+        {
+            glm::ivec2 tile = m_window_origin + glm::ivec2(x, y);
+
+            if (tile.x < 0 || tile.y < 0 || tile.x >= m_num_tiles.x || tile.y >= m_num_tiles.y || slot(tile) >= 0)
+                continue;
+
+            tiles.push_back(tile);
+        }
+    }
+
+    // Nearest first, the stable sort keeps the order deterministic for tiles at the same distance.
+    std::stable_sort(tiles.begin(), tiles.end(), [&](const glm::ivec2& a, const glm::ivec2& b) {
+        glm::ivec2 da = a - camera_tile;
+        glm::ivec2 db = b - camera_tile;
+
+        return da.x * da.x + da.y * da.y < db.x * db.x + db.y * db.y;
+    });
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+void WeatherResidency::worker()
+{
+    while (true)
+    {
+        glm::ivec2 tile;
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_condition.wait(lock, [this]() { return m_stop || !m_requests.empty(); });
+
+            if (m_stop)
+                return;
+
+            tile = m_requests.front();
+            m_requests.erase(m_requests.begin());
+
+            m_loading    = tile;
+            m_is_loading = true;
+        }
+
+        Load load = { tile, std::vector<uint8_t>(WEATHER_TILE_BYTES), false };
+
+        load.success = m_loader(tile, load.texels.data());
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_completed.push_back(std::move(load));
+            m_is_loading = false;
+        }
+    }
+}
+
+// -----------------------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Weather map: coverage, cloud type and precipitation over a world larger than any texture. The map is split into square tiles of
+// WEATHER_TILE_SIZE texels stored one after the other, so that a tile is read with a single seek. Only a WEATHER_WINDOW_TILES^2
+// window of tiles around the camera can be resident, in an atlas of WEATHER_ATLAS_TILES^2 slots with an indirection texture mapping
+// each cell of the window to its slot, so the GPU memory does not depend on the size of the map. WeatherResidency decides which tiles
+// are resident, weather_map.glsl samples them and CloudReference reads the whole map.
+//
+// Layout:
+//     WeatherMapHeader
+//     tiles_y rows of tiles_x tiles, each WEATHER_TILE_SIZE^2 RGBA8 texels with x varying fastest:
+//     r coverage (same unit as the Cloud Coverage parameter), g cloud type (0 stratus, 1 cumulonimbus), b precipitation, a unused
+
+#define WEATHER_MAP_MAGIC 0x52485457 // 'WTHR'
+#define WEATHER_MAP_VERSION 1
+#define WEATHER_TILE_SIZE 32
+#define WEATHER_TILE_BYTES (WEATHER_TILE_SIZE * WEATHER_TILE_SIZE * 4)
+
+// Keep in sync with weather_map.glsl. The window is odd so that it is centred on the tile of the camera, the atlas keeps a few tiles
+// outside of it as a cache for when the camera turns back.
+#define WEATHER_WINDOW_TILES 7
+#define WEATHER_ATLAS_TILES 8
+
+// Density multiplier of fully raining clouds. Keep in sync with weather_map.glsl.
+#define WEATHER_PRECIPITATION_DENSITY 1.5f
+
+// Bounds the texture uploads of a frame, the rest of the finished loads wait for the next frames.
+#define WEATHER_UPLOADS_PER_FRAME 4
+
+struct WeatherMapHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t tile_size;
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    float    origin_x; // World x/z of the corner of tile (0, 0).
+    float    origin_z;
+    float    texel_size; // World units per texel.
+};
+
+// Weather at a point of the map, all in [0, 1].
+struct Weather
+{
+    float coverage;
+    float cloud_type;
+    float precipitation;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Procedural map of 'tiles_x' x 'tiles_y' tiles centred on the world origin, written on first run when no map is found.
+void weather_map_generate(uint32_t tiles_x, uint32_t tiles_y, float texel_size, uint32_t seed, WeatherMapHeader& header, std::vector<uint8_t>& tiles);
+
+bool weather_map_write(const std::string& path, const WeatherMapHeader& header, const std::vector<uint8_t>& tiles);
+
+// Tile containing world position 'x', 'z', may be outside of the map.
+glm::ivec2 weather_map_tile(const WeatherMapHeader& header, float x, float z);
+
+// Bilinear sample of a tile at 'texel' (in texels from the corner of the tile), clamped half a texel inside the tile as the atlas
+// slots are not bordered. Keep in sync with sample_weather() in weather_map.glsl.
+Weather weather_map_sample_tile(const uint8_t* tile, const glm::vec2& texel);
+
+// Smallest coverage of a tile, the empty space skipping has to use the smallest coverage of everything that can be sampled.
+float weather_map_min_coverage(const uint8_t* tile);
+
+// Weight of the map against the global parameters at 'texel' (in texels from the corner of the window): 1 inside, falling to 0 over
+// the outer tile of the window so that its edge does not show as a seam. Keep in sync with weather_window_fade() in weather_map.glsl.
+float weather_map_window_fade(const glm::vec2& texel);
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Random access reader of a weather map file.
+class WeatherMapFile
+{
+public:
+    // Fails if the header is invalid or the file is too small for the tiles it declares.
+    bool open(const std::string& path);
+
+    bool read_tile(const glm::ivec2& tile, uint8_t* texels);
+
+    inline const WeatherMapHeader& header() const { return m_header; }
+
+private:
+    std::ifstream    m_file;
+    WeatherMapHeader m_header = {};
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------
+
+// Reads WEATHER_TILE_BYTES of 'tile' into 'texels'. Called on the worker thread in asynchronous mode.
+using WeatherTileLoader = std::function<bool(const glm::ivec2& tile, uint8_t* texels)>;
+
+struct WeatherTileUpload
+{
+    uint32_t             slot;
+    std::vector<uint8_t> texels;
+};
+
+// Keeps the tiles of the window around the camera resident in the atlas. Every update touches the resident tiles of the window,
+// places finished loads into free slots or evicts the least recently used tile outside of the window, and requests the missing tiles
+// nearest first. Requests for tiles that left the window are dropped before they are loaded.
+class WeatherResidency
+{
+public:
+    ~WeatherResidency();
+
+    // 'async' loads on a worker thread. Otherwise update() loads up to WEATHER_UPLOADS_PER_FRAME tiles itself, which is deterministic.
+    void initialize(const glm::ivec2& num_tiles, const WeatherTileLoader& loader, bool async);
+    void shutdown();
+
+    // Returns the tiles to copy into their atlas slot this frame.
+    void update(const glm::ivec2& camera_tile, std::vector<WeatherTileUpload>& uploads);
+
+    // Slot of a resident tile, -1 otherwise.
+    int32_t slot(const glm::ivec2& tile) const;
+
+    // Tile of the map in the first cell of the window.
+    inline glm::ivec2 window_origin() const { return m_window_origin; }
+
+    // WEATHER_WINDOW_TILES^2 RGBA8 texels: x and y of the atlas slot and 255 for resident cells, zero otherwise.
+    inline const std::vector<uint8_t>& indirection() const { return m_indirection; }
+
+    // Smallest coverage of the resident tiles of the window, 1 if there are none.
+    inline float min_coverage() const { return m_min_coverage; }
+
+    // Number of resident tiles in the window.
+    inline uint32_t resident_tiles() const { return m_resident_tiles; }
+
+private:
+    struct Slot
+    {
+        glm::ivec2 tile         = glm::ivec2(0);
+        uint64_t   last_used    = 0;
+        float      min_coverage = 1.0f;
+        bool       used         = false;
+    };
+
+    struct Load
+    {
+        glm::ivec2           tile;
+        std::vector<uint8_t> texels;
+        bool                 success;
+    };
+
+    bool in_window(const glm::ivec2& tile) const;
+    void missing_tiles(const glm::ivec2& camera_tile, std::vector<glm::ivec2>& tiles) const;
+    void worker();
+
+private:
+    glm::ivec2           m_num_tiles     = glm::ivec2(0);
+    glm::ivec2           m_window_origin = glm::ivec2(0);
+    WeatherTileLoader    m_loader;
+    bool                 m_async = false;
+    uint64_t             m_frame = 0;
+    std::vector<Slot>    m_slots;
+    std::vector<uint8_t> m_indirection;
+    float                m_min_coverage   = 1.0f;
+    uint32_t             m_resident_tiles = 0;
+
+    // Shared with the worker thread.
+    std::thread             m_thread;
+    std::mutex              m_mutex;
+    std::condition_variable m_condition;
+    std::vector<glm::ivec2> m_requests; // Nearest first.
+    std::vector<Load>       m_completed;
+    glm::ivec2              m_loading    = glm::ivec2(0);
+    bool                    m_is_loading = false;
+    bool                    m_stop       = false;
+};
+
+// -----------------------------------------------------------------------------------------------------------------------------------